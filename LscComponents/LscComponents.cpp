@@ -26,9 +26,20 @@
 */
 
 
-void waitForSaveReadWrite(){
-    while(100-(millis()-ComponentTracker::getInstance().lastOsCall) < 10){
-    }
+//Number of OsTickLocks currently held, the OS tick is unmasked when the last one is released. See SAVE READ WRITE EXPLANATION
+volatile uint8_t osTickLockDepth = 0;
+
+void lockOsTick(){
+    NVIC_DisableIRQ(TC5_IRQn);
+    __DSB();
+    __ISB();
+    osTickLockDepth++;
+}
+
+void unlockOsTick(){
+    if(osTickLockDepth == 0) return;
+    osTickLockDepth--;
+    if(osTickLockDepth == 0) NVIC_EnableIRQ(TC5_IRQn);
 }
 
 
@@ -38,17 +38,74 @@ RECOURCES:  TODO
 #include <functional>
 
 
-extern void waitForSaveReadWrite();
+//---- SAVE READ WRITE EXPLANATION ----
+/*
+    The OS tick (TC5 ISR, see SCHEDULER EXPLANATION in LscOS.h) updates the component states while the scene loop reads them.
+    A double is written with two stores, a read that is interrupted by the tick could return half of the old and half of the new value.
+    Instead of waiting for a window in which no tick can happen, the tick works as a sequence lock:
+    ComponentTracker::tickSequence is incremented at the start and at the end of every tick, i.e. it is odd while the tick runs.
+    saveRead() and saveReadBlock() copy the value(s) and repeat the copy if tickSequence changed in the meantime. Since the tick can
+    only interrupt a read and not the other way around, a read is repeated at most once per tick and never waits for anything.
+    Inside the tick (tickSequence is odd) values are read directly.
+    Writes from the scene loop (menus, actions, setters) must not be interrupted by the tick. They hold an OsTickLock, which
+    masks the TC5 interrupt while the write is in progress. A tick that becomes due in the meantime runs right after the lock is released.
+    The lock covers the stores and nothing else: reading the SD card, printing and action callbacks run with the tick enabled,
+    otherwise they would delay the tick by milliseconds.
+*/
+//---- END SAVE READ WRITE EXPLANATION ----
+extern void lockOsTick();
+extern void unlockOsTick();
+
+//Masks the OS tick as long as it exists, see SAVE READ WRITE EXPLANATION
+struct OsTickLock{
+    OsTickLock(){ lockOsTick(); }
+    ~OsTickLock(){ unlockOsTick(); }
+};
 class BaseComponent;
 struct BaseExposedState;
 
+//---- REGISTRY EXPLANATION ----
+/*
+    The ComponentTracker keeps the registered components and exposed states in Registries: arrays with a capacity fixed at
+    compile time and a count. Components and states register themselves in their constructors, i.e. before OS::init().
+    OS::init() seals the ComponentTracker, after that the registries never change again. This is what allows the OS tick to
+    iterate over them from the ISR without any allocation, copy or lock. Registering after sealing or beyond the capacity
+    raises an error and the component/state is ignored, together with the states of an ignored component.
+    Increase maxComponents/maxExposedStates if needed.
+*/
+//---- END REGISTRY EXPLANATION ----
+template<typename T, size_t Capacity>
+struct Registry{
+    T items[Capacity];
+    size_t count;
+
+    Registry() : count(0) {}
+    //Appends an item, returns false if the registry is full
+    bool add(const T& item){
+        if(count >= Capacity) return false;
+        items[count] = item;
+        count++;
+        return true;
+    }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t index) { return items[index]; }
+    T& back() { return items[count - 1]; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+};
+
         class ComponentTracker{
             private:
                 ComponentTracker() {}
+                bool sealed = false;
+                bool lastComponentAccepted = false; //the states registered next belong to the component registered last
             public:
-                volatile unsigned long lastOsCall;
-                std::vector<BaseComponent*> components;
-                std::vector<std::pair<BaseComponent*, BaseExposedState*>> states;
+                static constexpr size_t maxComponents = 32;
+                static constexpr size_t maxExposedStates = 128;
+                volatile uint32_t tickSequence; //odd while the OS tick runs, see SAVE READ WRITE EXPLANATION
+                Registry<BaseComponent*, maxComponents> components;
+                Registry<std::pair<BaseComponent*, BaseExposedState*>, maxExposedStates> states;
 
                 static ComponentTracker& getInstance() {
                     static ComponentTracker instance;  
@@ -56,24 +113,74 @@ struct BaseExposedState;
                 }
 
 
-                //Returns a vector with pointers to all registered components. 
-                std::vector<BaseComponent*> getComponets(){
-                    waitForSaveReadWrite();
-                    return ComponentTracker::getInstance().components;
+                //Returns the registry with pointers to all registered components. 
+                Registry<BaseComponent*, maxComponents>& getComponets(){
+                    return components;
                 }
                 //Registers the given component with the ComponentTracker
                 void registerComponent(BaseComponent* component){
-                    waitForSaveReadWrite();
-                    ComponentTracker::getInstance().components.push_back(component);
+                    {
+                        OsTickLock lock;
+                        lastComponentAccepted = !sealed && components.add(component);
+                    }
+                    if(lastComponentAccepted) return;
+                    if(sealed){
+                        ERROR_HANDLER.throwError(0x0, "A component was created after OS::init(), it will be ignored. See REGISTRY EXPLANATION", SeverityLevel::NORMAL);
+                    }else{
+                        ERROR_HANDLER.throwError(0x0, "More than " + String(maxComponents) + " components registered, the remaining ones will be ignored. See ComponentTracker::maxComponents", SeverityLevel::NORMAL);
+                    }
                 }
+                //Registers a state of the component that was registered last (states are members of their component, i.e. they are
+                //constructed right after it). The states of a component that was not accepted are ignored without another error.
                 void registerState(BaseExposedState* State){
-                    waitForSaveReadWrite();
-                    ComponentTracker::getInstance().states.push_back({ComponentTracker::getInstance().components.back(), State});
+                    if(sealed){
+                        ERROR_HANDLER.throwError(0x0, "An exposed state was created after OS::init(), it will be ignored. See REGISTRY EXPLANATION", SeverityLevel::NORMAL);
+                        return;
+                    }
+                    if(!lastComponentAccepted) return;
+                    bool added;
+                    {
+                        OsTickLock lock;
+                        added = states.add({components.back(), State});
+                    }
+                    if(!added){
+                        ERROR_HANDLER.throwError(0x0, "More than " + String(maxExposedStates) + " states registered, the remaining ones will be ignored. See ComponentTracker::maxExposedStates", SeverityLevel::NORMAL);
+                    }
+                }
+                //Freezes the registries, called by OS::init()
+                void seal(){
+                    sealed = true;
+                }
+                bool isSealed(){
+                    return sealed;
                 }
                 String getIDAsString(){
                   return String(components.size() + String(states.size()));
                 }
         };
+
+//Returns a copy of a value written by the OS tick, without tearing. See SAVE READ WRITE EXPLANATION
+template<typename T>
+T saveRead(const volatile T& value){
+    volatile uint32_t& tickSequence = ComponentTracker::getInstance().tickSequence;
+    while(true){
+        uint32_t sequence = tickSequence;
+        T copy = value;
+        if((sequence & 1) || sequence == tickSequence) return copy;
+    }
+}
+//Calls reader until it ran without being interrupted by the OS tick. reader must only copy values. See SAVE READ WRITE EXPLANATION
+template<typename F>
+void saveReadBlock(F reader){
+    volatile uint32_t& tickSequence = ComponentTracker::getInstance().tickSequence;
+    while(true){
+        uint32_t sequence = tickSequence;
+        asm volatile("" ::: "memory");
+        reader();
+        asm volatile("" ::: "memory");
+        if((sequence & 1) || sequence == tickSequence) return;
+    }
+}
           
         
 
@@ -289,17 +396,17 @@ class Gauge{
         double getPressureFromVoltage(double voltage){
             switch(gaugeType){
                 case GaugeType::PKR:
-                    return pow(10., (1.667*voltage-9.33));
+                    return FastMath::pow10((1.667*voltage-9.33));
                 case GaugeType::TPR:
-                    return pow(10., (voltage-3.5));
+                    return FastMath::pow10((voltage-3.5));
                 case GaugeType::VPM5:
-                    return pow(10., (voltage-4.5));  //still not sure this is correct....
+                    return FastMath::pow10((voltage-4.5));  //still not sure this is correct....
                 case GaugeType::BGP400:
-                    return pow(10., (voltage-7.75)/0.75+2);
+                    return FastMath::pow10((voltage-7.75)/0.75+2);
                 case GaugeType::IKR270:
-                    return pow(10., (1.25*voltage)-10.75);
+                    return FastMath::pow10((1.25*voltage)-10.75);
                 case GaugeType::VPMF:
-                    return pow(10., (1.667*voltage)-9.333);
+                    return FastMath::pow10((1.667*voltage)-9.333);
             }
             return 0;
         }
@@ -331,8 +438,15 @@ class BaseComponent{
     public:
         virtual void update() = 0;
         const char* componentName;
-
-        BaseComponent(const char* ComponentName): componentName(ComponentName){
+        //update() is called every updatePeriod_ms and has to return within updateDeadline_ms. See SCHEDULER EXPLANATION in LscOS.h
+        volatile uint32_t updatePeriod_ms;
+        volatile uint32_t updateDeadline_ms;
+
+        //A deadline of 0 sets the deadline to the period
+        BaseComponent(const char* ComponentName, uint32_t updatePeriod_ms = 100, uint32_t updateDeadline_ms = 0)
+            :   componentName(ComponentName),
+                updatePeriod_ms(updatePeriod_ms),
+                updateDeadline_ms(updateDeadline_ms == 0 ? updatePeriod_ms : updateDeadline_ms){
             ComponentTracker::getInstance().registerComponent(this);
         }
 };
@@ -394,12 +508,12 @@ struct ExposedState<ExposedStateType::ReadOnly, T> : BaseExposedState {
     T* state;
     Persistent<T> persistentState;        
     void writeToSD() override{
-        waitForSaveReadWrite();
-        persistentState = *state;
+        persistentState = saveRead(*state);
     }
     void readFromSD() override{
-        waitForSaveReadWrite();
-        *state = persistentState;
+        typename std::remove_volatile<T>::type value = persistentState;
+        OsTickLock lock;
+        *state = value;
     }
     void executeAction() override{
 
@@ -419,12 +533,12 @@ struct ExposedState<ExposedStateType::ReadWrite, T> : BaseExposedState {
     T* state;
     Persistent<T> persistentState;        
     void writeToSD() override{
-        waitForSaveReadWrite();
-        persistentState = *state;
+        persistentState = saveRead(*state);
     }
     void readFromSD() override{
-        waitForSaveReadWrite();
-        *state = persistentState;
+        typename std::remove_volatile<T>::type value = persistentState;
+        OsTickLock lock;
+        *state = value;
     }
     void executeAction() override{
 
@@ -470,12 +584,12 @@ struct ExposedState<ExposedStateType::ReadWriteRanged, T> : BaseExposedState {
 
     Persistent<T> persistentState;        
     void writeToSD() override{
-        waitForSaveReadWrite();
-        persistentState = *state;
+        persistentState = saveRead(*state);
     }
     void readFromSD() override{
-        waitForSaveReadWrite();
-        *state = persistentState;
+        typename std::remove_volatile<T>::type value = persistentState;
+        OsTickLock lock;
+        *state = value;
     }
     void executeAction() override{
 
@@ -496,15 +610,16 @@ struct ExposedState<ExposedStateType::ReadWriteSelection, T> : BaseExposedState
     Selection<T> _selection;
     Persistent<int> persistentIndex;        
     void writeToSD() override{
-        waitForSaveReadWrite();
         persistentIndex = index;
-        persistentIndex.writeObjectToSD();
+        //the assignment has staged the index already, this only forces a record when the assignment skipped it
+        (void)persistentIndex.writeObjectToSD();
         Serial.println("State: "+ String(stateName) + " wrote index: " + String(index));
             }
     void readFromSD() override{
-        waitForSaveReadWrite();
-        index = persistentIndex;
-        Serial.println("State: "+ String(stateName) + " read index: " + String(index));
+        int value = persistentIndex;
+        Serial.println("State: "+ String(stateName) + " read index: " + String(value));
+        OsTickLock lock;
+        index = value;
         writeSelectionItemToState();
     }
     void executeAction() override{
@@ -533,8 +648,9 @@ struct ExposedStateInterface {
         ExposedStateType getStateType(){
             return exposedState->stateType;
         }
+        //Runs the callback of an Action state. The callback runs with the OS tick enabled, the component functions it calls
+        //lock their own writes (see SAVE READ WRITE EXPLANATION)
         void executeAction(){
-            waitForSaveReadWrite();
             if(exposedState->stateType == ExposedStateType::Action){
                 exposedState->executeAction();
             }
@@ -546,13 +662,14 @@ struct ExposedStateInterface {
             exposedState->readFromSD();
         }
 
+        //Writes a new value into the state, only the write itself holds the OsTickLock
         template<typename T>
         void setStateValue(T Value){
-            waitForSaveReadWrite();
             switch(exposedState->stateType){
                 case ExposedStateType::ReadWriteSelection:{
                     auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWriteSelection, void*>*>(exposedState);
                     if((int)Value >= 0 && (int)Value < castStatePtr->_selection.getSelection().size()){
+                        OsTickLock lock;
                         castStatePtr->index = (int)Value;
                         castStatePtr->writeSelectionItemToState();
                     }
@@ -564,16 +681,19 @@ struct ExposedStateInterface {
                     switch(exposedState->typeInfo){
                         case TypeMetaInformation::DOUBLE:{
                             auto castStatDoublePtr = static_cast<ExposedState<ExposedStateType::ReadWrite, volatile double>*>(exposedState);
+                            OsTickLock lock;
                             *(castStatDoublePtr->state) = Value;
                             break;
                         }
                         case TypeMetaInformation::BOOL:{
                             auto castStatBoolPtr = static_cast<ExposedState<ExposedStateType::ReadWrite, volatile bool>*>(exposedState);
+                            OsTickLock lock;
                             *(castStatBoolPtr->state) = Value;
                             break;
                         }
                         case TypeMetaInformation::INT:{
                             auto castStatIntPtr = static_cast<ExposedState<ExposedStateType::ReadWrite, volatile int>*>(exposedState);
+                            OsTickLock lock;
                             *(castStatIntPtr->state) = Value;
                             break;
                         }
@@ -585,11 +705,13 @@ struct ExposedStateInterface {
                     switch(exposedState->typeInfo){
                         case TypeMetaInformation::DOUBLE:{
                             auto castStatDoublePtr = static_cast<ExposedState<ExposedStateType::ReadWriteRanged, volatile double>*>(exposedState);
+                            OsTickLock lock;
                             *(castStatDoublePtr->state) = Value;
                             break;
                         }
                         case TypeMetaInformation::INT:{
                             auto castStatIntPtr = static_cast<ExposedState<ExposedStateType::ReadWriteRanged, volatile int>*>(exposedState);
+                            OsTickLock lock;
                             *(castStatIntPtr->state) = Value;
                             break;
                         }
@@ -601,29 +723,27 @@ struct ExposedStateInterface {
 
         template<typename T>
         T getStateValue(){
-            waitForSaveReadWrite();
             if(exposedState->stateType == ExposedStateType::ReadWriteSelection){
                 auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWriteSelection, void*>*>(exposedState);
                 return static_cast<T>(castStatePtr->index);
             }else if(exposedState->stateType == ExposedStateType::ReadOnly){
                 auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadOnly,volatile T>*>(exposedState);
-                return static_cast<T>(*(castStatePtr->state));
+                return static_cast<T>(saveRead(*(castStatePtr->state)));
             }else if(exposedState->stateType == ExposedStateType::ReadWrite){
                 auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWrite,volatile T>*>(exposedState);
-                return static_cast<T>(*(castStatePtr->state));
+                return static_cast<T>(saveRead(*(castStatePtr->state)));
             }else if(exposedState->stateType == ExposedStateType::ReadWriteRanged){
                 if(exposedState->typeInfo == TypeMetaInformation::DOUBLE){
                     auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWriteRanged,volatile double>*>(exposedState);
-                    return static_cast<double>(*(castStatePtr->state));
+                    return static_cast<double>(saveRead(*(castStatePtr->state)));
                 }else if(exposedState->typeInfo == TypeMetaInformation::INT){
                     auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWriteRanged,volatile int>*>(exposedState);
-                    return static_cast<int>(*(castStatePtr->state));
+                    return static_cast<int>(saveRead(*(castStatePtr->state)));
                 }
                 
             }
         }
         const String getStateValueAsString(){
-            waitForSaveReadWrite();
             switch(exposedState->typeInfo){
                 case TypeMetaInformation::DOUBLE:
                     return String(getStateValue<double>(), 10);
@@ -649,7 +769,6 @@ struct ExposedStateInterface {
             }
         }
         const char* getStateTypeAsConstChar(){
-            waitForSaveReadWrite();
             switch(exposedState->typeInfo){
                 case TypeMetaInformation::DOUBLE:
                     return "double";
@@ -664,7 +783,6 @@ struct ExposedStateInterface {
             }
         }
         std::vector<const char*> getOptions(){
-            waitForSaveReadWrite();
             if(exposedState->stateType != ExposedStateType::ReadWriteSelection) return {""};
             auto castStatePtr = static_cast<ExposedState<ExposedStateType::ReadWriteSelection, void*>*>(exposedState);
             return castStatePtr->_selection.getOptions();
@@ -695,7 +813,7 @@ class Components{
             public:
                 TemperatureSensor(AnalogInPt100 &analogInPt100, const char* componentName = "genericTemperatureSensor") 
                         :   analogInPt100(analogInPt100), 
-                            BaseComponent(componentName), 
+                            BaseComponent(componentName, 1000), 
                             temperature(0), 
                             temeraturePtr("Temperature",&temperature), 
                             displayUnit(Units::Temperature::C), 
@@ -706,17 +824,14 @@ class Components{
                 
                 //Returns the temperature in K
                 double getTemperature(){
-                    waitForSaveReadWrite();
-                    return temperature;
+                    return saveRead(temperature);
                 }
                 //Returns the temperature as string including the unit suffix. The unit can be set with setDisplayUnit
                 String getTeperatureAsString() {
-                    waitForSaveReadWrite();
                     return String(displayUnit.convertFromSI(getTemperature()),0) + displayUnit.getSuffix();
                 }
                 //All calculations are done in SI units. In the case of temperature in Kelvin. But when the teperature is requested as string, it will be converted to the unit set here
                 void setDisplayUnit(Units::Temperature unit){
-                    waitForSaveReadWrite();
                     displayUnit.unitType = unit;
                 }
 
@@ -770,30 +885,43 @@ class Components{
                             ignoreErrorStatePtr("Ignore Error State", &ignoreErrorState, ignoreErrorStateSelection),
                             gassType(gassType),
                             gasTypeSelection({{GassType::N2, "N2"}, {GassType::He, "He"}, {GassType::Ne, "Ne"}, {GassType::Ar, "Ar"}, {GassType::Kr, "Kr"}, {GassType::Xe, "Xe"}}),
-                            gassTypePtr("Gas Type", &gassType, gasTypeSelection)
+                            gassTypePtr("Gas Type", &this->gassType, gasTypeSelection) //the parameter gassType hides the member
                         {
                 }
+                //Formats a value as "1.23E-04". Uses the power of ten table instead of log10/pow, see FAST MATH EXPLANATION
                 String doubleToSciString(double value) {
                     if(value == 0) return "0.00E+00";
-                    
-                    int exponent = static_cast<int>(floor(log10(value)));
-                    double mantissa = value / pow(10, exponent);
-                    int correction = 0;
-                    if(String(mantissa,2) == "10.00"){
-                        mantissa = 1.;
-                        correction = -1;
+                    bool negative = value < 0;
+                    if(negative) value = -value;
+                    int exponent = FastMath::exponentOfTen(value);
+                    if(exponent <= FastMath::minPowerOfTen || exponent >= FastMath::maxPowerOfTen){
+                        ERROR_HANDLER.throwError(0x0, "Failed to corretly format number in scientific notation. This has to be an error in LscComponents lib. see doubleToSciString()",SeverityLevel::NORMAL);
+                        return String(value,10);
                     }
-                    if(exponent >=11) return String(mantissa,2) + "E+" + String(exponent+correction);
-                    if(exponent >= 0) return String(mantissa,2) + "E+0" + String(exponent+correction);
-                    if(exponent <= -10) return String(mantissa,2) + "E" + String(exponent+correction);
-                    if(exponent <  0) return String(mantissa,2) + "E-0" + String(abs(exponent-correction));
-                    ERROR_HANDLER.throwError(0x0, "Failed to corretly format number in scientific notation. This has to be an error in LscComponents lib. see doubleToSciString()",SeverityLevel::NORMAL);
-                    
-                    return String(value,10);
+                    //mantissa rounded to two digits as integer, i.e. 1.234 -> 123
+                    uint32_t mantissa = (uint32_t)(value * FastMath::powerOfTen(2 - exponent) + 0.5);
+                    if(mantissa >= 1000){ //rounding up turned 9.995 into 10.00
+                        mantissa = 100;
+                        exponent++;
+                    }
+                    char buffer[12];
+                    char* c = buffer;
+                    if(negative) *c++ = '-';
+                    *c++ = '0' + mantissa / 100;
+                    *c++ = '.';
+                    *c++ = '0' + (mantissa / 10) % 10;
+                    *c++ = '0' + mantissa % 10;
+                    *c++ = 'E';
+                    *c++ = exponent < 0 ? '-' : '+';
+                    uint8_t absExponent = abs(exponent);
+                    *c++ = '0' + absExponent / 10;
+                    *c++ = '0' + absExponent % 10;
+                    *c = '\0';
+                    return String(buffer);
                 }
                 //Returns the temperature in K
                 double getPressure(){
-                    waitForSaveReadWrite();
+                    double pressure = saveRead(this->pressure);
                     switch (gauge.gaugeType){
                         case GaugeType::PKR :
                             switch (gassType){
@@ -857,8 +985,13 @@ class Components{
                 
                 //Returns the temperature as string including the unit suffix. The unit can be set with setDisplayUnit
                 String getPressureAsString(bool printUnitSuffix = true) {
-                    waitForSaveReadWrite();
-                    if(errorState && !ignoreErrorState) return "ERROR";
+                    double pressure;
+                    bool error;
+                    saveReadBlock([&](){
+                        pressure = this->pressure;
+                        error = errorState && !ignoreErrorState;
+                    });
+                    if(error) return "ERROR";
                     if(pressure <= gauge.getLowerCutOff()) return "---UR---" ;
                     if(printUnitSuffix){
                         return doubleToSciString(displayUnit.convertFromSI(getPressure())) + displayUnit.getSuffix();
@@ -868,12 +1001,10 @@ class Components{
                     }
                 }
                 String getUnitSuffixAsString() {
-                    waitForSaveReadWrite();
                     return displayUnit.getSuffix();
                 }
                 //All calculations are done in SI units. In the case of temperature in Kelvin. But when the teperature is requested as string, it will be converted to the unit set here
                 void setDisplayUnit(Units::Pressure unit){
-                    waitForSaveReadWrite();
                     displayUnit.unitType = unit;
                 }
 
@@ -890,12 +1021,10 @@ class Components{
                     
                 }
                 bool error(){
-                    waitForSaveReadWrite();
-                    return errorState;
+                    return saveRead(errorState);
                 }
                 bool ignoreError(){
-                    waitForSaveReadWrite();
-                    return ignoreErrorState;
+                    return saveRead(ignoreErrorState);
                 }
 
                 //Retuns the component type
@@ -920,7 +1049,7 @@ class Components{
             public:
                 bool* mystateptr;
                 Valve(DigitalOutBase &powerSwitch, const char* componentName = "genericValve") 
-                    :   BaseComponent(componentName),   
+                    :   BaseComponent(componentName, 10),   
                         powerSwitch(powerSwitch),
                         _isState(false),
                         state("State",&_isState),
@@ -934,28 +1063,28 @@ class Components{
             
                 void update() override {
                     if(openTimer > (long)0){
-                        openTimer -= 100;
-                        if(openTimer < (long)0 ){
+                        openTimer -= (long)updatePeriod_ms;
+                        if(openTimer <= (long)0 ){
+                            openTimer = 0;
                             powerSwitch.setState(true);
                             _isState = true;
                         }
                     }
                     if(closeTimer > (long)0){
-                        closeTimer -= 100;
-                        if(closeTimer < (long)0 ){
-                            powerSwitch.setState(true);
-                        _isState = false;
+                        closeTimer -= (long)updatePeriod_ms;
+                        if(closeTimer <= (long)0 ){
+                            closeTimer = 0;
+                            powerSwitch.setState(false);
+                            _isState = false;
                         }
                     }
                     
                 }
 
                 bool getState(){
-                    waitForSaveReadWrite();
-                    return _isState;
+                    return saveRead(_isState);
                 }
                 void setState(bool State){
-                    waitForSaveReadWrite();
                     if(State){
                         open();
                     }else{
@@ -964,23 +1093,23 @@ class Components{
                 }
                 void open(){
                     if(openTimer > 0) return;
-                    waitForSaveReadWrite();
+                    OsTickLock lock;
                     if(_isState) return;
                     powerSwitch.setState(true);
                     _isState = true;
                 }
                 void close(){
                     if(closeTimer > 0) return;
-                    waitForSaveReadWrite();
+                    OsTickLock lock;
                     if(!_isState) return;
                     powerSwitch.setState(false);
                     _isState = false;
                 }
-                //open with a delay in 100ms increments
+                //open with a delay, in increments of the update period (10ms)
                 void open(long delay_ms){
                     openTimer = delay_ms;
                 }
-                //close with a delay in 100ms increments
+                //close with a delay, in increments of the update period (10ms)
                 void close(long delay_ms){ 
                     closeTimer = delay_ms;
                 }
@@ -999,30 +1128,25 @@ class Components{
             private:
                 AnalogInBase &analogIn;
                 volatile int _state;
-                long lastMesurementTime;
                 ExposedState<ExposedStateType::ReadOnly, volatile int> state;
             public:
                 LN2LevelMeter(AnalogInBase &analogIn, const char* componentName = "genericLN2Meter") 
                     :   BaseComponent(componentName),   
                         analogIn(analogIn),
                         _state(0),
-                        lastMesurementTime(millis()),
                         state("State",&_state)
                     {
                     
                 }
             
                 void update() override {
-                    if(millis() - lastMesurementTime > 100){
-                        _state = ((double)_state +  (0.0307*(analogIn.getVoltage()/10.*4096.)) -24.61) / 2.;
-                        if(_state < 0 ) _state = 0;
-                    }
-                    
+                    //level = 0.0307 * ADC counts - 24.61, with ADC counts = voltage / 10V * 4096
+                    _state = ((Q16(_state) + Q16(0.0307 * 4096. / 10.) * analogIn.getFixed() - Q16(24.61)) / Q16(2)).toInt();
+                    if(_state < 0 ) _state = 0;
                 }
 
                 int getState(){
-                    waitForSaveReadWrite();
-                    return _state;
+                    return saveRead(_state);
                 }
 
                 //Retuns the component type
@@ -1045,7 +1169,7 @@ class Components{
                 
             public:
                 RoughingPump(MOSContact &mosContact, const char* componentName = "RoughingPump") 
-                    :   BaseComponent(componentName),   
+                    :   BaseComponent(componentName, 1000), //update() has nothing to do   
                         mosContact(mosContact),
                         _isState(false),
                         actionTurnOn("Turn On", this,&RoughingPump::turnOn),
@@ -1057,22 +1181,21 @@ class Components{
                     
                 }
                 bool getState(){
-                    waitForSaveReadWrite();
                     return _isState;
                 }
                 void setState(bool State){
-                    waitForSaveReadWrite();
+                    OsTickLock lock;
                     if(State == _isState) return;
                     State ? turnOn() : turnOff();
                     _isState = State;
                 }
                 void turnOn(){
-                    waitForSaveReadWrite();
+                    OsTickLock lock;
                     mosContact.setState(true);
                     _isState = true;
                 }
                 void turnOff(){
-                    waitForSaveReadWrite();
+                    OsTickLock lock;
                     mosContact.setState(false);
                     _isState = false;
                 }
@@ -1101,7 +1224,7 @@ class Components{
                 
             public:
                 GateValve(PowerSwitch &powerSwitchOpen, PowerSwitch &powerSwitchClose, DigitalInIsolated& digitalInIsolatedGateValveState,  const char* componentName = "GateValve") 
-                    :   BaseComponent(componentName),   
+                    :   BaseComponent(componentName, 10),   
                         powerSwitchOpen(powerSwitchOpen),
                         powerSwitchClose(powerSwitchClose),
                         digitalInIsolatedGateValveState(digitalInIsolatedGateValveState),
@@ -1118,20 +1241,21 @@ class Components{
                     state = digitalInIsolatedGateValveState.getState();
                     //Serial.println(digitalInIsolatedGateValveState.getDescription());
                     if(openTimer > (long)0){
-                        openTimer -= 100;
-                        if(openTimer < (long)0 ){
+                        openTimer -= (long)updatePeriod_ms;
+                        if(openTimer <= (long)0 ){
+                            openTimer = 0;
                             open();
                         }
                     }
                     if(closeTimer > (long)0){
-                        closeTimer -= 100;
-                        if(closeTimer < (long)0 ){
+                        closeTimer -= (long)updatePeriod_ms;
+                        if(closeTimer <= (long)0 ){
+                            closeTimer = 0;
                             close();
                         }
                     }
                 }
                 bool getState(){
-                    waitForSaveReadWrite();
                     state = digitalInIsolatedGateValveState.getState();
                     return state;
                 }
@@ -1140,19 +1264,21 @@ class Components{
                 }
                 void open(){
                     if(openTimer > 0) return;
+                    OsTickLock lock; //the tick must not switch the valve between the two writes, both switches would be on
                     powerSwitchClose.setState(false);
                     powerSwitchOpen.setState(true);
                 }
                 void close(){
                     if(closeTimer > 0) return;
+                    OsTickLock lock;
                     powerSwitchOpen.setState(false);
                     powerSwitchClose.setState(true);
                 }
-                //open with a delay in 100ms increments
+                //open with a delay, in increments of the update period (10ms)
                 void open(long delay_ms){
                     openTimer = delay_ms;
                 }
-                //close with a delay in 100ms increments
+                //close with a delay, in increments of the update period (10ms)
                 void close(long delay_ms){ 
                     closeTimer = delay_ms;
                 }
@@ -1212,13 +1338,12 @@ class Components{
                 }
                 
                 void sendTransferRequest(){
-                    waitForSaveReadWrite();   
+                    OsTickLock lock;
                     transferRequest.setState(true);
                     transferRequestSent = true;
                     transferRequestSentTime = millis();
                 }
                 bool getRequestState(){
-                    waitForSaveReadWrite();
                     return transferRequestResponse.getState();
                 }
 
@@ -59,7 +59,12 @@ This desige allows every object to throw errors that then can be handled by the
  */
 class ErrorHandler {
   private:
-    static std::vector<Error> errors; // Static container to strore error instances. 
+    // Static container to strore error instances. Created on first use, because the constructors of global objects (components,
+    // states) throw errors before a static member of another translation unit would be initialized.
+    static std::vector<Error>& errors(){
+      static std::vector<Error> instance;
+      return instance;
+    }
     ErrorHandler(){} // Private constructor to prevent direct external instantiation, following the singelton pattern.
 
   public:
@@ -74,15 +79,15 @@ class ErrorHandler {
     // errorMessage: A meaningfull error message explaining why the exception was thrown and what the current stat is the system is. This will be displayed to the user in some form.
     // severityLevel: SeverityLevel::NORMAL, SeverityLevel::CRITICAL, SeverityLevel::FATAL
     static void throwError(int errorCode, const String& errorMessage, const SeverityLevel serverityLevel) {
-        errors.push_back(Error(errorCode, errorMessage, serverityLevel));
+        errors().push_back(Error(errorCode, errorMessage, serverityLevel));
     }
 
     // Returns the vector containing the list of errors
     static const std::vector<Error>& getErrors() {
-      return errors;
+      return errors();
     }
     static void clearAll(){
-      errors.clear();
+      errors().clear();
     }
 };
 
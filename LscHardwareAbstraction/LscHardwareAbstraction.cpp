@@ -44,28 +44,32 @@ void TC3_Handler() {
     } 
 }
 
+//Handles ADC interupts. Called by the PDC whenever a dma buffer is full. See AdcSampler for detailed explanation
+void ADC_Handler(){
+    if(ADC->ADC_ISR & ADC_ISR_ENDRX){
+      uint8_t fullBuffer = ADC_SAMPLER.nextDmaBuffer;
+      //the pdc is already filling the other buffer, the full one will be next once we are done with it
+      ADC->ADC_RNPR = (uintptr_t)ADC_SAMPLER.dmaBuffer[fullBuffer];
+      ADC->ADC_RNCR = AdcSampler::bufferSize;
+      ADC_SAMPLER.nextDmaBuffer = fullBuffer ^ 1;
+      ADC_SAMPLER.processBuffer(ADC_SAMPLER.dmaBuffer[fullBuffer], AdcSampler::bufferSize);
+    }
+}
+
 //Handles TC2 interupts. This timer is responsible for sending the data from the uartBuffer to the uart see sync UART explanation
-//TODO: Optimize, there might be a way of writing directly form the ring buffer to the uart buffer without the need for the outBuffer
-                  //but im not sure what overhead Seria.write is connected with... To be tested...
 void TC2_Handler(){
     TC_GetStatus(TC0,2);
-    //LSC::getInstance().powerSwitch_0.setState(true);
-    char charBuf = ' ';
-    uint16_t dataLen = 0;
     //we never want so send more then 40B of data at a time
-    dataLen = min(LSC::getInstance().uartBuffer.size(),40);
-    //we ned to arrange the data in the ring buffer in a way we can send it
-    char outBuffer[3451];;
-    //pop the data from the ringbuffer and place it in the send buffer 
-    for(int i = 0; i< dataLen; i++){
-      LSC::getInstance().uartBuffer.pop(charBuf);
-      outBuffer[i] = charBuf;
-    } 
-    //zero terminate the outBuffer
-    outBuffer[dataLen] = '\0';
-    //send the data to the uart buffer
-    if(dataLen >0) Serial.print(outBuffer);
-    //  LSC::getInstance().powerSwitch_0.setState(false);
-    
+    uint16_t budget = 40;
+    while(budget > 0){
+      //the data is handed to the uart straight from the ring buffer, in at most two blocks if it wraps around
+      const char* span;
+      uint16_t length = LSC::getInstance().uartBuffer.peekSpan(span);
+      if(length == 0) break;
+      length = min(length, budget);
+      Serial.write(reinterpret_cast<const uint8_t*>(span), length);
+      LSC::getInstance().uartBuffer.drop(length);
+      budget -= length;
+    }
 }
 //EOF
\ No newline at end of file
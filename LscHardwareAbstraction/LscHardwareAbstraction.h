@@ -27,6 +27,7 @@ DESCRIPTION:  This class provides objects that represent the hardware of the LSC
                vent, or openValve.
 TODO:       Optimize
 RECOURCES:  TIMER: TC3-0 FOR: struct Beeper  
+            ADC + PDC FOR: struct AdcSampler
 */
 
 #ifndef LscHardwareAbstraction_H
@@ -37,8 +38,222 @@ RECOURCES:  TIMER: TC3-0 FOR: struct Beeper
 #include "RingBuf.h"
 #include "vector"
 #include "math.h"
+#include <stdarg.h>
 #define ERROR_HANDLER ErrorHandler::getInstance() // macro for the ErrorHandler singleton
 #define BEEPER Beeper::getInstance() // macro for the ErrorHandler singleton
+#define ADC_SAMPLER AdcSampler::getInstance() // macro for the AdcSampler singleton
+
+//===== FAST MATH =====
+
+    //---- FAST MATH EXPLANATION ----
+  /*
+    The SAM3X has no FPU, every pow(), log10() or floating point division is done in software and costs thousands of cycles.
+    The conversions that run every OS cycle (pressure gauges, Pt100, display formatting) therefore use precomputed tables
+    that are generated by the compiler from the formulas below and stored in flash:
+      - pow10FractionTable holds 10^(i/256) for i=0..256. pow10(x) splits x in a Q16 fixed point integer and fraction part
+        and interpolates linearly between two table entries (relative error < 5e-5).
+      - pt100TemperatureTable holds the Pt100 temperature in K (Q16, see Fixed) for every 16th ADC count and is indexed
+        directly by the 1/16 LSB values of the AdcSampler (error < 0.001K compared to the cubic formula).
+      - powersOfTen holds 1e-24 to 1e24 and replaces pow(10, n) and log10() for integer exponents.
+    The generators are constexpr functions (C++11: a single return statement, loops are written as recursion) and are
+    expanded over an index sequence, the static_asserts compare a few entries with known values. Nothing of this runs on
+    the Due. The inline functions that use the tables still take and return double, moving the gauge conversions and the
+    display formatting to fixed point is a deliberate scope limit: the table lookup is what replaced pow() and log10().
+  */
+    //---- END FAST MATH EXPLANATION ----
+
+namespace FastMath{
+  constexpr int minPowerOfTen = -24;
+  constexpr int maxPowerOfTen = 24;
+
+  //Sum of the Taylor series of e^x from the term x^(n-1)/(n-1)! on, 40 terms are exact in double for 0 <= x <= ln(10)
+  constexpr double expSeries(double x, double term, int n){
+    return n > 40 ? 0 : term + expSeries(x, term * x / n, n + 1);
+  }
+  //Pt100 temperature in K, see AnalogInPt100::update()
+  constexpr double pt100Temperature(double rPt){
+    return 273.15 - 2.429E+02 + 2.279E+00 * rPt + 1.674E-03 * rPt * rPt - 1.815E-06 * rPt * rPt * rPt;
+  }
+  //10^n, exact for 0 <= n <= 22
+  constexpr double exactPowerOfTen(int n){
+    return n == 0 ? 1 : 10 * exactPowerOfTen(n - 1);
+  }
+
+  //The generators, entry(i) is the value at index i of the table
+  struct Pow10FractionGenerator{
+    //10^(i/256)
+    static constexpr float entry(int i){ return (float)expSeries(2.302585092994045684 * i / 256, 1, 1); }
+  };
+  struct Pt100TemperatureGenerator{
+    //Temperature (Q16) at the ADC count adc = i*16, the -0.5 Ohm offset of rPt included
+    static constexpr int32_t entry(int i){
+      return (int32_t)(pt100Temperature(i * 16. * 3300 / (78720.8 - i * 16.) - 0.5) * 65536 + 0.5);
+    }
+  };
+  struct PowersOfTenGenerator{
+    //10^(i + minPowerOfTen), every value is rounded at most twice so it equals the literal (checked below)
+    static constexpr double entry(int i){ return power(i + minPowerOfTen); }
+    static constexpr double power(int exponent){
+      return exponent > 22 ? exactPowerOfTen(exponent - 12) * exactPowerOfTen(12)
+           : exponent >= 0 ? exactPowerOfTen(exponent)
+           : exponent >= -22 ? 1 / exactPowerOfTen(-exponent)
+           : 1 / exactPowerOfTen(-exponent - 12) / exactPowerOfTen(12);
+    }
+  };
+
+  //IndexSequence<0, 1, ..., N-1> as MakeIndexSequence<N>::type, C++11 has no std::index_sequence
+  template<int... I> struct IndexSequence{};
+  template<int N, int... I> struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...>{};
+  template<int... I> struct MakeIndexSequence<0, I...>{ typedef IndexSequence<I...> type; };
+
+  //Table<Generator, N>::values holds Generator::entry(0) to Generator::entry(N-1). Static members of a class template are
+  //defined once for the whole program, the tables are not copied into every translation unit that includes this header
+  template<typename Generator, typename Indices> struct TableValues;
+  template<typename Generator, int... I> struct TableValues<Generator, IndexSequence<I...>>{
+    static constexpr decltype(Generator::entry(0)) values[sizeof...(I)] = {Generator::entry(I)...};
+  };
+  template<typename Generator, int... I>
+  constexpr decltype(Generator::entry(0)) TableValues<Generator, IndexSequence<I...>>::values[sizeof...(I)];
+  template<typename Generator, int N> struct Table : TableValues<Generator, typename MakeIndexSequence<N>::type>{};
+
+  static constexpr const float (&pow10FractionTable)[257] = Table<Pow10FractionGenerator, 257>::values;
+  static constexpr const int32_t (&pt100TemperatureTable)[257] = Table<Pt100TemperatureGenerator, 257>::values;
+  static constexpr const double (&powersOfTen)[maxPowerOfTen - minPowerOfTen + 1] =
+    Table<PowersOfTenGenerator, maxPowerOfTen - minPowerOfTen + 1>::values;
+
+  static_assert(pow10FractionTable[0] == 1.f && pow10FractionTable[256] == 10.f, "10^0 and 10^1 must be exact");
+  static_assert(pow10FractionTable[128] > 3.162277f && pow10FractionTable[128] < 3.162278f, "10^0.5 = 3.1622777");
+  static_assert(pow10FractionTable[64] > 1.778279f && pow10FractionTable[64] < 1.778280f, "10^0.25 = 1.7782794");
+  static_assert(pt100TemperatureTable[0] == 1907813 && pt100TemperatureTable[256] == 31839188, "29.11K and 485.83K");
+  static_assert(pt100TemperatureTable[128] == 15835633, "241.63K at 2048 ADC counts");
+  static_assert(powersOfTen[0] == 1e-24 && powersOfTen[1] == 1e-23 && powersOfTen[-minPowerOfTen] == 1.,
+                "1e-24, 1e-23 and 1e0");
+  static_assert(powersOfTen[maxPowerOfTen - minPowerOfTen - 1] == 1e23 && powersOfTen[maxPowerOfTen - minPowerOfTen] == 1e24,
+                "1e23 and 1e24");
+
+  //Interpolates a table with 257 entries that covers the range 0-65536 of index in steps of 256
+  inline float interpolateTable(const float* table, uint32_t index){
+    if(index >= 65536) return table[256];
+    uint32_t i = index >> 8;
+    float fraction = (float)(index & 0xFF) * (1.f / 256.f);
+    return table[i] + (table[i + 1] - table[i]) * fraction;
+  }
+  //Same as above for tables holding fixed point values, uses integer arithmetic only
+  inline int32_t interpolateTable(const int32_t* table, uint32_t index){
+    if(index >= 65536) return table[256];
+    uint32_t i = index >> 8;
+    return table[i] + (((table[i + 1] - table[i]) * (int32_t)(index & 0xFF)) >> 8);
+  }
+  //Returns 10^exponent for integer exponents, 0 or the largest table value outside of minPowerOfTen to maxPowerOfTen
+  inline double powerOfTen(int exponent){
+    if(exponent < minPowerOfTen) return 0;
+    if(exponent > maxPowerOfTen) return powersOfTen[maxPowerOfTen - minPowerOfTen];
+    return powersOfTen[exponent - minPowerOfTen];
+  }
+  //Returns 10^x, replaces pow(10., x)
+  inline double pow10(double x){
+    if(x < minPowerOfTen) return 0;
+    if(x >= maxPowerOfTen) return powersOfTen[maxPowerOfTen - minPowerOfTen];
+    int32_t fixedPoint = (int32_t)(x * 65536.); //Q16, the arithmetic shift below rounds towards -infinity
+    int exponent = fixedPoint >> 16;
+    return (double)interpolateTable(pow10FractionTable, (uint32_t)(fixedPoint & 0xFFFF)) * powerOfTen(exponent);
+  }
+  //Returns the integer exponent of value in base 10, i.e. floor(log10(value)) for positive values
+  inline int exponentOfTen(double value){
+    if(value <= 0) return 0;
+    int exponent = 0;
+    while(exponent < maxPowerOfTen && value >= powerOfTen(exponent + 1)) exponent++;
+    while(exponent > minPowerOfTen && value < powerOfTen(exponent)) exponent--;
+    return exponent;
+  }
+}
+
+//===== FIXED POINT =====
+
+    //---- FIXED POINT EXPLANATION ----
+  /*
+    The analog inputs and outputs are 12bit quantities, there is no need to carry them around as double on a CPU without FPU.
+    Fixed<FractionalBits> stores a value as int32_t scaled by 2^FractionalBits (Q-format). Q16 (Fixed<16>) covers -32768 to
+    32767.99998 with a resolution of 15uV, which is used for voltages and temperatures of the analog inputs/outputs.
+    All arithmetic saturates at the limits of the type instead of wrapping around, a division by zero saturates as well.
+    Conversions from double are meant for constants and interfaces only, e.g. Q16(24.61). The arithmetic itself is integer only.
+    Values that span many decades (pressures) stay double, use FastMath for them.
+  */
+    //---- END FIXED POINT EXPLANATION ----
+
+template<uint8_t FractionalBits>
+struct Fixed{
+  static_assert(FractionalBits > 0 && FractionalBits < 31, "Fixed needs at least one fractional and one integer bit");
+  static constexpr int32_t one = (int32_t)1 << FractionalBits;
+  int32_t raw;
+
+  //--- CONSTRUCTOR ---
+  constexpr Fixed() : raw(0) {}
+  constexpr Fixed(int value) : raw(saturate((int64_t)value * one)) {}
+  constexpr Fixed(double value) : raw(saturate(value * one + (value < 0 ? -0.5 : 0.5))) {}
+  //Creates a value from its raw Q-format representation
+  static Fixed fromRaw(int32_t raw){
+    Fixed value;
+    value.raw = raw;
+    return value;
+  }
+  //Clamps a 64bit intermediate result to the range of the type
+  static constexpr int32_t saturate(int64_t value){
+    return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : (int32_t)value);
+  }
+  static constexpr int32_t saturate(double value){
+    return value >= 2147483647. ? INT32_MAX : (value <= -2147483648. ? INT32_MIN : (int32_t)value);
+  }
+
+  //--- CONVERSIONS ---
+  double toDouble() const { return (double)raw / one; }
+  float toFloat() const { return (float)raw / one; }
+  //Returns the integer part, rounded towards -infinity
+  int32_t toInt() const { return raw >> FractionalBits; }
+  //Returns the value as decimal string with the given number of decimals (rounded), without any floating point math
+  String toString(uint8_t decimals = 2) const {
+    char buffer[24];
+    char* c = buffer + sizeof(buffer);
+    *--c = '\0';
+    if(decimals > 9) decimals = 9;
+    uint64_t magnitude = raw < 0 ? -(int64_t)raw : raw;
+    uint32_t scale = 1;
+    for(uint8_t i = 0; i < decimals; i++) scale *= 10;
+    uint64_t scaled = (magnitude * scale + (one >> 1)) >> FractionalBits;
+    for(uint8_t i = 0; i < decimals; i++){
+      *--c = '0' + scaled % 10;
+      scaled /= 10;
+    }
+    if(decimals > 0) *--c = '.';
+    do{
+      *--c = '0' + scaled % 10;
+      scaled /= 10;
+    }while(scaled > 0);
+    if(raw < 0) *--c = '-';
+    return String(c);
+  }
+
+  //--- OVERLOADS ---
+  friend Fixed operator+(Fixed a, Fixed b){ return fromRaw(saturate((int64_t)a.raw + b.raw)); }
+  friend Fixed operator-(Fixed a, Fixed b){ return fromRaw(saturate((int64_t)a.raw - b.raw)); }
+  friend Fixed operator*(Fixed a, Fixed b){ return fromRaw(saturate(((int64_t)a.raw * b.raw) >> FractionalBits)); }
+  friend Fixed operator/(Fixed a, Fixed b){
+    if(b.raw == 0) return fromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+    return fromRaw(saturate(((int64_t)a.raw << FractionalBits) / b.raw));
+  }
+  Fixed operator-() const { return fromRaw(saturate(-(int64_t)raw)); }
+  Fixed& operator+=(Fixed other){ return *this = *this + other; }
+  Fixed& operator-=(Fixed other){ return *this = *this - other; }
+  Fixed& operator*=(Fixed other){ return *this = *this * other; }
+  Fixed& operator/=(Fixed other){ return *this = *this / other; }
+  friend bool operator==(Fixed a, Fixed b){ return a.raw == b.raw; }
+  friend bool operator!=(Fixed a, Fixed b){ return a.raw != b.raw; }
+  friend bool operator<(Fixed a, Fixed b){ return a.raw < b.raw; }
+  friend bool operator<=(Fixed a, Fixed b){ return a.raw <= b.raw; }
+  friend bool operator>(Fixed a, Fixed b){ return a.raw > b.raw; }
+  friend bool operator>=(Fixed a, Fixed b){ return a.raw >= b.raw; }
+};
+typedef Fixed<16> Q16;
 
 //##################################################
 //########## INPUT/OUTPUT TYPE DEFINITION ##########
@@ -135,15 +350,20 @@ struct AnalogOutBase {
       pinMode(arduinoPin, OUTPUT);
     }
     //--- PUBLIC VARS ---
-    double state;
+    Q16 state;
     //--- PUBLIC FUNCTIONS ---
 
     //Set the state of the Output
-    virtual void setVoltage(double value) {
+    virtual void setVoltage(Q16 value) {
       Assert::dacResolutionIs12bit(); // make sure the resolution is set to 12bit raise an error otherwise
-      analogWrite(arduinoPin, (int)value);
+      analogWrite(arduinoPin, value.toInt());
       state = value;
     }
+    //Set the state of the Output in Volt. Still virtual: outputs that override the double version keep working, the
+    //library itself only overrides the Q16 version
+    virtual void setVoltage(double value) {
+      setVoltage(Q16(value));
+    }
     //--- OVERLOADS ---
     // =
     AnalogOutBase& operator=(double value) {
@@ -152,19 +372,394 @@ struct AnalogOutBase {
     }
         // +=
     AnalogOutBase& operator+=(double other) {
-      state += other;
+      state += Q16(other);
       setVoltage(state);
       return *this;
     }
     // -=
     AnalogOutBase& operator-=(double other) {
-      state -= other;
+      state -= Q16(other);
       setVoltage(state);
       return *this;
     }
     // implicit double conversion
     operator double() const {
-      return state;
+      return state.toDouble();
+    }
+};
+
+//===== FILTERS =====
+
+    //---- FILTERS EXPLANATION ----
+  /*
+    A filter can be attached to every analog input with AnalogInBase::setFilter(). The filter is then fed with every single raw
+    sample of that input by the AdcSampler (AdcSampler::sampleRate_Hz = 5kS/s per channel) and the input reports the filter output.
+    All filters use integer arithmetic only and have their window sizes fixed at compile time, i.e. they never allocate memory.
+    The samples passed to the filters are ADC counts in 1/16 LSB (AdcSampler::valueScale) and the filters return the same scale.
+    Filter stages can be chained with FilterPipeline, the output of one stage is the input of the next one:
+      FilterPipeline<Filters::Median<5>, Filters::ExponentialMovingAverage<4>> pt100Filter;
+      lsc.analogInPt100_0.setFilter(pt100Filter);
+    Every stage has the function bool push(int32_t in, int32_t& out) which returns true if a new output value is available.
+    Decimating stages (CIC) only produce an output for every n-th input, the stages after them run at the reduced rate.
+    The filter object has to outlive the attachment (define it globally or call removeFilter() before it is destroyed).
+  */
+    //---- END FILTERS EXPLANATION ----
+
+namespace Filters{
+  constexpr uint32_t power(uint32_t base, uint8_t exponent){
+    return exponent == 0 ? 1 : base * power(base, exponent - 1);
+  }
+  constexpr uint8_t ceilLog2(uint32_t value){
+    return value <= 1 ? 0 : 1 + ceilLog2((value + 1) / 2);
+  }
+
+  //Moving average over the last N samples
+  template<uint16_t N>
+  struct MovingAverage{
+    static_assert(N > 0, "MovingAverage needs a window of at least one sample");
+    int32_t window[N];
+    int32_t sum;
+    uint16_t index;
+    uint16_t count;
+    MovingAverage(){ reset(); }
+    void reset(){
+      sum = 0;
+      index = 0;
+      count = 0;
+    }
+    bool push(int32_t in, int32_t& out){
+      if(count == N){
+        sum -= window[index];
+      }else{
+        count++;
+      }
+      window[index] = in;
+      sum += in;
+      index = (index + 1) % N;
+      out = sum / count;
+      return true;
+    }
+  };
+
+  //Exponential moving average with a smoothing factor of 1/2^Shift
+  template<uint8_t Shift>
+  struct ExponentialMovingAverage{
+    static_assert(Shift <= 15, "ExponentialMovingAverage supports a Shift of at most 15");
+    int32_t accumulator; //holds the average scaled by 2^Shift
+    bool initialized;
+    ExponentialMovingAverage(){ reset(); }
+    void reset(){
+      accumulator = 0;
+      initialized = false;
+    }
+    bool push(int32_t in, int32_t& out){
+      if(!initialized){
+        accumulator = in << Shift;
+        initialized = true;
+      }else{
+        accumulator += in - (accumulator >> Shift);
+      }
+      out = accumulator >> Shift;
+      return true;
+    }
+  };
+
+  //Median of the last N samples, removes single spikes. Meant for small windows (the window is sorted for every sample)
+  template<uint8_t N>
+  struct Median{
+    static_assert(N > 0 && N <= 15, "Median supports windows from 1 to 15 samples");
+    int32_t window[N];
+    uint8_t index;
+    uint8_t count;
+    Median(){ reset(); }
+    void reset(){
+      index = 0;
+      count = 0;
+    }
+    bool push(int32_t in, int32_t& out){
+      window[index] = in;
+      index = (index + 1) % N;
+      if(count < N) count++;
+      int32_t sorted[N];
+      for(uint8_t i = 0; i < count; i++){
+        int32_t value = window[i];
+        uint8_t k = i;
+        while(k > 0 && sorted[k - 1] > value){
+          sorted[k] = sorted[k - 1];
+          k--;
+        }
+        sorted[k] = value;
+      }
+      out = sorted[count / 2];
+      return true;
+    }
+  };
+
+  //Cascaded integrator comb filter of order Order, decimating by Decimation. Only every Decimation-th input produces an output.
+  //The integrators are allowed to wrap around, the result is still correct as long as the output fits into 32bit.
+  template<uint8_t Order, uint16_t Decimation>
+  struct CIC{
+    static_assert(Order > 0 && Decimation > 0, "CIC needs an order and a decimation of at least one");
+    static_assert(Order * ceilLog2(Decimation) + 17 <= 32, "CIC with this Order and Decimation does not fit into 32bit");
+    static constexpr uint32_t gain = power(Decimation, Order);
+    uint32_t integrators[Order];
+    uint32_t combs[Order];
+    uint16_t counter;
+    CIC(){ reset(); }
+    void reset(){
+      for(uint8_t i = 0; i < Order; i++){
+        integrators[i] = 0;
+        combs[i] = 0;
+      }
+      counter = 0;
+    }
+    bool push(int32_t in, int32_t& out){
+      uint32_t value = (uint32_t)in;
+      for(uint8_t i = 0; i < Order; i++){
+        integrators[i] += value;
+        value = integrators[i];
+      }
+      if(++counter < Decimation) return false;
+      counter = 0;
+      for(uint8_t i = 0; i < Order; i++){
+        uint32_t delayed = combs[i];
+        combs[i] = value;
+        value -= delayed;
+      }
+      out = (int32_t)value / (int32_t)gain;
+      return true;
+    }
+  };
+
+  //Chains filter stages, used by FilterPipeline
+  template<typename... Stages>
+  struct Chain;
+
+  template<typename Stage>
+  struct Chain<Stage>{
+    Stage stage;
+    void reset(){ stage.reset(); }
+    bool push(int32_t in, int32_t& out){ return stage.push(in, out); }
+  };
+
+  template<typename Stage, typename... Rest>
+  struct Chain<Stage, Rest...>{
+    Stage stage;
+    Chain<Rest...> rest;
+    void reset(){
+      stage.reset();
+      rest.reset();
+    }
+    bool push(int32_t in, int32_t& out){
+      int32_t intermediate;
+      if(!stage.push(in, intermediate)) return false;
+      return rest.push(intermediate, out);
+    }
+  };
+}
+
+//Interface the AdcSampler uses to feed samples into a filter
+struct BaseFilter{
+  virtual bool push(int32_t in, int32_t& out) = 0;
+  virtual void reset() = 0;
+  virtual ~BaseFilter(){}
+};
+
+//A filter that can be attached to an analog input, consisting of one or more stages from the Filters namespace
+template<typename... Stages>
+struct FilterPipeline : BaseFilter{
+  Filters::Chain<Stages...> chain;
+  bool push(int32_t in, int32_t& out) override{
+    return chain.push(in, out);
+  }
+  void reset() override{
+    chain.reset();
+  }
+};
+
+//===== ADC SAMPLER =====
+
+/*
+AdcSampler (ADC Hintergrundmessung) Singelton
+*/
+struct AdcSampler {
+    //---- ADC SAMPLER EXPLANATION ----
+  /*
+    Reading an analog input with analogRead() blocks the cpu for the whole conversion. To get a low noise value we used to
+    average 1000 reads in a row, which costs milliseconds of cpu time inside the OS tick for every single channel.
+    The AdcSampler lets the hardware do this work in the background:
+      The ADC runs in free running mode and scans all eight analog inputs (ADC0-ADC7) one after another. The peripheral DMA
+      controller (PDC) copies every conversion result into one of two buffers without any cpu involvement. The channel number
+      is tagged into the upper 4 bits of every result (ADC_EMR_TAG).
+      Once a buffer is full the ADC_Handler is called. It hands the other buffer to the PDC and processes the full one with
+      processBuffer(): all samples of a channel are averaged into a block value, which is written into a ring buffer of
+      blocksPerChannel entries for that channel. The running sum of the ring buffer is kept up to date, so the average over
+      the last blocksPerChannel blocks can be published as a single 32bit word.
+      At sampleRate_Hz a block covers 6.4ms and the average the last 205ms (1024 samples) of a channel. The ADC_Handler runs
+      every 6.4ms.
+    Reading a value is therefore O(1) and never blocks. Values are stored in 1/16 of an ADC count (see valueScale).
+    processBuffer() does not touch any hardware, which makes it possible to feed it with recorded or simulated data.
+    IMPORTANT: As soon as begin() has been called, analogRead() must not be used anymore, it would reconfigure the ADC.
+  */
+    //---- END ADC SAMPLER EXPLANATION ----
+
+    friend void ADC_Handler(); //grant access to private members to ADC_Handler
+
+  public:
+    static constexpr uint8_t numberOfChannels = 8;
+    static constexpr uint16_t samplesPerBlock = 32; //samples per channel and dma buffer
+    static constexpr uint16_t blocksPerChannel = 32; //number of blocks the average is taken over
+    static constexpr uint16_t bufferSize = numberOfChannels * samplesPerBlock;
+    static constexpr uint32_t valueScale = 16; //values are stored in 1/valueScale of an ADC count
+    //The datasheet allows an ADC clock of 1MHz to 20MHz. The slowest clock is plenty for our signals and gives the mux the most time to settle.
+    static constexpr uint32_t adcClock_Hz = 1000000;
+    static constexpr uint32_t prescal = VARIANT_MCK / (2 * adcClock_Hz) - 1; //ADC clock = MCK / ((PRESCAL + 1) * 2)
+    static constexpr uint32_t transfer = 1;
+    //A conversion takes 20 ADC clocks plus the transfer period of (TRANSFER * 2 + 3) clocks, tracking overlaps with the previous conversion
+    static constexpr uint32_t clocksPerConversion = 20 + transfer * 2 + 3;
+    static constexpr uint32_t sampleRate_Hz = adcClock_Hz / clocksPerConversion / numberOfChannels; //per channel, 5kS/s
+    static_assert(prescal <= 255 && VARIANT_MCK / ((prescal + 1) * 2) >= 1000000 && VARIANT_MCK / ((prescal + 1) * 2) <= 20000000,
+                  "The ADC clock has to be between 1MHz and 20MHz");
+
+  private:
+    uint16_t dmaBuffer[2][bufferSize];
+    volatile uint8_t nextDmaBuffer;
+    uint16_t blocks[numberOfChannels][blocksPerChannel];
+    uint16_t blockIndex[numberOfChannels];
+    uint16_t numberOfBlocks[numberOfChannels];
+    uint32_t blockSum[numberOfChannels];
+    volatile uint32_t latest[numberOfChannels];
+    volatile uint32_t average[numberOfChannels];
+    volatile uint32_t numberOfProcessedBuffers;
+    BaseFilter* volatile filters[numberOfChannels];
+    volatile int32_t filtered[numberOfChannels];
+    bool running;
+
+    //private constructor, following the singelton pattern
+    AdcSampler() : nextDmaBuffer(0), numberOfProcessedBuffers(0), running(false){
+      for(uint8_t channel = 0; channel < numberOfChannels; channel++){
+        blockIndex[channel] = 0;
+        numberOfBlocks[channel] = 0;
+        blockSum[channel] = 0;
+        latest[channel] = 0;
+        average[channel] = 0;
+        filters[channel] = nullptr;
+        filtered[channel] = 0;
+      }
+    }
+
+  public:
+    // Function that returns the instance of AdcSampler (if the instance does not exist yet, it is created)
+    static AdcSampler& getInstance() {
+      static AdcSampler instance;
+      return instance;
+    }
+
+    //Starts the background acquisition. Calling it more than once has no effect.
+    void begin(){
+      if(running) return;
+      running = true;
+      pmc_set_writeprotect(false);
+      pmc_enable_periph_clk(ID_ADC);
+      ADC->ADC_CR = ADC_CR_SWRST;
+      // ADC clock = 84MHz / ((41 + 1) * 2) = 1MHz, 40kS/s in total -> sampleRate_Hz = 5kS/s per channel
+      ADC->ADC_MR = ADC_MR_FREERUN_ON | ADC_MR_PRESCAL(prescal) | ADC_MR_STARTUP_SUT64 | ADC_MR_TRACKTIM(15) | ADC_MR_SETTLING_AST17 | ADC_MR_TRANSFER(transfer);
+      ADC->ADC_EMR = ADC_EMR_TAG; // write the channel number into bit 12-15 of every result
+      ADC->ADC_CHER = 0xFF; // ADC0 - ADC7
+      ADC->ADC_RPR = (uintptr_t)dmaBuffer[0];
+      ADC->ADC_RCR = bufferSize;
+      ADC->ADC_RNPR = (uintptr_t)dmaBuffer[1];
+      ADC->ADC_RNCR = bufferSize;
+      nextDmaBuffer = 0;
+      ADC->ADC_IER = ADC_IER_ENDRX;
+      ADC->ADC_PTCR = ADC_PTCR_RXTEN;
+      NVIC_ClearPendingIRQ(ADC_IRQn);
+      NVIC_SetPriority(ADC_IRQn, 6);
+      NVIC_EnableIRQ(ADC_IRQn);
+      ADC->ADC_CR = ADC_CR_START;
+    }
+
+    //Demultiplexes a buffer of tagged ADC results into the per channel ring buffers. Does not access any hardware.
+    void processBuffer(const uint16_t* buffer, uint16_t length){
+      uint32_t sum[numberOfChannels] = {0};
+      uint16_t count[numberOfChannels] = {0};
+      for(uint16_t i = 0; i < length; i++){
+        uint8_t channel = buffer[i] >> 12;
+        if(channel >= numberOfChannels) continue;
+        sum[channel] += buffer[i] & 0x0FFF;
+        count[channel]++;
+        BaseFilter* filter = filters[channel];
+        if(filter != nullptr){
+          int32_t out;
+          if(filter->push((int32_t)(buffer[i] & 0x0FFF) * valueScale, out)) filtered[channel] = out;
+        }
+      }
+      for(uint8_t channel = 0; channel < numberOfChannels; channel++){
+        if(count[channel] == 0) continue;
+        uint16_t value = (uint16_t)(sum[channel] * valueScale / count[channel]);
+        if(numberOfBlocks[channel] == blocksPerChannel){
+          blockSum[channel] -= blocks[channel][blockIndex[channel]]; // the oldest block is overwritten
+        }else{
+          numberOfBlocks[channel]++;
+        }
+        blocks[channel][blockIndex[channel]] = value;
+        blockSum[channel] += value;
+        blockIndex[channel] = (blockIndex[channel] + 1) % blocksPerChannel;
+        latest[channel] = value;
+        average[channel] = blockSum[channel] / numberOfBlocks[channel];
+      }
+      numberOfProcessedBuffers++;
+    }
+
+    //Returns the ADC channel (0-7) of an arduino analog pin
+    static uint8_t getChannel(uint8_t arduinoPin){
+      return g_APinDescription[arduinoPin].ulADCChannelNumber;
+    }
+    //Returns the newest block average of a channel in ADC counts (0-4095)
+    double getLatest(uint8_t channel){
+      if(channel >= numberOfChannels) return 0;
+      return (double)latest[channel] / valueScale;
+    }
+    //Returns the average over the last blocksPerChannel blocks of a channel in ADC counts (0-4095)
+    double getAverage(uint8_t channel){
+      if(channel >= numberOfChannels) return 0;
+      return (double)average[channel] / valueScale;
+    }
+    //Returns the output of the filter attached to a channel in ADC counts (0-4095), or the average if no filter is attached
+    double getFiltered(uint8_t channel){
+      if(channel >= numberOfChannels) return 0;
+      if(filters[channel] == nullptr) return getAverage(channel);
+      return (double)filtered[channel] / valueScale;
+    }
+    //Returns the output of the attached filter or, if no filter is attached, the average over the last blocksPerChannel blocks
+    //in 1/16 ADC counts (0-65520). Same as getFiltered() without the conversion to double.
+    uint32_t getScaled(uint8_t channel){
+      if(channel >= numberOfChannels) return 0;
+      if(filters[channel] == nullptr) return average[channel];
+      int32_t value = filtered[channel];
+      return value < 0 ? 0 : (uint32_t)value;
+    }
+    //Attaches a filter to a channel, every new sample of the channel will be pushed through it. Pass nullptr to remove the filter.
+    void setFilter(uint8_t channel, BaseFilter* filter){
+      if(channel >= numberOfChannels) return;
+      NVIC_DisableIRQ(ADC_IRQn);
+      if(filter != nullptr){
+        filter->reset();
+        filtered[channel] = average[channel];
+      }
+      filters[channel] = filter;
+      if(running) NVIC_EnableIRQ(ADC_IRQn);
+    }
+    bool hasFilter(uint8_t channel){
+      if(channel >= numberOfChannels) return false;
+      return filters[channel] != nullptr;
+    }
+    //Returns the number of dma buffers processed since begin(), can be used to check that the sampler is alive
+    uint32_t getNumberOfProcessedBuffers(){
+      return numberOfProcessedBuffers;
+    }
+    bool isRunning(){
+      return running;
     }
 };
 
@@ -176,7 +771,7 @@ struct AnalogInBase {
 
   protected:
     String description;
-    double state;
+    Q16 state;
   public:
     uint8_t arduinoPin;
     //--- CONSTRUCTOR ---
@@ -192,12 +787,25 @@ struct AnalogInBase {
     virtual void update() = 0;
     //Returns the voltage of the input
     virtual double getVoltage() = 0;
+    //Updates and returns the state of the input (voltage, or temperature for AnalogInPt100) as fixed point value
+    Q16 getFixed(){
+      update();
+      return state;
+    }
+    //Attaches a filter to the input, from now on the input reports the output of the filter. See FILTERS EXPLANATION
+    void setFilter(BaseFilter& filter){
+      ADC_SAMPLER.setFilter(AdcSampler::getChannel(arduinoPin), &filter);
+    }
+    //Removes the filter, the input falls back to its default averaging
+    void removeFilter(){
+      ADC_SAMPLER.setFilter(AdcSampler::getChannel(arduinoPin), nullptr);
+    }
     //--- OVERLOADS ---
     // =
     // implicit double conversion
     operator double() {
       getVoltage();
-      return state;
+      return state.toDouble();
     }
 };
 
@@ -261,15 +869,15 @@ struct AnalogOutIsolated : AnalogOutBase{
     using AnalogOutBase::operator=;
     using AnalogOutBase::operator+=;
     using AnalogOutBase::operator-=; 
+    using AnalogOutBase::setVoltage;
     //Sets the analog output in Volt 
-    void setVoltage(double value) override{
-      if((value >= 0.) && (value <= 10.) ){
-        int analogWriteDAC = 0;
-        analogWriteDAC = (uint)(value / 10.0 * 4095.0);
+    void setVoltage(Q16 value) override{
+      if((value >= Q16(0)) && (value <= Q16(10)) ){
+        uint32_t analogWriteDAC = (uint32_t)value.raw * 4095 / (uint32_t)Q16(10).raw;
         analogWrite(arduinoPin, analogWriteDAC);
         state = value;
       } else{
-        ERROR_HANDLER.throwError(0x0, "The DAC value on Arduino pin:" + String(arduinoPin) + " has to be between 0V and 10V but is: " + String(value) + "V. Nothing will be written to the Output!", SeverityLevel::NORMAL);
+        ERROR_HANDLER.throwError(0x0, "The DAC value on Arduino pin:" + String(arduinoPin) + " has to be between 0V and 10V but is: " + value.toString(3) + "V. Nothing will be written to the Output!", SeverityLevel::NORMAL);
       }
 
     }
@@ -282,20 +890,15 @@ AnalogIn (Analog Eingang)
 struct AnalogIn : AnalogInBase{
   public:
     //--- CONSTRUCTOR ---
-    AnalogIn(uint8_t arduinoPin) : AnalogInBase(arduinoPin), 
-      calibrationCurve( {{10, 0. },{18, 0.0012},{40, 0.1116},{65, 0.1995},{104, 0.3001},{146, 0.4001},{187, 0.5004},{228, 0.6009},{270, 0.701},{311, 0.8013},{352, 0.9014},{393, 1.0015},{805, 2.0},{1219, 3.0004},{1631, 4.006},{2043, 5.006},{2456, 6.007},{2866, 7.006},{3279, 8.007},{3689, 9.004},{4060, 9.905},{4088, 9.993}}){
+    AnalogIn(uint8_t arduinoPin) : AnalogInBase(arduinoPin) {
       description = "AnalogIn (Analog Eingang)\n0V to 10V, 12bit, Voltage divider 10KOhm \nArduino PIN: " + String(arduinoPin);
     }
 
     // Forward declaration this makes sure that we use the implicit conversion double() in the scope of the new Struct.
     using AnalogInBase::operator double; 
     void update() override {
-      int analogReadADC = 0;
-      for(int i = 0; i< 1000;i++){
-        analogReadADC += analogRead(arduinoPin);  
-      }
-      state = adcToVoltage((double)analogReadADC / 1000.);
-      analogReadADC = (int)((double)analogReadADC / 1000.); 
+      //the AdcSampler averages the last 1024 samples (205ms) in the background, or runs the attached filter (see AdcSampler::getScaled)
+      state = adcToVoltage(ADC_SAMPLER.getScaled(AdcSampler::getChannel(arduinoPin)));
       /*
       //analogReadADC = analogRead(arduinoPin);
       state = adcToVoltage(analogReadADC);
@@ -308,40 +911,13 @@ struct AnalogIn : AnalogInBase{
     double getVoltage() override {
       //TODO: assert analogReadResolution == 12
       update();
-      return state;
+      return state.toDouble();
     }
   private:
-    struct CalibrationPairs{
-      int adcValue;
-      double voltage;
-    };
-    double interpolate(double x, double x0, double x1, double y0, double y1) {
-      return y0 + (x - x0) * (y1 - y0) / (x1 - x0);
-    }
-    double adcToVoltage(double adcValue) {
-      return (double)(adcValue/4096.*10.);
-      // Find the two nearest data points
-      CalibrationPairs *lower = nullptr;
-      CalibrationPairs *upper = nullptr;
-
-      for (size_t i = 0; i < sizeof(calibrationCurve) / sizeof(calibrationCurve[0]); i++) {
-          if (adcValue >= calibrationCurve[i].adcValue) {
-              lower = &calibrationCurve[i];
-          } else {
-              upper = &calibrationCurve[i];
-              break;
-          }
-      }
-
-      // If no upper data point is found, return the voltage of the highest data point
-      if (!upper) {
-          return calibrationCurve[sizeof(calibrationCurve) / sizeof(calibrationCurve[0]) - 1].voltage;
-      }
-
-      // Perform linear interpolation
-      return interpolate(adcValue, lower->adcValue, upper->adcValue, lower->voltage, upper->voltage);
+    //Converts 1/16 ADC counts to Volt: 10V/4096/16 * 2^16 = 10 raw Q16 steps per scaled count
+    Q16 adcToVoltage(uint32_t scaledAdcValue) {
+      return Q16::fromRaw(scaledAdcValue * 10);
     }
-    CalibrationPairs calibrationCurve[22];
 
 
 };
@@ -377,18 +953,13 @@ struct AnalogInPt100 : AnalogInBase{
         where a=-2.429E+02, b=2.279E+00, c=1.674E-03, d=-1.815E-06;
       */
       Assert::dacResolutionIs12bit();
-      uint16_t analogReadADC = 0;
-      analogReadADC = analogRead(arduinoPin);
-      double rPT = (double)analogReadADC * 3300. / (78720.8 - (double)analogReadADC);
-      rPT -= 0.5;
-      const double a=-2.429E+02, b=2.279E+00, c=1.674E-03, d=-1.815E-06;
-      double temp = (d * pow(rPT, 3) + c * rPT * rPT + b * rPT + a);
-      state = 273.15 + temp;
+      //the formula above (including the -0.5 Ohm offset of rPT) is precomputed in pt100TemperatureTable, see FAST MATH EXPLANATION
+      state = Q16::fromRaw(FastMath::interpolateTable(FastMath::pt100TemperatureTable, ADC_SAMPLER.getScaled(AdcSampler::getChannel(arduinoPin))));
     }
     //Returns the temperature of the input in K
     double getTemperature() {
       update();
-      return state;
+      return state.toDouble();
     }
     double getVoltage() override{
       return -100000;
@@ -410,14 +981,13 @@ struct AnalogInGauge : AnalogInBase{
     using AnalogInBase::operator double; 
     void update() override{
       Assert::dacResolutionIs12bit();
-      int analogReadADC = 0;
-      analogReadADC = analogRead(arduinoPin);
-      state = (double)analogReadADC / 4096*8.5;
+      //8.5V/4096/16 * 2^16 = 8.5 raw Q16 steps per scaled count
+      state = Q16::fromRaw(ADC_SAMPLER.getScaled(AdcSampler::getChannel(arduinoPin)) * 17 / 2);
     }
     //Returns the voltage of the input
     double getVoltage() override {
       update();
-      return state;
+      return state.toDouble();
     }
 };
 
@@ -712,6 +1282,8 @@ class LSC{
               NVIC_SetPriority(PIOD_IRQn, 5); //set external gpio priority (it has to be higher than Beeper timer)
               analogWriteResolution(12);
               analogReadResolution(12);
+              //all analog inputs are read by the AdcSampler from now on
+              ADC_SAMPLER.begin();
 
               //Setting up the uart send timer see Async UART for explenation
               
@@ -828,44 +1400,251 @@ class LSC{
       the data to the uart buffer directly but first in the uartBuffer. 
       To write the data form the uartBuffer to the acctual uart we setup a timer with the handler TC2_Handler, that runs every 
       3.5ms and writes a junk of data smaller then the uart buffer to the uart. With this approach we can ensure, that the
-      uart buffer will never be full. With this implementation we can send 1.1Kb of data every 100ms, or 11kB/s.
-      Be carefull when filling the buffer from another timer. If the buffer overflows bad things happen. It is the responebility
-      of the sending timer to make sure that the buffer can't overflow!!!
-      Using the LSC::getInstance().println() function to send 1100B takes about 1.3ms. 
-      TLDR: Sending 1.1KB per OS tick (100ms) takes about 5.3 ms in cpu time.
+      uart buffer will never be full. The timer runs every 2282 * 128 / 84MHz = 3.48ms and hands at most 40B to the uart, which
+      take 3.47ms on the wire at 115200 baud. The uart therefore sends continuously and its own buffer never fills up: we can
+      send 11.5kB/s, i.e. 115B per OS tick (schedulerTick_ms). The uartBuffer holds 3450B, i.e. 300ms worth of data.
+      Be carefull when filling the buffer from another timer. If the buffer is full, print() waits for TC2_Handler, which
+      never happens if the caller has a higher priority than TC2 (e.g. the OS tick)!!!
       TLDR: As of now you are responsible to handle the buffer! there is no error handling for multithreaded applicatoins!!! 
+      Messages built with String + String allocate on the heap for every piece. LSC::printf() formats directly into the 
+      uartBuffer instead, without any String or heap allocation. It understands %d %i %u %x %X %c %s %f %e and %% with optional 
+      '-' / '0' flags, width, precision (e.g. "%5.1f", "%08x") and the l / ll length modifiers (e.g. "%lu" for uint32_t,
+      "%llu" for uint64_t). %e prints in the same format as the pressure display (1.23E-04).
+      TC2_Handler hands the data to the uart in contiguous blocks straight from the ring buffer, there is no intermediate copy.
     */
       //---- End Async UART explanation----
 
       //TODO: we need better error handling. there should be a watchdog and better hadling of buffer full conditions.
 
     //Sends a Sting using the uart. This function is asynchronous and non blocking. Data is being sent in the background. DONT OVERFLOW THE BUFFER!
-    void print(String data){ 
+    void print(const String& data){ 
+      print(data.c_str());
+    }
+    void print(const char* data){
       TC_Stop(TC0, 2);    //Stopping the uart send timer, to avoid reace conditions
-      bool bufferIsFull = false; //Temporary variable indicating wether the ring buffer is full or not
-
-      for(char character : data){ //we push char by char
-      //for(size_t i = 0; i<data.length();i++){ <= This is acctually slower by about 700us idk why XD
-        if (uartBuffer.isFull()){ //if the buffer is full we need to restart the urat send timer or the buffer would never get smaller
-          TC_Start(TC0, 2);
-          bufferIsFull = true;
-        } 
-        while (bufferIsFull){ // we wait for the uart timer to process the data.
-          if (!uartBuffer.isFull()){
-            bufferIsFull = false;
-            TC_Stop(TC0, 2); // once some data has been processed and there is room in the buffer we need to stopp the timer again.
-          } 
-        }
-        uartBuffer.push(character); //Pushing one char into the ring buffer
+      while(*data != '\0'){
+        pushToUartBuffer(*data++);
       }
       TC_Start(TC0, 2); //Once the write operation has concluded we can restart the send timer
     }
 
     //Sends a Sting using the uart. This function is asynchronous and non blocking. Data is being sent in the background
-    void println(String data){ 
-        print(data + '\n');
+    void println(const String& data){ 
+      println(data.c_str());
+    }
+    void println(const char* data){
+      TC_Stop(TC0, 2);
+      while(*data != '\0'){
+        pushToUartBuffer(*data++);
+      }
+      pushToUartBuffer('\n');
+      TC_Start(TC0, 2);
+    }
+
+    //Formats the arguments like printf() directly into the uart buffer, without allocating any memory. See Async UART explanation
+    //for the supported conversions. Asynchronous and non blocking like print().
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+      va_list arguments;
+      va_start(arguments, format);
+      TC_Stop(TC0, 2);
+      while(*format != '\0'){
+        if(*format != '%'){
+          pushToUartBuffer(*format++);
+          continue;
+        }
+        format++;
+        //flags, width and precision
+        bool leftAlign = false;
+        char padding = ' ';
+        while(*format == '-' || *format == '0'){
+          if(*format == '-') leftAlign = true;
+          else padding = '0';
+          format++;
+        }
+        uint8_t width = 0;
+        while(*format >= '0' && *format <= '9') width = width * 10 + (*format++ - '0');
+        int8_t precision = -1;
+        if(*format == '.'){
+          format++;
+          precision = 0;
+          while(*format >= '0' && *format <= '9') precision = precision * 10 + (*format++ - '0');
+        }
+        //length modifier: l (long, 32bit on the due) and ll (long long, 64bit)
+        uint8_t longs = 0;
+        while(*format == 'l'){
+          longs++;
+          format++;
+        }
+        //render the conversion into a small buffer first so we can pad it
+        char buffer[40];
+        const char* text = buffer;
+        size_t length = 0;
+        switch(*format){
+          case 'd':
+          case 'i':{
+            long long value = longs >= 2 ? va_arg(arguments, long long) : (longs == 1 ? va_arg(arguments, long) : va_arg(arguments, int));
+            length = formatInteger(buffer, value < 0 ? -(unsigned long long)value : (unsigned long long)value, 10, value < 0);
+            break;
+          }
+          case 'u':
+          case 'x':
+          case 'X':{
+            unsigned long long value = longs >= 2 ? va_arg(arguments, unsigned long long)
+                                                  : (longs == 1 ? va_arg(arguments, unsigned long) : va_arg(arguments, unsigned int));
+            length = formatInteger(buffer, value, *format == 'u' ? 10 : 16, false);
+            if(*format == 'X'){
+              for(size_t i = 0; i < length; i++){
+                if(buffer[i] >= 'a') buffer[i] -= 'a' - 'A';
+              }
+            }
+            break;
+          }
+          case 'c':
+            buffer[0] = (char)va_arg(arguments, int);
+            length = 1;
+            break;
+          case 's':
+            text = va_arg(arguments, const char*);
+            if(text == nullptr) text = "(null)";
+            length = strlen(text);
+            if(precision >= 0 && (size_t)precision < length) length = precision;
+            break;
+          case 'f':
+            length = formatFixed(buffer, va_arg(arguments, double), precision < 0 ? 6 : precision);
+            break;
+          case 'e':
+          case 'E':
+            length = formatScientific(buffer, va_arg(arguments, double), precision < 0 ? 2 : precision);
+            break;
+          case '%':
+            buffer[0] = '%';
+            length = 1;
+            break;
+          case '\0':
+            format--; //a single % at the end of the format string
+            break;
+          default:
+            buffer[0] = '%';
+            buffer[1] = *format;
+            length = 2;
+            break;
+        }
+        format++;
+        //zero padding goes after the sign
+        if(padding == '0' && !leftAlign && length > 0 && text == buffer && (buffer[0] == '-')){
+          pushToUartBuffer(*text++);
+          length--;
+          if(width > 0) width--;
+        }
+        for(size_t i = length; !leftAlign && i < width; i++) pushToUartBuffer(padding);
+        for(size_t i = 0; i < length; i++) pushToUartBuffer(text[i]);
+        for(size_t i = length; leftAlign && i < width; i++) pushToUartBuffer(' ');
+      }
+      TC_Start(TC0, 2);
+      va_end(arguments);
     }
 
+  private:
+    //Pushes one character into the uartBuffer. The uart send timer has to be stopped by the caller. If the buffer is full the
+    //timer is restarted until there is room again. See Async UART explanation
+    void pushToUartBuffer(char character){
+      if (uartBuffer.isFull()){ //if the buffer is full we need to restart the urat send timer or the buffer would never get smaller
+        TC_Start(TC0, 2);
+        while (uartBuffer.isFull()){} // we wait for the uart timer to process the data.
+        TC_Stop(TC0, 2); // once some data has been processed and there is room in the buffer we need to stopp the timer again.
+      }
+      uartBuffer.push(character); //Pushing one char into the ring buffer
+    }
+    //Writes value in the given base to out, returns the number of characters written (max 21)
+    static size_t formatInteger(char* out, uint64_t value, uint8_t base, bool negative){
+      char digits[20];
+      size_t count = 0;
+      //64bit divisions are library calls on the due, they are only used for the digits that do not fit into 32bit
+      while(value > UINT32_MAX){
+        uint8_t digit = value % base;
+        digits[count++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+      }
+      uint32_t low = (uint32_t)value;
+      do{
+        uint8_t digit = low % base;
+        digits[count++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        low /= base;
+      }while(low > 0);
+      size_t length = 0;
+      if(negative) out[length++] = '-';
+      while(count > 0) out[length++] = digits[--count];
+      return length;
+    }
+    //Writes value with the given number of decimals (max 9) to out, returns the number of characters written (max 21)
+    static size_t formatFixed(char* out, double value, uint8_t decimals){
+      if(value != value){
+        memcpy(out, "nan", 3);
+        return 3;
+      }
+      if(decimals > 9) decimals = 9;
+      size_t length = 0;
+      if(value < 0){
+        out[length++] = '-';
+        value = -value;
+      }
+      uint32_t scale = 1;
+      for(uint8_t i = 0; i < decimals; i++) scale *= 10;
+      value += 0.5 / scale;
+      if(value >= 4294967295.) return length + formatScientific(out + length, value, decimals);
+      uint32_t integerPart = (uint32_t)value;
+      uint32_t fraction = (uint32_t)((value - integerPart) * scale);
+      length += formatInteger(out + length, integerPart, 10, false);
+      if(decimals == 0) return length;
+      out[length++] = '.';
+      for(uint8_t i = decimals; i > 0; i--){
+        out[length + i - 1] = '0' + fraction % 10;
+        fraction /= 10;
+      }
+      return length + decimals;
+    }
+    //Writes value in scientific notation (1.23E-04) with the given number of decimals (max 9) to out, returns the number of
+    //characters written (max 16). Uses the power of ten table instead of log10/pow, see FAST MATH EXPLANATION
+    static size_t formatScientific(char* out, double value, uint8_t decimals){
+      if(value != value){
+        memcpy(out, "nan", 3);
+        return 3;
+      }
+      if(decimals > 8) decimals = 8;
+      size_t length = 0;
+      if(value < 0){
+        out[length++] = '-';
+        value = -value;
+      }
+      int exponent = value == 0 ? 0 : FastMath::exponentOfTen(value);
+      if(exponent <= FastMath::minPowerOfTen || exponent >= FastMath::maxPowerOfTen){
+        memcpy(out + length, "inf", 3);
+        return length + 3;
+      }
+      uint32_t scale = 1;
+      for(uint8_t i = 0; i < decimals; i++) scale *= 10;
+      //mantissa rounded to the requested decimals as integer, i.e. 1.234 -> 123 for two decimals
+      uint32_t mantissa = (uint32_t)(value * FastMath::powerOfTen(decimals - exponent) + 0.5);
+      if(mantissa >= 10 * scale){ //rounding up turned 9.995 into 10.00
+        mantissa /= 10;
+        exponent++;
+      }
+      out[length++] = '0' + mantissa / scale;
+      if(decimals > 0){
+        out[length++] = '.';
+        for(uint8_t i = decimals; i > 0; i--){
+          out[length + i - 1] = '0' + mantissa % 10;
+          mantissa /= 10;
+        }
+        length += decimals;
+      }
+      out[length++] = 'E';
+      out[length++] = exponent < 0 ? '-' : '+';
+      uint8_t absExponent = exponent < 0 ? -exponent : exponent;
+      out[length++] = '0' + absExponent / 10;
+      out[length++] = '0' + absExponent % 10;
+      return length;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -25,11 +25,142 @@
 namespace OS{
     bool watchdogRunning = false;
     bool bootUpFault = false;
+    bool tickStarted = false;
     uint32_t watchdogStartTime = 0;
     uint32_t cycleCount=0;
     uint32_t timekeeper = 0;
-    uint32_t lastOsCall = 0;    
     String version = "vX.X.X";
+    Profile componentProfiles[maxProfiledComponents];
+    Profile tickProfile = {"OS tick"};
+    volatile size_t numberOfProfiles = 0;
+
+    static_assert(maxScheduledComponents >= ComponentTracker::maxComponents, "The scheduler has to be able to hold every component the ComponentTracker accepts");
+
+    //A component in the timer wheel, see SCHEDULER EXPLANATION
+    struct Task{
+        BaseComponent* component;
+        Task* next;
+        uint16_t rounds;
+    };
+    Task tasks[maxScheduledComponents];
+    Task* timerWheel[timerWheelSlots];
+    size_t numberOfTasks = 0;
+    uint16_t currentSlot = 0;
+
+    //Puts a task into the slot the given number of ticks ahead of the current slot
+    void schedule(Task* task, uint32_t ticks){
+        if(ticks == 0) ticks = 1;
+        uint16_t slot = (currentSlot + ticks) % timerWheelSlots;
+        task->rounds = (ticks - 1) / timerWheelSlots;
+        task->next = timerWheel[slot];
+        timerWheel[slot] = task;
+    }
+
+    //Returns the period of a component in ticks, rounded up
+    uint32_t getPeriodInTicks(BaseComponent* component){
+        return (component->updatePeriod_ms + schedulerTick_ms - 1) / schedulerTick_ms;
+    }
+
+    //Adds all components that registered since the last tick to the timer wheel
+    void scheduleNewComponents(){
+        size_t numberOfComponents = ComponentTracker::getInstance().components.size();
+        while(numberOfTasks < numberOfComponents){
+            Task* task = &tasks[numberOfTasks];
+            task->component = ComponentTracker::getInstance().components[numberOfTasks];
+            componentProfiles[numberOfTasks].name = task->component->componentName;
+            schedule(task, getPeriodInTicks(task->component));
+            numberOfTasks++;
+            numberOfProfiles = numberOfTasks;
+        }
+    }
+
+    void Profile::record(uint32_t duration_us){
+        lastTime_us = duration_us;
+        if(numberOfCalls == 0 || duration_us < minTime_us) minTime_us = duration_us;
+        if(duration_us > maxTime_us) maxTime_us = duration_us;
+        if(numberOfCalls >= profileDecayAfter){
+            totalTime_us /= 2;
+            numberOfCalls /= 2;
+            for(uint8_t i = 0; i < profileHistogramBins; i++){
+                histogram[i] /= 2;
+            }
+        }
+        totalTime_us += duration_us;
+        numberOfCalls++;
+        //bin n holds all durations smaller than 2^n us
+        uint8_t bin = duration_us == 0 ? 0 : 32 - __builtin_clz(duration_us);
+        if(bin >= profileHistogramBins) bin = profileHistogramBins - 1;
+        histogram[bin]++;
+    }
+
+    void Profile::reset(){
+        lastTime_us = 0;
+        minTime_us = 0;
+        maxTime_us = 0;
+        totalTime_us = 0;
+        numberOfCalls = 0;
+        deadlineMisses = 0;
+        for(uint8_t i = 0; i < profileHistogramBins; i++){
+            histogram[i] = 0;
+        }
+    }
+
+    uint32_t Profile::getMean_us() const{
+        uint32_t calls = numberOfCalls;
+        if(calls == 0) return 0;
+        return totalTime_us / calls;
+    }
+
+    uint32_t Profile::getP99_us() const{
+        uint32_t total = 0;
+        for(uint8_t i = 0; i < profileHistogramBins; i++){
+            total += histogram[i];
+        }
+        if(total == 0) return 0;
+        //number of samples that are allowed to be above the p99 value
+        uint32_t above = total / 100;
+        uint32_t cumulative = 0;
+        for(uint8_t i = 0; i < profileHistogramBins; i++){
+            cumulative += histogram[i];
+            if(cumulative >= total - above){
+                if(i == profileHistogramBins - 1) return maxTime_us;
+                return (1u << i) - 1;
+            }
+        }
+        return maxTime_us;
+    }
+
+    size_t getNumberOfProfiles(){
+        return numberOfProfiles;
+    }
+
+    const Profile* getComponentProfile(size_t index){
+        if(index >= numberOfProfiles) return nullptr;
+        return &componentProfiles[index];
+    }
+
+    const Profile* getTickProfile(){
+        return &tickProfile;
+    }
+
+    void resetProfiles(){
+        for(size_t i = 0; i < maxProfiledComponents; i++){
+            componentProfiles[i].reset();
+        }
+        tickProfile.reset();
+    }
+
+    void printProfiles(){
+        LSC::getInstance().println("name: last/min/mean/p99/max [us] calls");
+        for(size_t i = 0; i <= numberOfProfiles; i++){
+            const Profile* profile = i < numberOfProfiles ? &componentProfiles[i] : &tickProfile;
+            LSC::getInstance().printf("%s: %lu/%lu/%lu/%lu/%lu %lu", profile->name, (unsigned long)profile->lastTime_us, (unsigned long)profile->minTime_us,
+                                        (unsigned long)profile->getMean_us(), (unsigned long)profile->getP99_us(), (unsigned long)profile->maxTime_us,
+                                        (unsigned long)profile->numberOfCalls);
+            if(profile->deadlineMisses > 0) LSC::getInstance().printf(" deadline misses: %lu", (unsigned long)profile->deadlineMisses);
+            LSC::getInstance().print("\n");
+        }
+    }
 
     void init(String Version = "vX.X.X"){
         version = Version;
@@ -37,12 +168,13 @@ namespace OS{
         pmc_set_writeprotect(false);
         pmc_enable_periph_clk(TC5_IRQn); 
         TC_Configure(TC1, 2, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK4); 
-        TC_SetRC(TC1, 2, 65620); 
+        TC_SetRC(TC1, 2, 6562); //(84MHz / 128) / 6562 = 10ms, see schedulerTick_ms
         TC1->TC_CHANNEL[2].TC_IER=TC_IER_CPCS;
         TC1->TC_CHANNEL[2].TC_IDR=~TC_IER_CPCS;
         NVIC_ClearPendingIRQ(TC5_IRQn);
         NVIC_EnableIRQ(TC5_IRQn);
         NVIC_SetPriority(TC5_IRQn, 4);
+        tickStarted = true;
         TC_Start(TC1, 2);  
         NVIC_SetPriority(SysTick_IRQn, 0); //delay, micros millis isr
 
@@ -82,9 +214,17 @@ namespace OS{
   
 
         BasePersistent::initComplete = true;
-        
+        PersistentTracker::getInstance().restore(); //one pass over the log, see PERSISTENT LOG EXPLANATION
+        if(!BasePersistent::initComplete){
+            //two Persistent with the same name, see CHANNELS in PERSISTENT LOG EXPLANATION
+            bootUpFault = true;
+            Serial.println("Persistent channel conflict, the persistence is not started");
+        }
         for(BasePersistent* basePersistent : *PersistentTracker::getInstance().getInstances()){
-            basePersistent->init();
+            //without a started persistence every init() fails, that has been reported above
+            if(basePersistent->init() && BasePersistent::initComplete){
+                Serial.println("The initial value of Persistent " + basePersistent->getFilename() + " could not be logged");
+            }
             
             Serial.println(String(reinterpret_cast<const char*>(basePersistent)));
             
@@ -94,6 +234,7 @@ namespace OS{
         for(auto &pair : ComponentTracker::getInstance().states){
             pair.second->readFromSD();
         }
+        ComponentTracker::getInstance().seal();
         if(bootUpFault) Serial.println("Bootup Failure");
         
         if (SD.exists("F")){
@@ -138,15 +279,83 @@ namespace OS{
 
     }
     uint32_t getNextOsCall_ms(){
-        return 100 - (millis() - lastOsCall);
+        //no tick can interrupt anything before init() has started the timer
+        if(!tickStarted) return UINT32_MAX;
+        uint32_t sinceLastTick_ms = (micros() - timekeeper) / 1000;
+        return sinceLastTick_ms < schedulerTick_ms ? schedulerTick_ms - sinceLastTick_ms : 0;
     }
     bool saveToRead(){
-        if(getNextOsCall_ms() < 10){
-            return false;
-        }else{
-            return true;
+        return (ComponentTracker::getInstance().tickSequence & 1) == 0;
+    }
+    //Executes one OS cycle: updates all components that are due (see SCHEDULER EXPLANATION) and checks the watchdog.
+    //Called by TC5_Handler every schedulerTick_ms. The function does not touch any timer registers, which allows
+    //the OS cycle to be driven by something other than the hardware timer (e.g. a simulated clock on a host).
+    void tick(){
+        cycleCount = micros() - timekeeper;
+        timekeeper = micros();
+        uint32_t start = timekeeper;
+        ComponentTracker::getInstance().tickSequence++; //odd: readers in the scene loop retry, see SAVE READ WRITE EXPLANATION
+
+        scheduleNewComponents();
+        currentSlot = (currentSlot + 1) % timerWheelSlots;
+        Task* task = timerWheel[currentSlot];
+        timerWheel[currentSlot] = nullptr;
+        while(task != nullptr){
+            Task* next = task->next;
+            if(task->rounds > 0){
+                //not due in this turn of the wheel, stays in the current slot
+                task->rounds--;
+                task->next = timerWheel[currentSlot];
+                timerWheel[currentSlot] = task;
+            }else{
+                size_t index = task - tasks;
+                uint32_t componentStart = micros();
+                task->component->update();
+                uint32_t end = micros();
+                componentProfiles[index].record(end - componentStart);
+                //the component was released at the start of the tick
+                if(end - start > task->component->updateDeadline_ms * 1000) componentProfiles[index].deadlineMisses++;
+                schedule(task, getPeriodInTicks(task->component));
+            }
+            task = next;
+        }
+        ComponentTracker::getInstance().tickSequence++;
+        tickProfile.record(micros() - start);
+    
+        if (watchdogRunning){
+            if(millis() - watchdogStartTime > 5000){
+                Serial.println("Detected a timeout, restarting the system!");
+                for(int i = 0; i< 4200000;i ++){asm("NOP");}
+                //NVIC_SystemReset();
+                __BKPT(0);
+            }
+        }
+
+    
+       // Serial.println(micros()-start);
+       /*
+        if(Serial.find('@')){
+            Serial.println(version);
+            auto file = SD.open("/");
+                            while(true){
+                                auto entry = file.openNextFile();
+                                if(!entry) break;
+                                const char* name = entry.name();
+                                if(entry.isDirectory()){
+                                    entry.close();
+                                    SD.rmdir(name);
+                                }else{
+                                    entry.close();
+                                    SD.remove(name);
+                                }
+                            }
+                            Serial.println("purged");
+                            Serial.flush();
+                            NVIC_SystemReset();
         }
+       */
     }
+
     
 }
 
@@ -174,52 +383,9 @@ namespace OS{
 
 void SUPC_Handler(void) {
     OS::powerFailureImminent = true;
-    PersistentTracker::getInstance().powerFailureImminent = true;        
+    PersistentTracker::getInstance().onPowerFailure();
 }
 void TC5_Handler(){
     TC_GetStatus(TC1, 2);
-    OS::cycleCount = micros() - OS::timekeeper;
-    OS::timekeeper = micros();
-
-    //Serial.println("now");
-    ComponentTracker::getInstance().lastOsCall = millis();
-    int start = micros();
-    for(BaseComponent* comp : ComponentTracker::getInstance().getComponets()){
-        comp->update();
-    }
-    
-    if (OS::watchdogRunning){
-        if(millis() - OS::watchdogStartTime > 5000){
-            Serial.println("Detected a timeout, restarting the system!");
-            for(int i = 0; i< 4200000;i ++){asm("NOP");}
-            //NVIC_SystemReset();
-            __asm volatile ("BKPT #0");
-        }
-    }
-
-    
-   // Serial.println(micros()-start);
-   /*
-    if(Serial.find('@')){
-        Serial.println(OS::version);
-        auto file = SD.open("/");
-                        while(true){
-                            auto entry = file.openNextFile();
-                            if(!entry) break;
-                            const char* name = entry.name();
-                            if(entry.isDirectory()){
-                                entry.close();
-                                SD.rmdir(name);
-                            }else{
-                                entry.close();
-                                SD.remove(name);
-                            }
-                        }
-                        Serial.println("purged");
-                        Serial.flush();
-                        NVIC_SystemReset();
-    }
-   */
-
-    
+    OS::tick();
 }
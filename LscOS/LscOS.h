@@ -39,13 +39,80 @@ RECOURCES:  TODO
 
 
 namespace OS{
+  //---- SCHEDULER EXPLANATION ----
+  /*
+    TC5 calls OS::tick() every schedulerTick_ms. Every component declares how often its update() has to run
+    (BaseComponent::updatePeriod_ms) and how long it may take from its release until update() returns (updateDeadline_ms).
+    E.g. a GateValve reads its feedback every 10ms while a TemperatureSensor only needs an update every second.
+    The updates run to completion inside the tick (no preemption, no stacks per task, see CoolContextSwitchinCodeThatDoesNotWork.h).
+    To find the due components without looking at all of them every tick, the components are kept in a hashed timer wheel:
+    timerWheelSlots linked lists, one per tick. A component that is due in n ticks is put into the slot n ticks ahead of the
+    current one, with the number of full turns of the wheel it has to wait (rounds) if n is larger than the wheel.
+    A tick only visits the one slot of the current time. A component that is updated is immediately put back into the wheel
+    one period ahead, so periods are kept exactly in ticks and do not drift.
+    Periods are rounded up to a multiple of schedulerTick_ms. Components are picked up by the scheduler on the first tick after
+    their registration, all components with the same period are released in the same tick (in the same phase as before).
+    If an update misses its deadline, deadlineMisses of its Profile is incremented.
+    The scene loop reads component states with saveRead(), see SAVE READ WRITE EXPLANATION in LscComponents.h.
+  */
+  //---- END SCHEDULER EXPLANATION ----
+  constexpr uint32_t schedulerTick_ms = 10;
+  constexpr uint16_t timerWheelSlots = 64;
+  constexpr size_t maxScheduledComponents = 32;
+
+  //---- PROFILER EXPLANATION ----
+  /*
+    Every OS tick measures how long each component's update() takes and how long the whole tick takes.
+    The results are kept in one Profile per registered component (in registration order) plus one for the tick.
+    A Profile only holds fixed size 32bit counters that are written exclusively by the OS tick. This means they can
+    be read from the scene loop without any locking. A read might be one tick out of date, but a single counter is never torn.
+    For the p99 estimate every measurement is sorted into a power of two histogram (bin n holds durations < 2^n us).
+    Once a Profile has seen profileDecayAfter calls, all sums and bins are halved, so old measurements fade out and
+    nothing can overflow. Min and max are kept until resetProfiles() is called.
+  */
+  //---- END PROFILER EXPLANATION ----
+  constexpr size_t maxProfiledComponents = maxScheduledComponents;
+  constexpr uint8_t profileHistogramBins = 16;
+  constexpr uint32_t profileDecayAfter = 32768;
+
+  struct Profile{
+    const char* volatile name;
+    volatile uint32_t lastTime_us;
+    volatile uint32_t minTime_us;
+    volatile uint32_t maxTime_us;
+    volatile uint32_t totalTime_us;
+    volatile uint32_t numberOfCalls;
+    volatile uint16_t histogram[profileHistogramBins];
+    volatile uint32_t deadlineMisses;
+
+    void record(uint32_t duration_us);
+    void reset();
+    //Returns the mean execution time in us
+    uint32_t getMean_us() const;
+    //Returns an upper bound for the 99th percentile of the execution time in us
+    uint32_t getP99_us() const;
+  };
+
   bool getBootUpState();
   void init(String Version);
   void startWatchdog();
   void stopWatchdog();
   uint32_t getCycleCount();
-  uint32_t getNextOsCall_ms();
-  bool saveToRead();
+  //Deprecated: returns the time in ms until the next OS tick, UINT32_MAX before init(). Reads no longer have to wait for a
+  //gap between the ticks, use saveRead() / saveReadBlock() (see SAVE READ WRITE EXPLANATION in LscComponents.h)
+  __attribute__((deprecated("use saveRead(), see SAVE READ WRITE EXPLANATION"))) uint32_t getNextOsCall_ms();
+  //Deprecated: returns false while the OS tick runs, true otherwise. Code outside of the tick can always read
+  __attribute__((deprecated("use saveRead(), see SAVE READ WRITE EXPLANATION"))) bool saveToRead();
+  void tick();
+  //Returns the number of components that have a valid Profile
+  size_t getNumberOfProfiles();
+  //Returns the Profile of the component with the given registration index, nullptr if the index is out of range
+  const Profile* getComponentProfile(size_t index);
+  //Returns the Profile of the whole OS tick
+  const Profile* getTickProfile();
+  void resetProfiles();
+  //Sends a table of all Profiles over the async UART (see LSC::print)
+  void printProfiles();
   static volatile bool powerFailureImminent = false;
 
 }
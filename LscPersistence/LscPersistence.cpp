@@ -21,4 +21,1161 @@
 #include "LscPersistence.h"
 
 volatile bool BasePersistent::initComplete = false;
-volatile bool PersistentTracker::powerFailureImminent = false;
\ No newline at end of file
+volatile bool PersistentTracker::powerFailureImminent = false;
+RollupPool::Slot RollupPool::slots[RollupPool::maxChannels] = {};
+size_t RollupPool::used = 0;
+static const char* const dumpName = "PDUMP.BIN";
+
+BasePersistent* PersistentTracker::findChannel(uint16_t channel){
+    //instances without a channel yet have the checkpointChannel
+    if(channel == PersistentLog::checkpointChannel) return nullptr;
+    for(BasePersistent* basePersistent : tracker){
+        if(basePersistent->channel == channel) return basePersistent;
+    }
+    return nullptr;
+}
+
+bool PersistentTracker::restore(){
+    channelConflict = false;
+    for(BasePersistent* basePersistent : tracker) hasUniqueName(basePersistent);
+    SdAccess access;
+    bool failed = !channelConflict && (log.restore() || minuteLog.restore() || hourLog.restore());
+    if(channelConflict){
+        //the persistence does not start, see CHANNELS in PERSISTENT LOG EXPLANATION
+        BasePersistent::initComplete = false;
+        return true;
+    }
+    if(failed) return true;
+    //the dump continues the sequence of the log as it was at the power failure, i.e. without the NAME records of new channels
+    bool dumpFailed = restoreDump();
+    return createChannels(nullptr) || dumpFailed;
+}
+
+bool PersistentTracker::restore(BasePersistent* instance){
+    channelConflict = false;
+    if(!hasUniqueName(instance)) return true;
+    SdAccess access;
+    if(instance->log->restore(instance)) return true;
+    return createChannels(instance);
+}
+
+void PersistentTracker::reportConflict(const String& message){
+    channelConflict = true;
+    ErrorHandler::getInstance().throwError(0x0, message, SeverityLevel::FATAL);
+}
+
+//Two instances with the same name would write to the same channel, see CHANNELS in PERSISTENT LOG EXPLANATION
+bool PersistentTracker::hasUniqueName(BasePersistent* instance){
+    if(instance->filename.length() > UINT8_MAX){
+        reportConflict("The name of Persistent " + instance->filename + " is longer than " + String(UINT8_MAX) + " characters");
+        return false;
+    }
+    for(BasePersistent* basePersistent : tracker){
+        //reported once for every pair
+        if(basePersistent == instance) break;
+        if(basePersistent->filename == instance->filename){
+            reportConflict("There are two Persistent with the name " + instance->filename);
+            return false;
+        }
+    }
+    return true;
+}
+
+//Binds the instance with the name of a NAME record to the channel of the record
+void PersistentTracker::bindChannel(PersistentLog* owningLog, uint16_t channel, const uint8_t* name, uint8_t length){
+    if(channel >= nextChannel) nextChannel = channel + 1;
+    for(BasePersistent* basePersistent : tracker){
+        bool sameName = basePersistent->filename.length() == length && memcmp(basePersistent->filename.c_str(), name, length) == 0;
+        if(sameName && basePersistent->log == owningLog){
+            if(basePersistent->channel == PersistentLog::checkpointChannel) basePersistent->channel = channel;
+            else if(basePersistent->channel != channel) reportConflict("The log holds two channels for Persistent " + basePersistent->filename);
+        }else if(!sameName && basePersistent->channel == channel){
+            reportConflict("The log holds channel " + String(channel) + " of Persistent " + basePersistent->filename + " for another name");
+        }
+    }
+}
+
+//Gives the instances without a channel the next unused numbers in registration order and records them in their logs
+bool PersistentTracker::createChannels(BasePersistent* only){
+    bool failed = false;
+    for(BasePersistent* basePersistent : tracker){
+        if(basePersistent->channel != PersistentLog::checkpointChannel || (only != nullptr && basePersistent != only)) continue;
+        if(nextChannel == PersistentLog::noChannel){
+            ErrorHandler::getInstance().throwError(0x0, "No log channel left for Persistent " + basePersistent->filename, SeverityLevel::NORMAL);
+            return true;
+        }
+        basePersistent->channel = nextChannel++;
+        if(basePersistent->log->writeName(basePersistent)){
+            failed = true;
+        }else if(basePersistent->log == &log && importFormerFiles(basePersistent)){
+            ErrorHandler::getInstance().throwError(0x0, "Could not import the files of Persistent " + basePersistent->filename, SeverityLevel::NORMAL);
+            failed = true;
+        }
+    }
+    return log.flush() || minuteLog.flush() || hourLog.flush() || failed;
+}
+
+//Appends the values of the files of the one file per Persistent format to the log and removes the files, see FORMER FILES in
+//PERSISTENT LOG EXPLANATION. Returns true on failure, the files are kept then.
+bool PersistentTracker::importFormerFiles(BasePersistent* owner){
+    String names[2] = {owner->filename, owner->filename + "_2"};
+    uint32_t sizes[2] = {0, 0};
+    bool exists[2];
+    for(uint8_t i = 0; i < 2; i++){
+        exists[i] = SD.exists(names[i]);
+        if(!exists[i]) continue;
+        File file = SD.open(names[i], FILE_READ);
+        statistics.opens++;
+        if(!file) return true;
+        sizes[i] = file.size();
+        file.close();
+        statistics.closes++;
+    }
+    if(!exists[0] && !exists[1]) return false;
+    //the bank that was written last is the smaller one, see the former Persistent<T>::init()
+    uint8_t older = sizes[1] < sizes[0] ? 0 : 1;
+    uint8_t size = owner->getObjectSize();
+    size_t valuesPerRead = PersistentLog::blockSize / size < maxFrameValues ? PersistentLog::blockSize / size : maxFrameValues;
+    uint8_t buffer[PersistentLog::blockSize];
+    FrameValue values[maxFrameValues];
+    for(uint8_t bank : {older, (uint8_t)(1 - older)}){
+        if(sizes[bank] < size) continue;
+        File file = SD.open(names[bank], FILE_READ);
+        statistics.opens++;
+        if(!file) return true;
+        uint32_t remaining = sizes[bank] / size;
+        bool failed = false;
+        while(remaining > 0 && !failed){
+            size_t count = remaining < valuesPerRead ? remaining : valuesPerRead;
+            statistics.reads++;
+            if(file.read(buffer, count * size) != (int)(count * size)) break;
+            for(size_t i = 0; i < count; i++) values[i] = {0, buffer + i * size};
+            size_t appended = owner->log->append(owner, values, count);
+            statistics.records += appended;
+            failed = appended < count;
+            remaining -= count;
+        }
+        file.close();
+        statistics.closes++;
+        if(failed) return true;
+    }
+    owner->totalEntries = owner->committedEntries + owner->stagedRecords;
+    if(owner->log->flush()) return true;
+    for(uint8_t i = 0; i < 2; i++){
+        if(!exists[i]) continue;
+        SD.remove(names[i]);
+        statistics.removes++;
+    }
+    return false;
+}
+
+bool PersistentTracker::stage(BasePersistent* owner, const void* data, uint16_t size){
+    if(sizeof(StagedRecord) + size > stagingBufferSize){
+        statistics.droppedRecords++;
+        return true;
+    }
+    //an interrupt can not commit (see commit()), a full buffer in an interrupt drops the record
+    if(stagedBytes + sizeof(StagedRecord) + size > stagingBufferSize) commit();
+    bool dropped = true;
+    noInterrupts();
+    if(stagedBytes + sizeof(StagedRecord) + size <= stagingBufferSize){
+        StagedRecord record = {owner, (uint32_t)millis(), size};
+        memcpy(stagingBuffer + stagedBytes, &record, sizeof(StagedRecord));
+        memcpy(stagingBuffer + stagedBytes + sizeof(StagedRecord), data, size);
+        stagedBytes += sizeof(StagedRecord) + size;
+        owner->stagedRecords++;
+        dropped = false;
+    }
+    interrupts();
+    if(dropped){
+        //the SD card is in use and the buffer could not be committed
+        statistics.droppedRecords++;
+        return true;
+    }
+    if(powerFailureImminent){
+        if(__get_IPSR() != 0) dumpFromInterrupt();
+        else commit();
+    }else if(stagedBytes > stagingBufferSize / 2){
+        //the next service() commits before the buffer runs full
+        commitRequested = true;
+    }
+    return false;
+}
+
+void PersistentTracker::commit(){
+    if(__get_IPSR() != 0){
+        //the scene loop may be in the middle of an SD or display transfer, service() or the end of an SdAccess commits
+        commitRequested = true;
+        return;
+    }
+    sdBusy++;
+    do{
+        commitRequested = false;
+        if(powerFailureImminent) dump();
+        else writeStagedRecords();
+    }while(commitRequested);
+    lastCommit = millis();
+    sdBusy--;
+}
+
+void PersistentTracker::service(){
+    if(commitRequested || millis() - lastCommit >= commitIntervall_ms) commit();
+}
+
+void PersistentTracker::onPowerFailure(){
+    powerFailureImminent = true;
+    dumpFromInterrupt();
+}
+
+//The only SD access from an interrupt, see POWER FAILURE DUMP EXPLANATION
+void PersistentTracker::dumpFromInterrupt(){
+    commitRequested = true;
+    //the scene loop is in the middle of an SD transfer
+    if(sdBusy > 0 || digitalRead(sdCardChipSelectPin) == LOW) return;
+    //the screen does not matter anymore, the display transfer we interrupt goes nowhere
+    if(digitalRead(displayChipSelectPin) == LOW) digitalWrite(displayChipSelectPin, HIGH);
+    sdBusy++;
+    commitRequested = false;
+    dump();
+    sdBusy--;
+}
+
+void PersistentTracker::writeStagedRecords(){
+    //records staged by an interrupt while we write are behind end and stay in the buffer
+    size_t end = stagedBytes;
+    if(end == 0) return;
+    statistics.commits++;
+    //all records of an owner are appended at once so they share FRAME records, see COMPRESSION EXPLANATION
+    //an appended record keeps its place in the buffer with owner = nullptr, a power failure leaves the rest to dump()
+    size_t position = 0;
+    while(position < end && !powerFailureImminent){
+        StagedRecord record;
+        memcpy(&record, stagingBuffer + position, sizeof(StagedRecord));
+        BasePersistent* owner = record.owner;
+        size_t scanPosition = position;
+        while(owner != nullptr && scanPosition < end){
+            FrameValue values[maxFrameValues];
+            size_t count = 0;
+            while(scanPosition < end && count < maxFrameValues){
+                StagedRecord other;
+                memcpy(&other, stagingBuffer + scanPosition, sizeof(StagedRecord));
+                if(other.owner == owner){
+                    values[count++] = {other.timestamp, stagingBuffer + scanPosition + sizeof(StagedRecord)};
+                    other.owner = nullptr;
+                    memcpy(stagingBuffer + scanPosition, &other, sizeof(StagedRecord));
+                }
+                scanPosition += sizeof(StagedRecord) + other.size;
+            }
+            size_t appended = owner->log->append(owner, values, count);
+            statistics.droppedRecords += count - appended;
+            statistics.records += appended;
+            //the OS tick stages records of the owner in between, the read-modify-writes must not lose its increments
+            noInterrupts();
+            owner->stagedRecords -= count;
+            //lost records, the following records of the owner take their numbers
+            owner->totalEntries -= count - appended;
+            interrupts();
+        }
+        position += sizeof(StagedRecord) + record.size;
+    }
+    log.flush();
+    minuteLog.flush();
+    hourLog.flush();
+    noInterrupts();
+    size_t kept = 0;
+    for(position = 0; position < end;){
+        StagedRecord record;
+        memcpy(&record, stagingBuffer + position, sizeof(StagedRecord));
+        size_t length = sizeof(StagedRecord) + record.size;
+        if(record.owner != nullptr){
+            memmove(stagingBuffer + kept, stagingBuffer + position, length);
+            kept += length;
+        }
+        position += length;
+    }
+    memmove(stagingBuffer + kept, stagingBuffer + end, stagedBytes - end);
+    stagedBytes -= end - kept;
+    interrupts();
+}
+
+//Writes the staged records to the dump region with one multi block write, see POWER FAILURE DUMP EXPLANATION
+void PersistentTracker::dump(){
+    if(!dumpReady) return;
+    unsigned long start = micros();
+    //records staged by an interrupt while we write are dumped by the next dump()
+    size_t end = stagedBytes;
+    uint16_t numberOfRecords = 0;
+    for(size_t position = 0; position < end;){
+        StagedRecord record;
+        memcpy(&record, stagingBuffer + position, sizeof(StagedRecord));
+        //records already appended by an interrupted commit have no owner
+        if(record.owner != nullptr) numberOfRecords++;
+        position += sizeof(StagedRecord) + record.size;
+    }
+    //a multiple block write of a file may be open, its next block fails
+    if(!SdVolume::streamStop() || !SD.card.writeStart(dumpFirstBlock, dumpBlocks)) return;
+    uint8_t block[PersistentLog::blockSize];
+    uint32_t blockPosition = 0;
+    uint16_t sequence = 0;
+    bool failed = false;
+    auto writeBlock = [&](){
+        memset(block + blockPosition, 0xFF, PersistentLog::blockSize - blockPosition);
+        if(!SD.card.writeData(block)) failed = true;
+        statistics.writes++;
+        blockPosition = 0;
+    };
+    auto putRecord = [&](LogRecordHeader header, const void* payload){
+        if(blockPosition + sizeof(LogRecordHeader) + header.size > PersistentLog::blockSize) writeBlock();
+        header.sequence = sequence++;
+        header.crc = 0;
+        memcpy(block + blockPosition, &header, sizeof(LogRecordHeader));
+        memcpy(block + blockPosition + sizeof(LogRecordHeader), payload, header.size);
+        header.crc = PersistentLog::getCrc(block + blockPosition);
+        memcpy(block + blockPosition, &header, sizeof(LogRecordHeader));
+        blockPosition += sizeof(LogRecordHeader) + header.size;
+    };
+    DumpMarker marker = {{log.getSequence(), minuteLog.getSequence(), hourLog.getSequence()}, numberOfRecords};
+    putRecord({PersistentLog::checkpointChannel, LogRecordType::DUMP, sizeof(DumpMarker), (uint32_t)millis()}, &marker);
+    for(size_t position = 0; position < end && !failed;){
+        StagedRecord record;
+        memcpy(&record, stagingBuffer + position, sizeof(StagedRecord));
+        if(record.owner != nullptr) putRecord({record.owner->channel, LogRecordType::VALUE, (uint8_t)record.size, record.timestamp}, stagingBuffer + position + sizeof(StagedRecord));
+        position += sizeof(StagedRecord) + record.size;
+    }
+    if(!failed) writeBlock();
+    SD.card.writeStop();
+    if(failed) return;
+    statistics.dumps++;
+    unsigned long duration = micros() - start;
+    if(duration > statistics.maxDumpTime_us) statistics.maxDumpTime_us = duration;
+}
+
+//Appends the dump of the last power failure to the log and prepares the dump region for the next one, returns true on failure
+bool PersistentTracker::restoreDump(){
+    SdFile file;
+    uint32_t lastBlock;
+    if(!file.open(&SD.root, dumpName, O_READ) || !file.contiguousRange(&dumpFirstBlock, &lastBlock) || lastBlock + 1 - dumpFirstBlock < dumpBlocks){
+        file.close();
+        SD.remove(dumpName);
+        if(!file.createContiguous(&SD.root, dumpName, dumpBlocks * PersistentLog::blockSize) || !file.contiguousRange(&dumpFirstBlock, &lastBlock)){
+            file.close();
+            ErrorHandler::getInstance().throwError(0x0, "Could not create the power failure dump " + String(dumpName), SeverityLevel::NORMAL);
+            return true;
+        }
+        file.close();
+        return eraseDump();
+    }
+    file.close();
+    uint8_t block[PersistentLog::blockSize];
+    bool markerFound = false;
+    bool valid = true;
+    DumpMarker marker;
+    PersistentLog* logs[] = {&log, &minuteLog, &hourLog};
+    //a log written since the dump has got its records already
+    bool pending[3] = {false, false, false};
+    uint16_t expectedSequence = 0;
+    uint16_t records = 0;
+    for(uint32_t i = 0; i < dumpBlocks && valid; i++){
+        //the records appended so far may have left a multiple block write open
+        if(!SdVolume::streamStop() || !SD.card.readBlock(dumpFirstBlock + i, block)) break;
+        statistics.reads++;
+        uint32_t offset = 0;
+        while(valid && offset + sizeof(LogRecordHeader) <= PersistentLog::blockSize){
+            LogRecordHeader header;
+            memcpy(&header, block + offset, sizeof(LogRecordHeader));
+            if(header.channel == PersistentLog::noChannel) break;
+            const uint8_t* payload = block + offset + sizeof(LogRecordHeader);
+            valid = offset + sizeof(LogRecordHeader) + header.size <= PersistentLog::blockSize
+                    && header.crc == PersistentLog::getCrc(block + offset)
+                    && header.sequence == expectedSequence;
+            if(!valid) break;
+            if(!markerFound){
+                markerFound = header.type == LogRecordType::DUMP && header.size == sizeof(DumpMarker);
+                if(markerFound){
+                    memcpy(&marker, payload, sizeof(DumpMarker));
+                    for(uint8_t j = 0; j < 3; j++) pending[j] = marker.logSequences[j] == logs[j]->getSequence();
+                }
+                //a dump that has been applied already or does not belong to these logs
+                valid = markerFound && (pending[0] || pending[1] || pending[2]);
+            }else{
+                BasePersistent* owner = findChannel(header.channel);
+                bool logPending = false;
+                for(uint8_t j = 0; j < 3 && owner != nullptr; j++) logPending |= owner->log == logs[j] && pending[j];
+                if(logPending && header.type == LogRecordType::VALUE && header.size == owner->getObjectSize()){
+                    FrameValue value = {header.timestamp, payload};
+                    if(owner->log->append(owner, &value, 1) == 0){
+                        statistics.droppedRecords++;
+                    }else{
+                        owner->totalEntries++;
+                        statistics.records++;
+                    }
+                }
+                valid = ++records < marker.numberOfRecords;
+            }
+            expectedSequence++;
+            offset += sizeof(LogRecordHeader) + header.size;
+        }
+    }
+    if(!markerFound){
+        dumpReady = true;
+        return false;
+    }
+    if(records > 0 && (log.flush() || minuteLog.flush() || hourLog.flush())) return true;
+    return eraseDump();
+}
+
+//Erases the dump region, if the card can not erase single blocks the marker block is overwritten
+bool PersistentTracker::eraseDump(){
+    if(!SD.card.erase(dumpFirstBlock, dumpFirstBlock + dumpBlocks - 1)){
+        uint8_t block[PersistentLog::blockSize];
+        memset(block, 0xFF, sizeof(block));
+        if(!SD.card.writeBlock(dumpFirstBlock, block)){
+            ErrorHandler::getInstance().throwError(0x0, "Could not erase the power failure dump " + String(dumpName), SeverityLevel::NORMAL);
+            return true;
+        }
+        statistics.writes++;
+    }
+    dumpReady = true;
+    return false;
+}
+
+//Returns the open file with the given name, opens it if necessary. Returns nullptr if the file can not be opened.
+File* PersistentTracker::getOpenFile(const String& name, bool writable){
+    OpenFile* leastRecentlyUsed = &openFiles[0];
+    for(OpenFile& openFile : openFiles){
+        if(openFile.name[0] != 0 && strcmp(openFile.name, name.c_str()) == 0){
+            if(writable && !openFile.writable){
+                //reopened for writing below
+                leastRecentlyUsed = &openFile;
+                break;
+            }
+            openFile.lastUse = ++useCounter;
+            return &openFile.file;
+        }
+        if(openFile.name[0] == 0 || (leastRecentlyUsed->name[0] != 0 && openFile.lastUse < leastRecentlyUsed->lastUse)){
+            leastRecentlyUsed = &openFile;
+        }
+    }
+    if(leastRecentlyUsed->name[0] != 0){
+        leastRecentlyUsed->file.close();
+        leastRecentlyUsed->name[0] = 0;
+        statistics.closes++;
+    }
+    leastRecentlyUsed->file = SD.open(name, writable ? FILE_WRITE : FILE_READ);
+    statistics.opens++;
+    if(!leastRecentlyUsed->file) return nullptr;
+    //without the block buffer appends go through the SD cache, which is slower but works as well
+    if(writable) leastRecentlyUsed->file.setSequentialAppend();
+    strncpy(leastRecentlyUsed->name, name.c_str(), sizeof(leastRecentlyUsed->name) - 1);
+    leastRecentlyUsed->name[sizeof(leastRecentlyUsed->name) - 1] = 0;
+    leastRecentlyUsed->writable = writable;
+    leastRecentlyUsed->lastUse = ++useCounter;
+    return &leastRecentlyUsed->file;
+}
+
+void PersistentTracker::closeFile(const String& name){
+    for(OpenFile& openFile : openFiles){
+        if(openFile.name[0] != 0 && strcmp(openFile.name, name.c_str()) == 0){
+            openFile.file.close();
+            openFile.name[0] = 0;
+            statistics.closes++;
+        }
+    }
+}
+
+void PersistentTracker::closeAllFiles(){
+    SdAccess access;
+    for(OpenFile& openFile : openFiles){
+        if(openFile.name[0] != 0){
+            openFile.file.close();
+            openFile.name[0] = 0;
+            statistics.closes++;
+        }
+    }
+}
+
+String PersistentTracker::getIoStatisticsString(){
+    String statisticsString = "";
+    statisticsString += "records: " + String(statistics.records) + "\n";
+    statisticsString += "droppedRecords: " + String(statistics.droppedRecords) + "\n";
+    statisticsString += "commits: " + String(statistics.commits) + "\n";
+    statisticsString += "opens: " + String(statistics.opens) + "\n";
+    statisticsString += "closes: " + String(statistics.closes) + "\n";
+    statisticsString += "writes: " + String(statistics.writes) + "\n";
+    statisticsString += "bytes: " + String(statistics.bytes) + "\n";
+    statisticsString += "flushes: " + String(statistics.flushes) + "\n";
+    statisticsString += "removes: " + String(statistics.removes) + "\n";
+    statisticsString += "reads: " + String(statistics.reads) + "\n";
+    statisticsString += "cacheHits: " + String(statistics.cacheHits) + "\n";
+    statisticsString += "dumps: " + String(statistics.dumps) + "\n";
+    statisticsString += "maxDumpTime_us: " + String(statistics.maxDumpTime_us) + "\n";
+    statisticsString += "operationsPerRecord: " + String(statistics.getOperationsPerRecord()) + "\n";
+    return statisticsString;
+}
+
+String PersistentLog::getSegmentName(uint32_t number){
+    return String(prefix) + String(number % numberOfSegments) + ".BIN";
+}
+
+//Returns the file of a segment, the active segment is opened for writing
+File* PersistentLog::getSegment(uint32_t number){
+    return PersistentTracker::getInstance().getOpenFile(getSegmentName(number), number == segmentNumber);
+}
+
+uint32_t PersistentLog::getSegmentSize(uint32_t number){
+    if(number == segmentNumber) return writePosition;
+    File* file = getSegment(number);
+    return file != nullptr ? file->size() : 0;
+}
+
+bool PersistentLog::write(const void* data, uint32_t size){
+    File* file = getSegment(segmentNumber);
+    if(file == nullptr) return true;
+    PersistentTracker::getInstance().statistics.writes++;
+    unflushed = true;
+    PersistentTracker::getInstance().statistics.bytes += size;
+    if(file->write(reinterpret_cast<const uint8_t*>(data), size) != size) return true;
+    writePosition += size;
+    return false;
+}
+
+//Fills the rest of the current block with 0xFF
+bool PersistentLog::pad(){
+    static const uint8_t fill[32] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    while(writePosition % blockSize != 0){
+        uint32_t size = blockSize - writePosition % blockSize;
+        if(size > sizeof(fill)) size = sizeof(fill);
+        if(write(fill, size)) return true;
+    }
+    return false;
+}
+
+uint16_t PersistentLog::getCrc(const uint8_t* record){
+    static const uint16_t table[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+                                       0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+    LogRecordHeader header;
+    memcpy(&header, record, sizeof(LogRecordHeader));
+    header.crc = 0;
+    uint16_t crc = 0xFFFF;
+    for(uint32_t i = 0; i < sizeof(LogRecordHeader) + header.size; i++){
+        uint8_t byte = i < sizeof(LogRecordHeader) ? reinterpret_cast<const uint8_t*>(&header)[i] : record[i];
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (byte >> 4)];
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (byte & 0x0F)];
+    }
+    return crc;
+}
+
+//Bit stream of a FRAME record, the bits are written most significant first, see COMPRESSION EXPLANATION
+class FrameBits{
+    public:
+        uint8_t* buffer;
+        uint32_t capacity_bits;
+        uint32_t position;
+        bool overflow;
+        FrameBits(uint8_t* Buffer, uint32_t Capacity_bits, uint32_t Position = 0)
+            :   buffer(Buffer),
+                capacity_bits(Capacity_bits),
+                position(Position),
+                overflow(false)
+            {
+        }
+        void write(uint64_t value, uint8_t bits){
+            for(int8_t i = bits - 1; i >= 0; i--){
+                if(position >= capacity_bits){
+                    overflow = true;
+                    return;
+                }
+                uint8_t mask = 0x80 >> (position % 8);
+                if((value >> i) & 1) buffer[position / 8] |= mask;
+                else buffer[position / 8] &= ~mask;
+                position++;
+            }
+        }
+        uint64_t read(uint8_t bits){
+            uint64_t value = 0;
+            for(uint8_t i = 0; i < bits; i++){
+                if(position >= capacity_bits){
+                    overflow = true;
+                    return 0;
+                }
+                value = (value << 1) | ((buffer[position / 8] >> (7 - position % 8)) & 1);
+                position++;
+            }
+            return value;
+        }
+        void writeNumber(uint64_t number){
+            if(number == 0) write(0x0, 1);
+            else if(number < (1ull << 7)) { write(0x2, 2); write(number, 7); }
+            else if(number < (1ull << 9)) { write(0x6, 3); write(number, 9); }
+            else if(number < (1ull << 12)) { write(0xE, 4); write(number, 12); }
+            else if(number < (1ull << 32)) { write(0x1E, 5); write(number, 32); }
+            else { write(0x1F, 5); write(number, 64); }
+        }
+        uint64_t readNumber(){
+            static const uint8_t bits[] = {0, 7, 9, 12, 32, 64};
+            uint8_t ones = 0;
+            while(ones < 5 && read(1) == 1) ones++;
+            return ones == 0 ? 0 : read(bits[ones]);
+        }
+        static uint64_t zigzag(int64_t value){
+            return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+        }
+        static int64_t unzigzag(uint64_t number){
+            return (int64_t)(number >> 1) ^ -(int64_t)(number & 1);
+        }
+};
+
+//Writes the values that fit into capacity bytes as the payload of one FRAME record, returns the size of the payload
+size_t PersistentLog::encodeFrame(ValueCoding coding, uint8_t size, const FrameValue* values, size_t count, uint8_t* payload, size_t capacity, uint8_t& frameCount){
+    FrameState state;
+    memcpy(&state.value, values[0].data, size);
+    state.timestamp = values[0].timestamp;
+    memcpy(payload + 1, values[0].data, size);
+    FrameBits bits(payload + 1 + size, (capacity - 1 - size) * 8);
+    uint64_t mask = size < sizeof(uint64_t) ? (1ull << (size * 8)) - 1 : ~0ull;
+    uint8_t runLength = 0;
+    uint32_t runStart = 0;
+    frameCount = 1;
+    while(frameCount < count && frameCount < UINT8_MAX){
+        const FrameValue& frameValue = values[frameCount];
+        uint64_t value = 0;
+        memcpy(&value, frameValue.data, size);
+        int32_t delta = (int32_t)(frameValue.timestamp - state.timestamp);
+        FrameState previous = state;
+        uint32_t previousPosition = bits.position;
+        if(value == state.value && delta == state.delta){
+            //a new run or the run written last becomes one value longer
+            if(runLength == 0) runStart = bits.position;
+            bits.position = runStart;
+            bits.write(0x0, 1);
+            bits.writeNumber(runLength);
+            if(bits.overflow){
+                if(runLength > 0){
+                    bits.overflow = false;
+                    bits.position = runStart;
+                    bits.write(0x0, 1);
+                    bits.writeNumber(runLength - 1);
+                }
+                bits.position = previousPosition;
+                break;
+            }
+            runLength++;
+        }else{
+            runLength = 0;
+            bits.write(0x1, 1);
+            bits.writeNumber(FrameBits::zigzag((int64_t)delta - state.delta));
+            if(coding == ValueCoding::INTEGER){
+                int64_t difference = (int64_t)((value - state.value) & mask);
+                if(size < sizeof(uint64_t) && (difference >> (size * 8 - 1)) & 1) difference -= (int64_t)mask + 1;
+                bits.writeNumber(FrameBits::zigzag(difference));
+            }else{
+                uint64_t bitsXor = value ^ state.value;
+                if(bitsXor == 0){
+                    bits.write(0x0, 1);
+                }else{
+                    uint8_t leading = __builtin_clzll(bitsXor);
+                    uint8_t trailing = __builtin_ctzll(bitsXor);
+                    if(state.leading != 64 && leading >= state.leading && trailing >= state.trailing){
+                        bits.write(0x2, 2);
+                        bits.write(bitsXor >> state.trailing, 64 - state.leading - state.trailing);
+                    }else{
+                        bits.write(0x3, 2);
+                        bits.write(leading, 6);
+                        bits.write(63 - leading - trailing, 6);
+                        bits.write(bitsXor >> trailing, 64 - leading - trailing);
+                        state.leading = leading;
+                        state.trailing = trailing;
+                    }
+                }
+            }
+            if(bits.overflow){
+                state = previous;
+                bits.position = previousPosition;
+                break;
+            }
+            state.value = value;
+            state.delta = delta;
+        }
+        state.timestamp = frameValue.timestamp;
+        frameCount++;
+    }
+    payload[0] = frameCount;
+    return 1 + size + (bits.position + 7) / 8;
+}
+
+//Decodes the next value of a FRAME record into data, returns true if the frame holds no further value
+bool PersistentLog::decodeFrame(FrameState& state, const LogRecordHeader& header, const uint8_t* payload, ValueCoding coding, uint8_t size, void* data){
+    if(coding == ValueCoding::RAW || header.size < 1 + size) return true;
+    if(state.index == 0){
+        state = FrameState();
+        state.count = payload[0];
+        state.timestamp = header.timestamp;
+        memcpy(&state.value, payload + 1, size);
+    }else if(state.index >= state.count){
+        return true;
+    }else if(state.remainingRun > 0){
+        state.remainingRun--;
+        state.timestamp += state.delta;
+    }else{
+        FrameBits bits(const_cast<uint8_t*>(payload) + 1 + size, (header.size - 1 - size) * 8, state.bitPosition);
+        if(bits.read(1) == 0){
+            state.remainingRun = bits.readNumber();
+            state.timestamp += state.delta;
+        }else{
+            state.delta += FrameBits::unzigzag(bits.readNumber());
+            state.timestamp += state.delta;
+            if(coding == ValueCoding::INTEGER){
+                state.value += (uint64_t)FrameBits::unzigzag(bits.readNumber());
+                if(size < sizeof(uint64_t)) state.value &= (1ull << (size * 8)) - 1;
+            }else if(bits.read(1) == 1){
+                if(bits.read(1) == 1){
+                    state.leading = bits.read(6);
+                    state.trailing = 63 - state.leading - bits.read(6);
+                }
+                if(state.leading + state.trailing >= 64) return true;
+                state.value ^= bits.read(64 - state.leading - state.trailing) << state.trailing;
+            }
+        }
+        if(bits.overflow) return true;
+        state.bitPosition = bits.position;
+    }
+    memcpy(data, &state.value, size);
+    state.index++;
+    return false;
+}
+
+//Writes a record with a payload made of two parts, the record has to fit into the current block
+bool PersistentLog::writeRecord(LogRecordHeader header, const void* first, uint8_t firstSize, const void* second, uint8_t secondSize){
+    if(writePosition % blockSize + sizeof(LogRecordHeader) + header.size > blockSize && pad()) return true;
+    uint8_t record[sizeof(LogRecordHeader) + UINT8_MAX];
+    header.sequence = sequence;
+    header.crc = 0;
+    memcpy(record, &header, sizeof(LogRecordHeader));
+    memcpy(record + sizeof(LogRecordHeader), first, firstSize);
+    if(secondSize > 0) memcpy(record + sizeof(LogRecordHeader) + firstSize, second, secondSize);
+    header.crc = getCrc(record);
+    memcpy(record, &header, sizeof(LogRecordHeader));
+    if(write(record, sizeof(LogRecordHeader) + firstSize + secondSize)) return true;
+    sequence++;
+    return false;
+}
+
+//Makes sure the next record of the given length fits into the current block, starts new segments and writes the checkpoints
+bool PersistentLog::makeRoom(uint32_t length){
+    while(true){
+        if(writePosition % blockSize + length > blockSize){
+            if(pad()) return true;
+        }else if(writePosition >= segmentBlocks * blockSize){
+            if(startSegment(segmentNumber + 1)) return true;
+        }else if(writePosition % getWindowSize() == 0){
+            if(writeCheckpoint()) return true;
+        }else{
+            return false;
+        }
+    }
+}
+
+//Removes the oldest segment file and reuses it as the active segment
+bool PersistentLog::startSegment(uint32_t number){
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    //closing the full segment writes its final size, a power failure must not cut off its last records
+    tracker.closeFile(getSegmentName(segmentNumber));
+    String name = getSegmentName(number);
+    tracker.closeFile(name);
+    if(SD.exists(name)){
+        SD.remove(name);
+        tracker.statistics.removes++;
+    }
+    segmentNumber = number;
+    writePosition = 0;
+    if(number >= numberOfSegments && number + 1 - numberOfSegments > oldestSegmentNumber){
+        oldestSegmentNumber = number + 1 - numberOfSegments;
+        readFirstEntries(nullptr);
+    }
+    File* file = getSegment(number);
+    if(file == nullptr) return true;
+    //on a fragmented card the segment grows cluster by cluster instead
+    file->preAllocate(segmentBlocks * blockSize);
+    return false;
+}
+
+bool PersistentLog::writeCheckpoint(){
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    CheckpointMarker checkpointMarker = {segmentNumber, 0, tracker.nextChannel};
+    for(BasePersistent* basePersistent : *tracker.getInstances()){
+        if(!isSelected(basePersistent, nullptr) || basePersistent->channel == checkpointChannel) continue;
+        checkpointMarker.numberOfRecords += basePersistent->committedEntries > 0 ? 2 : 1;
+    }
+    LogRecordHeader marker = {checkpointChannel, LogRecordType::CHECKPOINT, sizeof(CheckpointMarker), (uint32_t)millis()};
+    if(writeRecord(marker, &checkpointMarker, sizeof(CheckpointMarker))) return true;
+    for(BasePersistent* basePersistent : *tracker.getInstances()){
+        if(!isSelected(basePersistent, nullptr) || basePersistent->channel == checkpointChannel) continue;
+        uint8_t length = basePersistent->filename.length();
+        LogRecordHeader name = {basePersistent->channel, LogRecordType::NAME, length, marker.timestamp};
+        if(writeRecord(name, basePersistent->filename.c_str(), length)) return true;
+        if(basePersistent->committedEntries == 0) continue;
+        uint8_t objectSize = basePersistent->getObjectSize();
+        LogRecordHeader header = {basePersistent->channel, LogRecordType::CHECKPOINT, (uint8_t)(sizeof(uint32_t) + objectSize), marker.timestamp};
+        if(writeRecord(header, &basePersistent->committedEntries, sizeof(uint32_t), basePersistent->getCommittedValue(), objectSize)) return true;
+    }
+    return false;
+}
+
+bool PersistentLog::writeName(BasePersistent* owner){
+    uint8_t length = owner->filename.length();
+    if(makeRoom(sizeof(LogRecordHeader) + length)) return true;
+    LogRecordHeader header = {owner->channel, LogRecordType::NAME, length, (uint32_t)millis()};
+    return writeRecord(header, owner->filename.c_str(), length);
+}
+
+size_t PersistentLog::append(BasePersistent* owner, const FrameValue* values, size_t count){
+    //an instance without a channel, see CHANNELS in PERSISTENT LOG EXPLANATION
+    if(owner->channel == checkpointChannel) return 0;
+    ValueCoding coding = owner->getValueCoding();
+    uint8_t size = owner->getObjectSize();
+    size_t appended = 0;
+    while(appended < count){
+        if(coding == ValueCoding::RAW){
+            LogRecordHeader header = {owner->channel, LogRecordType::VALUE, size, values[appended].timestamp};
+            if(makeRoom(sizeof(LogRecordHeader) + size)) break;
+            if(writeRecord(header, values[appended].data, size)) break;
+            owner->setCommittedValue(values[appended].data);
+            owner->committedEntries++;
+            appended++;
+        }else{
+            //a frame starts in the current block if at least a few values fit
+            if(makeRoom(sizeof(LogRecordHeader) + 1 + size + 4)) break;
+            size_t capacity = blockSize - writePosition % blockSize - sizeof(LogRecordHeader);
+            if(capacity > UINT8_MAX) capacity = UINT8_MAX;
+            uint8_t payload[UINT8_MAX];
+            uint8_t frameCount;
+            size_t payloadSize = encodeFrame(coding, size, values + appended, count - appended, payload, capacity, frameCount);
+            LogRecordHeader header = {owner->channel, LogRecordType::FRAME, (uint8_t)payloadSize, values[appended].timestamp};
+            if(writeRecord(header, payload, payloadSize)) break;
+            //a checkpoint written by the next makeRoom() counts the frame
+            appended += frameCount;
+            owner->committedEntries += frameCount;
+            owner->setCommittedValue(values[appended - 1].data);
+        }
+    }
+    return appended;
+}
+
+bool PersistentLog::flush(){
+    if(!unflushed) return false;
+    File* file = getSegment(segmentNumber);
+    if(file == nullptr) return true;
+    file->flush();
+    unflushed = false;
+    PersistentTracker::getInstance().statistics.flushes++;
+    return false;
+}
+
+//Returns a block of a segment from the block cache, reads it if necessary. length is set to the number of bytes in the block,
+//returns nullptr behind the end of the segment. The log is append only, a cached block only becomes invalid by growing.
+const uint8_t* PersistentLog::getBlock(uint32_t segment, uint32_t block, uint32_t& length){
+    uint32_t size = getSegmentSize(segment);
+    if(block * blockSize >= size) return nullptr;
+    length = size - block * blockSize;
+    if(length > blockSize) length = blockSize;
+    CachedBlock* replace = &blockCache[0];
+    for(CachedBlock& cachedBlock : blockCache){
+        if(cachedBlock.length > 0 && cachedBlock.segment == segment && cachedBlock.block == block){
+            if(cachedBlock.length >= length){
+                cachedBlock.lastUse = ++useCounter;
+                PersistentTracker::getInstance().statistics.cacheHits++;
+                return cachedBlock.data;
+            }
+            replace = &cachedBlock;
+            break;
+        }
+        if(cachedBlock.lastUse < replace->lastUse) replace = &cachedBlock;
+    }
+    replace->length = 0;
+    File* file = getSegment(segment);
+    if(file == nullptr || !file->seek(block * blockSize)) return nullptr;
+    PersistentTracker::getInstance().statistics.reads++;
+    if(file->read(replace->data, length) != (int)length) return nullptr;
+    replace->segment = segment;
+    replace->block = block;
+    replace->length = length;
+    replace->lastUse = ++useCounter;
+    return replace->data;
+}
+
+//Reads the records of a segment starting at position (the start of a record or a block) until the end of the segment.
+//callback(header, payload, recordPosition) is called for every valid record, returns true if the callback stopped the scan by returning true.
+template<typename F>
+bool PersistentLog::scan(uint32_t segment, uint32_t position, F callback){
+    bool sequenceKnown = false;
+    uint16_t expectedSequence = 0;
+    while(true){
+        uint32_t length;
+        const uint8_t* block = getBlock(segment, position / blockSize, length);
+        if(block == nullptr) return false;
+        uint32_t blockStart = position - position % blockSize;
+        uint32_t offset = position % blockSize;
+        while(offset + sizeof(LogRecordHeader) <= length){
+            LogRecordHeader header;
+            memcpy(&header, block + offset, sizeof(LogRecordHeader));
+            if(header.channel == noChannel) break;
+            uint32_t next = offset + sizeof(LogRecordHeader) + header.size;
+            if(next > length) break;
+            //a torn or stale record ends the block, see PERSISTENT LOG EXPLANATION
+            if(header.crc != getCrc(block + offset)) break;
+            if(sequenceKnown && header.sequence != expectedSequence) break;
+            sequenceKnown = true;
+            expectedSequence = header.sequence + 1;
+            if(callback(header, block + offset + sizeof(LogRecordHeader), blockStart + offset)) return true;
+            offset = next;
+        }
+        position = blockStart + blockSize;
+    }
+}
+
+bool PersistentLog::isSelected(BasePersistent* basePersistent, BasePersistent* only){
+    return basePersistent->log == this && (only == nullptr || basePersistent == only);
+}
+
+bool PersistentLog::readMarker(const LogRecordHeader& header, const uint8_t* payload, CheckpointMarker& marker){
+    if(header.channel != checkpointChannel || header.type != LogRecordType::CHECKPOINT || header.size != sizeof(CheckpointMarker)) return false;
+    memcpy(&marker, payload, sizeof(CheckpointMarker));
+    return true;
+}
+
+//Reads the number of records the owner has written before the window. Returns true if the window has no complete checkpoint.
+//With owner = nullptr it only checks the checkpoint.
+bool PersistentLog::readCheckpoint(uint32_t segment, uint32_t window, BasePersistent* owner, uint32_t& count){
+    bool first = true;
+    bool complete = false;
+    uint32_t remaining = 0;
+    count = 0;
+    scan(segment, window * getWindowSize(), [&](const LogRecordHeader& header, const uint8_t* payload, uint32_t position){
+        if(first){
+            first = false;
+            CheckpointMarker marker;
+            if(!readMarker(header, payload, marker)) return true;
+            remaining = marker.numberOfRecords;
+            complete = remaining == 0;
+            return complete;
+        }
+        if(header.type != LogRecordType::CHECKPOINT && header.type != LogRecordType::NAME) return true;
+        if(owner != nullptr && header.type == LogRecordType::CHECKPOINT && header.channel == owner->channel){
+            memcpy(&count, payload, sizeof(count));
+            complete = true;
+            return true;
+        }
+        remaining--;
+        complete = remaining == 0;
+        return complete;
+    });
+    return !complete;
+}
+
+//Reads the first checkpoint of the oldest segment, it holds the number of records that have been removed with older segments
+void PersistentLog::readFirstEntries(BasePersistent* only){
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    for(BasePersistent* basePersistent : *tracker.getInstances()){
+        if(isSelected(basePersistent, only)) basePersistent->firstEntry = 0;
+    }
+    bool first = true;
+    scan(oldestSegmentNumber, 0, [&](const LogRecordHeader& header, const uint8_t* payload, uint32_t position){
+        if(first){
+            first = false;
+            CheckpointMarker marker;
+            return !readMarker(header, payload, marker);
+        }
+        if(header.type == LogRecordType::NAME) return false;
+        if(header.type != LogRecordType::CHECKPOINT) return true;
+        BasePersistent* owner = tracker.findChannel(header.channel);
+        if(owner != nullptr && isSelected(owner, only)) memcpy(&owner->firstEntry, payload, sizeof(uint32_t));
+        return false;
+    });
+}
+
+bool PersistentLog::restore(BasePersistent* only){
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    //find the active (newest) and the oldest segment, every segment starts with a checkpoint holding its number
+    bool found = false;
+    for(uint8_t i = 0; i < numberOfSegments; i++){
+        String name = getSegmentName(i);
+        if(!SD.exists(name)) continue;
+        File* file = tracker.getOpenFile(name, false);
+        if(file == nullptr || !file->seek(0)) continue;
+        uint8_t buffer[sizeof(LogRecordHeader) + sizeof(CheckpointMarker)];
+        if(file->read(buffer, sizeof(buffer)) != sizeof(buffer)) continue;
+        LogRecordHeader header;
+        CheckpointMarker marker;
+        memcpy(&header, buffer, sizeof(header));
+        if(header.crc != getCrc(buffer) || !readMarker(header, buffer + sizeof(header), marker)) continue;
+        uint32_t number = marker.segmentNumber;
+        if(number % numberOfSegments != i) continue;
+        if(!found || number > segmentNumber) segmentNumber = number;
+        if(!found || number < oldestSegmentNumber) oldestSegmentNumber = number;
+        found = true;
+    }
+    if(!found){
+        oldestSegmentNumber = 0;
+        return startSegment(0);
+    }
+    File* file = getSegment(segmentNumber);
+    if(file == nullptr) return true;
+    writePosition = file->size();
+    if(only == nullptr) file->preAllocate(segmentBlocks * blockSize);
+
+    //one pass from the latest complete checkpoint to the end of the log
+    for(BasePersistent* basePersistent : *tracker.getInstances()){
+        if(isSelected(basePersistent, only)) basePersistent->committedEntries = 0;
+    }
+    uint32_t segment = segmentNumber;
+    uint32_t window = getLastWindow(segment);
+    while(!isCheckpoint(segment, window)){
+        if(window > 0) window--;
+        else if(segment > oldestSegmentNumber) window = getLastWindow(--segment);
+        else break;
+    }
+    bool foundRecord = false;
+    uint16_t lastSequence = 0;
+    uint32_t validEnd = 0; //in the active segment
+    auto restoreRecord = [&](const LogRecordHeader& header, const uint8_t* payload, uint32_t position){
+        foundRecord = true;
+        lastSequence = header.sequence;
+        if(segment == segmentNumber) validEnd = position + sizeof(LogRecordHeader) + header.size;
+        CheckpointMarker marker;
+        if(readMarker(header, payload, marker)){
+            if(marker.nextChannel > tracker.nextChannel && marker.nextChannel <= noChannel) tracker.nextChannel = marker.nextChannel;
+            return false;
+        }
+        if(header.type == LogRecordType::NAME){
+            //every record of a channel follows its NAME record, see CHANNELS
+            tracker.bindChannel(this, header.channel, payload, header.size);
+            return false;
+        }
+        BasePersistent* owner = tracker.findChannel(header.channel);
+        if(owner == nullptr || !isSelected(owner, only)) return false;
+        uint8_t objectSize = owner->getObjectSize();
+        if(header.type == LogRecordType::CHECKPOINT && header.size == sizeof(uint32_t) + objectSize){
+            memcpy(&owner->committedEntries, payload, sizeof(uint32_t));
+            owner->setCommittedValue(payload + sizeof(uint32_t));
+        }else if(header.type == LogRecordType::VALUE && header.size == objectSize){
+            owner->committedEntries++;
+            owner->setCommittedValue(payload);
+        }else if(header.type == LogRecordType::FRAME){
+            FrameState frame;
+            uint64_t value;
+            while(!decodeFrame(frame, header, payload, owner->getValueCoding(), objectSize, &value));
+            if(frame.index > 0){
+                owner->committedEntries += frame.index;
+                owner->setCommittedValue(reinterpret_cast<const uint8_t*>(&value));
+            }
+        }
+        return false;
+    };
+    for(uint32_t position = window * getWindowSize(); segment <= segmentNumber; segment++, position = 0){
+        scan(segment, position, restoreRecord);
+    }
+    if(tracker.channelConflict) return true;
+    readFirstEntries(only);
+    for(BasePersistent* basePersistent : *tracker.getInstances()){
+        if(isSelected(basePersistent, only)) basePersistent->totalEntries = basePersistent->committedEntries + basePersistent->stagedRecords;
+    }
+    if(only != nullptr) return false;
+    if(foundRecord) sequence = lastSequence + 1;
+    //the first checkpoint of the active segment is torn, no record behind it has been written
+    if(segmentNumber > oldestSegmentNumber && !isCheckpoint(segmentNumber, 0)) return startSegment(segmentNumber);
+    //a torn commit, the garbage behind the last valid record stays in the block
+    if(validEnd < writePosition) return pad();
+    return false;
+}
+
+bool PersistentLog::seek(LogCursor& cursor, BasePersistent* owner, uint32_t entry){
+    cursor.valid = false;
+    if(entry < owner->firstEntry || entry >= owner->committedEntries) return true;
+    uint32_t count;
+    //the newest segment that starts before the entry
+    uint32_t low = oldestSegmentNumber;
+    uint32_t high = segmentNumber;
+    while(low < high){
+        uint32_t middle = low + (high - low + 1) / 2;
+        if(!readCheckpoint(middle, 0, owner, count) && count <= entry) low = middle;
+        else high = middle - 1;
+    }
+    uint32_t segment = low;
+    //the newest window of the segment that starts before the entry
+    uint32_t firstWindow = 0;
+    uint32_t lastWindow = getSegmentSize(segment) / getWindowSize();
+    while(firstWindow < lastWindow){
+        uint32_t middle = firstWindow + (lastWindow - firstWindow + 1) / 2;
+        if(!readCheckpoint(segment, middle, owner, count) && count <= entry) firstWindow = middle;
+        else lastWindow = middle - 1;
+    }
+    if(readCheckpoint(segment, firstWindow, owner, count)) return true;
+    scan(segment, firstWindow * getWindowSize(), [&](const LogRecordHeader& header, const uint8_t* payload, uint32_t position){
+        if(header.channel != owner->channel) return false;
+        uint32_t values = header.type == LogRecordType::VALUE ? 1 : header.type == LogRecordType::FRAME ? payload[0] : 0;
+        if(count + values <= entry){
+            count += values;
+            return false;
+        }
+        cursor.owner = owner;
+        cursor.segment = segment;
+        cursor.position = position;
+        cursor.entry = entry;
+        cursor.frame = FrameState();
+        cursor.valid = true;
+        //decode the frame up to the entry
+        uint64_t value;
+        while(header.type == LogRecordType::FRAME && count < entry && cursor.valid){
+            cursor.valid = !decodeFrame(cursor.frame, header, payload, owner->getValueCoding(), owner->getObjectSize(), &value);
+            count++;
+        }
+        return true;
+    });
+    return !cursor.valid;
+}
+
+bool PersistentLog::next(LogCursor& cursor, void* data, uint8_t size){
+    if(!cursor.valid) return true;
+    BasePersistent* owner = cursor.owner;
+    if(cursor.segment < oldestSegmentNumber || cursor.entry >= owner->committedEntries){
+        cursor.valid = false;
+        return true;
+    }
+    //the record is the first one of the channel at or behind the cursor, possibly in a newer segment
+    bool found = false;
+    bool sizeMatches = false;
+    while(!found){
+        found = scan(cursor.segment, cursor.position, [&](const LogRecordHeader& header, const uint8_t* payload, uint32_t position){
+            if(header.channel != owner->channel) return false;
+            if(header.type == LogRecordType::VALUE){
+                sizeMatches = header.size == size;
+                if(sizeMatches) memcpy(data, payload, size);
+                cursor.position = position + sizeof(LogRecordHeader) + header.size;
+                cursor.frame = FrameState();
+                return true;
+            }
+            if(header.type != LogRecordType::FRAME) return false;
+            if(position != cursor.position) cursor.frame = FrameState();
+            sizeMatches = size == owner->getObjectSize() && !decodeFrame(cursor.frame, header, payload, owner->getValueCoding(), size, data);
+            cursor.position = position;
+            if(cursor.frame.index >= cursor.frame.count){
+                //the frame is done, the next value is in a later record
+                cursor.position = position + sizeof(LogRecordHeader) + header.size;
+                cursor.frame = FrameState();
+            }
+            return true;
+        });
+        if(!found){
+            if(cursor.segment >= segmentNumber) break;
+            cursor.segment++;
+            cursor.position = 0;
+        }
+    }
+    if(!sizeMatches){
+        cursor.valid = false;
+        return true;
+    }
+    cursor.entry++;
+    return false;
+}
@@ -21,11 +21,13 @@
 #ifndef LscPersistence_H
 #define LscPersistence_H
 
+#include <new>
 #include <utility>
 #include <type_traits>
 #include <vector>
 #include <SPI.h>
 #include <SD.h>
+#include "LscError.h"
 
 
 
@@ -106,13 +108,417 @@ struct has_modulo_operator {
     static constexpr bool value = decltype(test<T>(nullptr))::value;
 };
 
+//---- WRITE BEHIND EXPLANATION ----
+/*
+    Assigning a value to a Persistent<T> used to open its file, append sizeof(T) bytes, flush and close the file again. Every one
+    of these steps walks the FAT or reads and writes a whole 512 byte block, i.e. a 4 byte value cost several block operations.
+    An assignment now only copies the value into the RAM staging buffer of the PersistentTracker (stage()). commit() appends all
+    staged records to the PersistentLog (see PERSISTENT LOG EXPLANATION) and flushes it once, so every touched block is written
+    once per commit instead of once per record. The last maxOpenFiles log files stay open between commits, if another file is
+    needed the least recently used one is closed.
+    The active segment of a log is allocated contiguously when it starts (SdFile::preAllocate()) and written in sequential append
+    mode (SdFile::setSequentialAppend()): its last block stays in a block buffer of the file instead of the shared SD cache and
+    the full blocks of a commit go to the card with one multiple block write (CMD25), which the flush at the end of the commit
+    ends. A commit therefore neither reads the last block back nor updates the FAT.
+    The records are committed:
+        - by service() every commitIntervall_ms, service() is called by the scene loop (SceneManager::switchScene())
+        - by the next service() once the staging buffer is half full
+        - when the staging buffer is full and the record is staged by the scene loop
+        - before the history of a Persistent<T> with staged records is read
+        - when SUPC_Handler detects a power failure (onPowerFailure()) they are dumped instead, see POWER FAILURE DUMP EXPLANATION
+    Most records are staged by the OS tick, but a commit never runs in an interrupt: the scene loop shares the SPI bus with the
+    display and uses the SD card outside of the persistence (SD.exists() in SceneManager::switchScene(), TJpg_Decoder), an
+    interrupt can not know whether it is in the middle of such a transfer. commit() called by an interrupt only sets
+    commitRequested, service() or the end of the current SdAccess (all SD accesses of the persistence hold one) commits.
+    A record staged by an interrupt while the buffer is full is dropped and counted in IoStatistics::droppedRecords.
+    The SD operations are counted in IoStatistics, see getIoStatisticsString().
+*/
+//---- END WRITE BEHIND EXPLANATION ----
+
+//---- POWER FAILURE DUMP EXPLANATION ----
+/*
+    The supply monitor leaves only a few milliseconds between SUPC_Handler and the brown-out reset. A regular commit walks the FAT,
+    writes the log blocks one by one and updates the directory entry, which may take longer than that. Instead the staged records
+    are dumped into the contiguous file PDUMP.BIN (dumpBlocks blocks, allocated and erased by restore()) with one multi block
+    write to the raw block addresses of the file, i.e. without touching the file system.
+    The dump uses the record format of the PersistentLog: a DUMP record with the next sequence numbers of the raw log and of both
+    rollup logs and the number of records in the dump, followed by one VALUE record per staged record. The sequence of the dump
+    records starts at 0.
+    onPowerFailure() dumps right away unless the SD card is in the middle of a transfer, i.e. the persistence uses it (sdBusy) or
+    its chip select is low. A display transfer of the scene loop is cut off by deselecting the display, the screen does not matter
+    anymore and a display transfer may take longer than the hold-up time. A multiple block write of a file that is left open
+    between two transfers is ended, the next block written to the file fails. If the SD card is in use the dump is requested like
+    a commit: the running commit stops after the current record and flushes what it has written so far, and the end of the SD
+    access, the next service() or the next record staged by an interrupt dumps. Every record staged afterwards dumps the whole
+    staging buffer again.
+    At boot restore() appends the valid records of the dump to their logs, but only to a log that still continues with the
+    sequence number of the dump, i.e. the records of a log that has been written since the dump have been applied already. Then
+    the dump region is erased again.
+    The worst case dump time is recorded in IoStatistics::maxDumpTime_us, see getIoStatisticsString().
+*/
+//---- END POWER FAILURE DUMP EXPLANATION ----
+
+//---- ROLLUP EXPLANATION ----
+/*
+    The raw history of a Persistent<T> holds one sample per minIntervall, reading a month of it streams millions of records. For
+    arithmetic T enableRollups() adds two rollup tiers that keep the minimum, maximum and mean of every minute and of every hour.
+    Every value written to the Persistent<T> (also the ones skipped because of minIntervall) is added to the open bucket of both
+    tiers by RollupChannel::add(). The bucket is closed and staged as one RollupSample when the first value of a later bucket
+    arrives. The open buckets only live in RAM, they are lost at a reboot.
+    Every tier is a channel (filename + ".M" or ".H") of a PersistentLog of its own (PMIN*.BIN and PHOUR*.BIN), i.e. staging,
+    commits, checkpoints, restore and cursors work the same as for the raw samples. A tier log only holds the samples of its tier,
+    so 30 days of hourly samples are 720 records per channel instead of 2.6 million raw samples at a minIntervall of 1s.
+    getRollupRange() reads the samples of a tier like getRange() reads the raw history, index 0 is the oldest sample.
+    The RollupChannels live in the static slots of the RollupPool (RollupPool::maxChannels, two per Persistent<T>) instead of
+    the heap, enableRollups() reports an error and leaves the rollups off once the pool is used up.
+*/
+//---- END ROLLUP EXPLANATION ----
+
+//---- COMPRESSION EXPLANATION ----
+/*
+    Most Persistent<T> values change slowly and are written at a fixed interval, a VALUE record spends 12 bytes of header on
+    every one of them. Values with sizeof(T) <= 8 are therefore committed as FRAME records: all values of a channel staged in one
+    commit are packed into as few frames as possible. A frame never crosses a block and starts with the first value and its
+    timestamp, i.e. every block can be decoded on its own. The header timestamp is the one of the first value, the payload is
+        | count (1) | first value (size) | bit stream |
+    The bit stream holds for every further value either
+        '0' + number                    a run of number + 1 values equal to the previous one, at the previous interval
+        '1' + number + value            the delta of delta of the timestamp (zigzag encoded) and the value
+    A number is written as '0' for 0, or '10', '110', '1110', '11110', '11111' followed by 7, 9, 12, 32 or 64 bits.
+    The value is written depending on getValueCoding():
+        - ValueCoding::INTEGER (integers, enums and bool): the difference to the previous value as zigzag encoded number
+        - ValueCoding::BITS (float, double, small structs): the XOR with the previous value as in Gorilla, '0' if it is 0, '10'
+          and the bits between the leading and trailing zeros of the previous XOR if they fit, otherwise '11', 6 bit leading
+          zeros, 6 bit length - 1 and the meaningful bits
+        - ValueCoding::RAW (sizeof(T) > 8): not compressed, one VALUE record per value
+    A cursor (see LogCursor) decodes a frame value by value and keeps the decoder state in its FrameState.
+    With setOnlyLogChanges(true) a value equal to the last written one is not written at all.
+    IoStatistics::bytes counts the bytes written to the logs.
+*/
+//---- END COMPRESSION EXPLANATION ----
+
+//---- PERSISTENT LOG EXPLANATION ----
+/*
+    All Persistent<T> instances share one append only log instead of one file (plus a "_2" bank file) each. The log is split into
+    numberOfSegments segment files (PLOG0.BIN, PLOG1.BIN, ...) that are used round robin: when the active segment is full, the
+    oldest one is removed and reused. Every record carries the channel of its Persistent<T> (see CHANNELS below), the time
+    it was staged (millis()), a sequence number, a CRC-16 over the header and the payload, and the value:
+        | channel (2) | type (1) | size (1) | timestamp (4) | sequence (2) | crc (2) | payload (size) |
+    Records never cross a 512 byte block, the rest of a block that can not hold the next record is filled with 0xFF.
+    Every checkpointInterval_blocks blocks (a window) starts with a checkpoint: a CHECKPOINT record on checkpointChannel holding
+    the segment number, the number of records in the checkpoint and the next unused channel, followed by a NAME record per
+    channel and, for every channel that has written a value, a CHECKPOINT record with the number of records the channel has
+    written before the window and its latest value.
+    At boot restore() reads the latest complete checkpoint and every record behind it in one sequential pass, which yields the
+    latest value and the number of records of every channel. The first checkpoint of the oldest segment tells which records are
+    still in the log.
+
+    Power can fail in the middle of a commit. The SD library writes the blocks of a file in order and updates the size in the
+    directory entry last, so a torn commit leaves a tail block with a valid prefix followed by garbage. A record is only valid if
+    its CRC matches and its sequence number follows the one of the previous record, the first invalid record ends the block for
+    every reader. restore() continues the sequence behind the last valid record and pads the torn block, i.e. the garbage is
+    skipped but nothing is removed. The active segment is chosen by the segment number in its checkpoint, never by the size of
+    a file. A new segment whose first checkpoint is incomplete can not hold any valid record yet, restore() restores from the
+    previous segment and starts the new segment again. A full segment is closed before the next one starts, so its size is final.
+    The only data ever removed is the oldest segment when a new one starts.
+    The history is read with a LogCursor: seek() finds a record by binary searching the checkpoints of the segments and windows
+    for its number and scanning the window, next() then streams the following records of the channel. The blocks are read through
+    a cache of blockCacheSize blocks and the segment files stay open (see WRITE BEHIND EXPLANATION), so reading consecutive entries
+    costs one block read per block of the log instead of a file open and a seek per entry. Every Persistent<T> keeps the cursor of
+    its last getElement(), a loop over the history continues it instead of searching again. For charts Persistent<T>::getRange()
+    reads a range of entries and Persistent<T>::Cursor streams the history from a given index.
+
+    CHANNELS
+    The channels are numbered in the order the Persistent<T> instances register, starting at firstChannel, and a number is never
+    given to another name. Which name has which number is recorded in the log itself: a NAME record (payload: the file name) is
+    written as soon as a channel is created, before any of its values, and repeated in every checkpoint. restore() binds every
+    instance to the number the log holds for its file name, so adding, removing or reordering Persistent<T> instances in a new
+    firmware keeps every history with its instance. Instances whose name is not in the log get the next unused numbers (the
+    checkpoint marker carries the next unused number, so the numbers of removed instances stay reserved).
+    Two instances with the same file name, a name longer than UINT8_MAX, or a log that holds two numbers for one name or one
+    number for two names is a conflict: restore() raises a FATAL error and the persistence does not start, i.e.
+    BasePersistent::initComplete stays false and no record is written. An instance created after OS::init() with a conflicting
+    name only stays without a channel, its values are dropped.
+
+    FORMER FILES
+    Before the PersistentLog every Persistent<T> appended its raw values to a file of its own (filename, and filename_2 as the
+    second bank once maxNumberOfBackLogEntries was reached). When a channel of the raw log is created and these files exist,
+    their values are appended to the log (the older bank first, with timestamp 0) and the files are removed once the log is
+    flushed. A channel that exists already never imports them, i.e. files left behind by an import that was cut short by a
+    power failure stay on the card.
+*/
+//---- END PERSISTENT LOG EXPLANATION ----
+
+//SD operations of the PersistentTracker, see WRITE BEHIND EXPLANATION
+struct IoStatistics{
+    unsigned long records = 0;
+    unsigned long droppedRecords = 0;
+    unsigned long commits = 0;
+    unsigned long opens = 0;
+    unsigned long closes = 0;
+    unsigned long writes = 0;
+    unsigned long flushes = 0;
+    unsigned long removes = 0;
+    unsigned long reads = 0;
+    unsigned long bytes = 0;
+    unsigned long cacheHits = 0;
+    unsigned long dumps = 0;
+    unsigned long maxDumpTime_us = 0;
+    //returns the number of SD operations (open, close, write, flush, remove) per committed record
+    float getOperationsPerRecord() const {
+        if(records == 0) return 0;
+        return (float)(opens + closes + writes + flushes + removes) / records;
+    }
+};
+
+enum class LogRecordType : uint8_t { VALUE = 1, CHECKPOINT = 2, DUMP = 3, FRAME = 4, NAME = 5 };
+
+//How the values of a channel are compressed, see COMPRESSION EXPLANATION
+enum class ValueCoding : uint8_t { RAW, INTEGER, BITS };
+
+//Header of every record in the PersistentLog, see PERSISTENT LOG EXPLANATION
+struct LogRecordHeader{
+    uint16_t channel;
+    LogRecordType type;
+    uint8_t size;
+    uint32_t timestamp;
+    uint16_t sequence;
+    uint16_t crc; //of the header with crc = 0 and the payload
+};
+static_assert(sizeof(LogRecordHeader) == 12, "LogRecordHeader has to be packed");
+
+//Payload of the first record of every checkpoint, see PERSISTENT LOG EXPLANATION
+struct CheckpointMarker{
+    uint32_t segmentNumber;
+    uint32_t numberOfRecords; //NAME and CHECKPOINT records behind the marker
+    uint32_t nextChannel;
+};
+
+//Payload of the first record of a power failure dump, see POWER FAILURE DUMP EXPLANATION
+struct DumpMarker{
+    uint16_t logSequences[3]; //the next sequence numbers of log, minuteLog and hourLog
+    uint16_t numberOfRecords;
+};
+
+//Rollup tiers of a Persistent<T>, see ROLLUP EXPLANATION
+enum class RollupTier : uint8_t { MINUTE = 0, HOUR = 1 };
+constexpr uint8_t numberOfRollupTiers = 2;
+inline uint32_t getRollupInterval_ms(RollupTier tier){
+    return tier == RollupTier::MINUTE ? 60000ul : 3600000ul;
+}
+
+//Minimum, maximum and mean of the values written during one interval of a rollup tier
+template<typename T>
+struct RollupSample{
+    T minimum;
+    T maximum;
+    double mean;
+    uint32_t count; //of the values in the interval
+};
+
+//A staged value handed to PersistentLog::append()
+struct FrameValue{
+    uint32_t timestamp;
+    const uint8_t* data;
+};
+
+//Decoder state of a FRAME record, see COMPRESSION EXPLANATION
+struct FrameState{
+    uint8_t index = 0; //of the next value
+    uint8_t count = 0;
+    uint8_t remainingRun = 0;
+    uint8_t leading = 64; //of the last meaningful XOR bits, 64 if there are none yet
+    uint8_t trailing = 0;
+    uint16_t bitPosition = 0;
+    uint32_t timestamp = 0;
+    int32_t delta = 0;
+    uint64_t value = 0;
+};
+
 class BasePersistent;
+//Position of a record in the PersistentLog, see PERSISTENT LOG EXPLANATION
+struct LogCursor{
+    BasePersistent* owner = nullptr;
+    uint32_t segment = 0;
+    uint32_t position = 0; //of the record with the number entry
+    uint32_t entry = 0;
+    bool valid = false;
+    FrameState frame; //if the record is a FRAME
+};
+
+class PersistentLog{
+    public:
+        static constexpr uint32_t blockSize = 512;
+        static constexpr uint16_t checkpointChannel = 0; //also the channel of an instance that has none yet
+        static constexpr uint16_t firstChannel = 1;
+        static constexpr uint16_t noChannel = 0xFFFF; //the rest of the block is unused
+        static constexpr size_t blockCacheSize = 4;
+        PersistentLog(const char* Prefix, uint32_t SegmentBlocks, uint8_t NumberOfSegments, uint32_t CheckpointInterval_blocks)
+            :   prefix(Prefix),
+                segmentBlocks(SegmentBlocks),
+                numberOfSegments(NumberOfSegments),
+                checkpointInterval_blocks(CheckpointInterval_blocks),
+                segmentNumber(0),
+                oldestSegmentNumber(0),
+                writePosition(0),
+                sequence(0),
+                unflushed(false),
+                useCounter(0)
+            {
+            for(CachedBlock& cachedBlock : blockCache) cachedBlock.length = 0;
+        }
+        //reads the latest value and number of records of all channels (or only the given one) from the log
+        bool restore(BasePersistent* only = nullptr);
+        //appends the values of the owner as FRAME or VALUE records, returns the number of values appended
+        size_t append(BasePersistent* owner, const FrameValue* values, size_t count);
+        //records the channel of the owner, see CHANNELS in PERSISTENT LOG EXPLANATION
+        bool writeName(BasePersistent* owner);
+        bool flush();
+        //moves the cursor to record number entry (counted since the channel was created) of the owner
+        bool seek(LogCursor& cursor, BasePersistent* owner, uint32_t entry);
+        //reads the value of the record at the cursor and moves the cursor to the next record of the channel
+        bool next(LogCursor& cursor, void* data, uint8_t size);
+        //the sequence number of the next record
+        uint16_t getSequence(){
+            return sequence;
+        }
+        //returns the CRC-16/CCITT of a record (header with crc = 0 and payload)
+        static uint16_t getCrc(const uint8_t* record);
+    private:
+        struct CachedBlock{
+            uint32_t segment;
+            uint32_t block;
+            uint32_t length; //0 if unused
+            uint32_t lastUse;
+            uint8_t data[blockSize];
+        };
+        const char* prefix;
+        uint32_t segmentBlocks;
+        uint8_t numberOfSegments;
+        uint32_t checkpointInterval_blocks;
+        uint32_t segmentNumber; //of the active segment
+        uint32_t oldestSegmentNumber;
+        uint32_t writePosition; //in the active segment
+        uint16_t sequence; //of the next record
+        bool unflushed; //written since the last flush()
+        CachedBlock blockCache[blockCacheSize];
+        uint32_t useCounter;
+        String getSegmentName(uint32_t number);
+        File* getSegment(uint32_t number);
+        uint32_t getSegmentSize(uint32_t number);
+        uint32_t getLastWindow(uint32_t number){
+            uint32_t size = getSegmentSize(number);
+            return size > 0 ? (size - 1) / getWindowSize() : 0;
+        }
+        uint32_t getWindowSize(){
+            return checkpointInterval_blocks * blockSize;
+        }
+        bool write(const void* data, uint32_t size);
+        bool pad();
+        bool writeRecord(LogRecordHeader header, const void* first, uint8_t firstSize, const void* second = nullptr, uint8_t secondSize = 0);
+        bool makeRoom(uint32_t length);
+        bool startSegment(uint32_t number);
+        bool writeCheckpoint();
+        bool isCheckpoint(uint32_t segment, uint32_t window){
+            uint32_t count;
+            return !readCheckpoint(segment, window, nullptr, count);
+        }
+        static bool readMarker(const LogRecordHeader& header, const uint8_t* payload, CheckpointMarker& marker);
+        static size_t encodeFrame(ValueCoding coding, uint8_t size, const FrameValue* values, size_t count, uint8_t* payload, size_t capacity, uint8_t& frameCount);
+        static bool decodeFrame(FrameState& state, const LogRecordHeader& header, const uint8_t* payload, ValueCoding coding, uint8_t size, void* data);
+        //true if the instance writes to this log and is selected by only (all instances if only is nullptr)
+        bool isSelected(BasePersistent* basePersistent, BasePersistent* only);
+        bool readCheckpoint(uint32_t segment, uint32_t window, BasePersistent* owner, uint32_t& count);
+        void readFirstEntries(BasePersistent* only);
+        const uint8_t* getBlock(uint32_t segment, uint32_t block, uint32_t& length);
+        template<typename F>
+        bool scan(uint32_t segment, uint32_t position, F callback);
+};
+
 class PersistentTracker{
+    friend class PersistentLog;
+    public:
+        static constexpr size_t stagingBufferSize = 2048;
+        static constexpr size_t maxOpenFiles = 8;
+        static constexpr unsigned long commitIntervall_ms = 10000;
+        static constexpr uint32_t segmentBlocks = 65536; //32MB
+        static constexpr uint8_t numberOfSegments = 4;
+        static constexpr uint32_t checkpointInterval_blocks = 64;
+        static constexpr uint32_t minuteSegmentBlocks = 32768; //16MB
+        static constexpr uint32_t hourSegmentBlocks = 2048; //1MB
+        static constexpr size_t maxFrameValues = 64; //values of one owner encoded at once
+        static constexpr uint32_t sdCardChipSelectPin = 31;
+        static constexpr uint32_t displayChipSelectPin = 30; //TFT_CS in TFT_eSPI/User_Setup.h
+        static_assert(segmentBlocks % checkpointInterval_blocks == 0, "A segment has to hold a whole number of checkpoint windows");
+        //a block that can not take the next record holds more than blockSize - (header + UINT8_MAX) bytes
+        static constexpr uint32_t dumpBlocks = (sizeof(LogRecordHeader) + sizeof(DumpMarker) + stagingBufferSize) / (PersistentLog::blockSize - sizeof(LogRecordHeader) - UINT8_MAX) + 1;
     private:
+        struct StagedRecord{
+            BasePersistent* owner;
+            uint32_t timestamp;
+            uint16_t size;
+        };
+        struct OpenFile{
+            File file;
+            char name[13];
+            bool writable;
+            uint32_t lastUse;
+        };
         std::vector<BasePersistent*> tracker;
-        PersistentTracker(){}
+        PersistentLog log;
+        PersistentLog minuteLog;
+        PersistentLog hourLog;
+        uint8_t stagingBuffer[stagingBufferSize];
+        volatile size_t stagedBytes;
+        OpenFile openFiles[maxOpenFiles];
+        uint32_t useCounter;
+        unsigned long lastCommit;
+        volatile uint8_t sdBusy;
+        volatile bool commitRequested;
+        uint32_t dumpFirstBlock;
+        bool dumpReady;
+        uint16_t nextChannel; //see CHANNELS in PERSISTENT LOG EXPLANATION
+        bool channelConflict;
+        IoStatistics statistics;
+        PersistentTracker()
+            :   log("PLOG", segmentBlocks, numberOfSegments, checkpointInterval_blocks),
+                minuteLog("PMIN", minuteSegmentBlocks, numberOfSegments, checkpointInterval_blocks),
+                hourLog("PHOUR", hourSegmentBlocks, numberOfSegments, checkpointInterval_blocks),
+                stagedBytes(0),
+                useCounter(0),
+                lastCommit(0),
+                sdBusy(0),
+                commitRequested(false),
+                dumpFirstBlock(0),
+                dumpReady(false),
+                nextChannel(PersistentLog::firstChannel),
+                channelConflict(false)
+            {
+            for(OpenFile& openFile : openFiles) openFile.name[0] = 0;
+        }
+        File* getOpenFile(const String& name, bool writable);
+        void closeFile(const String& name);
+        void writeStagedRecords();
+        void dump();
+        void dumpFromInterrupt();
+        bool restoreDump();
+        bool eraseDump();
+        void reportConflict(const String& message);
+        bool hasUniqueName(BasePersistent* instance);
+        void bindChannel(PersistentLog* owningLog, uint16_t channel, const uint8_t* name, uint8_t length);
+        bool createChannels(BasePersistent* only);
+        bool importFormerFiles(BasePersistent* owner);
     public:
         static volatile bool powerFailureImminent;
+        //Marks the SD card as in use as long as it exists, see WRITE BEHIND EXPLANATION
+        struct SdAccess{
+            SdAccess(){ getInstance().sdBusy++; }
+            ~SdAccess(){
+                PersistentTracker& tracker = getInstance();
+                tracker.sdBusy--;
+                if(tracker.sdBusy == 0 && tracker.commitRequested) tracker.commit();
+            }
+        };
         static PersistentTracker& getInstance(){
             static PersistentTracker instance;
             return instance;
@@ -123,20 +529,68 @@ class PersistentTracker{
         std::vector<BasePersistent*>* getInstances(){
             return &tracker;
         }
+        PersistentLog& getLog(){
+            return log;
+        }
+        PersistentLog& getLog(RollupTier tier){
+            return tier == RollupTier::MINUTE ? minuteLog : hourLog;
+        }
+        //returns the instance writing to the given channel, nullptr if there is none
+        BasePersistent* findChannel(uint16_t channel);
+        //reads the latest values of all instances from the log and applies a power failure dump, called once by OS::init()
+        bool restore();
+        //restores an instance created after OS::init()
+        bool restore(BasePersistent* instance);
+        //copies a record into the staging buffer, returns true if the record had to be dropped
+        bool stage(BasePersistent* owner, const void* data, uint16_t size);
+        //writes all staged records to the SD card, called by an interrupt it only requests the commit from service()
+        void commit();
+        //commits the staged records every commitIntervall_ms, has to be called regularly
+        void service();
+        //called by SUPC_Handler, dumps the staged records as soon as the SD card is not in use
+        void onPowerFailure();
+        void closeAllFiles();
+        const IoStatistics& getIoStatistics(){
+            return statistics;
+        }
+        String getIoStatisticsString();
 };
 
 
 class BasePersistent{
+    friend class PersistentTracker;
+    friend class PersistentLog;
     protected:
         String filename;
         unsigned long maxNumberOfBackLogEntries;
-        unsigned long numberOfBackLogEntries;
         unsigned long minIntervall;
         unsigned long lastWrite;
-        unsigned long fileSize;
-        bool onSecondBank;
         bool onlyLogChanges;
         bool initialValueLoaded;
+        uint16_t channel; //assigned by PersistentTracker::restore(), see CHANNELS in PERSISTENT LOG EXPLANATION
+        volatile uint16_t stagedRecords;
+        //records are counted since the channel was created, see PERSISTENT LOG EXPLANATION
+        volatile uint32_t totalEntries; //staged and committed, incremented by the OS tick
+        uint32_t committedEntries;
+        uint32_t firstEntry; //the oldest record still in the log
+        LogCursor historyCursor; //of the last getElement()
+        PersistentLog* log; //the raw log or the log of a rollup tier
+        virtual void setCommittedValue(const uint8_t* data) = 0;
+        virtual const void* getCommittedValue() = 0;
+        virtual uint8_t getObjectSize() = 0;
+        virtual ValueCoding getValueCoding() = 0;
+        //reads history entry index with the given cursor, returns true if the entry can not be read
+        bool readHistory(LogCursor& cursor, size_t index, void* value, uint8_t size){
+            unsigned long numberOfEntries = getNumbersOfEntries();
+            if(index >= numberOfEntries) return true;
+            uint32_t entry = totalEntries - numberOfEntries + index;
+            PersistentTracker::SdAccess access;
+            if(entry >= committedEntries) PersistentTracker::getInstance().commit();
+            if(!cursor.valid || cursor.owner != this || cursor.entry != entry){
+                if(log->seek(cursor, this, entry)) return true;
+            }
+            return log->next(cursor, value, size);
+        }
     private:
         
     public:
@@ -144,36 +598,50 @@ class BasePersistent{
         virtual bool readObjectFromSD() = 0;
         virtual bool init() = 0;
         static volatile bool initComplete;
+        const String& getFilename() const {
+            return filename;
+        }
         
     
         BasePersistent(String Filename)
             :   filename(String(Filename)),
                 maxNumberOfBackLogEntries(10000000),
-                numberOfBackLogEntries(0),
                 minIntervall(1000),
                 lastWrite(millis()),
-                fileSize(0),
-                onSecondBank(false),
                 onlyLogChanges(false),
-                initialValueLoaded(false)
+                initialValueLoaded(false),
+                channel(PersistentLog::checkpointChannel),
+                stagedRecords(0),
+                totalEntries(0),
+                committedEntries(0),
+                firstEntry(0),
+                log(&PersistentTracker::getInstance().getLog())
             {
-            PersistentTracker::getInstance().registeInstance(this);
             filename.replace(" ","_");
+            PersistentTracker::getInstance().registeInstance(this);
             }
+        unsigned long getNumbersOfEntries(){
+            uint32_t entries = totalEntries - firstEntry;
+            return entries < maxNumberOfBackLogEntries ? entries : maxNumberOfBackLogEntries;
+        }
+        //returns the number of bytes the history occupies in the log without compression
         unsigned long getSize(){
-            return fileSize;
+            return getNumbersOfEntries() * (sizeof(LogRecordHeader) + getObjectSize());
         }
         String getStateString(){
             String stateString = "";
             stateString += "filename: " + String(filename) + "\n";
+            stateString += "channel: " + String(channel) + "\n";
             stateString += "maxNumberOfBackLogEntries: " + String(maxNumberOfBackLogEntries)+ "\n";
-            stateString += "numberOfBackLogEntries: " + String(numberOfBackLogEntries)+ "\n";
+            stateString += "numberOfBackLogEntries: " + String(getNumbersOfEntries())+ "\n";
             stateString += "minIntervall: " + String(minIntervall)+ "\n";
             stateString += "lastWrite: " + String(lastWrite)+ "\n";
-            stateString += "fileSize: " + String(fileSize)+ "\n";
-            stateString += "onSecondBank: " + String(onSecondBank)+ "\n";
+            stateString += "totalEntries: " + String(totalEntries)+ "\n";
+            stateString += "committedEntries: " + String(committedEntries)+ "\n";
+            stateString += "firstEntry: " + String(firstEntry)+ "\n";
             stateString += "onlyLogChanges: " + String(onlyLogChanges)+ "\n";
             stateString += "initialValueLoaded: " + String(initialValueLoaded)+ "\n";
+            stateString += "stagedRecords: " + String(stagedRecords)+ "\n";
             stateString += "initComplete: " + String(initComplete)+ "\n";
             return stateString;
         }
@@ -181,17 +649,151 @@ class BasePersistent{
 
 
 
+//One rollup tier of a Persistent<T>, see ROLLUP EXPLANATION
+template<typename T>
+class RollupChannel : public BasePersistent{
+    static_assert(sizeof(RollupSample<T>) + 4 + sizeof(LogRecordHeader) <= PersistentLog::blockSize, "A record has to fit into a block of the PersistentLog");
+    private:
+        uint32_t interval_ms;
+        uint32_t bucket; //millis() / interval_ms of the open sample
+        double sum;
+        RollupSample<T> openSample;
+        RollupSample<T> lastSample; //the latest sample in the log
+        void setCommittedValue(const uint8_t* data) override {
+            memcpy(&lastSample, data, sizeof(lastSample));
+        }
+        const void* getCommittedValue() override {
+            return &lastSample;
+        }
+        uint8_t getObjectSize() override {
+            return sizeof(lastSample);
+        }
+        ValueCoding getValueCoding() override {
+            return ValueCoding::RAW;
+        }
+    public:
+        RollupChannel(String Name, RollupTier Tier)
+            :   BasePersistent(Name),
+                interval_ms(getRollupInterval_ms(Tier)),
+                bucket(0),
+                sum(0)
+            {
+                openSample.count = 0;
+                log = &PersistentTracker::getInstance().getLog(Tier);
+                if(initComplete) PersistentTracker::getInstance().restore(this);
+        }
+        //adds a value to the open sample, a value of a later interval stages the open sample first
+        void add(const T& value){
+            uint32_t now = millis() / interval_ms;
+            if(openSample.count > 0 && now != bucket){
+                openSample.mean = sum / openSample.count;
+                if(!PersistentTracker::getInstance().stage(this, &openSample, sizeof(openSample))) totalEntries++;
+                openSample.count = 0;
+            }
+            if(openSample.count == 0){
+                bucket = now;
+                sum = 0;
+                openSample.minimum = value;
+                openSample.maximum = value;
+            }
+            if(value < openSample.minimum) openSample.minimum = value;
+            if(value > openSample.maximum) openSample.maximum = value;
+            sum += value;
+            openSample.count++;
+        }
+        //reads sample index of the tier, returns true if the sample can not be read
+        bool readSample(LogCursor& cursor, size_t index, RollupSample<T>& sample){
+            return readHistory(cursor, index, &sample, sizeof(sample));
+        }
+        //the samples are staged by add()
+        bool writeObjectToSD() override {
+            return true;
+        }
+        bool readObjectFromSD() override {
+            return false;
+        }
+        bool init() override {
+            return false;
+        }
+};
+
+//Fixed storage of the RollupChannels of all Persistent<T>, see ROLLUP EXPLANATION
+class RollupPool{
+    public:
+        //two per Persistent<T> with rollups
+        static constexpr size_t maxChannels = 16;
+        //the largest RollupChannel of an arithmetic T
+        static constexpr size_t slotSize = sizeof(RollupChannel<uint64_t>) > sizeof(RollupChannel<double>) ? sizeof(RollupChannel<uint64_t>) : sizeof(RollupChannel<double>);
+        static size_t getFreeSlots(){
+            return maxChannels - used;
+        }
+        //returns the storage of a RollupChannel, the slot is never given back
+        static void* take(){
+            if(used == maxChannels) return nullptr;
+            return slots[used++].data;
+        }
+    private:
+        struct Slot{
+            alignas(8) uint8_t data[slotSize];
+        };
+        static Slot slots[maxChannels];
+        static size_t used;
+};
+
 template<typename T>
 class Persistent : public BasePersistent  {
     static_assert(std::is_pod<T>::value, "Only types with no dynamic memory are allowed!");
-    private:
-        typename std::remove_volatile<T>::type object;
-        typename std::remove_volatile<T>::type lastObjectValue;
+    static_assert(sizeof(T) + 4 + sizeof(LogRecordHeader) <= PersistentLog::blockSize, "A record has to fit into a block of the PersistentLog");
     public:
-        unsigned long getNumbersOfEntries(){
-            return numberOfBackLogEntries;
+        typedef typename std::remove_volatile<T>::type ValueType;
+    private:
+        ValueType object;
+        ValueType lastObjectValue; //the latest value in the log
+        ValueType lastStagedValue; //for onlyLogChanges
+        void setCommittedValue(const uint8_t* data) override {
+            memcpy(&lastObjectValue, data, sizeof(lastObjectValue));
         }
-        
+        const void* getCommittedValue() override {
+            return &lastObjectValue;
+        }
+        uint8_t getObjectSize() override {
+            return sizeof(object);
+        }
+        ValueCoding getValueCoding() override {
+            if(sizeof(ValueType) > sizeof(uint64_t)) return ValueCoding::RAW;
+            if(std::is_integral<ValueType>::value || std::is_enum<ValueType>::value) return ValueCoding::INTEGER;
+            return ValueCoding::BITS;
+        }
+        RollupChannel<ValueType>* rollups[numberOfRollupTiers];
+        bool readEntry(LogCursor& cursor, size_t index, ValueType& value){
+            return readHistory(cursor, index, &value, sizeof(value));
+        }
+        void addToRollups(std::true_type){
+            for(RollupChannel<ValueType>* rollup : rollups){
+                if(rollup != nullptr) rollup->add(object);
+            }
+        }
+        void addToRollups(std::false_type){}
+    public:
+        //Streams consecutive history entries, see PERSISTENT LOG EXPLANATION
+        class Cursor{
+            private:
+                Persistent<T>* persistent;
+                LogCursor logCursor;
+                size_t index;
+            public:
+                Cursor(Persistent<T>* Persistent, size_t Index): persistent(Persistent), index(Index){}
+                //reads the next entry, returns false at the end of the history
+                bool next(ValueType& value){
+                    if(!initComplete) return false;
+                    if(persistent->readEntry(logCursor, index, value)) return false;
+                    index++;
+                    return true;
+                }
+                size_t getIndex(){
+                    return index;
+                }
+        };
         void setMaxNumberOfBackLogEntries(unsigned long number){
             if(number < 20) number = 20;
             maxNumberOfBackLogEntries = number;
@@ -199,114 +801,79 @@ class Persistent : public BasePersistent  {
         void setMinIntervall(unsigned long intervall){
             minIntervall = intervall;
         }
+        //skips values equal to the last written one, see COMPRESSION EXPLANATION
+        void setOnlyLogChanges(bool OnlyLogChanges){
+            onlyLogChanges = OnlyLogChanges;
+        }
 
         
         [[nodiscard]] bool writeObjectToSD() override {
             if(!initComplete) return true;
-            
+            addToRollups(std::is_arithmetic<ValueType>());
             if((millis()-lastWrite < minIntervall) && initialValueLoaded) return true;
-            String currentBankName = String(filename);
-            if(numberOfBackLogEntries == maxNumberOfBackLogEntries) onSecondBank = true;
-            if(numberOfBackLogEntries >= 2 * maxNumberOfBackLogEntries){
-                if(onSecondBank){
-                    if(SD.exists(filename)) SD.remove(filename);
-                    onSecondBank = false;
-                }else{
-                    if(SD.exists(String(filename) + "_2")) SD.remove(String(filename) + "_2");
-                    onSecondBank = true;
-                }
-                numberOfBackLogEntries = maxNumberOfBackLogEntries;
-            }
-
-            if(onSecondBank) currentBankName += "_2";
-            auto file = SD.open(currentBankName,FILE_WRITE);
-            if(!file) return true;
-            if(PersistentTracker::getInstance().powerFailureImminent) return false;
-            file.write(reinterpret_cast<const char*>(&object),sizeof(object));
-            fileSize = file.size();
-            numberOfBackLogEntries++;
-            file.flush();
-            file.close();
+            if(onlyLogChanges && initialValueLoaded && memcmp(&object, &lastStagedValue, sizeof(object)) == 0) return true;
+            if(PersistentTracker::getInstance().stage(this, &object, sizeof(object))) return true;
+            lastStagedValue = object;
+            totalEntries++;
             lastWrite = millis();
             return false;
         }
 
+        //loads the latest value in the log, PersistentTracker::restore() has read it at boot
         [[nodiscard]] bool readObjectFromSD() override {
-            String currentBankName = String(filename);
-            Serial.println("Start read: " + currentBankName);
-            if(onSecondBank) currentBankName += "_2";
-
             if(!initComplete) return true;
-
-            if(!SD.exists(currentBankName)) return false;
-            auto file = SD.open(currentBankName, FILE_READ);
-            if (!file) return true;
-            if(file.size() >= sizeof(object)){
-                file.seek(file.size() - sizeof(object));
-            }else{
-                return true;
-            }
-            file.read(reinterpret_cast<uint8_t*>(&object), sizeof(object));
-            file.close();
+            if(committedEntries > 0 && stagedRecords == 0) object = lastObjectValue;
             return false;
         }
 
         T getElement(size_t index){
             if(!initComplete) return object;
-            if(index >= numberOfBackLogEntries) return object;
-            
-            if(numberOfBackLogEntries <= maxNumberOfBackLogEntries && !onSecondBank){
-                if(!SD.exists(filename)) return object;
-                auto file = SD.open(filename, FILE_READ);
-                if(!file) return object;
-                T ret;
-                file.seek(index * sizeof(object));
-                file.read(reinterpret_cast<uint8_t*>(&ret), sizeof(object));
-                file.close();
-                return ret;
-            }
+            ValueType ret;
+            if(readEntry(historyCursor, index, ret)) return object;
+            return ret;
+        }
 
-            if(index >= maxNumberOfBackLogEntries){
-                if(!onSecondBank){
-                    if(!SD.exists(filename)) return object;
-                    auto file = SD.open(filename, FILE_READ);
-                    if(!file) return object;
-                    T ret;
-                    file.seek((index - maxNumberOfBackLogEntries) * sizeof(object));
-                    file.read(reinterpret_cast<uint8_t*>(&ret), sizeof(object));
-                    file.close();
-                    return ret;
-                }else{
-                    if(!SD.exists(String(filename) + "_2")) return object;
-                    auto file = SD.open(String(filename) + "_2", FILE_READ);
-                    if(!file) return object;
-                    T ret;
-                    file.seek((index - maxNumberOfBackLogEntries) * sizeof(object));
-                    file.read(reinterpret_cast<uint8_t*>(&ret), sizeof(object));
-                    file.close();
-                    return ret;
-                }
-            }else{
-                if(!onSecondBank){
-                    if(!SD.exists(String(filename) + "_2")) return object;
-                    auto file = SD.open(String(filename) + "_2", FILE_READ);
-                    if(!file) return object;
-                    T ret;
-                    file.seek(index * sizeof(object));
-                    file.read(reinterpret_cast<uint8_t*>(&ret), sizeof(object));
-                    file.close();
-                    return ret;
-                }else{
-                    if(!SD.exists(filename)) return object;
-                    auto file = SD.open(filename , FILE_READ);
-                    if(!file) return object;
-                    T ret;
-                    file.seek(index * sizeof(object));
-                    file.read(reinterpret_cast<uint8_t*>(&ret), sizeof(object));
-                    file.close();
-                    return ret;
-                }
+        //returns a cursor that streams the history starting at index
+        Cursor getCursor(size_t index){
+            return Cursor(this, index);
+        }
+
+        //reads up to count entries starting at index from into out, returns the number of entries read
+        size_t getRange(size_t from, size_t count, ValueType* out){
+            if(!initComplete) return 0;
+            Cursor cursor(this, from);
+            size_t read = 0;
+            while(read < count && cursor.next(out[read])) read++;
+            return read;
+        }
+
+        //adds the minute and hour rollup tiers, see ROLLUP EXPLANATION
+        template <typename U = ValueType>
+        typename std::enable_if<std::is_arithmetic<U>::value>::type
+            enableRollups(){
+            static_assert(sizeof(RollupChannel<ValueType>) <= RollupPool::slotSize && alignof(RollupChannel<ValueType>) <= 8, "The RollupChannel does not fit into a slot of the RollupPool");
+            if(rollups[0] != nullptr) return;
+            if(RollupPool::getFreeSlots() < numberOfRollupTiers){
+                ErrorHandler::getInstance().throwError(0x0, "No RollupPool slots left for the rollups of " + filename, SeverityLevel::NORMAL);
+                return;
             }
+            rollups[(uint8_t)RollupTier::MINUTE] = new (RollupPool::take()) RollupChannel<ValueType>(filename + ".M", RollupTier::MINUTE);
+            rollups[(uint8_t)RollupTier::HOUR] = new (RollupPool::take()) RollupChannel<ValueType>(filename + ".H", RollupTier::HOUR);
+        }
+
+        unsigned long getNumberOfRollups(RollupTier tier){
+            RollupChannel<ValueType>* rollup = rollups[(uint8_t)tier];
+            return rollup == nullptr ? 0 : rollup->getNumbersOfEntries();
+        }
+
+        //reads up to count samples of the tier starting at index from into out, returns the number of samples read
+        size_t getRollupRange(RollupTier tier, size_t from, size_t count, RollupSample<ValueType>* out){
+            RollupChannel<ValueType>* rollup = rollups[(uint8_t)tier];
+            if(!initComplete || rollup == nullptr) return 0;
+            LogCursor cursor;
+            size_t read = 0;
+            while(read < count && !rollup->readSample(cursor, from + read, out[read])) read++;
+            return read;
         }
         
         T operator[](size_t index) {
@@ -314,67 +881,30 @@ class Persistent : public BasePersistent  {
         }
 
         [[nodiscard]] bool init() override{
-            bool firstBankFileOk = false;
-            if (!SD.begin(31)){
-                return true;
-            }
-
-            if(SD.exists(filename)){ //we start checking the base bank file
-                auto file = SD.open(filename, FILE_READ);
-                if(!file){
-                    return true;
-                }else{
-                    if(file.size() % sizeof(object) != 0){ //the size of the existing first bank file is not correct
-                        file.close();
-                        SD.remove(filename);
-                    }else{ // the first bank file is ok
-                        fileSize = file.size();
-                        numberOfBackLogEntries = fileSize / sizeof(object);
-                        firstBankFileOk = true;
-                        file.close();
-                    }
-                }
-            }
-            //Check if we are on the second Bank
-            if(SD.exists(String(filename) + "_2")){
-                auto file = SD.open(String(filename) + "_2", FILE_READ);
-                if(!file){
-                    return true;
-                }else{
-                    unsigned long  secondFileSize = file.size();
-                    file.close();
-                    if(secondFileSize % sizeof(object) != 0 && !firstBankFileOk){ //Make sure the second bank file has to correct length 
-                        SD.remove(String(filename) + "_2"); //if the lenght is not correct we delete the file.
-                    }else{ //the second bank file is ok -> we can set the number of elements in the file
-                        numberOfBackLogEntries += secondFileSize / sizeof(object);
-                        if(secondFileSize < fileSize){
-                            fileSize = secondFileSize;
-                            onSecondBank = true;
-                        }
-                    }
-                }
-                
-            } //we have checked all conditions for the second bank file
-            if(!SD.exists(filename)){
-                writeObjectToSD();
-                Serial.println("created: " + filename);
-            } 
+            bool failed = false;
+            //the first value of a new channel is the initial value, it fails if the persistence did not start or the staging
+            //buffer is full
+            if(committedEntries == 0 && stagedRecords == 0) failed = writeObjectToSD();
+            else if(stagedRecords == 0) lastStagedValue = lastObjectValue;
             readObjectFromSD();
             initialValueLoaded = true;
-            return false;
+            return failed;
         }
         
         template <typename... Args>
         Persistent(String FileName, Args&&... args) 
             :   BasePersistent(String(FileName)),   
-                object(std::forward<Args>(args)...)
+                object(std::forward<Args>(args)...),
+                lastObjectValue(object),
+                lastStagedValue(object)
                 
             {
+                for(RollupChannel<ValueType>*& rollup : rollups) rollup = nullptr;
                 if(initComplete){
-                    if(!SD.exists(filename)){
-                         writeObjectToSD();
-                    }else{
-                        readObjectFromSD();
+                    //constructed after OS::init(), the log has been restored without this channel
+                    PersistentTracker::getInstance().restore(this);
+                    if(init()){
+                        ErrorHandler::getInstance().throwError(0x0, "The initial value of Persistent " + filename + " could not be logged", SeverityLevel::NORMAL);
                     }
                 }    
         }
@@ -393,7 +923,8 @@ class Persistent : public BasePersistent  {
         typename std::enable_if<has_assignment_operator<U>::value>::type
             operator= (const U& rhs)  {
             object = static_cast<T>(rhs);
-            if(initComplete) writeObjectToSD();
+            //a value that could not be staged is counted in the statistics of the PersistentTracker
+            if(initComplete) (void)writeObjectToSD();
             
         }
 
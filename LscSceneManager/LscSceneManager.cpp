@@ -22,6 +22,11 @@
 
 std::vector<BaseUI_element*> ElementTracker::elements;
 std::vector<std::vector<BaseUI_element*>> ElementTracker::clearLayers;
+std::vector<ScreenRect> ElementTracker::damagedRects;
+
+SpritePool::Slot SpritePool::slots[SpritePool::maxSlots] = {};
+uint32_t SpritePool::usedBytes = 0;
+uint32_t SpritePool::useCount = 0;
 
 volatile bool Rules::allowed = true;
 
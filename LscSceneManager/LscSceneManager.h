@@ -95,6 +95,78 @@ T* getStateFromDerived(BaseExposedState* basePtr) {
 
 struct BaseUI_element;
 
+      //---- DAMAGE EXPLANATION ----
+  /*
+    The UI_elements draw straight to the tft and remove themselves by overdrawing their pixels in the background color.
+    This is cheap as long as elements do not overlap. If they do, clearing or moving one element also erases the pixels of
+    the elements below or on top of it. To repair this an element marks the area it used to cover as damaged with damage()
+    whenever it is removed from that area (destructor, setX(), rotate()...). The ElementTracker collects the damaged
+    rectangles of a frame and merges overlapping or neighbouring ones. SceneManager::repaintDamage() (called once per frame
+    by switchScene()) then repaints each merged rectangle: the tft is clipped to the rectangle, the rectangle is filled with
+    the background color and all visible elements whose getBounds() intersect it are redrawn in the order they were
+    created, i.e. back to front. Only the pixels inside the rectangle are sent to the display. A rectangle no visible
+    element intersects is skipped, the element that damaged it already cleared it.
+    Elements hidden by clearAllElementsLayer() (behind a popup) are not repainted until reDrawLastLayer().
+    A change of the background color damages the whole screen, every background pixel changes. switchScene() builds the
+    scene again and the next frame repaints the screen once. A change of the foreground color only builds the scene again,
+    the elements it removes damage their own area.
+    The popups (StandardMenu) cover the whole screen. clearAllElementsLayer() therefore clears every element of the layer
+    below and reDrawLastLayer() draws them again. Both send only the pixels of the elements, a repaint of the damaged
+    screen would also fill the background of all of it.
+  */
+    //---- END DAMAGE EXPLANATION ----
+
+//A rectangle on the screen in pixels
+struct ScreenRect{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    static constexpr int16_t screenWidth = 320;
+    static constexpr int16_t screenHeight = 240;
+
+    ScreenRect(int16_t X = 0, int16_t Y = 0, int16_t W = 0, int16_t H = 0): x(X), y(Y), w(W), h(H){}
+    //the whole screen
+    static ScreenRect screen(){
+        return ScreenRect(0, 0, screenWidth, screenHeight);
+    }
+    //the smallest rectangle containing both points
+    static ScreenRect spanning(int X0, int Y0, int X1, int Y1){
+        return ScreenRect(X0 < X1 ? X0 : X1, Y0 < Y1 ? Y0 : Y1, (X1 > X0 ? X1 - X0 : X0 - X1) + 1, (Y1 > Y0 ? Y1 - Y0 : Y0 - Y1) + 1);
+    }
+    //the square around a circle
+    static ScreenRect aroundCircle(int X, int Y, int R){
+        return ScreenRect(X - R, Y - R, 2 * R + 1, 2 * R + 1);
+    }
+    bool isEmpty() const {
+        return w <= 0 || h <= 0;
+    }
+    int32_t area() const {
+        return isEmpty() ? 0 : (int32_t)w * h;
+    }
+    bool intersects(const ScreenRect& other) const {
+        return !isEmpty() && !other.isEmpty() && x < other.x + other.w && other.x < x + w && y < other.y + other.h && other.y < y + h;
+    }
+    //the smallest rectangle containing both rectangles. An empty rectangle is ignored
+    ScreenRect unite(const ScreenRect& other) const {
+        if(isEmpty()) return other;
+        if(other.isEmpty()) return *this;
+        int left = x < other.x ? x : other.x;
+        int top = y < other.y ? y : other.y;
+        int right = x + w > other.x + other.w ? x + w : other.x + other.w;
+        int bottom = y + h > other.y + other.h ? y + h : other.y + other.h;
+        return ScreenRect(left, top, right - left, bottom - top);
+    }
+    //the part of the rectangle that is on the screen
+    ScreenRect clipToScreen() const {
+        int left = x > 0 ? x : 0;
+        int top = y > 0 ? y : 0;
+        int right = x + w < screenWidth ? x + w : screenWidth;
+        int bottom = y + h < screenHeight ? y + h : screenHeight;
+        return ScreenRect(left, top, right - left, bottom - top);
+    }
+};
+
 //The ElementTracker keeps track of all UI_element instances that are created. When an element is created, a pointer
 //to the element will be stored in the ElementTracker. The tracker provides two functions one to register elments and 
 //one to remove elements. The Tracker is implemented as singelton. 
@@ -106,6 +178,10 @@ struct ElementTracker{
         //vecor that holds the pointer of all elements
         static std::vector<BaseUI_element*> elements;
         static std::vector<std::vector<BaseUI_element*>> clearLayers;
+        //the rectangles of the screen that have to be repainted, see DAMAGE EXPLANATION
+        static std::vector<ScreenRect> damagedRects;
+        //at most this many rectangles are tracked, further damage is merged into the rectangle that grows the least
+        static constexpr size_t maxDamagedRects = 8;
         //singelton lazy init
         static ElementTracker& getInstance() {
             static ElementTracker instance;
@@ -120,6 +196,141 @@ struct ElementTracker{
         static void removeElement(BaseUI_element* element){
             elements.erase(std::remove(elements.begin(), elements.end(), element), elements.end());
         }
+        //returns true if the element has been cleared by clearAllElementsLayer() and is waiting for reDrawLastLayer()
+        static bool isHidden(const BaseUI_element* element){
+            for(std::vector<BaseUI_element*> &layer : clearLayers){
+                if(std::find(layer.begin(), layer.end(), element) != layer.end()) return true;
+            }
+            return false;
+        }
+        //marks a rectangle of the screen to be repainted. Rectangles that overlap or touch are merged such that no pixel is
+        //repainted twice
+        static void damage(ScreenRect rect){
+            rect = rect.clipToScreen();
+            if(rect.isEmpty()) return;
+            bool merged = true;
+            while(merged){
+                merged = false;
+                for(size_t i = 0; i < damagedRects.size(); i++){
+                    ScreenRect united = damagedRects[i].unite(rect);
+                    //merging touching rectangles costs at most the pixels between them
+                    if(united.area() <= damagedRects[i].area() + rect.area() || damagedRects[i].intersects(rect)){
+                        rect = united;
+                        damagedRects.erase(damagedRects.begin() + i);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+            if(damagedRects.size() >= maxDamagedRects){
+                size_t best = 0;
+                int32_t bestGrowth = INT32_MAX;
+                for(size_t i = 0; i < damagedRects.size(); i++){
+                    int32_t growth = damagedRects[i].unite(rect).area() - damagedRects[i].area();
+                    if(growth < bestGrowth){
+                        bestGrowth = growth;
+                        best = i;
+                    }
+                }
+                ScreenRect united = damagedRects[best].unite(rect);
+                damagedRects.erase(damagedRects.begin() + best);
+                damage(united);
+                return;
+            }
+            damagedRects.push_back(rect);
+        }
+};
+
+      //---- SPRITE EXPLANATION ----
+  /*
+    A TextBox normally updates the screen glyph by glyph: every glyph that changes is removed in the background color and
+    redrawn, each one a separate window on the SPI bus and visible in between (fast changing readouts flicker).
+    A buffered TextBox (see TextBox::setBuffered()) instead renders its text into a sprite in RAM and sends it to the
+    display with a single pushSprite(), i.e. one window setup per update and no visible intermediate state.
+    The field of a buffered TextBox is the area its text has covered since it was last cleared. The sprite spans the
+    height of the field and the columns of the glyphs that changed, such that pushing it also removes the glyphs of a
+    longer previous text while the columns of the kept glyphs are not sent again.
+    A text has only two colors, so the sprites are 1 bit per pixel (a 320x24 field is 960 bytes) and the colors are set at
+    push time. Sprites are not owned by the TextBoxes but borrowed from the SpritePool right before the push. The pool keeps
+    a few sprites of the most recently used field sizes and never holds more than maxBytes. A field that does not fit is
+    drawn glyph by glyph as before.
+  */
+    //---- END SPRITE EXPLANATION ----
+
+//The SpritePool lends 1 bit sprites to the UI_elements, see SPRITE EXPLANATION. The pool is implemented as singelton.
+struct SpritePool{
+    private:
+        //private constructor to follow singelton pattern
+        SpritePool(){}
+        struct Slot{
+            TFT_eSprite* sprite;
+            int16_t width;
+            int16_t height;
+            uint32_t lastUse;
+        };
+        //returns the number of bytes a 1 bit sprite of width x height allocates
+        static uint32_t bytesOf(int16_t width, int16_t height){
+            return ((width + 7) >> 3) * (uint32_t)height + 1;
+        }
+        //frees the buffer of a slot, the sprite object itself is kept for the next size
+        static void release(Slot& slot){
+            if(slot.sprite != nullptr) slot.sprite->deleteSprite();
+            usedBytes -= bytesOf(slot.width, slot.height);
+            slot.width = 0;
+            slot.height = 0;
+        }
+    public:
+        //number of sprites the pool holds at most
+        static constexpr size_t maxSlots = 4;
+        //upper limit of the memory of all sprites together
+        static constexpr uint32_t maxBytes = 4096;
+        static Slot slots[maxSlots];
+        static uint32_t usedBytes;
+        static uint32_t useCount;
+        //singelton lazy init
+        static SpritePool& getInstance() {
+            static SpritePool instance;
+            return instance;
+        }
+        //returns a 1 bit sprite of exactly width x height pixels drawing to tft, or nullptr if the pool can not provide it.
+        //The sprite is only borrowed, its content is undefined and it must not be kept after the next call.
+        static TFT_eSprite* acquire(TFT_eSPI& tft, int16_t width, int16_t height){
+            if(width < 1 || height < 1 || bytesOf(width, height) > maxBytes) return nullptr;
+            useCount++;
+            for(Slot& slot : slots){
+                if(slot.width == width && slot.height == height){
+                    slot.lastUse = useCount;
+                    return slot.sprite;
+                }
+            }
+            //take an empty slot or the least recently used one, then free least recently used sprites until the new one fits
+            Slot* target = &slots[0];
+            for(Slot& slot : slots){
+                if(slot.width == 0){
+                    target = &slot;
+                    break;
+                }
+                if(slot.lastUse < target->lastUse) target = &slot;
+            }
+            if(target->width != 0) release(*target);
+            while(usedBytes + bytesOf(width, height) > maxBytes){
+                Slot* oldest = nullptr;
+                for(Slot& slot : slots){
+                    if(slot.width != 0 && (oldest == nullptr || slot.lastUse < oldest->lastUse)) oldest = &slot;
+                }
+                release(*oldest);
+            }
+            if(target->sprite == nullptr){
+                target->sprite = new TFT_eSprite(&tft);
+                target->sprite->setColorDepth(1);
+            }
+            if(target->sprite->createSprite(width, height) == nullptr) return nullptr;
+            target->width = width;
+            target->height = height;
+            target->lastUse = useCount;
+            usedBytes += bytesOf(width, height);
+            return target->sprite;
+        }
 };
 
 //Represents a UI_element all objects that reder something on the tft should inherit form this class.
@@ -129,11 +340,22 @@ struct ElementTracker{
 //          this is usefull to temporaraly clear the screen to for exemple render a popup
 //  2.  reDraw
 //          after clear has been called reDraw should be able to rerender an object based on the internal state
+//Elements that know where they draw override getBounds, see DAMAGE EXPLANATION
 struct BaseUI_element{
     private:
     public:
         virtual void clear() const  = 0;
         virtual void reDraw() = 0;
+        //returns the part of the screen the element draws on. An element that does not override this is redrawn whenever
+        //any part of the screen is repainted
+        virtual ScreenRect getBounds() const {
+            return ScreenRect::screen();
+        }
+        //marks the area the element covers as damaged. Call this after clear() when the element leaves the area. Elements
+        //that only draw a small part of their bounds (an outline) override this
+        virtual void damage() const {
+            ElementTracker::getInstance().damage(getBounds());
+        }
         //constructor adds the element to the ElementTracker
         BaseUI_element(){
             ElementTracker::getInstance().registerElement(this);
@@ -263,7 +485,6 @@ class SceneManager{
         
         std::vector<String> getComponentListAsString(){
             std::vector<String> retVec;
-            waitForSaveReadWrite();
             for(BaseComponent* component : ComponentTracker::getInstance().components){
                 retVec.push_back(String(component->componentName));
             }
@@ -271,7 +492,6 @@ class SceneManager{
         }
         std::vector<BaseExposedState*> getComponentStateListByIndex(uint16_t index){
             std::vector<BaseExposedState*> retVec;
-            waitForSaveReadWrite();
             for(std::pair<BaseComponent*,BaseExposedState*> pair : ComponentTracker::getInstance().states){
                 if(pair.first == ComponentTracker::getInstance().components[index]){
                 retVec.push_back(pair.second);
@@ -282,7 +502,6 @@ class SceneManager{
 
         std::vector<String> componentStateListToString(std::vector<BaseExposedState*> list){
             std::vector<String> retVec;
-            waitForSaveReadWrite();
             for(BaseExposedState* state: list){
                 retVec.push_back(state->stateName);
             }
@@ -320,18 +539,18 @@ class SceneManager{
         }
         static void reDrawLastLayer(){
             if(ElementTracker::getInstance().clearLayers.empty()) return;
+            //repair what the popup damaged while the layer is still hidden, the layer itself is redrawn completely
+            repaintDamage();
             for(BaseUI_element* element : ElementTracker::getInstance().clearLayers.back()){
                 element->reDraw();
             }
             ElementTracker::getInstance().clearLayers.pop_back();
         }
         uint32_t getBackGroundColor(){
-            waitForSaveReadWrite();
             return options.bColor;
         }
 
         uint32_t getForeGroundColor(){
-            waitForSaveReadWrite();
             return options.fColor;
         }
 
@@ -342,9 +561,32 @@ class SceneManager{
                 element->reDraw();
             }
         }
+        //repaints the damaged rectangles of the screen, see DAMAGE EXPLANATION
+        static void repaintDamage(){
+            if(ElementTracker::getInstance().damagedRects.empty()) return;
+            //a reDraw() may damage the screen again, this is repainted in the next frame
+            std::vector<ScreenRect> rects;
+            rects.swap(ElementTracker::getInstance().damagedRects);
+            std::vector<BaseUI_element*> intersecting;
+            for(const ScreenRect& rect : rects){
+                intersecting.clear();
+                for(BaseUI_element* element : ElementTracker::getInstance().elements){
+                    if(element->getBounds().intersects(rect) && !ElementTracker::getInstance().isHidden(element)){
+                        intersecting.push_back(element);
+                    }
+                }
+                if(intersecting.empty()) continue;
+                //clip everything to the rectangle such that only its pixels are sent to the display
+                tft.setViewport(rect.x, rect.y, rect.w, rect.h, false);
+                tft.fillRect(rect.x, rect.y, rect.w, rect.h, backGroundColor);
+                for(BaseUI_element* element : intersecting){
+                    element->reDraw();
+                }
+                tft.resetViewport();
+            }
+        }
         //returns the number of all currently defined elements
         static int getNumberOfElements(){
-            waitForSaveReadWrite();
             return ElementTracker::getInstance().elements.size();
         }
         //inizialises the SceneManager setting the first scene and background color
@@ -388,7 +630,6 @@ class SceneManager{
         }
         //will return false for as long as now new scene has to be loaded. Use this in a while loop in the every scene:
         //while(!sceneManager.switchScene()) 
-        bool colorSwitch = false;
         bool switchScene(){
             if(!systemStableFor20Sec && millis() > 20000){
                 if (SD.exists("F")){
@@ -399,23 +640,16 @@ class SceneManager{
                 }
                 systemStableFor20Sec = true;
             }
-            if(colorSwitch){
-                tft.fillScreen(backGroundColor);
-                reDrawAllElements();
-                colorSwitch = false;
-            }
+            PersistentTracker::getInstance().service(); //see WRITE BEHIND EXPLANATION in LscPersistence.h
+            repaintDamage(); //see DAMAGE EXPLANATION
+            //the scene is built again with the new colors, see DAMAGE EXPLANATION
             if(options.bColor != backGroundColor){
                 backGroundColor = options.bColor;
-                tft.fillScreen(backGroundColor);
-                reDrawAllElements();
-                colorSwitch = true;
+                ElementTracker::getInstance().damage(ScreenRect::screen());
                 return true;
             }
             if(options.fColor != defaultForeGroundColor){
-                clearAllElements();
                 defaultForeGroundColor = options.fColor;
-                reDrawAllElements();
-                colorSwitch = true;
                 return true;
             }
 
@@ -451,6 +685,14 @@ class SceneManager{
                     *point = *point * factor;
                 }
             }
+            //returns the smallest rectangle containing all points moved by offset
+            ScreenRect getBounds(const LinAlg::Vector_2D& offset) const {
+                ScreenRect bounds;
+                for(LinAlg::Vector_2D* point : collection){
+                    bounds = bounds.unite(ScreenRect(point->vec[0] + offset.vec[0], point->vec[1] + offset.vec[1], 1, 1));
+                }
+                return bounds;
+            }
         };
         struct ConstructionLineCollection{
             std::vector<ConstructionLine> collection;
@@ -467,6 +709,80 @@ class SceneManager{
                 }
             }
         };
+        //The shape of a symbol (Valve, Pump...) in screen coordinates. A symbol is constructed from points that are rotated
+        //and scaled with doubles. After every such transformation the symbol bakes its shape into integer lines, circles, arcs
+        //and triangles once, drawing and clearing then only walks these lists. Horizontal and vertical lines are sent as fast
+        //lines and the whole symbol is drawn in one SPI transaction.
+        struct SymbolGeometry{
+            struct Line{
+                int16_t x0, y0, x1, y1;
+                Line(int X0, int Y0, int X1, int Y1): x0(X0), y0(Y0), x1(X1), y1(Y1){}
+            };
+            struct Circle{
+                int16_t x, y, r;
+                Circle(int X, int Y, int R): x(X), y(Y), r(R){}
+            };
+            //a ring of drawArc() from r to r + 1, the angles are in degrees
+            struct Arc{
+                int16_t x, y, r, startAngle, endAngle;
+                Arc(int X, int Y, int R, int StartAngle, int EndAngle): x(X), y(Y), r(R), startAngle(StartAngle), endAngle(EndAngle){}
+            };
+            struct Triangle{
+                int16_t x0, y0, x1, y1, x2, y2;
+                Triangle(int X0, int Y0, int X1, int Y1, int X2, int Y2): x0(X0), y0(Y0), x1(X1), y1(Y1), x2(X2), y2(Y2){}
+            };
+            std::vector<Line> lines;
+            std::vector<Circle> circles;
+            std::vector<Arc> arcs;
+            std::vector<Triangle> triangles;
+            ScreenRect bounds;  //the getBounds() of the symbol, computed once per transformation
+
+            void reset(){
+                lines.clear();
+                circles.clear();
+                arcs.clear();
+                triangles.clear();
+                bounds = ScreenRect();
+            }
+            void addLines(const ConstructionLineCollection& Lines){
+                for(const ConstructionLine& line : Lines.collection){
+                    lines.push_back(Line(line.start->vec[0] + Lines.offset->vec[0], line.start->vec[1] + Lines.offset->vec[1], line.end->vec[0] + Lines.offset->vec[0], line.end->vec[1] + Lines.offset->vec[1]));
+                }
+            }
+            void addCircle(int X, int Y, int R){
+                circles.push_back(Circle(X, Y, R));
+            }
+            void addArc(int X, int Y, int R, int StartAngle, int EndAngle){
+                arcs.push_back(Arc(X, Y, R, StartAngle, EndAngle));
+            }
+            //the points of the triangle are relative to offset
+            void addTriangle(const LinAlg::Vector_2D& offset, const LinAlg::Vector_2D& A, const LinAlg::Vector_2D& B, const LinAlg::Vector_2D& C){
+                triangles.push_back(Triangle(A.vec[0] + offset.vec[0], A.vec[1] + offset.vec[1], B.vec[0] + offset.vec[0], B.vec[1] + offset.vec[1], C.vec[0] + offset.vec[0], C.vec[1] + offset.vec[1]));
+            }
+
+            void draw(uint32_t Color) const {
+                tft.startWrite();
+                for(const Line& line : lines){
+                    if(line.y0 == line.y1){
+                        tft.drawFastHLine(line.x0 < line.x1 ? line.x0 : line.x1, line.y0, abs(line.x1 - line.x0) + 1, Color);
+                    }else if(line.x0 == line.x1){
+                        tft.drawFastVLine(line.x0, line.y0 < line.y1 ? line.y0 : line.y1, abs(line.y1 - line.y0) + 1, Color);
+                    }else{
+                        tft.drawLine(line.x0, line.y0, line.x1, line.y1, Color);
+                    }
+                }
+                for(const Circle& circle : circles){
+                    tft.drawCircle(circle.x, circle.y, circle.r, Color);
+                }
+                for(const Arc& arc : arcs){
+                    tft.drawArc(arc.x, arc.y, arc.r + 1, arc.r, arc.startAngle, arc.endAngle, Color, backGroundColor, false);
+                }
+                for(const Triangle& triangle : triangles){
+                    tft.fillTriangle(triangle.x0, triangle.y0, triangle.x1, triangle.y1, triangle.x2, triangle.y2, Color);
+                }
+                tft.endWrite();
+            }
+        };
 
 
         struct UI_elements{
@@ -497,6 +813,8 @@ class SceneManager{
                         state after the screen has been cleared.
                 3.  There might be an issue if member variables are changed by an interrupt. Consider for which variables this
                     might be the case and declare them as volatile.
+                4.  Elements should override ScreenRect getBounds() const and call damage() after clear() when they leave an
+                    area (destructor, moving, rotating...) such that overlapping elements are repaired, see DAMAGE EXPLANATION.
                 
             */
             //A TextBox can be used to display text. 
@@ -510,6 +828,11 @@ class SceneManager{
                 }
                 ~StatusIndicator(){
                     clear();
+                    damage();
+                }
+                ScreenRect getBounds() const override{
+                    if(offset != nullptr) return ScreenRect::aroundCircle((*offset + *position).vec[0],(*offset + *position).vec[1],5);
+                    return ScreenRect::aroundCircle(position->vec[0],position->vec[1],5);
                 }
                 void setStatus(bool Active){
                     if(Active == active) return;
@@ -548,85 +871,145 @@ class SceneManager{
                     uint32_t backColour;
                     uint32_t fontColour;
                     const GFXfont* font;
+                    bool buffered;      //if true the text is pushed as one sprite, see SPRITE EXPLANATION
+                    ScreenRect field;   //the area the text of a buffered TextBox covered since it was last cleared
                     
-                    //removes a single character from the tft
-                    void clearChar(String Text, uint16_t index) const {
-                        tft.setFreeFont(font);
-                        tft.setTextColor(backColour);
-                        //we basically overrite the character on the screen with the exact same char in the background color
-                        //by doing this we achive pixel level difference update which is as efficient as we can get
-                        //there are a lot of highlevel function calls to string functions, but compared to the time if takes to 
-                        //write to the tft its neglectable
-                        if(Text.length() > index){
-                            tft.drawChar(Text[index], xPos + tft.textWidth(Text.substring(0,index+1)) -tft.textWidth(String(Text[index])),yPos);
+                    //returns the advance of a character in the font of the TextBox, i.e. the distance to the next character.
+                    //The glyph table of the GFXfont is the advance table, no String is created or summed up
+                    int16_t advanceOf(char c) const {
+                        if(font == nullptr) return tft.textWidth(String(c));
+                        if((uint8_t)c < font->first || (uint8_t)c > font->last) return 0;
+                        return font->glyph[(uint8_t)c - font->first].xAdvance;
+                    }
+
+                    //calls Removed(c, x) for every glyph of text and Added(c, x) for every glyph of Text that is not kept when
+                    //text is replaced by Text. A glyph is kept if the same character is at the same x position in both strings.
+                    //The x positions are summed up while walking both strings, one pass per string
+                    template<typename RemovedF, typename AddedF>
+                    void forEachChangedGlyph(const String& Text, RemovedF Removed, AddedF Added) const {
+                        uint16_t textLength = text.length();
+                        uint16_t TextLength = Text.length();
+
+                        int16_t textX = xPos;
+                        int16_t TextX = xPos;
+                        uint16_t k = 0;
+                        for(uint16_t i = 0; i < textLength; i++){
+                            while(k < TextLength && TextX < textX){
+                                TextX += advanceOf(Text[k]);
+                                k++;
+                            }
+                            if(k >= TextLength || TextX != textX || Text[k] != text[i]){
+                                Removed(text[i], textX);
+                            }
+                            textX += advanceOf(text[i]);
                         }
-                        tft.setTextColor(fontColour);
-                    }
-
-                    void update(String Text) const {  
-                        tft.setFreeFont(font);
-                        tft.setTextColor(fontColour, backColour);
 
-                        uint16_t textLength = text.length();
-                        uint16_t textSubstringLength = 0;
-                        uint16_t TextSubstringLength = 0;
-                        uint16_t TextCurrentCharWidth = 0;
-                        uint16_t textCurrentCharWidth = 0;
-
-                        if(tft.textWidth(text) > tft.textWidth(Text) && tft.textWidth(text) != 0){
-                            for(int cleared = text.length(); tft.textWidth(text.substring(0,cleared)) >= tft.textWidth(Text);cleared--){
-                                clearChar(text,cleared);
-                                if (cleared <= 0) break;
+                        textX = xPos;
+                        TextX = xPos;
+                        k = 0;
+                        for(uint16_t i = 0; i < TextLength; i++){
+                            while(k < textLength && textX < TextX){
+                                textX += advanceOf(text[k]);
+                                k++;
                             }
+                            if(k >= textLength || textX != TextX || text[k] != Text[i]){
+                                Added(Text[i], TextX);
+                            }
+                            TextX += advanceOf(Text[i]);
                         }
+                    }
 
-                        uint32_t alreadyCleared = 0;
-                        for(uint16_t i = 0; i < Text.length();i++){
-                            textSubstringLength = tft.textWidth(text.substring(0,i + 1));
-                            TextSubstringLength = tft.textWidth(Text.substring(0,i + 1));
-                            TextCurrentCharWidth = tft.textWidth(String(Text[i]));
-
-                            if(i < textLength){
-                                    //WE NEED TO CLEAER
-
-                                    if(tft.textWidth(Text.substring(0,i)) == tft.textWidth(text.substring(0,alreadyCleared))){
-                                        if(text[alreadyCleared]==Text[i]){
-                                            alreadyCleared++;
-                                            continue;
-                                        }
-                                    }
-                                    while(true){
-                                        clearChar(text,alreadyCleared);
-
-                                        alreadyCleared += 1;
-
-                                        if(alreadyCleared>= text.length()) break;
-                                        if(tft.textWidth(Text.substring(0,i+1)) <= tft.textWidth(text.substring(0,alreadyCleared))) break;
-                                    }
-                                    
-                                    tft.drawChar(Text[i], xPos + tft.textWidth(Text.substring(0,i+1))-tft.textWidth(String(Text[i])),yPos );
-                            }else{
-                                tft.drawChar(Text[i], TextSubstringLength + xPos - TextCurrentCharWidth,yPos);
+                    //replaces text by Text on the tft. Every glyph of text that is not kept is removed by overwriting it in the
+                    //background colour and every glyph of Text that is not kept is drawn. By doing this we achive pixel level
+                    //difference update which is as efficient as we can get without a buffer
+                    void update(String Text) const {
+                        tft.setFreeFont(font);
+                        forEachChangedGlyph(Text,
+                            [this](char c, int16_t x){
+                                tft.setTextColor(backColour);
+                                tft.drawChar(c, x, yPos);
+                            },
+                            [this](char c, int16_t x){
+                                tft.setTextColor(fontColour, backColour);
+                                tft.drawChar(c, x, yPos);
+                            });
+                    }
+
+                    //renders Text into a sprite of the pool and pushes it to the field, which grows to cover Text. Only the columns
+                    //of the field with glyphs that are not kept are pushed, unless Whole is set. Returns false if the pool can not
+                    //provide the sprite, the tft has not been changed then. See SPRITE EXPLANATION
+                    bool pushText(String Text, bool Whole = false){
+                        if(font == nullptr) return false;
+                        ScreenRect area = field.unite(boundsOf(Text)).clipToScreen();
+                        ScreenRect push = area;
+                        if(!Whole){
+                            ScreenRect changed;
+                            auto unite = [&](char c, int16_t x){ changed = changed.unite(glyphBounds(c, x)); };
+                            forEachChangedGlyph(Text, unite, unite);
+                            changed = changed.clipToScreen();
+                            if(changed.isEmpty()){
+                                field = area;
+                                return true;
                             }
+                            //a multiple of 8 wide such that the pool mostly has a matching sprite
+                            int16_t width = (changed.w + 7) & ~7;
+                            if(width > area.w) width = area.w;
+                            int16_t left = changed.x;
+                            if(left + width > area.x + area.w) left = area.x + area.w - width;
+                            push = ScreenRect(left, area.y, width, area.h);
                         }
-                            
+                        if(push.isEmpty()) return true;
+                        TFT_eSprite* sprite = SpritePool::acquire(tft, push.w, push.h);
+                        if(sprite == nullptr) return false;
+                        sprite->fillSprite(0);
+                        sprite->setFreeFont(font);
+                        sprite->setTextColor(1);
+                        int16_t cursor = xPos - push.x;
+                        for(uint16_t i = 0; i < Text.length(); i++){
+                            sprite->drawChar(Text[i], cursor, yPos - push.y);
+                            cursor += advanceOf(Text[i]);
+                        }
+                        sprite->setBitmapColor(fontColour, backColour);
+                        sprite->pushSprite(push.x, push.y);
+                        field = area;
+                        return true;
+                    }
+
+                    //the pixels of the glyph c if it was drawn at x with its baseline at yPos
+                    ScreenRect glyphBounds(uint8_t c, int16_t x) const {
+                        if(c < font->first || c > font->last) return ScreenRect();
+                        const GFXglyph& glyph = font->glyph[c - font->first];
+                        return ScreenRect(x + glyph.xOffset, yPos + glyph.yOffset, glyph.width, glyph.height);
+                    }
+
+                    //the pixels of the glyphs of Text if it was drawn with its baseline at yPos
+                    ScreenRect boundsOf(const String& Text) const {
+                        ScreenRect bounds;
+                        int16_t cursor = xPos;
+                        for(uint16_t i = 0; i < Text.length(); i++){
+                            bounds = bounds.unite(glyphBounds(Text[i], cursor));
+                            cursor += advanceOf(Text[i]);
+                        }
+                        return bounds;
                     }
 
                 public:
                     void setX(uint16_t pos){
                         if(xPos == pos) return;
-                        String tempText = text;
                         clear();
+                        damage();
+                        field = ScreenRect();
                         xPos = pos;
-                        setText(tempText);
+                        reDraw();
 
                     }
                     void setY(uint16_t pos){
                         if(yPos == pos) return;
-                        String tempText = text;
-                        clear();                        
+                        clear();
+                        damage();
+                        field = ScreenRect();
                         yPos = pos;
-                        setText(tempText);
+                        reDraw();
                     }
                     uint16_t getX(){
                         return xPos;
@@ -642,21 +1025,32 @@ class SceneManager{
                         tft.setFreeFont(font);
                         return tft.fontHeight();
                     }
+                    //switches between glyph by glyph updates and pushing the whole text as one sprite, see SPRITE EXPLANATION
+                    void setBuffered(bool Buffered){
+                        buffered = Buffered;
+                    }
                     
 
-                    TextBox(uint16_t xPosition, uint16_t yPosition, String Text="" , const GFXfont* Font=defaultFont , uint32_t FontColour=defaultForeGroundColor , uint32_t BackColour=backGroundColor){
+                    TextBox(uint16_t xPosition, uint16_t yPosition, String Text="" , const GFXfont* Font=defaultFont , uint32_t FontColour=defaultForeGroundColor , uint32_t BackColour=backGroundColor, bool Buffered=false){
                         text = "";
                         xPos = xPosition;
                         yPos = yPosition;
                         font = Font;
                         backColour = BackColour;
                         fontColour = FontColour;
+                        buffered = Buffered;
                         tft.setFreeFont(font);
                         setText(Text);
                     }
 
                     ~TextBox(){
                         clear();
+                        damage();
+                    }
+                    //the pixels of the glyphs, the text is drawn with its baseline at yPos. A buffered TextBox also covers its field
+                    ScreenRect getBounds() const override{
+                        if(font == nullptr) return ScreenRect::screen();
+                        return boundsOf(text).unite(field);
                     }
                     void reDraw(){
                         String temp_text = text;
@@ -665,6 +1059,12 @@ class SceneManager{
                     }
                     void setColor(uint32_t Color){
                         if(Color == fontColour) return;
+                        if(buffered){
+                            uint32_t oldColor = fontColour;
+                            fontColour = Color;
+                            if(pushText(text, true)) return;
+                            fontColour = oldColor;
+                        }
                         uint32_t oldColor = backColour;
                         backColour = Color;
                         update("");
@@ -681,15 +1081,24 @@ class SceneManager{
                     
                     TextBox& operator=(String Text){
                         setText(Text);
+                        return *this;
                     }
 
                     void setText(String Text){
                         if(text != Text){
-                            update(Text);
+                            if(!buffered || !pushText(Text)){
+                                //the glyphs in the field are removed by update() as well, the field is not needed anymore
+                                field = ScreenRect();
+                                update(Text);
+                            }
                         }
                         text = Text;
                     }
                     void clear() const override{
+                        if(!field.isEmpty()){
+                            tft.fillRect(field.x, field.y, field.w, field.h, backColour);
+                            return;
+                        }
                         update("");
                         //setText("");
                     }
@@ -711,6 +1120,10 @@ class SceneManager{
                     }
                     ~CheckBox(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect(xPos,yPos,size,size);
                     }
                     void reDraw(){
                         tft.drawRect(xPos,yPos,size,size,foreColour);
@@ -735,6 +1148,7 @@ class SceneManager{
 
                     CheckBox& operator= (bool state){
                         setChecked(state);
+                        return *this;
                     }
 
                     explicit operator bool() const{
@@ -771,6 +1185,10 @@ class SceneManager{
                     }
                     ~ProgressBar(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect(xPosition,yPosition,width,height);
                     }
                     void reDraw(){
                         tft.drawRect(xPosition,yPosition, width,height,foreColour);
@@ -787,6 +1205,7 @@ class SceneManager{
                     }
                     ProgressBar& operator= (long Progress){
                         setProgress(Progress);
+                        return *this;
                     }
 
                     void setProgress(long Progress){
@@ -833,6 +1252,10 @@ class SceneManager{
                     }
                     ~Line(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect::spanning(xPosStart,yPosStart,xPosEnd,yPosEnd);
                     }
                     void clear() const{
                         tft.drawLine(xPosStart,yPosStart,xPosEnd,yPosEnd,backColor);
@@ -848,6 +1271,7 @@ class SceneManager{
                     void setPos(uint16_t XPosStart, uint16_t YPosStart, uint16_t XPosEnd, uint16_t YPosEnd){
                         if( XPosStart != xPosStart || XPosEnd != xPosEnd || YPosStart != yPosStart || YPosEnd != yPosEnd){
                             clear();
+                            damage();
                             xPosStart = XPosStart;
                             xPosEnd = XPosEnd;
                             yPosStart = YPosStart;
@@ -872,6 +1296,22 @@ class SceneManager{
                     } 
                     ~Rectangle() override {
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect(xPos,yPos,x_width,y_width);
+                    }
+                    //an outline damages its four edges, not the elements inside it. The edges do not overlap such that they are
+                    //not merged into the whole rectangle
+                    void damage() const override{
+                        if(filled || x_width <= 2 || y_width <= 2){
+                            BaseUI_element::damage();
+                            return;
+                        }
+                        ElementTracker::getInstance().damage(ScreenRect(xPos, yPos, x_width, 1));
+                        ElementTracker::getInstance().damage(ScreenRect(xPos, yPos + y_width - 1, x_width, 1));
+                        ElementTracker::getInstance().damage(ScreenRect(xPos, yPos + 1, 1, y_width - 2));
+                        ElementTracker::getInstance().damage(ScreenRect(xPos + x_width - 1, yPos + 1, 1, y_width - 2));
                     }
                     void clear() const{
                         if(filled){
@@ -900,13 +1340,168 @@ class SceneManager{
             };
 
 
-            struct Chart : BaseUI_element{ //TODO: Implement
+            //A trend chart of width x height pixels with a frame. Every sample is one column inside the frame. New samples are
+            //drawn at a cursor that sweeps from left to right and wraps around, the column at the cursor is kept empty such that
+            //the newest sample can be told apart from the oldest one. Only the column of the new sample and the empty column are
+            //sent to the display, each with one pushImage(), nothing is shifted. Scrolling the ILI9341 in hardware is no option,
+            //its scroll area always spans the whole height of the screen in landscape.
+            //The y axis is linear or logarithmic (pressures), the grid lines are at the decades or at the quarters of the range.
+            struct Chart : BaseUI_element{
+                private:
+                    uint16_t xPos;
+                    uint16_t yPos;
+                    uint16_t width;
+                    uint16_t height;
+                    bool logScale;
+                    double scaleMin;    //yMin, log10(yMin) for a logarithmic chart
+                    double scaleMax;    //yMax, log10(yMax) for a logarithmic chart
+                    uint32_t lineColour;
+                    uint32_t gridColour;
+                    uint32_t backColour;
+                    std::vector<int16_t> rows;          //the row of the sample in every column inside the frame, -1 if it has none
+                    std::vector<double> gridValues;     //the values of the horizontal grid lines
+                    std::vector<int16_t> gridRows;      //the rows of the horizontal grid lines
+                    uint16_t cursor;                    //the column the next sample is drawn in
+
+                    //returns the row inside the frame a value is drawn in, 0 is the top row. Values out of range are drawn at
+                    //the border, NAN is not drawn (-1)
+                    int16_t rowOf(double value) const {
+                        if(isnan(value)) return -1;
+                        int16_t lastRow = height - 3;
+                        double scaled = value;
+                        if(logScale) scaled = value > 0 ? log10(value) : scaleMin;
+                        double position = (scaled - scaleMin) / (scaleMax - scaleMin);
+                        if(position < 0) position = 0;
+                        if(position > 1) position = 1;
+                        return lastRow - (int16_t)(position * lastRow + 0.5);
+                    }
+
+                    //stores a sample at the cursor and moves the cursor to the next column, nothing is drawn
+                    void storeSample(double value){
+                        rows[cursor] = rowOf(value);
+                        cursor = (cursor + 1) % rows.size();
+                    }
+
+                    //sends one column inside the frame to the display. The sample is connected to the one in the column to the
+                    //left by a vertical line. The column at the cursor is empty
+                    void drawColumn(uint16_t column) const {
+                        uint16_t inner = height - 2;
+                        uint16_t line[ScreenRect::screenHeight];
+                        for(uint16_t i = 0; i < inner; i++) line[i] = backColour;
+                        for(int16_t row : gridRows) line[row] = gridColour;
+                        int16_t row = rows[column];
+                        if(column != cursor && row >= 0){
+                            int16_t from = row;
+                            if(column > 0 && rows[column - 1] >= 0) from = rows[column - 1];
+                            int16_t top = from < row ? from : row;
+                            int16_t bottom = from < row ? row : from;
+                            for(int16_t i = top; i <= bottom; i++) line[i] = lineColour;
+                        }
+                        bool swapBytes = tft.getSwapBytes();
+                        tft.setSwapBytes(true);
+                        tft.pushImage(xPos + 1 + column, yPos + 1, 1, inner, line);
+                        tft.setSwapBytes(swapBytes);
+                    }
+
                 public:
+                    Chart(uint16_t xPosition, uint16_t yPosition, uint16_t Width, uint16_t Height, double YMin, double YMax, bool LogScale = false, uint32_t LineColour = defaultForeGroundColor, uint32_t GridColour = TFT_DARKGREY, uint32_t BackColour = backGroundColor)
+                        :   xPos(xPosition),
+                            yPos(yPosition),
+                            width(Width < 4 ? 4 : Width),
+                            height(Height < 3 ? 3 : (Height > ScreenRect::screenHeight ? ScreenRect::screenHeight : Height)),
+                            logScale(LogScale && YMin > 0 && YMax > YMin),
+                            lineColour(LineColour),
+                            gridColour(GridColour),
+                            backColour(BackColour),
+                            cursor(0)
+                    {
+                        scaleMin = logScale ? log10(YMin) : YMin;
+                        scaleMax = logScale ? log10(YMax) : YMax;
+                        if(scaleMax <= scaleMin) scaleMax = scaleMin + 1;
+                        rows.assign(width - 2, -1);
+                        if(logScale){
+                            for(int decade = (int)ceil(scaleMin); decade <= (int)floor(scaleMax); decade++){
+                                gridValues.push_back(pow(10, decade));
+                            }
+                        }else{
+                            for(int quarter = 1; quarter < 4; quarter++){
+                                gridValues.push_back(YMin + (YMax - YMin) * quarter / 4);
+                            }
+                        }
+                        for(double value : gridValues) gridRows.push_back(rowOf(value));
+                        reDraw();
+                    }
+                    ~Chart(){
+                        clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect(xPos, yPos, width, height);
+                    }
                     void clear() const override{
+                        tft.fillRect(xPos, yPos, width, height, backColour);
+                    }
+                    void reDraw(){
+                        tft.drawRect(xPos, yPos, width, height, lineColour);
+                        for(uint16_t column = 0; column < rows.size(); column++) drawColumn(column);
+                    }
+
+                    //draws value in the column at the cursor and empties the next column
+                    void addSample(double value){
+                        uint16_t column = cursor;
+                        storeSample(value);
+                        drawColumn(column);
+                        drawColumn(cursor);
+                    }
+
+                    //draws all samples waiting in buffer, returns the number of samples drawn. Call this from the thread that
+                    //consumes the buffer
+                    template<typename ET, size_t S, typename IT, typename BT>
+                    size_t addSamples(RingBuf<ET, S, IT, BT>& buffer){
+                        ET sample;
+                        size_t count = 0;
+                        while(buffer.pop(sample)){
+                            addSample(sample);
+                            count++;
+                        }
+                        return count;
+                    }
 
+                    //draws count entries of the history of persistent starting at entry from, returns the number of entries drawn.
+                    //The history is streamed with a cursor (see PERSISTENT LOG EXPLANATION in LscPersistence.h), entries that
+                    //would be overwritten in the same call are skipped and every column is drawn once
+                    template<typename T>
+                    size_t addHistory(Persistent<T>& persistent, size_t from, size_t count){
+                        if(count > rows.size()){
+                            from += count - rows.size();
+                            count = rows.size();
+                        }
+                        typename Persistent<T>::Cursor historyCursor = persistent.getCursor(from);
+                        typename Persistent<T>::ValueType value;
+                        uint16_t first = cursor;
+                        size_t read = 0;
+                        while(read < count && historyCursor.next(value)){
+                            storeSample(value);
+                            read++;
+                        }
+                        for(size_t i = 0; i <= read && i < rows.size(); i++) drawColumn((first + i) % rows.size());
+                        return read;
                     }
-                private:
 
+                    //number of samples the chart shows
+                    uint16_t getNumberOfColumns() const {
+                        return rows.size();
+                    }
+                    uint16_t getNumberOfGridLines() const {
+                        return gridValues.size();
+                    }
+                    double getGridValue(uint16_t index) const {
+                        return gridValues[index];
+                    }
+                    //returns the y position of a grid line on the tft
+                    uint16_t getGridY(uint16_t index) const {
+                        return yPos + 1 + gridRows[index];
+                    }
             };
 
 
@@ -915,6 +1510,7 @@ class SceneManager{
                     bool open;
                     ConstructionPointCollection pointCollection;
                     ConstructionLineCollection lineCollection;
+                    SymbolGeometry geometry;
                     uint32_t lineColor;
                     LinAlg::Vector_2D zeroPoint;
                     LinAlg::Vector_2D upperLeft;
@@ -928,6 +1524,13 @@ class SceneManager{
                     LinAlg::Vector_2D valveActuator;
                     LinAlg::Vector_2D center;
                     StatusIndicator indicator;
+
+                    //bakes the shape into geometry, see SymbolGeometry
+                    void bake(){
+                        geometry.reset();
+                        geometry.addLines(lineCollection);
+                        geometry.bounds = pointCollection.getBounds(zeroPoint);
+                    }
                 public:
                     Valve(uint16_t xPos, uint16_t yPos, bool Open = false ,double Rotation = 0,double Scale = 1.3, uint32_t LineColor = defaultForeGroundColor) 
                             :zeroPoint(xPos,yPos),
@@ -965,21 +1568,30 @@ class SceneManager{
                         lineCollection.addLine(ConstructionLine(&leftConnection,&leftMidPoint));
                         lineCollection.addLine(ConstructionLine(&rightConnection,&rightMidPoint));
                         lineCollection.addLine(ConstructionLine(&center,&valveActuator));
+                        bake();
                         if(Rotation !=0 ) rotate(Rotation);
                         if(Scale !=1 ) scale(Scale);
                         reDraw();
                     }
                     ~Valve(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return geometry.bounds.unite(indicator.getBounds());
                     }
                     void rotate(double Angle){
                         clear();
+                        damage();
                         pointCollection.rotate(Angle);
+                        bake();
                         reDraw();
                     }
                     void scale(double factor){
                         clear();
+                        damage();
                         pointCollection.scale(factor);
+                        bake();
                         reDraw();
                     }
                     void setState(bool state){
@@ -993,12 +1605,12 @@ class SceneManager{
                         return LinAlg::Vector_2D((rightConnection + zeroPoint).vec[0],(rightConnection + zeroPoint).vec[1]);;
                     }
                     void reDraw() override{
-                        lineCollection.draw(lineColor);
+                        geometry.draw(lineColor);
                         indicator.setStatus(open);
                         indicator.reDraw();
                     }
                     void clear() const override{
-                        lineCollection.draw(backGroundColor);
+                        geometry.draw(backGroundColor);
                         indicator.clear();
                     }
             };
@@ -1007,6 +1619,7 @@ class SceneManager{
                     bool open;
                     ConstructionPointCollection pointCollection;
                     ConstructionLineCollection lineCollection;
+                    SymbolGeometry geometry;
                     uint32_t lineColor;
                     LinAlg::Vector_2D zeroPoint;
                     LinAlg::Vector_2D upperLeft;
@@ -1024,6 +1637,15 @@ class SceneManager{
                     LinAlg::Vector_2D gateLL;
                     LinAlg::Vector_2D gateLR;
                     StatusIndicator indicator;
+
+                    //bakes the shape into geometry, see SymbolGeometry
+                    void bake(){
+                        geometry.reset();
+                        geometry.addLines(lineCollection);
+                        geometry.addTriangle(zeroPoint, gateLL, gateLR, gateUL);
+                        geometry.addTriangle(zeroPoint, gateUL, gateUR, gateLR);
+                        geometry.bounds = pointCollection.getBounds(zeroPoint);
+                    }
                 public:
                     GateValve(uint16_t xPos, uint16_t yPos, bool Open = false ,double Rotation = 0,double Scale = 1.3, uint32_t LineColor = defaultForeGroundColor) 
                             :zeroPoint(xPos,yPos),
@@ -1069,21 +1691,30 @@ class SceneManager{
                         lineCollection.addLine(ConstructionLine(&leftConnection,&leftMidPoint));
                         lineCollection.addLine(ConstructionLine(&rightConnection,&rightMidPoint));
                         lineCollection.addLine(ConstructionLine(&center,&valveActuator));
+                        bake();
                         if(Rotation !=0 ) rotate(Rotation);
                         if(Scale !=1 ) scale(Scale);
                         reDraw();
                     }
                     ~GateValve(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return geometry.bounds.unite(indicator.getBounds());
                     }
                     void rotate(double Angle){
                         clear();
+                        damage();
                         pointCollection.rotate(Angle);
+                        bake();
                         reDraw();
                     }
                     void scale(double factor){
                         clear();
+                        damage();
                         pointCollection.scale(factor);
+                        bake();
                         reDraw();
                     }
                     void setState(bool state){
@@ -1100,17 +1731,13 @@ class SceneManager{
                         return LinAlg::Vector_2D((rightConnection + zeroPoint).vec[0],(rightConnection + zeroPoint).vec[1]);
                     }
                     void reDraw() override{
-                        lineCollection.draw(lineColor);
-                        tft.fillTriangle(gateLL.vec[0] + zeroPoint.vec[0],gateLL.vec[1] + zeroPoint.vec[1],gateLR.vec[0] + zeroPoint.vec[0],gateLR.vec[1] + zeroPoint.vec[1],gateUL.vec[0] + zeroPoint.vec[0],gateUL.vec[1] + zeroPoint.vec[1],lineColor);
-                        tft.fillTriangle(gateUL.vec[0] + zeroPoint.vec[0],gateUL.vec[1] + zeroPoint.vec[1],gateUR.vec[0] + zeroPoint.vec[0],gateUR.vec[1] + zeroPoint.vec[1],gateLR.vec[0] + zeroPoint.vec[0],gateLR.vec[1] + zeroPoint.vec[1],lineColor);
+                        geometry.draw(lineColor);
                         indicator.setStatus(open);
                         indicator.reDraw();
                     }
                     void clear() const override{
-                        lineCollection.draw(backGroundColor);
+                        geometry.draw(backGroundColor);
                         indicator.clear();
-                        tft.fillTriangle(gateLL.vec[0] + zeroPoint.vec[0],gateLL.vec[1] + zeroPoint.vec[1],gateLR.vec[0] + zeroPoint.vec[0],gateLR.vec[1] + zeroPoint.vec[1],gateUL.vec[0] + zeroPoint.vec[0],gateUL.vec[1] + zeroPoint.vec[1],backGroundColor);
-                        tft.fillTriangle(gateUL.vec[0] + zeroPoint.vec[0],gateUL.vec[1] + zeroPoint.vec[1],gateUR.vec[0] + zeroPoint.vec[0],gateUR.vec[1] + zeroPoint.vec[1],gateLR.vec[0] + zeroPoint.vec[0],gateLR.vec[1] + zeroPoint.vec[1],backGroundColor);
                     }
             };
 
@@ -1120,6 +1747,7 @@ class SceneManager{
                     uint16_t radius;
                     ConstructionPointCollection pointCollection;
                     ConstructionLineCollection lineCollection;
+                    SymbolGeometry geometry;
                     uint32_t lineColor;
                     LinAlg::Vector_2D zeroPoint;
                     LinAlg::Vector_2D center;
@@ -1133,6 +1761,16 @@ class SceneManager{
                     LinAlg::Vector_2D rightConnection;
                     LinAlg::Vector_2D rightConnectionOnCircle;
                     StatusIndicator indicator;
+
+                    //bakes the shape into geometry, see SymbolGeometry
+                    void bake(){
+                        geometry.reset();
+                        geometry.addLines(lineCollection);
+                        geometry.addCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius);
+                        geometry.addCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3);
+                        geometry.addCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3 + 2);
+                        geometry.bounds = pointCollection.getBounds(zeroPoint).unite(ScreenRect::aroundCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius));
+                    }
                 public:
                     TurboMolecularPump(uint16_t xPos, uint16_t yPos, bool State = false ,double Rotation = 0,double Scale = 1, uint32_t LineColor = defaultForeGroundColor) 
                             :zeroPoint(xPos,yPos),
@@ -1172,6 +1810,7 @@ class SceneManager{
                        lineCollection.addLine(ConstructionLine(&funnelUR,&funnelLR));
                        lineCollection.addLine(ConstructionLine(&leftConnection,&leftConnectionOnCircle));
                        lineCollection.addLine(ConstructionLine(&rightConnection,&rightConnectionOnCircle));
+                        bake();
                         
                         if(Rotation !=0 ) rotate(Rotation);
                         if(Scale !=1 ) scale(Scale);
@@ -1180,6 +1819,10 @@ class SceneManager{
 
                     ~TurboMolecularPump(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return geometry.bounds.unite(indicator.getBounds());
                     }
                     LinAlg::Vector_2D getLeftConnectionPoint(){
                         return LinAlg::Vector_2D((leftConnection + zeroPoint).vec[0],(leftConnection + zeroPoint).vec[1]);
@@ -1189,13 +1832,17 @@ class SceneManager{
                     }
                     void rotate(double Angle){
                         clear();
+                        damage();
                         pointCollection.rotate(Angle);
+                        bake();
                         reDraw();
                     }
                     void scale(double factor){
                         clear();
+                        damage();
                         pointCollection.scale(factor);
                         radius = radius * factor;
+                        bake();
                         reDraw();
                     }
                     void setState(bool State){
@@ -1204,18 +1851,12 @@ class SceneManager{
                     }
 
                     void reDraw() override{
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius, lineColor);
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3, lineColor);
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3 + 2, lineColor);
-                        lineCollection.draw(lineColor);
+                        geometry.draw(lineColor);
                         indicator.setStatus(state);
                         indicator.reDraw();
                     }
                     void clear() const override{
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius, backGroundColor);
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3, backGroundColor);
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius/3 + 2, backGroundColor);
-                        lineCollection.draw(backGroundColor);
+                        geometry.draw(backGroundColor);
                         indicator.clear();
                     }
             };
@@ -1225,6 +1866,7 @@ class SceneManager{
                     uint16_t radius;
                     ConstructionPointCollection pointCollection;
                     ConstructionLineCollection lineCollection;
+                    SymbolGeometry geometry;
                     uint32_t lineColor;
                     LinAlg::Vector_2D zeroPoint;
                     LinAlg::Vector_2D center;
@@ -1238,6 +1880,14 @@ class SceneManager{
                     LinAlg::Vector_2D rightConnection;
                     LinAlg::Vector_2D rightConnectionOnCircle;
                     StatusIndicator indicator;
+
+                    //bakes the shape into geometry, see SymbolGeometry
+                    void bake(){
+                        geometry.reset();
+                        geometry.addLines(lineCollection);
+                        geometry.addCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius);
+                        geometry.bounds = pointCollection.getBounds(zeroPoint).unite(ScreenRect::aroundCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius));
+                    }
                 public:
                     Pump(uint16_t xPos, uint16_t yPos, bool State = false ,double Rotation = 0,double Scale = 1, uint32_t LineColor = defaultForeGroundColor) 
                             :zeroPoint(xPos,yPos),
@@ -1277,6 +1927,7 @@ class SceneManager{
                        lineCollection.addLine(ConstructionLine(&funnelUR,&funnelLR));
                        lineCollection.addLine(ConstructionLine(&leftConnection,&leftConnectionOnCircle));
                        lineCollection.addLine(ConstructionLine(&rightConnection,&rightConnectionOnCircle));
+                        bake();
                         
                         if(Rotation !=0 ) rotate(Rotation);
                         if(Scale !=1 ) scale(Scale);
@@ -1285,6 +1936,10 @@ class SceneManager{
 
                     ~Pump(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return geometry.bounds.unite(indicator.getBounds());
                     }
                     LinAlg::Vector_2D getLeftConnectionPoint(){
                         return LinAlg::Vector_2D((leftConnection + zeroPoint).vec[0],(leftConnection + zeroPoint).vec[1]);
@@ -1294,13 +1949,17 @@ class SceneManager{
                     }
                     void rotate(double Angle){
                         clear();
+                        damage();
                         pointCollection.rotate(Angle);
+                        bake();
                         reDraw();
                     }
                     void scale(double factor){
                         clear();
+                        damage();
                         pointCollection.scale(factor);
                         radius = radius * factor;
+                        bake();
                         reDraw();
                     }
                     void setState(bool State){
@@ -1309,14 +1968,12 @@ class SceneManager{
                     }
 
                     void reDraw() override{
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius, lineColor);
-                        lineCollection.draw(lineColor);
+                        geometry.draw(lineColor);
                         indicator.setStatus(state);
                         indicator.reDraw();
                     }
                     void clear() const override{
-                        tft.drawCircle(center.vec[0] + zeroPoint.vec[0], center.vec[1] + zeroPoint.vec[1], radius, backGroundColor);
-                        lineCollection.draw(backGroundColor);
+                        geometry.draw(backGroundColor);
                         indicator.clear();
                     }
             };
@@ -1324,6 +1981,7 @@ class SceneManager{
                 private:
                     ConstructionPointCollection pointCollection;
                     ConstructionLineCollection lineCollection;
+                    SymbolGeometry geometry;
                     uint32_t lineColor;
                     LinAlg::Vector_2D zeroPoint;
                     double rotation;
@@ -1346,38 +2004,38 @@ class SceneManager{
                     LinAlg::Vector_2D LowerRightCorner;
                     static constexpr int cornerR = 10;
 
+                    //returns Angle in [0, 2pi), negative angles become 0
                     double normalizeAngle(double Angle) const{
-                        double ret = Angle;
-                        int watchdog = 0;
-                        while(ret >= LinAlg::pi *2.){
-                            ret -= LinAlg::pi*2.;
-                            if(watchdog>=10000) {
-                                ret = 0;
-                                break;
-                            }
-                        }
-                        if(ret<0) ret = 0;
-                        watchdog = 0;
-                        while(ret < 0){
-                            ret += LinAlg::pi*2.;
-                            if(watchdog>=10000) {
-                                ret = 0;
-                                break;
-                            }
-                        }
-                        return ret;
+                        if(Angle < 0) return 0;
+                        return fmod(Angle, LinAlg::pi*2.);
                     }
-                    void drawCircleSegment(uint16_t x , uint16_t y, uint16_t r, double startAngle, double endAngle, uint32_t color) const {
-                        
+                    //adds the ring of radius r around x, y from startAngle to endAngle (radians) to geometry. An arc through
+                    //0 is split in two
+                    void addCircleSegment(uint16_t x , uint16_t y, uint16_t r, double startAngle, double endAngle){
                         startAngle = normalizeAngle(startAngle) ;
                         endAngle = normalizeAngle (endAngle);
 
                         if(endAngle > startAngle){
-                            tft.drawArc(x,y,r+1,r, startAngle/LinAlg::pi/2.*360., endAngle/LinAlg::pi/2.*360.,color,backGroundColor,false );
+                            geometry.addArc(x,y,r, startAngle/LinAlg::pi/2.*360., endAngle/LinAlg::pi/2.*360.);
                         }else{
-                            tft.drawArc(x,y,r+1,r, startAngle/LinAlg::pi/2.*360., 360.,color,backGroundColor,false );
-                            tft.drawArc(x,y,r+1,r, 0., endAngle/LinAlg::pi/2.*360.,color,backGroundColor,false );
-                        }           
+                            geometry.addArc(x,y,r, startAngle/LinAlg::pi/2.*360., 360.);
+                            geometry.addArc(x,y,r, 0., endAngle/LinAlg::pi/2.*360.);
+                        }
+                    }
+                    //bakes the shape into geometry, see SymbolGeometry
+                    void bake(){
+                        geometry.reset();
+                        geometry.addLines(lineCollection);
+                        addCircleSegment(zeroPoint.vec[0] + UpperLeftCorner.vec[0],zeroPoint.vec[1] +UpperLeftCorner.vec[1],cornerR * _scale,rotation,rotation+ LinAlg::pi/2.);
+                        addCircleSegment(zeroPoint.vec[0] + UpperRightCorner.vec[0],zeroPoint.vec[1] +UpperRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi*3./2.,rotation);
+                        addCircleSegment(zeroPoint.vec[0] + LowerLeftCorner.vec[0],zeroPoint.vec[1] +LowerLeftCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi/2.,rotation + LinAlg::pi);
+                        addCircleSegment(zeroPoint.vec[0] + LowerRightCorner.vec[0],zeroPoint.vec[1] +LowerRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi,rotation+ LinAlg::pi*3./2.);
+                        int r = cornerR * _scale + 1;
+                        geometry.bounds = pointCollection.getBounds(zeroPoint)
+                            .unite(ScreenRect::aroundCircle(zeroPoint.vec[0] + UpperLeftCorner.vec[0], zeroPoint.vec[1] + UpperLeftCorner.vec[1], r))
+                            .unite(ScreenRect::aroundCircle(zeroPoint.vec[0] + UpperRightCorner.vec[0], zeroPoint.vec[1] + UpperRightCorner.vec[1], r))
+                            .unite(ScreenRect::aroundCircle(zeroPoint.vec[0] + LowerLeftCorner.vec[0], zeroPoint.vec[1] + LowerLeftCorner.vec[1], r))
+                            .unite(ScreenRect::aroundCircle(zeroPoint.vec[0] + LowerRightCorner.vec[0], zeroPoint.vec[1] + LowerRightCorner.vec[1], r));
                     }
 
                 public:
@@ -1435,29 +2093,33 @@ class SceneManager{
 
                         lineCollection.addLine(ConstructionLine(&leftConnection,&leftMidPoint));
                         lineCollection.addLine(ConstructionLine(&rightConnection,&rightMidPoint));
+                        bake();
                         if(Rotation !=0 ) rotate(Rotation);
                         if(Scale !=1 ) scale(Scale);
                         reDraw();
                     }
                     ~VacuumChamber(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return geometry.bounds;
                     }
                     void rotate(double Angle){
                         clear();
+                        damage();
                         pointCollection.rotate(Angle);
-                        rotation -= Angle;
-                        while(rotation<0){
-                            rotation += LinAlg::pi*2.;
-                        }
-                        while(rotation>=LinAlg::pi*2.){
-                            rotation -= LinAlg::pi*2.;
-                        }
+                        rotation = fmod(rotation - Angle, LinAlg::pi*2.);
+                        if(rotation < 0) rotation += LinAlg::pi*2.;
+                        bake();
                         reDraw();
                     }
                     void scale(double factor){
                         clear();
+                        damage();
                         _scale *= factor;
                         pointCollection.scale(factor);
+                        bake();
                         reDraw();
                     }
 
@@ -1468,19 +2130,10 @@ class SceneManager{
                         return LinAlg::Vector_2D((rightConnection + zeroPoint).vec[0],(rightConnection + zeroPoint).vec[1]);
                     }
                     void reDraw() override{
-                        lineCollection.draw(lineColor);
-                        drawCircleSegment(zeroPoint.vec[0] + UpperLeftCorner.vec[0],zeroPoint.vec[1] +UpperLeftCorner.vec[1],cornerR * _scale,rotation,rotation+ LinAlg::pi/2.,lineColor);
-                        drawCircleSegment(zeroPoint.vec[0] + UpperRightCorner.vec[0],zeroPoint.vec[1] +UpperRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi*3./2.,rotation,lineColor);
-                        drawCircleSegment(zeroPoint.vec[0] + LowerLeftCorner.vec[0],zeroPoint.vec[1] +LowerLeftCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi/2.,rotation + LinAlg::pi,lineColor);
-                        drawCircleSegment(zeroPoint.vec[0] + LowerRightCorner.vec[0],zeroPoint.vec[1] +LowerRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi,rotation+ LinAlg::pi*3./2.,lineColor);
-
-                   }
+                        geometry.draw(lineColor);
+                    }
                     void clear() const override{
-                        lineCollection.draw(backGroundColor);
-                        drawCircleSegment(zeroPoint.vec[0] + UpperLeftCorner.vec[0],zeroPoint.vec[1] +UpperLeftCorner.vec[1],cornerR * _scale,rotation,rotation+ LinAlg::pi/2.,backGroundColor);
-                        drawCircleSegment(zeroPoint.vec[0] + UpperRightCorner.vec[0],zeroPoint.vec[1] +UpperRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi*3./2.,rotation,backGroundColor);
-                        drawCircleSegment(zeroPoint.vec[0] + LowerLeftCorner.vec[0],zeroPoint.vec[1] +LowerLeftCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi/2.,rotation + LinAlg::pi,backGroundColor);
-                        drawCircleSegment(zeroPoint.vec[0] + LowerRightCorner.vec[0],zeroPoint.vec[1] +LowerRightCorner.vec[1],cornerR * _scale,rotation + LinAlg::pi,rotation+ LinAlg::pi*3./2.,backGroundColor);
+                        geometry.draw(backGroundColor);
                     }
             };
 
@@ -1489,51 +2142,117 @@ class SceneManager{
                 private:
                     uint32_t lineColor;
 
-                public:
+                    //the arrows sit in the right column of the StandardMenu, from the top of the screen down to yDepth
+                    static constexpr int xDepth = 19;
+                    static constexpr int yDepth = 140;
+                    static constexpr int right = ScreenRect::screenWidth - 1;
+                    static constexpr int left = ScreenRect::screenWidth - xDepth + 1;
+                    static constexpr int tip = ScreenRect::screenWidth - (xDepth / 2);
 
-                    void clear() const{
-                        int yDepth = 140;
-                        int xDepth = 19;
+                    void draw(uint32_t color) const{
                         // Lower triabgle
-                        tft.drawLine(320 - xDepth + 1, yDepth - 25, 320 - (xDepth / 2), yDepth, backGroundColor);
-                        tft.drawLine(320 - 1, yDepth - 25, 320 - (xDepth / 2), yDepth, backGroundColor);
+                        tft.drawLine(left, yDepth - 25, tip, yDepth, color);
+                        tft.drawLine(right, yDepth - 25, tip, yDepth, color);
                         // upe driangle
-                        tft.drawLine(320 - xDepth + 1, 25, 320 - (xDepth / 2), 0, backGroundColor);
-                        tft.drawLine(320 - 1, 25, 320 - (xDepth / 2), 0, backGroundColor);
+                        tft.drawLine(left, 25, tip, 0, color);
+                        tft.drawLine(right, 25, tip, 0, color);
+                    }
+
+                public:
+
+                    void clear() const{
+                        draw(backGroundColor);
                     }
 
                     void reDraw(){
-                        int yDepth = 140;
-                        int xDepth = 19;
-                        // Lower triabgle
-                        tft.drawLine(320 - xDepth + 1, yDepth - 25, 320 - (xDepth / 2), yDepth, lineColor);
-                        tft.drawLine(320 - 1, yDepth - 25, 320 - (xDepth / 2), yDepth, lineColor);
-                        // upe driangle
-                        tft.drawLine(320 - xDepth + 1, 25, 320 - (xDepth / 2), 0, lineColor);
-                        tft.drawLine(320 - 1, 25, 320 - (xDepth / 2), 0, lineColor);
+                        draw(lineColor);
                     }
                     ScrollBar(uint32_t LineColor = defaultForeGroundColor): lineColor(LineColor){
                         reDraw();
                     }
                     ~ScrollBar(){
                         clear();
+                        damage();
+                    }
+                    ScreenRect getBounds() const override{
+                        return ScreenRect(left, 0, right - left + 1, yDepth + 1);
                     }
             };
 
         };
+        //A Chart with a title above it and the values of its grid lines on its left, see UI_elements::Chart.
+        //The Plot occupies width x height pixels at xPosition, yPosition
         struct Plot : BaseUI_element{
-            Plot(){
-
-            }
-            ~Plot(){
-
-            }
-            void clear() const override{
-
-            }
-            void reDraw() override{
+            private:
+                UI_elements::TextBox* title;
+                UI_elements::Chart* chart;
+                std::vector<UI_elements::TextBox*> labels;
 
-            }
+                //returns the text of the label of a grid line
+                static String labelOf(double value, bool logScale){
+                    if(logScale) return "1E" + String((int)round(log10(value)));
+                    return String(value, 1);
+                }
+            public:
+                Plot(String Title, uint16_t xPosition, uint16_t yPosition, uint16_t Width, uint16_t Height, double YMin, double YMax, bool LogScale = false, uint32_t LineColor = defaultForeGroundColor, uint32_t GridColor = TFT_DARKGREY, uint32_t TextColor = defaultForeGroundColor, const GFXfont* Font = FM9){
+                    tft.setFreeFont(Font);
+                    //the baseline of a text is this far below its top, the height of a digit is used to center the labels
+                    int16_t ascent = 0;
+                    int16_t digitHeight = 0;
+                    if('0' >= Font->first && '0' <= Font->last) digitHeight = Font->glyph['0' - Font->first].height;
+                    if('E' >= Font->first && 'E' <= Font->last) ascent = -Font->glyph['E' - Font->first].yOffset;
+                    title = new UI_elements::TextBox(xPosition, yPosition + ascent, Title, Font, TextColor);
+                    uint16_t chartY = yPosition + tft.fontHeight();
+                    //the labels are only known once the grid lines are, the widest possible label makes room for them. The chart
+                    //ends half a digit above the bottom such that the label of its lowest grid line fits
+                    uint16_t labelWidth = tft.textWidth(LogScale ? "1E-10" : String(YMax, 1)) + 2;
+                    chart = new UI_elements::Chart(xPosition + labelWidth, chartY, Width - labelWidth, Height - tft.fontHeight() - digitHeight / 2, YMin, YMax, LogScale, LineColor, GridColor);
+                    for(uint16_t i = 0; i < chart->getNumberOfGridLines(); i++){
+                        labels.push_back(new UI_elements::TextBox(xPosition, chart->getGridY(i) + digitHeight / 2, labelOf(chart->getGridValue(i), LogScale), Font, TextColor));
+                    }
+                }
+                ~Plot(){
+                    delete(title);
+                    delete(chart);
+                    for(UI_elements::TextBox* label : labels){
+                        delete(label);
+                    }
+                }
+                //the parts of the Plot are elements of their own
+                ScreenRect getBounds() const override{
+                    return ScreenRect();
+                }
+                void clear() const override{
+                    title->clear();
+                    chart->clear();
+                    for(UI_elements::TextBox* label : labels){
+                        label->clear();
+                    }
+                }
+                void reDraw() override{
+                    title->reDraw();
+                    chart->reDraw();
+                    for(UI_elements::TextBox* label : labels){
+                        label->reDraw();
+                    }
+                }
+                void setTitle(String Title){
+                    title->setText(Title);
+                }
+                void addSample(double value){
+                    chart->addSample(value);
+                }
+                template<typename ET, size_t S, typename IT, typename BT>
+                size_t addSamples(RingBuf<ET, S, IT, BT>& buffer){
+                    return chart->addSamples(buffer);
+                }
+                template<typename T>
+                size_t addHistory(Persistent<T>& persistent, size_t from, size_t count){
+                    return chart->addHistory(persistent, from, count);
+                }
+                uint16_t getNumberOfColumns() const {
+                    return chart->getNumberOfColumns();
+                }
         };
         
         
@@ -1691,8 +2410,9 @@ class SceneManager{
 
                 void createTextBoxList(){
                     for(int i = 0; i < maxLinesOnScreen; i++){
-                        messageTextBoxCollection.push_back(new UI_elements::TextBox(5+tft.fontHeight(),45+i*tft.fontHeight(), "",textFont,textColor));
-                        arrowCollection.push_back(new UI_elements::TextBox(5,45+i*tft.fontHeight(), "",textFont,textColor));
+                        //the rows are rewritten on every page change, see SPRITE EXPLANATION
+                        messageTextBoxCollection.push_back(new UI_elements::TextBox(5+tft.fontHeight(),45+i*tft.fontHeight(), "",textFont,textColor,backGroundColor,true));
+                        arrowCollection.push_back(new UI_elements::TextBox(5,45+i*tft.fontHeight(), "",textFont,textColor,backGroundColor,true));
                     }
                 }
                 void destroyTextBoxList(){
@@ -1847,7 +2567,6 @@ class SceneManager{
             
             
             while(true){
-                waitForSaveReadWrite();
                 if(menuLevel == 0){
                     selectionBox->update();
                     if(selectionBox->backHasBeenClicked()) break;
@@ -1863,7 +2582,6 @@ class SceneManager{
                 if(menuLevel == 1){
                     selectionBox->update();
                     if(selectionBox->backHasBeenClicked()){
-                        waitForSaveReadWrite();
                         selectionBox->setTitle(version);
                         selectionBox->loadList(componentListString);
                         selectionBox->setSelectedIndex(selectionOnMenuLevel_0);
@@ -1871,7 +2589,6 @@ class SceneManager{
                         LSC::getInstance().buttons.bt_5.hasBeenClicked();
                     } 
                     if(selectionBox->selectHasBeenClicked()){
-                        waitForSaveReadWrite();
                         selectionOnMenuLevel_1 = selectionBox->getSelectedIndex();
                         selectionBox->setTitle(componentStateListToString(exposedStateList)[selectionOnMenuLevel_1]);
                         // --- ReadWriteSelection ---
@@ -1890,10 +2607,8 @@ class SceneManager{
                             selectionBox->setColorOfItemByIndex(indexOfCurrentSetting,TFT_GREEN);
                             
                             while(true){
-                                waitForSaveReadWrite();
                                 selectionBox->update();
                                 if(selectionBox->selectHasBeenClicked()){ //One onf the selection options has been chosen
-                                    waitForSaveReadWrite();
         
                                     stateInterface.setStateValue(selectionBox->getSelectedIndex());
                                     selectionBox->setColorOfAllItems(defaultForeGroundColor);
@@ -1915,7 +2630,6 @@ class SceneManager{
                         ExposedStateInterface stateInterface(exposedStateList[selectionOnMenuLevel_1]);
                         if(exposedStateList[selectionOnMenuLevel_1]->stateType  == ExposedStateType::ReadOnly){                            
                             while(true){
-                                waitForSaveReadWrite();
                                 selectionBox->loadList({"ReadOnly State:",stateInterface.getStateValueAsString()});
                                 selectionBox->setColorOfItemByIndex(1,TFT_GREEN);
                                 selectionBox->update();
@@ -1931,7 +2645,6 @@ class SceneManager{
                             }
                         }
                         if(stateInterface.getStateType() == ExposedStateType::Action){
-                            waitForSaveReadWrite();
                             if(!options.debugMode){
                                 showMessageBox("Not In Debug Mode", "Switch to debug mode to change the state of the system!","","ok");
                             }else{
@@ -1943,7 +2656,6 @@ class SceneManager{
                     }
                 }
                 if(menuLevel == 2){
-                    waitForSaveReadWrite();
                     selectionBox->update();
                     if(selectionBox->backHasBeenClicked()){
                         selectionBox->setTitle(componentListString[selectionOnMenuLevel_0]);
@@ -0,0 +1,652 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//SPI bus, SD card and display of the simulation. See SPI BUS in LscSimulation.h
+
+#include "LscSimulationInternal.h"
+#include <SPI.h>
+#include <sys/mman.h>
+
+using namespace Simulation;
+
+namespace {
+    //Everything a test has to see after the firmware ran in its own process lives in shared memory
+    struct SharedState{
+        BusStatistics bus;
+        SdCard::Statistics card;
+        SdCard::Timing timing;
+        bool powerCutArmed;
+        uint64_t powerCutAfterBytes;
+        Display::Statistics display;
+        uint16_t framebuffer[Display::width * Display::height];
+    };
+    SharedState* const shared = [](){
+        SharedState* state = allocateShared<SharedState>();
+        //a class 10 card: 100us until the first data byte of a read, a few 100us per written block
+        state->timing.readLatency_ns = 100000;
+        state->timing.singleBlockProgram_ns = 800000;
+        state->timing.multiBlockProgram_ns = 150000;
+        state->timing.stopTransmission_ns = 250000;
+        state->timing.eraseBase_ns = 2000000;
+        state->timing.erasePerBlock_ns = 100;
+        return state;
+    }();
+
+    //the blocks are mapped by the test process, the firmware processes inherit the mapping
+    uint8_t* media = nullptr;
+    uint32_t mediaBlocks = 0;
+
+    //---- SD card protocol state, reset like the card by a power cut ----
+    enum class Phase{ Command, WaitDataToken, ReceiveData };
+    struct Card{
+        bool selected = false;
+        bool idle = true;
+        bool appCommand = false;
+        Phase phase = Phase::Command;
+        uint8_t command[6];
+        uint8_t commandLength = 0;
+        uint8_t response[520];
+        uint16_t responseHead = 0;
+        uint16_t responseLength = 0;
+        uint16_t responseHoldIndex = 0;     //bytes from here on are only available after responseHold_ns
+        uint64_t responseHold_ns = 0;
+        bool multiBlockWrite = false;
+        uint32_t writeBlock = 0;
+        uint8_t writeBuffer[514];
+        uint16_t writeLength = 0;
+        bool dataResponsePending = false;
+        uint64_t programTime_ns = 0;
+        uint64_t busyUntil_ns = 0;
+        uint32_t eraseStart = 0;
+        uint32_t eraseEnd = 0;
+    };
+    Card card;
+
+    //---- display protocol state ----
+    struct Ili9341{
+        bool selected = false;
+        uint8_t command = 0;
+        uint8_t parameters[4];
+        uint8_t parameterCount = 0;
+        uint16_t columnStart = 0, columnEnd = 0, pageStart = 0, pageEnd = 0;
+        uint16_t column = 0, page = 0;
+        bool rowColumnExchange = false;
+        bool highByteReceived = false;
+        uint8_t highByte = 0;
+    };
+    Ili9341 display;
+
+    uint32_t spiClock = 4000000; //the Due SPI library starts with SPI_CLOCK_DIV21
+
+    //---- SD card ----
+    void respond(const uint8_t* bytes, uint16_t length){
+        for(uint16_t i = 0; i < length && card.responseLength < sizeof(card.response); i++) card.response[card.responseLength++] = bytes[i];
+    }
+
+    void respond(uint8_t byte){
+        respond(&byte, 1);
+    }
+
+    //a data block follows the R1 after delay_ns
+    void respondData(const uint8_t* data, uint16_t length, uint64_t delay_ns){
+        card.responseHoldIndex = card.responseLength;
+        card.responseHold_ns = getTime_ns() + delay_ns;
+        respond(0xFE);
+        respond(data, length);
+        respond(0xFF);
+        respond(0xFF);
+    }
+
+    uint8_t r1(){
+        return card.idle ? 0x01 : 0x00;
+    }
+
+    void csd(uint8_t* registerData){
+        memset(registerData, 0, 16);
+        uint32_t cSize = mediaBlocks / 1024 - 1;
+        registerData[0] = 0x40;         //CSD version 2.0
+        registerData[1] = 0x0E;
+        registerData[3] = 0x32;         //25MHz
+        registerData[4] = 0x5B;
+        registerData[5] = 0x59;         //READ_BL_LEN 512
+        registerData[7] = (cSize >> 16) & 0x3F;
+        registerData[8] = (cSize >> 8) & 0xFF;
+        registerData[9] = cSize & 0xFF;
+        registerData[10] = 0x7F;        //ERASE_BLK_EN, SECTOR_SIZE
+        registerData[11] = 0x80;
+        registerData[12] = 0x0A;
+        registerData[13] = 0x40;
+        registerData[15] = 0x01;
+    }
+
+    void cid(uint8_t* registerData){
+        static const uint8_t value[16] = {0x03, 'S', 'D', 'L', 'S', 'C', 'S', 'I', 'M', 0x10, 0x00, 0x00, 0x00, 0x01, 0x18, 0x01};
+        memcpy(registerData, value, 16);
+    }
+
+    void executeCommand(){
+        uint8_t index = card.command[0] & 0x3F;
+        uint32_t argument = ((uint32_t)card.command[1] << 24) | ((uint32_t)card.command[2] << 16) | ((uint32_t)card.command[3] << 8) | card.command[4];
+        bool appCommand = card.appCommand;
+        card.appCommand = false;
+        card.responseHead = 0;
+        card.responseLength = 0;
+        card.responseHoldIndex = sizeof(card.response);
+        shared->card.commands++;
+        respond(0xFF); //Ncr
+        if(appCommand){
+            switch(index){
+                case 41:
+                    card.idle = false;
+                    respond(0x00);
+                    return;
+                case 23:
+                    respond(r1());
+                    return;
+            }
+        }
+        switch(index){
+            case 0:
+                card.idle = true;
+                card.phase = Phase::Command;
+                card.multiBlockWrite = false;
+                respond(0x01);
+                return;
+            case 8:{
+                const uint8_t r7[5] = {r1(), 0x00, 0x00, (uint8_t)((argument >> 8) & 0x0F), (uint8_t)(argument & 0xFF)};
+                respond(r7, 5);
+                return;
+            }
+            case 55:
+                card.appCommand = true;
+                respond(r1());
+                return;
+            case 58:{
+                const uint8_t r3[5] = {r1(), 0xC0, 0xFF, 0x80, 0x00}; //powered up, SDHC
+                respond(r3, 5);
+                return;
+            }
+            case 9:
+            case 10:{
+                uint8_t registerData[16];
+                if(index == 9) csd(registerData);
+                else cid(registerData);
+                respond(r1());
+                respondData(registerData, 16, 0);
+                return;
+            }
+            case 13:
+                respond(r1());
+                respond(0x00);
+                return;
+            case 17:
+                if(argument >= mediaBlocks){
+                    respond(0x40); //parameter error
+                    return;
+                }
+                respond(0x00);
+                respondData(media + (size_t)argument * 512, 512, shared->timing.readLatency_ns);
+                shared->card.blockReads++;
+                return;
+            case 24:
+            case 25:
+                if(argument >= mediaBlocks){
+                    respond(0x40);
+                    return;
+                }
+                respond(0x00);
+                card.phase = Phase::WaitDataToken;
+                card.multiBlockWrite = index == 25;
+                card.writeBlock = argument;
+                if(index == 25) shared->card.multiBlockWrites++;
+                return;
+            case 32:
+                card.eraseStart = argument;
+                respond(r1());
+                return;
+            case 33:
+                card.eraseEnd = argument;
+                respond(r1());
+                return;
+            case 38:{
+                respond(r1());
+                uint32_t end = card.eraseEnd < mediaBlocks ? card.eraseEnd : mediaBlocks - 1;
+                if(card.eraseStart <= end){
+                    memset(media + (size_t)card.eraseStart * 512, 0xFF, (size_t)(end - card.eraseStart + 1) * 512);
+                    uint64_t busy = shared->timing.eraseBase_ns + (uint64_t)(end - card.eraseStart + 1) * shared->timing.erasePerBlock_ns;
+                    card.busyUntil_ns = getTime_ns() + busy;
+                    shared->card.busyTime_ns += busy;
+                }
+                shared->card.erases++;
+                return;
+            }
+            default:
+                respond(r1() | 0x04); //illegal command
+                return;
+        }
+    }
+
+    //Programs the received block, the power may fail in the middle of it
+    void programBlock(){
+        uint8_t* block = media + (size_t)card.writeBlock * 512;
+        uint32_t length = 512;
+        bool cut = false;
+        if(shared->powerCutArmed && shared->powerCutAfterBytes < length){
+            length = (uint32_t)shared->powerCutAfterBytes;
+            cut = true;
+        }
+        memcpy(block, card.writeBuffer, length);
+        shared->card.programmedBytes += length;
+        if(shared->powerCutArmed) shared->powerCutAfterBytes -= length;
+        if(cut){
+            shared->powerCutArmed = false;
+            cutPower();
+        }
+        shared->card.blockWrites++;
+        if(!card.multiBlockWrite) shared->card.singleBlockWrites++;
+        card.programTime_ns = card.multiBlockWrite ? shared->timing.multiBlockProgram_ns : shared->timing.singleBlockProgram_ns;
+        card.dataResponsePending = true;
+        if(card.multiBlockWrite){
+            card.writeBlock++;
+            card.phase = card.writeBlock < mediaBlocks ? Phase::WaitDataToken : Phase::Command;
+        }else{
+            card.phase = Phase::Command;
+        }
+    }
+
+    uint8_t exchangeWithCard(uint8_t in){
+        uint64_t now = getTime_ns();
+        if(card.dataResponsePending){
+            card.dataResponsePending = false;
+            card.busyUntil_ns = now + card.programTime_ns;
+            shared->card.busyTime_ns += card.programTime_ns;
+            return 0xE5; //data accepted
+        }
+        if(now < card.busyUntil_ns) return 0x00;
+        switch(card.phase){
+            case Phase::WaitDataToken:
+                if(card.responseHead < card.responseLength) return card.response[card.responseHead++]; //R1 of CMD24/CMD25
+                if(in == 0xFE || in == 0xFC){
+                    card.phase = Phase::ReceiveData;
+                    card.writeLength = 0;
+                }else if(in == 0xFD && card.multiBlockWrite){
+                    card.phase = Phase::Command;
+                    card.multiBlockWrite = false;
+                    card.busyUntil_ns = now + shared->timing.stopTransmission_ns;
+                    shared->card.busyTime_ns += shared->timing.stopTransmission_ns;
+                }
+                return 0xFF;
+            case Phase::ReceiveData:
+                card.writeBuffer[card.writeLength++] = in;
+                if(card.writeLength == sizeof(card.writeBuffer)) programBlock();
+                return 0xFF;
+            case Phase::Command:
+                break;
+        }
+        if(card.commandLength > 0 || (in & 0xC0) == 0x40){
+            card.command[card.commandLength++] = in;
+            if(card.commandLength == sizeof(card.command)){
+                card.commandLength = 0;
+                executeCommand();
+            }
+            return 0xFF;
+        }
+        if(card.responseHead >= card.responseLength) return 0xFF;
+        if(card.responseHead >= card.responseHoldIndex && now < card.responseHold_ns) return 0xFF;
+        return card.response[card.responseHead++];
+    }
+
+    void deselectCard(){
+        card.commandLength = 0;
+        card.responseHead = 0;
+        card.responseLength = 0;
+    }
+
+    //---- display ----
+    void writePixel(uint16_t color){
+        uint16_t stride = display.rowColumnExchange ? Display::width : Display::height;
+        uint16_t rows = display.rowColumnExchange ? Display::height : Display::width;
+        if(display.column < stride && display.page < rows) shared->framebuffer[display.page * stride + display.column] = color;
+        shared->display.pixels++;
+        if(display.column < display.columnEnd){
+            display.column++;
+            return;
+        }
+        display.column = display.columnStart;
+        display.page = display.page < display.pageEnd ? display.page + 1 : display.pageStart;
+    }
+
+    void receiveByDisplay(uint8_t in){
+        if(!getPinLevel(displayDataCommandPin)){
+            display.command = in;
+            display.parameterCount = 0;
+            display.highByteReceived = false;
+            shared->display.commands++;
+            if(in == 0x2C){
+                display.column = display.columnStart;
+                display.page = display.pageStart;
+                shared->display.windows++;
+            }
+            return;
+        }
+        shared->display.dataBytes++;
+        switch(display.command){
+            case 0x2A: //CASET
+            case 0x2B: //PASET
+                if(display.parameterCount < 4) display.parameters[display.parameterCount++] = in;
+                if(display.parameterCount == 4){
+                    uint16_t start = (display.parameters[0] << 8) | display.parameters[1];
+                    uint16_t end = (display.parameters[2] << 8) | display.parameters[3];
+                    if(display.command == 0x2A){
+                        display.columnStart = start;
+                        display.columnEnd = end;
+                    }else{
+                        display.pageStart = start;
+                        display.pageEnd = end;
+                    }
+                }
+                return;
+            case 0x2C: //RAMWR
+                if(!display.highByteReceived){
+                    display.highByte = in;
+                    display.highByteReceived = true;
+                    return;
+                }
+                display.highByteReceived = false;
+                writePixel((display.highByte << 8) | in);
+                return;
+            case 0x36: //MADCTL
+                display.rowColumnExchange = in & 0x20;
+                return;
+        }
+    }
+
+    //a chip select that has not been configured as output yet is pulled up by the device
+    bool isSelected(uint32_t pin){
+        return isOutput(pin) && !getPinLevel(pin);
+    }
+}
+
+namespace Simulation{
+    void onOutputChanged(uint32_t pin, bool level){
+        if(pin != sdCardChipSelectPin && pin != displayChipSelectPin) return;
+        bool sd = pin == sdCardChipSelectPin;
+        if(!level){
+            //on the real board the two devices would drive MISO against each other
+            if(isSelected(sd ? displayChipSelectPin : sdCardChipSelectPin)) shared->bus.conflicts++;
+            if(sd) card.selected = true;
+            else display.selected = true;
+            return;
+        }
+        if(sd){
+            card.selected = false;
+            deselectCard();
+        }else{
+            display.selected = false;
+        }
+    }
+
+    uint8_t transferSpiByte(uint8_t data, uint32_t clock){
+        uint64_t byteTime = getSpiByteTime_ns(clock);
+        bool sd = isSelected(sdCardChipSelectPin) && media != nullptr;
+        bool tft = isSelected(displayChipSelectPin);
+        shared->bus.bytes++;
+        shared->bus.busyTime_ns += byteTime;
+        if(sd && tft) shared->bus.conflictBytes++;
+        if(!isSelected(sdCardChipSelectPin) && !tft) shared->bus.unselectedBytes++;
+        if(isInInterrupt()) shared->bus.interruptBytes++;
+        advanceTo(getTime_ns() + byteTime);
+        uint8_t result = 0xFF;
+        if(sd) result &= exchangeWithCard(data);
+        if(tft) receiveByDisplay(data);
+        return result;
+    }
+
+    BusStatistics getBusStatistics(){
+        return shared->bus;
+    }
+
+    void resetBusStatistics(){
+        shared->bus = BusStatistics();
+    }
+
+    uint64_t getSpiByteTime_ns(uint32_t clock){
+        uint32_t divider = clock == 0 ? 255 : (VARIANT_MCK + clock - 1) / clock;
+        if(divider < 1) divider = 1;
+        if(divider > 255) divider = 255;
+        return (8ULL * divider + 32) * 1000000000ULL / VARIANT_MCK;
+    }
+
+    namespace SdCard{
+        static void write16(uint8_t* p, uint16_t value){
+            p[0] = value & 0xFF;
+            p[1] = value >> 8;
+        }
+
+        static void write32(uint8_t* p, uint32_t value){
+            write16(p, value & 0xFFFF);
+            write16(p + 2, value >> 16);
+        }
+
+        //Formats the card like the SD association formatter would: MBR, partition 1 at block 2048
+        static void format(uint8_t fatType){
+            const uint32_t volumeStart = 2048;
+            uint32_t volumeBlocks = mediaBlocks - volumeStart;
+            uint16_t reserved = fatType == 32 ? 32 : 1;
+            uint16_t rootEntries = fatType == 32 ? 0 : 512;
+            uint32_t rootBlocks = rootEntries * 32 / 512;
+            uint8_t sectorsPerCluster = 1;
+            uint32_t fatBlocks = 0;
+            uint32_t clusters = 0;
+            while(true){
+                uint32_t dataBlocks = volumeBlocks - reserved - rootBlocks;
+                fatBlocks = ((dataBlocks / sectorsPerCluster + 2) * (fatType == 32 ? 4 : 2) + 511) / 512;
+                clusters = (dataBlocks - 2 * fatBlocks) / sectorsPerCluster;
+                if(fatType == 32 || clusters < 65525 || sectorsPerCluster == 128) break;
+                sectorsPerCluster *= 2;
+            }
+            if((fatType == 16 && (clusters < 4085 || clusters >= 65525)) || (fatType == 32 && clusters < 65525)){
+                fprintf(stderr, "Simulation: %u blocks do not make a FAT%u volume\n", (unsigned)mediaBlocks, (unsigned)fatType);
+                abort();
+            }
+
+            uint8_t* mbr = media;
+            uint8_t* partition = mbr + 0x1BE;
+            partition[4] = fatType == 32 ? 0x0C : 0x06;
+            write32(partition + 8, volumeStart);
+            write32(partition + 12, volumeBlocks);
+            mbr[510] = 0x55;
+            mbr[511] = 0xAA;
+
+            uint8_t* boot = media + (size_t)volumeStart * 512;
+            const uint8_t jump[3] = {0xEB, 0x3C, 0x90};
+            memcpy(boot, jump, 3);
+            memcpy(boot + 3, "LSCSIM  ", 8);
+            write16(boot + 11, 512);
+            boot[13] = sectorsPerCluster;
+            write16(boot + 14, reserved);
+            boot[16] = 2;
+            write16(boot + 17, rootEntries);
+            if(fatType == 16 && volumeBlocks < 65536) write16(boot + 19, volumeBlocks);
+            else write32(boot + 32, volumeBlocks);
+            boot[21] = 0xF8;
+            write16(boot + 24, 63);
+            write16(boot + 26, 255);
+            write32(boot + 28, volumeStart);
+            if(fatType == 32){
+                write32(boot + 36, fatBlocks);
+                write32(boot + 44, 2);      //root directory cluster
+                write16(boot + 48, 1);      //FSInfo
+                write16(boot + 50, 6);      //backup boot sector
+                boot[64] = 0x80;
+                boot[66] = 0x29;
+                memcpy(boot + 71, "LSC        FAT32   ", 19);
+            }else{
+                write16(boot + 22, fatBlocks);
+                boot[36] = 0x80;
+                boot[38] = 0x29;
+                memcpy(boot + 43, "LSC        FAT16   ", 19);
+            }
+            boot[510] = 0x55;
+            boot[511] = 0xAA;
+
+            uint8_t* fatStart = boot + (size_t)reserved * 512;
+            for(uint8_t copy = 0; copy < 2; copy++){
+                uint8_t* fat = fatStart + (size_t)copy * fatBlocks * 512;
+                if(fatType == 32){
+                    write32(fat, 0x0FFFFFF8);
+                    write32(fat + 4, 0x0FFFFFFF);
+                    write32(fat + 8, 0x0FFFFFFF); //root directory
+                }else{
+                    write16(fat, 0xFFF8);
+                    write16(fat + 2, 0xFFFF);
+                }
+            }
+            if(fatType == 32){
+                uint8_t* fsInfo = boot + 512;
+                write32(fsInfo, 0x41615252);
+                write32(fsInfo + 484, 0x61417272);
+                write32(fsInfo + 488, 0xFFFFFFFF);
+                write32(fsInfo + 492, 0xFFFFFFFF);
+                write32(fsInfo + 508, 0xAA550000);
+                memcpy(boot + 6 * 512, boot, 2 * 512);
+            }
+        }
+
+        void insert(uint32_t blocks, uint8_t fatType){
+            remove();
+            mediaBlocks = blocks / 1024 * 1024;
+            media = (uint8_t*)allocateSharedMemory((size_t)mediaBlocks * 512);
+            format(fatType);
+            resetStatistics();
+        }
+
+        void remove(){
+            if(media != nullptr) munmap(media, (size_t)mediaBlocks * 512);
+            media = nullptr;
+            mediaBlocks = 0;
+        }
+
+        uint32_t getNumberOfBlocks(){
+            return mediaBlocks;
+        }
+
+        uint8_t* getBlock(uint32_t block){
+            return block < mediaBlocks ? media + (size_t)block * 512 : nullptr;
+        }
+
+        Statistics getStatistics(){
+            return shared->card;
+        }
+
+        void resetStatistics(){
+            shared->card = Statistics();
+        }
+
+        Timing& getTiming(){
+            return shared->timing;
+        }
+
+        void cutPowerAfterProgrammedBytes(uint64_t bytes){
+            shared->powerCutArmed = true;
+            shared->powerCutAfterBytes = bytes;
+        }
+
+        void cancelPowerCut(){
+            shared->powerCutArmed = false;
+        }
+    }
+
+    namespace Display{
+        static uint16_t stride(){
+            return display.rowColumnExchange ? width : height;
+        }
+
+        uint16_t getPixel(uint16_t x, uint16_t y){
+            return shared->framebuffer[y * stride() + x];
+        }
+
+        uint32_t countPixels(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color){
+            uint32_t count = 0;
+            for(uint16_t row = y; row < y + h; row++){
+                for(uint16_t column = x; column < x + w; column++){
+                    if(getPixel(column, row) == color) count++;
+                }
+            }
+            return count;
+        }
+
+        bool writePpm(const char* fileName){
+            FILE* file = fopen(fileName, "wb");
+            if(file == nullptr) return false;
+            uint16_t columns = stride();
+            uint16_t rows = width * height / columns;
+            fprintf(file, "P6\n%u %u\n255\n", (unsigned)columns, (unsigned)rows);
+            for(uint32_t i = 0; i < (uint32_t)columns * rows; i++){
+                uint16_t color = shared->framebuffer[i];
+                uint8_t rgb[3] = {(uint8_t)((color >> 8) & 0xF8), (uint8_t)((color >> 3) & 0xFC), (uint8_t)((color << 3) & 0xF8)};
+                fwrite(rgb, 1, 3, file);
+            }
+            return fclose(file) == 0;
+        }
+
+        Statistics getStatistics(){
+            return shared->display;
+        }
+
+        void resetStatistics(){
+            shared->display = Statistics();
+        }
+    }
+}
+
+//---- SPI ----
+SPIClass SPI;
+
+void SPIClass::begin(){
+}
+
+void SPIClass::end(){
+}
+
+void SPIClass::beginTransaction(SPISettings settings){
+    spiClock = settings.clock;
+}
+
+void SPIClass::endTransaction(){
+}
+
+uint8_t SPIClass::transfer(uint8_t data){
+    return transferSpiByte(data, spiClock);
+}
+
+uint16_t SPIClass::transfer16(uint16_t data){
+    uint16_t high = transfer(data >> 8);
+    return (high << 8) | transfer(data & 0xFF);
+}
+
+void SPIClass::transfer(void* buffer, size_t count){
+    uint8_t* bytes = (uint8_t*)buffer;
+    for(size_t i = 0; i < count; i++) bytes[i] = transfer(bytes[i]);
+}
+
+void SPIClass::setClockDivider(uint8_t divider){
+    spiClock = VARIANT_MCK / (divider == 0 ? 1 : divider);
+}
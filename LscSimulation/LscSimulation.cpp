@@ -0,0 +1,1038 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Clock, interrupts, timers, ADC, pins, Serial, power and heap of the simulation. See SIMULATION EXPLANATION in LscSimulation.h
+
+#include "LscSimulationInternal.h"
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+namespace {
+    constexpr int numberOfIrqs = PERIPH_COUNT_IRQn;
+    constexpr uint32_t threadPriority = 0x100; //lower than every interrupt priority
+    constexpr uint64_t never = UINT64_MAX;
+    constexpr int exitPowerCut = 101;
+    constexpr int exitReset = 102;
+    constexpr int exitHalted = 103;
+
+    Tc tc[3];
+    Adc adc;
+    Supc supc;
+
+    //---- clock ----
+    volatile uint64_t now_ns = 0;
+    uint32_t spinReads = 0;
+    uint64_t spinReadTime_ns = 0;
+    bool insideFirmware = false;
+
+    //---- NVIC ----
+    volatile bool irqEnabled[numberOfIrqs];
+    volatile bool irqPending[numberOfIrqs];
+    uint8_t irqPriority[numberOfIrqs];
+    uint32_t irqCount[numberOfIrqs];
+    uint32_t irqLost[numberOfIrqs];
+    uint64_t irqLastTime_ns[numberOfIrqs];
+    void (*irqHook[numberOfIrqs])(uint64_t);
+    volatile bool primask = false;
+    volatile uint32_t runningPriority = threadPriority;
+    volatile int runningIrq = -1;
+    volatile bool asynchronous = false;
+
+    //---- timers ----
+    struct TimerChannel{
+        Tc* tc;
+        uint32_t channel;
+        IRQn_Type irq;
+        bool running;
+        uint64_t start_ns;      //time of the last (re)start, the k-th compare is at start_ns + k * period
+        uint64_t compares;
+        uint64_t next_ns;
+    };
+    TimerChannel timers[9] = {
+        {&tc[0], 0, TC0_IRQn, false, 0, 0, never}, {&tc[0], 1, TC1_IRQn, false, 0, 0, never}, {&tc[0], 2, TC2_IRQn, false, 0, 0, never},
+        {&tc[1], 0, TC3_IRQn, false, 0, 0, never}, {&tc[1], 1, TC4_IRQn, false, 0, 0, never}, {&tc[1], 2, TC5_IRQn, false, 0, 0, never},
+        {&tc[2], 0, TC6_IRQn, false, 0, 0, never}, {&tc[2], 1, TC7_IRQn, false, 0, 0, never}, {&tc[2], 2, TC8_IRQn, false, 0, 0, never}
+    };
+
+    //---- ADC ----
+    uint16_t analogValue[16];
+    uint16_t (*analogSource[16])(uint64_t);
+    bool adcRunning = false;
+    uint64_t adcNext_ns = never;
+    uint8_t adcChannel = 0;
+    uint64_t adcConversions = 0;
+    uint32_t peripheralClocks[2] = {0, 0};
+    int analogReadBits = 10;
+
+    //---- power ----
+    uint64_t powerCut_ns = never;
+
+    //---- pins ----
+    struct Pin{
+        uint8_t mode;
+        bool output;
+        bool input;
+        bool inputSet;
+        uint32_t analogOutput;
+        void (*callback)();
+        uint32_t callbackMode;
+        bool interruptFlag;
+    };
+    Pin pins[PINS_COUNT];
+
+    //PIO controller of every Due pin (0 = A ... 3 = D), from variant.cpp of the Due
+    const uint8_t pinPort[PINS_COUNT] = {
+        0, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 1, 3, 3, 0, 0, 0, 0, //0-19
+        1, 1, 1, 0, 0, 3, 3, 3, 3, 3, 3, 0, 3, 2, 2, 2, 2, 2, 2, 2, //20-39
+        2, 2, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 0, 0, 0, 0, 0, 0, //40-59
+        1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 1     //60-78
+    };
+    //ADC channel of the analog pins A0-A11 (54-65), from variant.cpp of the Due
+    const uint8_t analogPinChannel[12] = {7, 6, 5, 4, 3, 2, 1, 0, 10, 11, 12, 13};
+
+    //---- serial ----
+    unsigned long serialBaudRate = 0;
+    uint32_t serialQueued = 0;
+    uint64_t serialLastDrain_ns = 0;
+    char serialCapture[Simulation::serialCaptureSize];
+    uint64_t serialWritten = 0;
+
+    //---- heap ----
+    uint64_t heapAllocations = 0;
+    uint64_t heapAllocatedBytes = 0;
+
+    //---- asynchronous interrupt ----
+    timer_t asyncTimer;
+    bool asyncTimerCreated = false;
+    volatile int asyncIrq = -1;
+    uint32_t asyncMin_us = 0;
+    uint32_t asyncMax_us = 0;
+    uint32_t asyncRandom = 1;
+}
+
+extern "C" {
+    __attribute__((weak)) void SUPC_Handler(){}
+    __attribute__((weak)) void TC0_Handler(){}
+    __attribute__((weak)) void TC1_Handler(){}
+    __attribute__((weak)) void TC2_Handler(){}
+    __attribute__((weak)) void TC3_Handler(){}
+    __attribute__((weak)) void TC4_Handler(){}
+    __attribute__((weak)) void TC5_Handler(){}
+    __attribute__((weak)) void TC6_Handler(){}
+    __attribute__((weak)) void TC7_Handler(){}
+    __attribute__((weak)) void TC8_Handler(){}
+    __attribute__((weak)) void ADC_Handler(){}
+
+    //the Due core owns the PIO handlers, they call the attachInterrupt() callbacks of their port
+    static void pioHandler(uint8_t port){
+        for(uint32_t pin = 0; pin < PINS_COUNT; pin++){
+            if(pinPort[pin] != port || !pins[pin].interruptFlag) continue;
+            pins[pin].interruptFlag = false;
+            if(pins[pin].callback != nullptr) pins[pin].callback();
+        }
+    }
+    void PIOA_Handler(){ pioHandler(0); }
+    void PIOB_Handler(){ pioHandler(1); }
+    void PIOC_Handler(){ pioHandler(2); }
+    void PIOD_Handler(){ pioHandler(3); }
+}
+
+Tc* const TC0 = &tc[0];
+Tc* const TC1 = &tc[1];
+Tc* const TC2 = &tc[2];
+Adc* const ADC = &adc;
+Supc* const SUPC = &supc;
+
+namespace {
+    void (*handler(int irq))(){
+        switch(irq){
+            case SUPC_IRQn: return SUPC_Handler;
+            case PIOA_IRQn: return PIOA_Handler;
+            case PIOB_IRQn: return PIOB_Handler;
+            case PIOC_IRQn: return PIOC_Handler;
+            case PIOD_IRQn: return PIOD_Handler;
+            case TC0_IRQn: return TC0_Handler;
+            case TC1_IRQn: return TC1_Handler;
+            case TC2_IRQn: return TC2_Handler;
+            case TC3_IRQn: return TC3_Handler;
+            case TC4_IRQn: return TC4_Handler;
+            case TC5_IRQn: return TC5_Handler;
+            case TC6_IRQn: return TC6_Handler;
+            case TC7_IRQn: return TC7_Handler;
+            case TC8_IRQn: return TC8_Handler;
+            case ADC_IRQn: return ADC_Handler;
+            default: return nullptr;
+        }
+    }
+
+    //In the asynchronous mode the signal handler must not run between picking an interrupt and marking it as running
+    struct SignalGuard{
+        sigset_t previous;
+        bool blocked;
+        SignalGuard() : blocked(asynchronous){
+            if(!blocked) return;
+            sigset_t set;
+            sigemptyset(&set);
+            sigaddset(&set, SIGRTMIN);
+            sigprocmask(SIG_BLOCK, &set, &previous);
+        }
+        ~SignalGuard(){
+            if(blocked) sigprocmask(SIG_SETMASK, &previous, nullptr);
+        }
+    };
+
+    //Runs every pending interrupt that may preempt the running code, highest priority first
+    void dispatch(){
+        while(!primask){
+            int irq = -1;
+            uint32_t previousPriority;
+            int previousIrq;
+            {
+                SignalGuard guard;
+                for(int i = 0; i < numberOfIrqs; i++){
+                    if(!irqPending[i] || !irqEnabled[i] || irqPriority[i] >= runningPriority) continue;
+                    if(irq < 0 || irqPriority[i] < irqPriority[irq]) irq = i;
+                }
+                if(irq < 0) return;
+                irqPending[irq] = false;
+                previousPriority = runningPriority;
+                previousIrq = runningIrq;
+                runningPriority = irqPriority[irq];
+                runningIrq = irq;
+            }
+            irqCount[irq]++;
+            irqLastTime_ns[irq] = now_ns;
+            if(irqHook[irq] != nullptr) irqHook[irq](now_ns);
+            void (*function)() = handler(irq);
+            if(function != nullptr) function();
+            //the exception return restores primask as it was on entry on a Cortex-M3 as well: it is not stacked, a
+            //handler that leaves interrupts disabled is a bug we do not model
+            SignalGuard guard;
+            runningPriority = previousPriority;
+            runningIrq = previousIrq;
+        }
+    }
+
+    void raiseInterrupt(int irq){
+        if(irqPending[irq]) irqLost[irq]++;
+        irqPending[irq] = true;
+        dispatch();
+    }
+
+    //---- timers ----
+    uint64_t timerPeriod_ns(const TimerChannel& timer, uint64_t compares){
+        const TcChannel& channel = timer.tc->TC_CHANNEL[timer.channel];
+        uint32_t mode = channel.TC_CMR;
+        if(!(mode & TC_CMR_WAVE) || (mode & TC_CMR_WAVSEL_Msk) != TC_CMR_WAVSEL_UP_RC) return 0;
+        uint64_t counts = (uint64_t)channel.TC_RC + 1;
+        switch(mode & TC_CMR_TCCLKS_Msk){
+            case TC_CMR_TCCLKS_TIMER_CLOCK1: return counts * 2 * compares * 1000000000ULL / VARIANT_MCK;
+            case TC_CMR_TCCLKS_TIMER_CLOCK2: return counts * 8 * compares * 1000000000ULL / VARIANT_MCK;
+            case TC_CMR_TCCLKS_TIMER_CLOCK3: return counts * 32 * compares * 1000000000ULL / VARIANT_MCK;
+            case TC_CMR_TCCLKS_TIMER_CLOCK4: return counts * 128 * compares * 1000000000ULL / VARIANT_MCK;
+            case TC_CMR_TCCLKS_TIMER_CLOCK5: return counts * compares * 1000000000ULL / 32768;
+            default: return 0;
+        }
+    }
+
+    bool timerInterruptEnabled(const TimerChannel& timer){
+        const TcChannel& channel = timer.tc->TC_CHANNEL[timer.channel];
+        return channel.TC_IER & ~channel.TC_IDR & TC_IER_CPCS;
+    }
+
+    void scheduleTimer(TimerChannel& timer){
+        uint64_t period = timerPeriod_ns(timer, 1);
+        timer.next_ns = (timer.running && period > 0) ? timer.start_ns + timerPeriod_ns(timer, timer.compares + 1) : never;
+    }
+
+    TimerChannel& findTimer(Tc* tc, uint32_t channel){
+        for(TimerChannel& timer : timers){
+            if(timer.tc == tc && timer.channel == channel) return timer;
+        }
+        return timers[0];
+    }
+
+    //---- ADC ----
+    uint16_t readAnalogChannel(uint8_t channel){
+        if(analogSource[channel] != nullptr) return analogSource[channel](now_ns) & 0x0FFF;
+        return analogValue[channel];
+    }
+
+    uint64_t adcClock_Hz(){
+        uint32_t prescal = (adc.ADC_MR & ADC_MR_PRESCAL_Msk) >> ADC_MR_PRESCAL_Pos;
+        return VARIANT_MCK / ((prescal + 1) * 2);
+    }
+
+    uint64_t adcConversion_ns(){
+        uint32_t transfer = (adc.ADC_MR & ADC_MR_TRANSFER_Msk) >> ADC_MR_TRANSFER_Pos;
+        uint64_t clocks = 20 + transfer * 2 + 3;
+        return clocks * 1000000000ULL / adcClock_Hz();
+    }
+
+    bool adcActive(){
+        return (peripheralClocks[ID_ADC / 32] & (1u << (ID_ADC % 32))) && (adc.ADC_MR & ADC_MR_FREERUN_ON)
+            && (adc.ADC_CHER & 0xFFFF) && (adc.ADC_CR & ADC_CR_START);
+    }
+
+    //notices the firmware starting or stopping the ADC, registers are plain memory
+    void updateAdc(){
+        bool active = adcActive();
+        if(active && !adcRunning){
+            static const uint16_t startupClocks[16] = {0, 8, 16, 24, 64, 80, 96, 112, 512, 576, 640, 704, 768, 832, 896, 960};
+            uint32_t startup = (adc.ADC_MR & ADC_MR_STARTUP_Msk) >> ADC_MR_STARTUP_Pos;
+            adcNext_ns = now_ns + startupClocks[startup] * 1000000000ULL / adcClock_Hz() + adcConversion_ns();
+            adcChannel = 0;
+        }
+        if(!active) adcNext_ns = never;
+        adcRunning = active;
+    }
+
+    void convert(){
+        uint32_t channels = adc.ADC_CHER & 0xFFFF;
+        while(!(channels & (1u << adcChannel))) adcChannel = (adcChannel + 1) % 16;
+        uint16_t value = readAnalogChannel(adcChannel);
+        uint32_t result = (adc.ADC_EMR & ADC_EMR_TAG) ? ((uint32_t)adcChannel << ADC_LCDR_CHNB_Pos) | value : value;
+        adc.ADC_CDR[adcChannel] = value;
+        adc.ADC_LCDR = result;
+        adc.ADC_ISR |= ADC_ISR_DRDY | (1u << adcChannel);
+        adcConversions++;
+        adcChannel = (adcChannel + 1) % 16;
+        adcNext_ns += adcConversion_ns();
+
+        //PDC: ENDRX stays set until the firmware writes a new next buffer
+        if((adc.ADC_ISR & ADC_ISR_ENDRX) && adc.ADC_RNCR != 0) adc.ADC_ISR &= ~ADC_ISR_ENDRX;
+        if(!(adc.ADC_PTCR & ADC_PTCR_RXTEN) || adc.ADC_RCR == 0) return;
+        *(uint16_t*)adc.ADC_RPR = (uint16_t)result;
+        adc.ADC_RPR += sizeof(uint16_t);
+        adc.ADC_RCR--;
+        if(adc.ADC_RCR > 0) return;
+        adc.ADC_ISR |= ADC_ISR_ENDRX;
+        if(adc.ADC_RNCR > 0){
+            adc.ADC_RPR = adc.ADC_RNPR;
+            adc.ADC_RCR = adc.ADC_RNCR;
+            adc.ADC_RNCR = 0;
+        }else{
+            adc.ADC_ISR |= ADC_ISR_RXBUFF;
+        }
+        if(adc.ADC_IER & ~adc.ADC_IDR & ADC_IER_ENDRX) raiseInterrupt(ADC_IRQn);
+    }
+
+    //---- serial ----
+    uint64_t serialByte_ns(){
+        return 10 * 1000000000ULL / serialBaudRate;
+    }
+
+    void drainSerial(){
+        if(serialBaudRate == 0 || serialQueued == 0){
+            serialQueued = 0;
+            return;
+        }
+        uint64_t sent = (now_ns - serialLastDrain_ns) / serialByte_ns();
+        if(sent >= serialQueued){
+            serialQueued = 0;
+        }else{
+            serialQueued -= sent;
+            serialLastDrain_ns += sent * serialByte_ns();
+        }
+    }
+
+    //---- asynchronous interrupt ----
+    uint32_t nextAsyncInterval_us(){
+        asyncRandom ^= asyncRandom << 13;
+        asyncRandom ^= asyncRandom >> 17;
+        asyncRandom ^= asyncRandom << 5;
+        return asyncMin_us + asyncRandom % (asyncMax_us - asyncMin_us + 1);
+    }
+
+    void armAsyncTimer(){
+        itimerspec spec = {};
+        uint32_t interval = nextAsyncInterval_us();
+        spec.it_value.tv_sec = interval / 1000000;
+        spec.it_value.tv_nsec = (interval % 1000000) * 1000;
+        timer_settime(asyncTimer, 0, &spec, nullptr);
+    }
+
+    void asyncSignalHandler(int){
+        int irq = asyncIrq;
+        if(irq < 0) return;
+        armAsyncTimer();
+        raiseInterrupt(irq);
+    }
+}
+
+namespace Simulation{
+    //---- clock ----
+    uint64_t getTime_ns(){
+        return now_ns;
+    }
+
+    void advanceTo(uint64_t time_ns){
+        while(true){
+            updateAdc();
+            uint64_t next = powerCut_ns;
+            if(adcNext_ns < next) next = adcNext_ns;
+            for(TimerChannel& timer : timers){
+                if(timer.next_ns < next) next = timer.next_ns;
+            }
+            if(next > time_ns) break;
+            if(next > now_ns) now_ns = next;
+            if(powerCut_ns <= now_ns) cutPower();
+            for(TimerChannel& timer : timers){
+                if(timer.next_ns > now_ns) continue;
+                timer.compares++;
+                scheduleTimer(timer);
+                if(!timerInterruptEnabled(timer)) continue;
+                timer.tc->TC_CHANNEL[timer.channel].TC_SR |= TC_SR_CPCS;
+                raiseInterrupt(timer.irq);
+            }
+            if(adcNext_ns <= now_ns) convert();
+        }
+        if(time_ns > now_ns) now_ns = time_ns;
+    }
+
+    void advance_ns(uint64_t duration_ns){
+        spinReads = 0;
+        advanceTo(now_ns + duration_ns);
+    }
+
+    bool advanceUntil(bool (*condition)(), uint64_t timeout_ns, uint64_t step_ns){
+        uint64_t end = now_ns + timeout_ns;
+        while(!condition()){
+            if(now_ns >= end) return false;
+            advance_ns(end - now_ns < step_ns ? end - now_ns : step_ns);
+        }
+        return true;
+    }
+
+    //---- interrupts ----
+    uint32_t getInterruptCount(IRQn_Type irq){
+        return irqCount[irq];
+    }
+
+    uint32_t getLostInterruptCount(IRQn_Type irq){
+        return irqLost[irq];
+    }
+
+    uint64_t getLastInterruptTime_ns(IRQn_Type irq){
+        return irqLastTime_ns[irq];
+    }
+
+    void setInterruptHook(IRQn_Type irq, void (*hook)(uint64_t)){
+        irqHook[irq] = hook;
+    }
+
+    uint64_t getTimerPeriod_ns(Tc* tc, uint32_t channel){
+        TimerChannel& timer = findTimer(tc, channel);
+        if(!timerInterruptEnabled(timer)) return 0;
+        return timerPeriod_ns(timer, 1);
+    }
+
+    bool isInInterrupt(){
+        return runningIrq >= 0;
+    }
+
+    void startAsynchronousInterrupt(IRQn_Type irq, uint32_t minInterval_us, uint32_t maxInterval_us, uint32_t seed){
+        stopAsynchronousInterrupt();
+        if(!asyncTimerCreated){
+            struct sigaction action = {};
+            action.sa_handler = asyncSignalHandler;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGRTMIN, &action, nullptr);
+            sigevent event = {};
+            event.sigev_notify = SIGEV_SIGNAL;
+            event.sigev_signo = SIGRTMIN;
+            timer_create(CLOCK_MONOTONIC, &event, &asyncTimer);
+            asyncTimerCreated = true;
+        }
+        asyncMin_us = minInterval_us;
+        asyncMax_us = maxInterval_us < minInterval_us ? minInterval_us : maxInterval_us;
+        asyncRandom = seed == 0 ? 1 : seed;
+        asynchronous = true;
+        asyncIrq = irq;
+        armAsyncTimer();
+    }
+
+    void stopAsynchronousInterrupt(){
+        if(!asyncTimerCreated) return;
+        asyncIrq = -1;
+        itimerspec spec = {};
+        timer_settime(asyncTimer, 0, &spec, nullptr);
+        asynchronous = false;
+    }
+
+    //---- power ----
+    bool isRunningFirmware(){
+        return insideFirmware;
+    }
+
+    Shutdown runFirmware(void (*firmware)()){
+        fflush(nullptr);
+        pid_t pid = fork();
+        if(pid < 0){
+            perror("fork");
+            abort();
+        }
+        if(pid == 0){
+            insideFirmware = true;
+            firmware();
+            fflush(nullptr);
+            _exit(0);
+        }
+        int status = 0;
+        while(waitpid(pid, &status, 0) < 0){}
+        if(!WIFEXITED(status)) return Shutdown::Crashed;
+        switch(WEXITSTATUS(status)){
+            case 0: return Shutdown::Returned;
+            case exitPowerCut: return Shutdown::PowerCut;
+            case exitReset: return Shutdown::Reset;
+            case exitHalted: return Shutdown::Halted;
+            default: return Shutdown::Crashed;
+        }
+    }
+
+    void triggerPowerFailure(uint32_t holdUp_us){
+        powerCut_ns = now_ns + (uint64_t)holdUp_us * 1000;
+        supc.SUPC_SR |= SUPC_SR_SMS;
+        if(supc.SUPC_SMMR & SUPC_SMMR_SMIEN) raiseInterrupt(SUPC_IRQn);
+    }
+
+    void cutPower(){
+        if(!insideFirmware){
+            fprintf(stderr, "Simulation: the power can only be cut inside runFirmware()\n");
+            abort();
+        }
+        fflush(nullptr);
+        _exit(exitPowerCut);
+    }
+
+    void* allocateSharedMemory(size_t size){
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED){
+            perror("mmap");
+            abort();
+        }
+        return memory;
+    }
+
+    //---- pins ----
+    static uint8_t analogChannel(uint32_t pin){
+        if(pin < A0) pin += A0;
+        if(pin < A0 || pin > A11) return 0xFF;
+        return analogPinChannel[pin - A0];
+    }
+
+    void setAnalogInput(uint32_t pin, uint16_t value){
+        uint8_t channel = analogChannel(pin);
+        if(channel == 0xFF) return;
+        analogSource[channel] = nullptr;
+        analogValue[channel] = value & 0x0FFF;
+    }
+
+    void setAnalogInput(uint32_t pin, uint16_t (*source)(uint64_t)){
+        uint8_t channel = analogChannel(pin);
+        if(channel == 0xFF) return;
+        analogSource[channel] = source;
+    }
+
+    uint16_t getAnalogInput(uint32_t pin){
+        uint8_t channel = analogChannel(pin);
+        if(channel == 0xFF) return 0;
+        return readAnalogChannel(channel);
+    }
+
+    void setDigitalInput(uint32_t pin, bool level){
+        if(pin >= PINS_COUNT) return;
+        Pin& state = pins[pin];
+        bool previous = getPinLevel(pin);
+        state.input = level;
+        state.inputSet = true;
+        bool current = getPinLevel(pin);
+        if(state.callback == nullptr || previous == current) return;
+        if(state.callbackMode == CHANGE || (state.callbackMode == RISING && current) || (state.callbackMode == FALLING && !current)){
+            state.interruptFlag = true;
+            raiseInterrupt(PIOA_IRQn + pinPort[pin]);
+        }
+    }
+
+    bool getDigitalOutput(uint32_t pin){
+        return pin < PINS_COUNT && pins[pin].output;
+    }
+
+    uint32_t getAnalogOutput(uint32_t pin){
+        return pin < PINS_COUNT ? pins[pin].analogOutput : 0;
+    }
+
+    uint64_t getAdcConversionCount(){
+        return adcConversions;
+    }
+
+    uint64_t getAdcConversionTime_ns(){
+        updateAdc();
+        return adcRunning ? adcConversion_ns() : 0;
+    }
+
+    bool getPinLevel(uint32_t pin){
+        if(pin >= PINS_COUNT) return false;
+        const Pin& state = pins[pin];
+        if(state.mode == OUTPUT) return state.output;
+        if(state.inputSet) return state.input;
+        return state.mode == INPUT_PULLUP;
+    }
+
+    bool isOutput(uint32_t pin){
+        return pin < PINS_COUNT && pins[pin].mode == OUTPUT;
+    }
+
+    //---- serial ----
+    std::string getSerialOutput(){
+        if(serialWritten <= serialCaptureSize) return std::string(serialCapture, (size_t)serialWritten);
+        size_t start = serialWritten % serialCaptureSize;
+        return std::string(serialCapture + start, serialCaptureSize - start) + std::string(serialCapture, start);
+    }
+
+    void clearSerialOutput(){
+        serialWritten = 0;
+    }
+
+    uint64_t getSerialBytesWritten(){
+        return serialWritten;
+    }
+
+    //---- heap ----
+    void countHeapAllocation(size_t size){
+        heapAllocations++;
+        heapAllocatedBytes += size;
+    }
+
+    uint64_t getHeapAllocations(){
+        return heapAllocations;
+    }
+
+    uint64_t getHeapAllocatedBytes(){
+        return heapAllocatedBytes;
+    }
+}
+
+using namespace Simulation;
+
+//---- libsam ----
+void TC_Configure(Tc* tc, uint32_t channel, uint32_t mode){
+    TcChannel& registers = tc->TC_CHANNEL[channel];
+    registers.TC_CCR = TC_CCR_CLKDIS;
+    registers.TC_IER = 0;
+    registers.TC_IDR = 0;
+    registers.TC_SR = 0;
+    registers.TC_CMR = mode;
+    findTimer(tc, channel).running = false;
+    scheduleTimer(findTimer(tc, channel));
+}
+
+void TC_Start(Tc* tc, uint32_t channel){
+    TcChannel& registers = tc->TC_CHANNEL[channel];
+    registers.TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+    registers.TC_SR |= TC_SR_CLKSTA;
+    TimerChannel& timer = findTimer(tc, channel);
+    timer.running = true;
+    timer.start_ns = now_ns;
+    timer.compares = 0;
+    scheduleTimer(timer);
+}
+
+void TC_Stop(Tc* tc, uint32_t channel){
+    TcChannel& registers = tc->TC_CHANNEL[channel];
+    registers.TC_CCR = TC_CCR_CLKDIS;
+    registers.TC_SR &= ~TC_SR_CLKSTA;
+    TimerChannel& timer = findTimer(tc, channel);
+    timer.running = false;
+    scheduleTimer(timer);
+}
+
+void TC_SetRA(Tc* tc, uint32_t channel, uint32_t value){
+    tc->TC_CHANNEL[channel].TC_RA = value;
+}
+
+void TC_SetRB(Tc* tc, uint32_t channel, uint32_t value){
+    tc->TC_CHANNEL[channel].TC_RB = value;
+}
+
+void TC_SetRC(Tc* tc, uint32_t channel, uint32_t value){
+    TimerChannel& timer = findTimer(tc, channel);
+    //the counter keeps running, the next compare is measured from the last one
+    uint64_t lastCompare_ns = timer.start_ns + timerPeriod_ns(timer, timer.compares);
+    tc->TC_CHANNEL[channel].TC_RC = value;
+    if(timer.running){
+        timer.start_ns = lastCompare_ns;
+        timer.compares = 0;
+    }
+    scheduleTimer(timer);
+}
+
+uint32_t TC_ReadCV(Tc* tc, uint32_t channel){
+    TimerChannel& timer = findTimer(tc, channel);
+    uint64_t period = timerPeriod_ns(timer, 1);
+    if(!timer.running || period == 0) return tc->TC_CHANNEL[channel].TC_CV;
+    uint64_t elapsed = now_ns - (timer.next_ns - period);
+    return (uint32_t)(elapsed * (tc->TC_CHANNEL[channel].TC_RC + 1) / period);
+}
+
+uint32_t TC_GetStatus(Tc* tc, uint32_t channel){
+    uint32_t status = tc->TC_CHANNEL[channel].TC_SR;
+    tc->TC_CHANNEL[channel].TC_SR = status & TC_SR_CLKSTA; //reading the status register clears the event flags
+    return status;
+}
+
+void pmc_set_writeprotect(uint32_t enable){
+    (void)enable;
+}
+
+uint32_t pmc_enable_periph_clk(uint32_t id){
+    if(id >= 64) return 1;
+    peripheralClocks[id / 32] |= 1u << (id % 32);
+    return 0;
+}
+
+uint32_t pmc_disable_periph_clk(uint32_t id){
+    if(id >= 64) return 1;
+    peripheralClocks[id / 32] &= ~(1u << (id % 32));
+    return 0;
+}
+
+//---- CMSIS ----
+void NVIC_EnableIRQ(IRQn_Type irq){
+    if(irq < 0) return;
+    irqEnabled[irq] = true;
+    dispatch();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq){
+    if(irq < 0) return;
+    irqEnabled[irq] = false;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq){
+    return irq >= 0 && irqPending[irq];
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq){
+    if(irq < 0) return;
+    raiseInterrupt(irq);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq){
+    if(irq < 0) return;
+    irqPending[irq] = false;
+}
+
+uint32_t NVIC_GetActive(IRQn_Type irq){
+    return irq >= 0 && runningIrq == irq;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority){
+    if(irq < 0) return;
+    irqPriority[irq] = priority & 0x0F; //the SAM3X implements 4 priority bits
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq){
+    return irq < 0 ? 0 : irqPriority[irq];
+}
+
+void NVIC_SystemReset(){
+    if(!insideFirmware){
+        fprintf(stderr, "Simulation: NVIC_SystemReset() outside of runFirmware()\n");
+        abort();
+    }
+    fflush(nullptr);
+    _exit(exitReset);
+}
+
+void __enable_irq(){
+    primask = false;
+    dispatch();
+}
+
+void __disable_irq(){
+    primask = true;
+}
+
+uint32_t __get_PRIMASK(){
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask){
+    if(priMask & 1) __disable_irq();
+    else __enable_irq();
+}
+
+uint32_t __get_IPSR(){
+    return runningIrq < 0 ? 0 : runningIrq + 16;
+}
+
+void __bkpt_simulated(uint32_t value){
+    if(!insideFirmware){
+        fprintf(stderr, "Simulation: breakpoint %u outside of runFirmware()\n", (unsigned)value);
+        abort();
+    }
+    fflush(nullptr);
+    _exit(exitHalted);
+}
+
+//---- wiring ----
+static void readClock(){
+    //a loop that polls the clock waits for time to pass, see TIME in LscSimulation.h
+    if(spinReadTime_ns != now_ns){
+        spinReadTime_ns = now_ns;
+        spinReads = 0;
+    }
+    if(++spinReads <= spinReadLimit) return;
+    advanceTo(now_ns + 1000);
+    spinReadTime_ns = now_ns;
+}
+
+unsigned long millis(){
+    readClock();
+    return (uint32_t)(now_ns / 1000000);
+}
+
+unsigned long micros(){
+    readClock();
+    return (uint32_t)(now_ns / 1000);
+}
+
+void delay(unsigned long ms){
+    advance_ns((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us){
+    advance_ns((uint64_t)us * 1000);
+}
+
+void yield(){
+}
+
+void pinMode(uint32_t pin, uint32_t mode){
+    if(pin >= PINS_COUNT) return;
+    bool previous = getPinLevel(pin);
+    pins[pin].mode = mode;
+    bool current = getPinLevel(pin);
+    if(previous != current) onOutputChanged(pin, current);
+}
+
+void digitalWrite(uint32_t pin, uint32_t value){
+    if(pin >= PINS_COUNT) return;
+    bool previous = getPinLevel(pin);
+    pins[pin].output = value != LOW;
+    bool current = getPinLevel(pin);
+    if(previous != current) onOutputChanged(pin, current);
+}
+
+int digitalRead(uint32_t pin){
+    return getPinLevel(pin) ? HIGH : LOW;
+}
+
+uint32_t analogRead(uint32_t pin){
+    uint8_t channel = analogChannel(pin);
+    if(channel == 0xFF) return 0;
+    advanceTo(now_ns + 4000); //a single conversion including the channel switch, about 4us on the Due
+    uint32_t value = readAnalogChannel(channel);
+    if(analogReadBits < 12) return value >> (12 - analogReadBits);
+    return value << (analogReadBits - 12);
+}
+
+void analogWrite(uint32_t pin, uint32_t value){
+    if(pin < PINS_COUNT) pins[pin].analogOutput = value;
+}
+
+void analogReadResolution(int resolution){
+    analogReadBits = resolution;
+}
+
+void analogWriteResolution(int resolution){
+    (void)resolution;
+}
+
+void attachInterrupt(uint32_t pin, void (*callback)(), uint32_t mode){
+    if(pin >= PINS_COUNT) return;
+    pins[pin].callback = callback;
+    pins[pin].callbackMode = mode;
+    irqEnabled[PIOA_IRQn + pinPort[pin]] = true;
+}
+
+void detachInterrupt(uint32_t pin){
+    if(pin >= PINS_COUNT) return;
+    pins[pin].callback = nullptr;
+}
+
+long random(long howBig){
+    if(howBig == 0) return 0;
+    return ::random() % howBig;
+}
+
+long random(long howSmall, long howBig){
+    if(howSmall >= howBig) return howSmall;
+    return random(howBig - howSmall) + howSmall;
+}
+
+void randomSeed(unsigned long seed){
+    if(seed != 0) srandom(seed);
+}
+
+long map(long value, long fromLow, long fromHigh, long toLow, long toHigh){
+    return (value - fromLow) * (toHigh - toLow) / (fromHigh - fromLow) + toLow;
+}
+
+static char* convertNumber(unsigned long value, bool negative, char* string, int radix){
+    char digits[33];
+    int length = 0;
+    do{
+        uint32_t digit = value % radix;
+        digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= radix;
+    }while(value > 0);
+    char* out = string;
+    if(negative) *out++ = '-';
+    while(length > 0) *out++ = digits[--length];
+    *out = 0;
+    return string;
+}
+
+char* itoa(int value, char* string, int radix){
+    return ltoa(value, string, radix);
+}
+
+char* ltoa(long value, char* string, int radix){
+    int32_t number = (int32_t)value; //long is 32 bit on the Due
+    bool negative = number < 0 && radix == 10;
+    uint32_t magnitude = negative ? 0u - (uint32_t)number : (uint32_t)number;
+    return convertNumber(magnitude, negative, string, radix);
+}
+
+char* utoa(unsigned int value, char* string, int radix){
+    return convertNumber(value, false, string, radix);
+}
+
+char* ultoa(unsigned long value, char* string, int radix){
+    return convertNumber((uint32_t)value, false, string, radix);
+}
+
+//g_APinDescription only carries the ADC channels
+static PinDescription makePinDescription(uint32_t pin){
+    PinDescription description;
+    uint8_t channel = analogChannel(pin);
+    if(pin >= A0 && pin <= A11) description.ulADCChannelNumber = (EAnalogChannel)channel;
+    else if(pin == DAC0) description.ulADCChannelNumber = DA0;
+    else if(pin == DAC1) description.ulADCChannelNumber = DA1;
+    else description.ulADCChannelNumber = NO_ADC;
+    return description;
+}
+
+#define PIN_DESCRIPTIONS_10(start) makePinDescription(start), makePinDescription(start + 1), makePinDescription(start + 2), \
+    makePinDescription(start + 3), makePinDescription(start + 4), makePinDescription(start + 5), makePinDescription(start + 6), \
+    makePinDescription(start + 7), makePinDescription(start + 8), makePinDescription(start + 9)
+extern const PinDescription g_APinDescription[PINS_COUNT + 1] = {
+    PIN_DESCRIPTIONS_10(0), PIN_DESCRIPTIONS_10(10), PIN_DESCRIPTIONS_10(20), PIN_DESCRIPTIONS_10(30),
+    PIN_DESCRIPTIONS_10(40), PIN_DESCRIPTIONS_10(50), PIN_DESCRIPTIONS_10(60), PIN_DESCRIPTIONS_10(70)
+};
+
+//symbols of the Due linker script, referenced by FreeRam() of the SD library
+int __bss_end;
+int* __brkval;
+
+//---- Serial ----
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baudRate){
+    serialBaudRate = baudRate;
+    serialQueued = 0;
+}
+
+void HardwareSerial::end(){
+    flush();
+    serialBaudRate = 0;
+}
+
+int HardwareSerial::availableForWrite(){
+    drainSerial();
+    return bufferSize - 1 - serialQueued;
+}
+
+void HardwareSerial::flush(){
+    drainSerial();
+    while(serialQueued > 0){
+        advanceTo(serialLastDrain_ns + serialQueued * serialByte_ns());
+        drainSerial();
+    }
+}
+
+size_t HardwareSerial::write(uint8_t data){
+    drainSerial();
+    if(serialBaudRate != 0){
+        //the Due core spins until there is room in the transmit buffer
+        while(serialQueued >= (uint32_t)bufferSize - 1){
+            advanceTo(serialLastDrain_ns + serialByte_ns());
+            drainSerial();
+        }
+        if(serialQueued == 0) serialLastDrain_ns = now_ns;
+        serialQueued++;
+    }
+    serialCapture[serialWritten % serialCaptureSize] = (char)data;
+    serialWritten++;
+    return 1;
+}
+
+//---- heap ----
+void* operator new(size_t size){
+    countHeapAllocation(size);
+    void* memory = malloc(size == 0 ? 1 : size);
+    if(memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept{
+    countHeapAllocation(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept{
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept{
+    free(memory);
+}
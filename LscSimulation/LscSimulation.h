@@ -0,0 +1,231 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+/*
+    Runs the LSC libraries on a PC for the tests in LscSimulation/tests, see CMakeLists.txt in the root of the repository.
+    Never included by the firmware.
+*/
+
+#ifndef LSCSIMULATION_H
+#define LSCSIMULATION_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <new>
+
+//---- SIMULATION EXPLANATION ----
+/*
+    The firmware is compiled unchanged against the headers in core/, which declare the Arduino Due API (millis(),
+    digitalWrite(), SPI, Serial, ...) and the SAM3X registers and CMSIS functions the LSC code uses. Everything behind
+    these declarations is implemented here.
+
+    TIME
+    The simulation has its own clock in ns, it starts at 0 with every run of the firmware. Executing code takes no time,
+    time only passes when
+        - the code waits for hardware: every SPI byte, every UART byte that does not fit into the transmit buffer, delay()
+        - the code polls the clock: after spinReadLimit reads of millis()/micros() without any progress the clock is
+          moved forward by 1us, such that busy waits terminate
+        - a test calls advance_ns() (e.g. to let the system run for a while or to model the cost of a computation)
+    Every interrupt that becomes due while time passes fires at its exact time, i.e. in the middle of an SPI transfer,
+    a delay() or an advance_ns(). The simulation is deterministic: the same test produces the same trace every time.
+
+    INTERRUPTS
+    The NVIC is modelled with enable, pending and priority per interrupt, PRIMASK (noInterrupts()) and nesting: an
+    interrupt only preempts the running code if its priority number is lower than the one of the running handler.
+    __get_IPSR() is not 0 inside a handler. Pending interrupts run as soon as they are unmasked.
+    The handlers are the ones the firmware defines (TC5_Handler, TC2_Handler, ...), the ones it does not define do nothing.
+    Sources:
+        - timer counters: a channel that is started in waveform mode UP_RC with the RC compare interrupt enabled fires its
+          interrupt every (RC + 1) counter clocks (TIMER_CLOCK1-4 = MCK/2, /8, /32, /128). TC0 ch2 -> TC2, TC1 ch0 -> TC3,
+          TC1 ch2 -> TC5. The interrupt enable is taken as TC_IER & ~TC_IDR, the way the LSC code writes them.
+        - ADC: free running conversions of the enabled channels, written to the PDC buffers, see ADC below.
+        - SUPC: triggerPowerFailure()
+        - PIO: attachInterrupt() callbacks fire when a test changes a digital input
+    For stress tests there is also an asynchronous mode (startAsynchronousInterrupt()): a POSIX timer signal raises the
+    interrupt at random moments of real time, i.e. at any instruction of the interrupted code. Masking, priorities and
+    pending work the same way.
+
+    ADC
+    The conversion time follows ADC_MR: ADC clock = MCK / ((PRESCAL + 1) * 2), every conversion takes 20 ADC clocks plus
+    the transfer period (TRANSFER * 2 + 3 clocks), tracking overlaps with the previous conversion. The value of every
+    conversion comes from setAnalogInput(), analogRead() reads the same inputs.
+
+    SPI BUS
+    Every byte on the bus goes to the device whose chip select is low, the SD card at pin sdCardChipSelectPin and the
+    ILI9341 display at displayChipSelectPin (its D/C line is displayDataCommandPin). A byte takes
+    (8 * SCBR + 32) / MCK, SCBR = MCK / clock of the active SPISettings rounded up and 32 the DLYBCT of the Due SPI library.
+    Two selected devices at the same time is a bus conflict, it is counted (getBusStatistics()) because on the real
+    board it corrupts both transfers.
+    The SD card understands the SPI mode command set used by Sd2Card (init, single and multi block read/write, erase,
+    CSD/CID). Its blocks live in memory that is shared between runs of the firmware (runFirmware()), i.e. it survives
+    a power cut or a reset like a real card. cutPowerAfterProgrammedBytes() lets the power fail at an exact byte.
+    The display decodes CASET/PASET/RAMWR/MADCTL into a framebuffer and counts commands, windows and pixels.
+
+    POWER
+    runFirmware() runs the firmware in a forked process, i.e. with fresh static state like after a reset. The process
+    ends when the firmware returns, the power is cut, NVIC_SystemReset() is called or the core halts (__BKPT).
+    The SD card and the memory of allocateSharedMemory() are kept.
+
+    HEAP
+    Every operator new and every String buffer (re)allocation is counted, see getHeapAllocations().
+*/
+//---- END SIMULATION EXPLANATION ----
+
+namespace Simulation{
+    constexpr uint32_t sdCardChipSelectPin = 31;
+    constexpr uint32_t displayChipSelectPin = 30;
+    constexpr uint32_t displayDataCommandPin = 28;
+    constexpr uint32_t spinReadLimit = 64;
+
+    //---- clock ----
+    uint64_t getTime_ns();
+    //Lets time pass, every interrupt that becomes due fires at its time
+    void advance_ns(uint64_t duration_ns);
+    inline void advance_us(uint64_t duration_us){ advance_ns(duration_us * 1000); }
+    inline void advance_ms(uint64_t duration_ms){ advance_ns(duration_ms * 1000000); }
+    //Lets time pass until condition() returns true or timeout_ns passed. Returns the result of the last call of condition()
+    bool advanceUntil(bool (*condition)(), uint64_t timeout_ns, uint64_t step_ns = 1000);
+
+    //---- interrupts ----
+    //Number of times the handler of irq has been entered
+    uint32_t getInterruptCount(IRQn_Type irq);
+    //Number of times irq became due while it was still pending, i.e. interrupts that have been lost
+    uint32_t getLostInterruptCount(IRQn_Type irq);
+    //Time of the last entry into the handler of irq
+    uint64_t getLastInterruptTime_ns(IRQn_Type irq);
+    //Is called on every entry into the handler of irq with the time of the entry, nullptr removes the hook
+    void setInterruptHook(IRQn_Type irq, void (*hook)(uint64_t time_ns));
+    //Period of a timer counter channel as configured in its registers, 0 if it does not fire interrupts
+    uint64_t getTimerPeriod_ns(Tc* tc, uint32_t channel);
+    //true while an interrupt handler is running
+    bool isInInterrupt();
+    //Raises irq from a POSIX timer signal every minInterval_us to maxInterval_us (uniformly random) of real time
+    void startAsynchronousInterrupt(IRQn_Type irq, uint32_t minInterval_us, uint32_t maxInterval_us, uint32_t seed = 1);
+    void stopAsynchronousInterrupt();
+
+    //---- power ----
+    enum class Shutdown{ Returned, PowerCut, Reset, Halted, Crashed };
+    //Runs firmware() in a fresh process and returns why it ended
+    Shutdown runFirmware(void (*firmware)());
+    //Sets the supply monitor, raises SUPC_IRQn and cuts the power holdUp_us later
+    void triggerPowerFailure(uint32_t holdUp_us);
+    [[noreturn]] void cutPower();
+    //Memory that is shared between the test and all runs of the firmware, zero initialized
+    void* allocateSharedMemory(size_t size);
+    template<typename T> T* allocateShared(){ return new (allocateSharedMemory(sizeof(T))) T(); }
+
+    //---- pins ----
+    //Sets the voltage on an analog input in ADC counts (0-4095)
+    void setAnalogInput(uint32_t pin, uint16_t value);
+    //The value of every conversion of the input is source(time of the conversion)
+    void setAnalogInput(uint32_t pin, uint16_t (*source)(uint64_t time_ns));
+    uint16_t getAnalogInput(uint32_t pin);
+    //Sets the level of a digital input, attachInterrupt() callbacks fire in the PIO interrupt of the pin
+    void setDigitalInput(uint32_t pin, bool level);
+    bool getDigitalOutput(uint32_t pin);
+    uint32_t getAnalogOutput(uint32_t pin);
+    //Number of conversions the ADC has done since the start of the run
+    uint64_t getAdcConversionCount();
+    //Time one ADC conversion takes with the current ADC_MR, 0 if the ADC is not running
+    uint64_t getAdcConversionTime_ns();
+
+    //---- serial ----
+    //Everything that has been written to Serial (the last serialCaptureSize bytes of it)
+    constexpr size_t serialCaptureSize = 1 << 16;
+    std::string getSerialOutput();
+    void clearSerialOutput();
+    uint64_t getSerialBytesWritten();
+
+    //---- heap ----
+    void countHeapAllocation(size_t size);
+    uint64_t getHeapAllocations();
+    uint64_t getHeapAllocatedBytes();
+
+    //---- SPI bus ----
+    struct BusStatistics{
+        uint64_t bytes;
+        uint64_t busyTime_ns;
+        uint64_t conflicts;         //a chip select went low while another device was selected
+        uint64_t conflictBytes;     //bytes transferred while more than one device was selected
+        uint64_t unselectedBytes;   //bytes transferred while no device was selected (Sd2Card::init() sends 10 on purpose)
+        uint64_t interruptBytes;    //bytes transferred from an interrupt handler
+    };
+    BusStatistics getBusStatistics();
+    void resetBusStatistics();
+    //Time one byte takes on the bus with the given SPI clock
+    uint64_t getSpiByteTime_ns(uint32_t clock);
+
+    //---- SD card ----
+    namespace SdCard{
+        struct Statistics{
+            uint64_t commands;
+            uint64_t blockReads;
+            uint64_t blockWrites;           //single and multi block
+            uint64_t singleBlockWrites;
+            uint64_t multiBlockWrites;      //CMD25
+            uint64_t erases;                //CMD38
+            uint64_t programmedBytes;
+            uint64_t busyTime_ns;           //time the card was busy programming or erasing
+        };
+        struct Timing{
+            uint32_t readLatency_ns;        //from CMD17 to the data token
+            uint32_t singleBlockProgram_ns; //busy after a CMD24 block
+            uint32_t multiBlockProgram_ns;  //busy after every CMD25 block
+            uint32_t stopTransmission_ns;   //busy after the stop token
+            uint32_t eraseBase_ns;          //busy after CMD38
+            uint32_t erasePerBlock_ns;
+        };
+        //Puts a freshly formatted card (MBR + one FAT16 or FAT32 partition) into the slot. blocks is rounded down to 1024
+        void insert(uint32_t blocks, uint8_t fatType = 16);
+        void remove();
+        uint32_t getNumberOfBlocks();
+        uint8_t* getBlock(uint32_t block);
+        Statistics getStatistics();
+        void resetStatistics();
+        Timing& getTiming();
+        //The power fails while the card programs the byte with the given number (counted from now on)
+        void cutPowerAfterProgrammedBytes(uint64_t bytes);
+        void cancelPowerCut();
+    }
+
+    //---- display ----
+    namespace Display{
+        constexpr uint16_t width = 320;
+        constexpr uint16_t height = 240;
+        struct Statistics{
+            uint64_t commands;
+            uint64_t windows;       //CASET/PASET pairs followed by a RAMWR
+            uint64_t pixels;        //pixels written by RAMWR
+            uint64_t dataBytes;
+        };
+        //Colour of a pixel in the orientation set by MADCTL (i.e. the one of tft.setRotation())
+        uint16_t getPixel(uint16_t x, uint16_t y);
+        //Number of pixels of the rectangle with the given colour
+        uint32_t countPixels(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+        //Writes the framebuffer as binary PPM, for looking at failing tests
+        bool writePpm(const char* fileName);
+        Statistics getStatistics();
+        void resetStatistics();
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Interfaces between the parts of the simulation, not meant for tests. See LscSimulation.h
+
+#ifndef LSCSIMULATIONINTERNAL_H
+#define LSCSIMULATIONINTERNAL_H
+
+#include "LscSimulation.h"
+
+namespace Simulation{
+    //Called by digitalWrite() for every change of an output
+    void onOutputChanged(uint32_t pin, bool level);
+    //Level of a pin as the devices on the bus see it
+    bool getPinLevel(uint32_t pin);
+    bool isOutput(uint32_t pin);
+    //Exchanges one byte with the selected device(s), called by SPIClass
+    uint8_t transferSpiByte(uint8_t data, uint32_t clock);
+    //true inside the process started by runFirmware()
+    bool isRunningFirmware();
+    //Lets time pass without the spin detection of millis()/micros() noticing
+    void advanceTo(uint64_t time_ns);
+}
+
+#endif
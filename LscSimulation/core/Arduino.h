@@ -0,0 +1,149 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+/*
+    Host stand-in for the Arduino Due core (arduino/sam). Only what the LSC code and the bundled libraries use is
+    provided, the behaviour behind it lives in LscSimulation.cpp, see SIMULATION EXPLANATION in LscSimulation.h.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "sam.h"
+#include "avr/pgmspace.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+
+//pins of the Due variant
+#define PINS_COUNT 79
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) ((p) < PINS_COUNT ? (p) : NOT_AN_INTERRUPT)
+#define digitalPinToBitMask(p) (1u << ((p) % 32))
+static const uint8_t SS   = 10;
+static const uint8_t MOSI = 75;
+static const uint8_t MISO = 74;
+static const uint8_t SCK  = 76;
+static const uint8_t A0  = 54;
+static const uint8_t A1  = 55;
+static const uint8_t A2  = 56;
+static const uint8_t A3  = 57;
+static const uint8_t A4  = 58;
+static const uint8_t A5  = 59;
+static const uint8_t A6  = 60;
+static const uint8_t A7  = 61;
+static const uint8_t A8  = 62;
+static const uint8_t A9  = 63;
+static const uint8_t A10 = 64;
+static const uint8_t A11 = 65;
+static const uint8_t DAC0 = 66;
+static const uint8_t DAC1 = 67;
+
+#define ADC_RESOLUTION 12
+#define DACC_RESOLUTION 12
+#define PWM_RESOLUTION 8
+
+//only the member of the Due PinDescription the LSC code reads
+typedef enum _EAnalogChannel{
+    NO_ADC = -1,
+    ADC0 = 0, ADC1, ADC2, ADC3, ADC4, ADC5, ADC6, ADC7, ADC8, ADC9, ADC10, ADC11, ADC12, ADC13, ADC14, ADC15,
+    DA0, DA1
+} EAnalogChannel;
+
+typedef struct _PinDescription{
+    EAnalogChannel ulADCChannelNumber;
+} PinDescription;
+
+extern const PinDescription g_APinDescription[];
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+uint32_t analogRead(uint32_t pin);
+void analogWrite(uint32_t pin, uint32_t value);
+void analogReadResolution(int resolution);
+void analogWriteResolution(int resolution);
+void attachInterrupt(uint32_t pin, void (*callback)(), uint32_t mode);
+void detachInterrupt(uint32_t pin);
+#define noInterrupts() __disable_irq()
+#define interrupts() __enable_irq()
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long value, long fromLow, long fromHigh, long toLow, long toHigh);
+
+//itoa.h of the Due core
+char* itoa(int value, char* string, int radix);
+char* ltoa(long value, char* string, int radix);
+char* utoa(unsigned int value, char* string, int radix);
+char* ultoa(unsigned long value, char* string, int radix);
+
+#ifdef __cplusplus
+//the min/max macros of the Due core break the standard headers on the host, the templates do the same for equal types
+#include <algorithm>
+using std::min;
+using std::max;
+#define constrain(amount, low, high) ((amount) < (low) ? (low) : ((amount) > (high) ? (high) : (amount)))
+
+#include "WString.h"
+#include "HardwareSerial.h"
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+/*
+    Host stand-in for the UART of the Arduino Due core. Serial behaves like UARTClass: write() queues into a 128 byte
+    transmit buffer that is drained at the baud rate in simulated time and blocks while the buffer is full. What has
+    been transmitted can be inspected with Simulation::getSerialOutput().
+*/
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Stream.h"
+
+class HardwareSerial : public Stream{
+    public:
+        static const int bufferSize = 128;
+
+        void begin(unsigned long baudRate);
+        void end();
+        int available() override { return 0; }
+        int read() override { return -1; }
+        int peek() override { return -1; }
+        int availableForWrite() override;
+        void flush() override;
+        size_t write(uint8_t data) override;
+        using Print::write;
+        operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    Host stand-in for Print.h of the Arduino Due core.
+    Copyright (c) 2008 David A. Mellis.  All right reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef Print_h
+#define Print_h
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print{
+    private:
+        int write_error;
+        size_t printNumber(unsigned long, uint8_t);
+        size_t printFloat(double, uint8_t);
+    protected:
+        void setWriteError(int err = 1) { write_error = err; }
+    public:
+        Print() : write_error(0) {}
+        virtual ~Print() {}
+
+        int getWriteError() { return write_error; }
+        void clearWriteError() { setWriteError(0); }
+
+        virtual size_t write(uint8_t) = 0;
+        size_t write(const char* str){
+            if(str == NULL) return 0;
+            return write((const uint8_t*)str, strlen(str));
+        }
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* buffer, size_t size){
+            return write((const uint8_t*)buffer, size);
+        }
+        virtual int availableForWrite() { return 0; }
+        virtual void flush() {}
+
+        size_t print(const String&);
+        size_t print(const char[]);
+        size_t print(char);
+        size_t print(unsigned char, int = DEC);
+        size_t print(int, int = DEC);
+        size_t print(unsigned int, int = DEC);
+        size_t print(long, int = DEC);
+        size_t print(unsigned long, int = DEC);
+        size_t print(double, int = 2);
+
+        size_t println(const String& s);
+        size_t println(const char[]);
+        size_t println(char);
+        size_t println(unsigned char, int = DEC);
+        size_t println(int, int = DEC);
+        size_t println(unsigned int, int = DEC);
+        size_t println(long, int = DEC);
+        size_t println(unsigned long, int = DEC);
+        size_t println(double, int = 2);
+        size_t println(void);
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+    Host stand-in for the SPI library of the Arduino Due core. Every transferred byte goes to the simulated device
+    whose chip select is low, see SPI BUS in LscSimulation.h.
+*/
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include "Arduino.h"
+
+#define SPI_HAS_TRANSACTION 1
+
+#define SPI_MODE0 0x02
+#define SPI_MODE1 0x00
+#define SPI_MODE2 0x03
+#define SPI_MODE3 0x01
+
+#define SPI_CLOCK_DIV2   11
+#define SPI_CLOCK_DIV4   21
+#define SPI_CLOCK_DIV8   42
+#define SPI_CLOCK_DIV16  84
+#define SPI_CLOCK_DIV32  168
+#define SPI_CLOCK_DIV64  255
+#define SPI_CLOCK_DIV128 255
+
+class SPISettings{
+    public:
+        SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+        SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    private:
+        uint32_t clock;
+        uint8_t bitOrder;
+        uint8_t dataMode;
+        friend class SPIClass;
+};
+
+class SPIClass{
+    public:
+        void begin();
+        void end();
+        void usingInterrupt(uint8_t interruptNumber) { (void)interruptNumber; }
+        void beginTransaction(SPISettings settings);
+        void endTransaction();
+        uint8_t transfer(uint8_t data);
+        uint16_t transfer16(uint16_t data);
+        void transfer(void* buffer, size_t count);
+        void setBitOrder(uint8_t bitOrder) { (void)bitOrder; }
+        void setDataMode(uint8_t dataMode) { (void)dataMode; }
+        void setClockDivider(uint8_t divider);
+};
+
+extern SPIClass SPI;
+
+#endif
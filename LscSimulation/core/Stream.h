@@ -0,0 +1,24 @@
+/*
+    Host stand-in for Stream.h of the Arduino Due core. Reading is not simulated, a Stream never has data available.
+*/
+
+#ifndef Stream_h
+#define Stream_h
+
+#include "Print.h"
+
+class Stream : public Print{
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        bool find(char target) { return find(&target, 1); }
+        bool find(const char* target, size_t length){
+            (void)target;
+            (void)length;
+            return false;
+        }
+};
+
+#endif
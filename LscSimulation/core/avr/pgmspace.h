@@ -0,0 +1,28 @@
+/*
+    Host stand-in for avr/pgmspace.h of the Arduino Due core. The Due has a flat address space, so do we.
+*/
+
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(string) (string)
+#define F(string) (string)
+
+#define pgm_read_byte(address) (*(const unsigned char*)(address))
+#define pgm_read_word(address) (*(const unsigned short*)(address))
+#define pgm_read_dword(address) (*(const unsigned long*)(address)) //as on the Due, wide enough for the pointers in font tables
+#define pgm_read_float(address) (*(const float*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define pgm_read_byte_near(address) pgm_read_byte(address)
+#define pgm_read_word_near(address) pgm_read_word(address)
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcmp_P strcmp
+
+#endif
@@ -0,0 +1,314 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+/*
+    Host stand-in for the SAM3X8E device header and the parts of CMSIS/libsam the LSC code uses.
+    Register layouts and bit positions follow the SAM3X datasheet. The peripherals are plain memory, the simulation
+    (see LscSimulation.h) reads them whenever it has to decide what the hardware does next.
+    Deviation: the PDC pointer registers are uintptr_t wide, such that they can hold host pointers.
+*/
+
+#ifndef SAM_H
+#define SAM_H
+
+#include <stdint.h>
+
+#define VARIANT_MCK 84000000UL
+#define F_CPU VARIANT_MCK
+
+typedef volatile uint32_t RoReg;
+typedef volatile uint32_t WoReg;
+typedef volatile uint32_t RwReg;
+
+typedef enum IRQn{
+    NonMaskableInt_IRQn   = -14,
+    MemoryManagement_IRQn = -12,
+    BusFault_IRQn         = -11,
+    UsageFault_IRQn       = -10,
+    SVCall_IRQn           = -5,
+    DebugMonitor_IRQn     = -4,
+    PendSV_IRQn           = -2,
+    SysTick_IRQn          = -1,
+    SUPC_IRQn   =  0,
+    RSTC_IRQn   =  1,
+    RTC_IRQn    =  2,
+    RTT_IRQn    =  3,
+    WDT_IRQn    =  4,
+    PMC_IRQn    =  5,
+    EFC0_IRQn   =  6,
+    EFC1_IRQn   =  7,
+    UART_IRQn   =  8,
+    SMC_IRQn    =  9,
+    PIOA_IRQn   = 11,
+    PIOB_IRQn   = 12,
+    PIOC_IRQn   = 13,
+    PIOD_IRQn   = 14,
+    USART0_IRQn = 17,
+    USART1_IRQn = 18,
+    USART2_IRQn = 19,
+    USART3_IRQn = 20,
+    HSMCI_IRQn  = 21,
+    TWI0_IRQn   = 22,
+    TWI1_IRQn   = 23,
+    SPI0_IRQn   = 24,
+    SSC_IRQn    = 26,
+    TC0_IRQn    = 27,
+    TC1_IRQn    = 28,
+    TC2_IRQn    = 29,
+    TC3_IRQn    = 30,
+    TC4_IRQn    = 31,
+    TC5_IRQn    = 32,
+    TC6_IRQn    = 33,
+    TC7_IRQn    = 34,
+    TC8_IRQn    = 35,
+    PWM_IRQn    = 36,
+    ADC_IRQn    = 37,
+    DACC_IRQn   = 38,
+    DMAC_IRQn   = 39,
+    UOTGHS_IRQn = 40,
+    TRNG_IRQn   = 41,
+    EMAC_IRQn   = 42,
+    CAN0_IRQn   = 43,
+    CAN1_IRQn   = 44,
+    PERIPH_COUNT_IRQn = 45
+} IRQn_Type;
+
+#define ID_TC0  27
+#define ID_TC1  28
+#define ID_TC2  29
+#define ID_TC3  30
+#define ID_TC4  31
+#define ID_TC5  32
+#define ID_ADC  37
+
+//---- TC ----
+typedef struct {
+    WoReg TC_CCR;
+    RwReg TC_CMR;
+    RwReg TC_SMMR;
+    RoReg Reserved1[1];
+    RwReg TC_CV;
+    RwReg TC_RA;
+    RwReg TC_RB;
+    RwReg TC_RC;
+    RoReg TC_SR;
+    WoReg TC_IER;
+    WoReg TC_IDR;
+    RoReg TC_IMR;
+    RoReg Reserved2[4];
+} TcChannel;
+
+typedef struct {
+    TcChannel TC_CHANNEL[3];
+    WoReg TC_BCR;
+    RwReg TC_BMR;
+    WoReg TC_QIER;
+    WoReg TC_QIDR;
+    RoReg TC_QIMR;
+    RoReg TC_QISR;
+    RwReg TC_FMR;
+    RoReg Reserved1[2];
+    RwReg TC_WPMR;
+} Tc;
+
+#define TC_CCR_CLKEN  (0x1u << 0)
+#define TC_CCR_CLKDIS (0x1u << 1)
+#define TC_CCR_SWTRG  (0x1u << 2)
+#define TC_CMR_TCCLKS_Msk (0x7u << 0)
+#define TC_CMR_TCCLKS_TIMER_CLOCK1 (0x0u << 0) //MCK/2
+#define TC_CMR_TCCLKS_TIMER_CLOCK2 (0x1u << 0) //MCK/8
+#define TC_CMR_TCCLKS_TIMER_CLOCK3 (0x2u << 0) //MCK/32
+#define TC_CMR_TCCLKS_TIMER_CLOCK4 (0x3u << 0) //MCK/128
+#define TC_CMR_TCCLKS_TIMER_CLOCK5 (0x4u << 0) //SLCK
+#define TC_CMR_WAVSEL_Msk       (0x3u << 13)
+#define TC_CMR_WAVSEL_UP        (0x0u << 13)
+#define TC_CMR_WAVSEL_UPDOWN    (0x1u << 13)
+#define TC_CMR_WAVSEL_UP_RC     (0x2u << 13)
+#define TC_CMR_WAVSEL_UPDOWN_RC (0x3u << 13)
+#define TC_CMR_WAVE (0x1u << 15)
+#define TC_IER_COVFS (0x1u << 0)
+#define TC_IER_CPAS  (0x1u << 2)
+#define TC_IER_CPBS  (0x1u << 3)
+#define TC_IER_CPCS  (0x1u << 4)
+#define TC_IDR_CPCS  (0x1u << 4)
+#define TC_SR_CPCS   (0x1u << 4)
+#define TC_SR_CLKSTA (0x1u << 16)
+
+//---- ADC ----
+typedef struct {
+    WoReg ADC_CR;
+    RwReg ADC_MR;
+    RwReg ADC_SEQR1;
+    RwReg ADC_SEQR2;
+    WoReg ADC_CHER;
+    WoReg ADC_CHDR;
+    RoReg ADC_CHSR;
+    RoReg Reserved1[1];
+    RoReg ADC_LCDR;
+    WoReg ADC_IER;
+    WoReg ADC_IDR;
+    RoReg ADC_IMR;
+    RoReg ADC_ISR;
+    RoReg Reserved2[2];
+    RoReg ADC_OVER;
+    RwReg ADC_EMR;
+    RwReg ADC_CWR;
+    RwReg ADC_CGR;
+    RwReg ADC_COR;
+    RoReg ADC_CDR[16];
+    RoReg Reserved3[1];
+    RwReg ADC_ACR;
+    RoReg Reserved4[19];
+    RwReg ADC_WPMR;
+    RoReg ADC_WPSR;
+    volatile uintptr_t ADC_RPR;
+    RwReg ADC_RCR;
+    volatile uintptr_t ADC_RNPR;
+    RwReg ADC_RNCR;
+    WoReg ADC_PTCR;
+    RoReg ADC_PTSR;
+} Adc;
+
+#define ADC_CR_SWRST (0x1u << 0)
+#define ADC_CR_START (0x1u << 1)
+#define ADC_MR_LOWRES  (0x1u << 4)
+#define ADC_MR_SLEEP   (0x1u << 5)
+#define ADC_MR_FREERUN_ON (0x1u << 7)
+#define ADC_MR_PRESCAL_Pos 8
+#define ADC_MR_PRESCAL_Msk (0xffu << ADC_MR_PRESCAL_Pos)
+#define ADC_MR_PRESCAL(value) ((ADC_MR_PRESCAL_Msk & ((value) << ADC_MR_PRESCAL_Pos)))
+#define ADC_MR_STARTUP_Pos 16
+#define ADC_MR_STARTUP_Msk (0xfu << ADC_MR_STARTUP_Pos)
+#define ADC_MR_STARTUP_SUT0   (0x0u << 16)
+#define ADC_MR_STARTUP_SUT8   (0x1u << 16)
+#define ADC_MR_STARTUP_SUT16  (0x2u << 16)
+#define ADC_MR_STARTUP_SUT24  (0x3u << 16)
+#define ADC_MR_STARTUP_SUT64  (0x4u << 16)
+#define ADC_MR_STARTUP_SUT80  (0x5u << 16)
+#define ADC_MR_STARTUP_SUT96  (0x6u << 16)
+#define ADC_MR_STARTUP_SUT112 (0x7u << 16)
+#define ADC_MR_STARTUP_SUT512 (0x8u << 16)
+#define ADC_MR_SETTLING_Pos 20
+#define ADC_MR_SETTLING_Msk (0x3u << ADC_MR_SETTLING_Pos)
+#define ADC_MR_SETTLING_AST3  (0x0u << 20)
+#define ADC_MR_SETTLING_AST5  (0x1u << 20)
+#define ADC_MR_SETTLING_AST9  (0x2u << 20)
+#define ADC_MR_SETTLING_AST17 (0x3u << 20)
+#define ADC_MR_TRACKTIM_Pos 24
+#define ADC_MR_TRACKTIM_Msk (0xfu << ADC_MR_TRACKTIM_Pos)
+#define ADC_MR_TRACKTIM(value) ((ADC_MR_TRACKTIM_Msk & ((value) << ADC_MR_TRACKTIM_Pos)))
+#define ADC_MR_TRANSFER_Pos 28
+#define ADC_MR_TRANSFER_Msk (0x3u << ADC_MR_TRANSFER_Pos)
+#define ADC_MR_TRANSFER(value) ((ADC_MR_TRANSFER_Msk & ((value) << ADC_MR_TRANSFER_Pos)))
+#define ADC_EMR_TAG (0x1u << 24)
+#define ADC_LCDR_LDATA_Msk (0xfffu << 0)
+#define ADC_LCDR_CHNB_Pos 12
+#define ADC_LCDR_CHNB_Msk (0xfu << ADC_LCDR_CHNB_Pos)
+#define ADC_IER_DRDY   (0x1u << 24)
+#define ADC_IER_ENDRX  (0x1u << 27)
+#define ADC_IER_RXBUFF (0x1u << 28)
+#define ADC_IDR_ENDRX  (0x1u << 27)
+#define ADC_ISR_DRDY   (0x1u << 24)
+#define ADC_ISR_ENDRX  (0x1u << 27)
+#define ADC_ISR_RXBUFF (0x1u << 28)
+#define ADC_PTCR_RXTEN  (0x1u << 0)
+#define ADC_PTCR_RXTDIS (0x1u << 1)
+
+//---- SUPC ----
+typedef struct {
+    WoReg SUPC_CR;
+    RwReg SUPC_SMMR;
+    RwReg SUPC_MR;
+    RwReg SUPC_WUMR;
+    RwReg SUPC_WUIR;
+    RoReg SUPC_SR;
+} Supc;
+
+#define SUPC_SMMR_SMTH_Pos 0
+#define SUPC_SMMR_SMTH_Msk (0xfu << SUPC_SMMR_SMTH_Pos)
+#define SUPC_SMMR_SMSMPL_Msk     (0x7u << 8)
+#define SUPC_SMMR_SMSMPL_SMD     (0x0u << 8)
+#define SUPC_SMMR_SMSMPL_CSM     (0x1u << 8)
+#define SUPC_SMMR_SMSMPL_32SLCK  (0x2u << 8)
+#define SUPC_SMMR_SMRSTEN (0x1u << 12)
+#define SUPC_SMMR_SMIEN   (0x1u << 13)
+#define SUPC_SR_SMS       (0x1u << 5)
+
+extern Tc* const TC0;
+extern Tc* const TC1;
+extern Tc* const TC2;
+extern Adc* const ADC;
+extern Supc* const SUPC;
+
+//---- libsam ----
+void TC_Configure(Tc* tc, uint32_t channel, uint32_t mode);
+void TC_Start(Tc* tc, uint32_t channel);
+void TC_Stop(Tc* tc, uint32_t channel);
+void TC_SetRA(Tc* tc, uint32_t channel, uint32_t value);
+void TC_SetRB(Tc* tc, uint32_t channel, uint32_t value);
+void TC_SetRC(Tc* tc, uint32_t channel, uint32_t value);
+uint32_t TC_ReadCV(Tc* tc, uint32_t channel);
+uint32_t TC_GetStatus(Tc* tc, uint32_t channel);
+void pmc_set_writeprotect(uint32_t enable);
+uint32_t pmc_enable_periph_clk(uint32_t id);
+uint32_t pmc_disable_periph_clk(uint32_t id);
+
+//---- CMSIS ----
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t NVIC_GetActive(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+[[noreturn]] void NVIC_SystemReset();
+void __enable_irq();
+void __disable_irq();
+uint32_t __get_PRIMASK();
+void __set_PRIMASK(uint32_t priMask);
+uint32_t __get_IPSR();
+void __bkpt_simulated(uint32_t value);
+#define __BKPT(value) __bkpt_simulated(value)
+#define __NOP() __asm__ volatile("nop")
+#define __DSB() __asm__ volatile("" ::: "memory")
+#define __ISB() __asm__ volatile("" ::: "memory")
+#define __DMB() __asm__ volatile("" ::: "memory")
+
+//---- exception handlers provided by the application ----
+extern "C" {
+    void SUPC_Handler();
+    void PIOA_Handler();
+    void PIOB_Handler();
+    void PIOC_Handler();
+    void PIOD_Handler();
+    void TC0_Handler();
+    void TC1_Handler();
+    void TC2_Handler();
+    void TC3_Handler();
+    void TC4_Handler();
+    void TC5_Handler();
+    void TC6_Handler();
+    void TC7_Handler();
+    void TC8_Handler();
+    void ADC_Handler();
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the ADC configuration, the sample rate and the block averages of the AdcSampler
+
+#include "LscSimulation.h"
+#include "LscHardwareAbstraction.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+static const uint32_t analogPins[AdcSampler::numberOfChannels] = {A0, A1, A2, A3, A4, A5, A6, A7};
+
+//a constant level of 2000 with +-64 counts of noise that alternates from one conversion of the channel to the next
+static uint16_t noisyInput(uint64_t time_ns){
+    return (time_ns * AdcSampler::sampleRate_Hz / 1000000000ULL) % 2 ? 2064 : 1936;
+}
+
+int main(){
+    for(uint8_t i = 0; i < AdcSampler::numberOfChannels; i++){
+        setAnalogInput(analogPins[i], 100 * (i + 1));
+    }
+    ADC_SAMPLER.begin();
+
+    //the ADC clock has to stay within 1MHz to 20MHz
+    uint32_t prescal = (ADC->ADC_MR & ADC_MR_PRESCAL_Msk) >> ADC_MR_PRESCAL_Pos;
+    uint32_t adcClock = VARIANT_MCK / ((prescal + 1) * 2);
+    CHECK(adcClock >= 1000000 && adcClock <= 20000000);
+    CHECK(getAdcConversionTime_ns() == 1000000000ULL / (AdcSampler::sampleRate_Hz * AdcSampler::numberOfChannels));
+
+    //every channel gets sampleRate_Hz conversions per second, one ADC interrupt per full dma buffer
+    advance_ms(100);
+    uint64_t conversions = getAdcConversionCount();
+    uint32_t buffers = ADC_SAMPLER.getNumberOfProcessedBuffers();
+    advance_ms(1000);
+    CHECK_NEAR(getAdcConversionCount() - conversions, AdcSampler::sampleRate_Hz * AdcSampler::numberOfChannels, 1);
+    CHECK_NEAR(ADC_SAMPLER.getNumberOfProcessedBuffers() - buffers, AdcSampler::sampleRate_Hz * AdcSampler::numberOfChannels / AdcSampler::bufferSize, 1);
+    CHECK(getLostInterruptCount(ADC_IRQn) == 0);
+
+    //the channel tags sort every sample into its own channel
+    for(uint8_t i = 0; i < AdcSampler::numberOfChannels; i++){
+        uint8_t channel = AdcSampler::getChannel(analogPins[i]);
+        CHECK(ADC_SAMPLER.getLatest(channel) == 100 * (i + 1));
+        CHECK(ADC_SAMPLER.getAverage(channel) == 100 * (i + 1));
+    }
+
+    //a step reaches the average after blocksPerChannel blocks, the latest block right away
+    uint8_t channel = AdcSampler::getChannel(A0);
+    uint64_t window_ns = 1000000000ULL * AdcSampler::samplesPerBlock * AdcSampler::blocksPerChannel / AdcSampler::sampleRate_Hz;
+    setAnalogInput(A0, 3000);
+    advance_ns(window_ns / 2);
+    CHECK(ADC_SAMPLER.getLatest(channel) == 3000);
+    CHECK(ADC_SAMPLER.getAverage(channel) > 100 && ADC_SAMPLER.getAverage(channel) < 3000);
+    advance_ns(window_ns / 2 + 2 * window_ns / AdcSampler::blocksPerChannel);
+    CHECK(ADC_SAMPLER.getAverage(channel) == 3000);
+
+    //the noise averages out within a block
+    setAnalogInput(A0, noisyInput);
+    advance_ns(window_ns + 2 * window_ns / AdcSampler::blocksPerChannel);
+    CHECK_NEAR(ADC_SAMPLER.getLatest(channel), 2000, 4);
+    CHECK_NEAR(ADC_SAMPLER.getAverage(channel), 2000, 1);
+
+    //reading an input costs no time and does not touch the ADC
+    AnalogIn input(A1);
+    uint64_t start = getTime_ns();
+    conversions = getAdcConversionCount();
+    CHECK_NEAR(input.getVoltage(), 10.0 * 200 / 4096, 0.001);
+    CHECK(getTime_ns() == start && getAdcConversionCount() == conversions);
+
+    //processBuffer() works on recorded data without hardware
+    uint16_t recorded[AdcSampler::bufferSize];
+    for(uint16_t i = 0; i < AdcSampler::bufferSize; i++){
+        uint16_t recordedChannel = i % AdcSampler::numberOfChannels;
+        recorded[i] = (recordedChannel << 12) | (recordedChannel == 7 ? 4000 + (i / AdcSampler::numberOfChannels) % 2 : 10);
+    }
+    NVIC_DisableIRQ(ADC_IRQn);
+    ADC_SAMPLER.processBuffer(recorded, AdcSampler::bufferSize);
+    CHECK(ADC_SAMPLER.getLatest(7) == 4000.5);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    printf("ADC clock %u Hz, %u S/s per channel, %u ADC interrupts/s\n", adcClock, (unsigned)AdcSampler::sampleRate_Hz,
+           (unsigned)(AdcSampler::sampleRate_Hz * AdcSampler::numberOfChannels / AdcSampler::bufferSize));
+    return Check::result();
+}
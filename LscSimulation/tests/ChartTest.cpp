@@ -0,0 +1,215 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the pixels of a logarithmic pressure Chart (samples, grid lines, cursor column, out of range values), that the
+//chart drawn sample by sample looks like a full redraw after it wrapped around, that samples from a RingBuf and from the
+//history of a Persistent draw the same and that a Plot stays inside its area. Measures the pixels, windows, SPI bytes and
+//time of a sample against a redraw
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "LscSceneManager.h"
+#include "Check.h"
+#include "Screen.h"
+
+using namespace Simulation;
+using UI = SceneManager::UI_elements;
+
+constexpr uint16_t chartX = 20;
+constexpr uint16_t chartY = 10;
+constexpr uint16_t chartWidth = 202;
+constexpr uint16_t chartHeight = 102;
+constexpr uint16_t numberOfColumns = chartWidth - 2;
+//the chart of the other source is drawn this far below
+constexpr int16_t referenceOffset = 115;
+constexpr double pressureMin = 1e-9;
+constexpr double pressureMax = 1e-3;
+
+Persistent<double> pressure("PRESSURE", 0);
+
+static void scene(){}
+
+//a pump down from 1E-3 mbar with a bit of noise
+static double pressureOf(uint32_t sample){
+    return pressureMax * pow(10, -6.0 * (sample % 400) / 400) * (1 + 0.2 * ((sample * 37) % 11) / 11);
+}
+
+//the row inside the frame of a sample of the log chart, computed like the chart should
+static int16_t expectedRow(double value){
+    int16_t lastRow = chartHeight - 3;
+    double position = (log10(value) - log10(pressureMin)) / (log10(pressureMax) - log10(pressureMin));
+    if(position < 0) position = 0;
+    if(position > 1) position = 1;
+    return lastRow - (int16_t)(position * lastRow + 0.5);
+}
+
+static uint16_t pixelInChart(uint16_t column, int16_t row){
+    return Display::getPixel(chartX + 1 + column, chartY + 1 + row);
+}
+
+//the pixels in the rows of the chart that differ from the rows referenceOffset below
+static uint32_t differences(){
+    uint32_t count = 0;
+    for(int16_t y = chartY; y < chartY + chartHeight; y++){
+        for(uint16_t x = 0; x < Display::width; x++) count += Display::getPixel(x, y) != Display::getPixel(x, y + referenceOffset);
+    }
+    return count;
+}
+
+static UI::Chart* newChart(int16_t offset = 0){
+    return new UI::Chart(chartX, chartY + offset, chartWidth, chartHeight, pressureMin, pressureMax, true, TFT_WHITE,
+                         TFT_DARKGREY, TFT_BLACK);
+}
+
+static void testPixels(){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    UI::Chart* chart = newChart();
+    CHECK(chart->getNumberOfColumns() == numberOfColumns);
+    //a grid line per decade
+    CHECK(chart->getNumberOfGridLines() == 7);
+    constexpr uint32_t numberOfSamples = 150;
+    for(uint32_t sample = 0; sample < numberOfSamples; sample++){
+        if(sample == 100) chart->addSample(NAN);
+        else if(sample == 120) chart->addSample(1e-12);
+        else chart->addSample(pressureOf(sample));
+    }
+    bool samplesDrawn = true;
+    for(uint32_t sample = 0; sample < numberOfSamples; sample++){
+        if(sample == 100) continue;
+        double value = sample == 120 ? 1e-12 : pressureOf(sample);
+        samplesDrawn &= pixelInChart(sample, expectedRow(value)) == TFT_WHITE;
+    }
+    CHECK(samplesDrawn);
+    //below the range at the bottom row, no sample at all for NAN
+    CHECK(expectedRow(1e-12) == chartHeight - 3);
+    CHECK(Display::countPixels(chartX + 1 + 100, chartY + 1, 1, chartHeight - 2, TFT_WHITE) == 0);
+    //the cursor column is empty, the columns behind it only show the grid
+    CHECK(Display::countPixels(chartX + 1 + numberOfSamples, chartY + 1, 1, chartHeight - 2, TFT_WHITE) == 0);
+    for(uint16_t line = 0; line < chart->getNumberOfGridLines(); line++){
+        CHECK(chart->getGridY(line) == chartY + 1 + expectedRow(chart->getGridValue(line)));
+        CHECK(Display::getPixel(chartX + 1 + numberOfSamples + 10, chart->getGridY(line)) == TFT_DARKGREY);
+    }
+    CHECK(Display::getPixel(chartX + 1 + numberOfSamples + 10, chartY + 1 + 5) == TFT_BLACK);
+    //the frame
+    CHECK(Display::countPixels(chartX, chartY, chartWidth, 1, TFT_WHITE) == chartWidth);
+    CHECK(Display::countPixels(chartX + chartWidth - 1, chartY, 1, chartHeight, TFT_WHITE) == chartHeight);
+    delete chart;
+    SceneManager::repaintDamage();
+    CHECK(Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK) == Screen::fullScreen);
+}
+
+//samples drawn one by one for several sweeps against redrawing the whole chart
+static void testScrolling(){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    UI::Chart* chart = newChart();
+    constexpr uint32_t numberOfSamples = 5 * numberOfColumns + 17;
+    Screen::Traffic traffic;
+    traffic.start();
+    uint64_t start_ns = getTime_ns();
+    uint64_t hostStart_ns = Check::hostTime_ns();
+    for(uint32_t sample = 0; sample < numberOfSamples; sample++) chart->addSample(pressureOf(sample));
+    double hostTime_us = (Check::hostTime_ns() - hostStart_ns) / 1e3 / numberOfSamples;
+    double time_us = (getTime_ns() - start_ns) / 1e3 / numberOfSamples;
+    uint64_t pixels = traffic.getPixels();
+    uint64_t windows = traffic.getWindows();
+    uint64_t busBytes = traffic.getBusBytes();
+    printf("%-12s %7.1f pixels, %5.2f windows, %7.1f SPI bytes, %7.1f us transfer, %5.2f us host time\n", "per sample",
+           (double)pixels / numberOfSamples, (double)windows / numberOfSamples, (double)busBytes / numberOfSamples, time_us,
+           hostTime_us);
+    //the new column and the empty one at the cursor
+    CHECK(pixels == 2ull * (chartHeight - 2) * numberOfSamples);
+    CHECK(windows == 2ull * numberOfSamples);
+
+    Screen::Snapshot* screen = new Screen::Snapshot();
+    screen->take();
+    traffic.start();
+    start_ns = getTime_ns();
+    chart->reDraw();
+    time_us = (getTime_ns() - start_ns) / 1e3;
+    printf("%-12s %7llu pixels, %5llu windows, %7llu SPI bytes, %7.1f us transfer\n", "redraw",
+           (unsigned long long)traffic.getPixels(), (unsigned long long)traffic.getWindows(),
+           (unsigned long long)traffic.getBusBytes(), time_us);
+    CHECK(screen->differences() == 0);
+    CHECK(traffic.getPixels() > 50 * pixels / numberOfSamples);
+    delete screen;
+    delete chart;
+}
+
+//the same samples through addSample(), a RingBuf and the history of a Persistent
+static void testSources(){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    constexpr uint32_t numberOfSamples = numberOfColumns + 60;
+    UI::Chart* single = newChart();
+    UI::Chart* buffered = newChart(referenceOffset);
+    RingBuf<double, 16> buffer;
+    for(uint32_t sample = 0; sample < numberOfSamples; sample++){
+        single->addSample(pressureOf(sample));
+        buffer.push(pressureOf(sample));
+        if(buffer.isFull()) buffered->addSamples(buffer);
+    }
+    CHECK(buffered->addSamples(buffer) == numberOfSamples % 16);
+    CHECK(differences() == 0);
+    delete buffered;
+
+    //more entries than columns, only the last ones are drawn. A new chart shows the last columns of the history
+    for(uint32_t sample = 0; sample < numberOfSamples; sample++) pressure = pressureOf(sample);
+    PersistentTracker::getInstance().commit();
+    size_t first = pressure.getNumbersOfEntries() - numberOfSamples;
+    delete single;
+    single = newChart();
+    for(uint32_t sample = numberOfSamples - numberOfColumns; sample < numberOfSamples; sample++) single->addSample(pressureOf(sample));
+    UI::Chart* history = newChart(referenceOffset);
+    Screen::Traffic traffic;
+    traffic.start();
+    CHECK(history->addHistory(pressure, first, numberOfSamples) == numberOfColumns);
+    //every column once
+    CHECK(traffic.getWindows() == numberOfColumns);
+    CHECK(differences() == 0);
+    delete single;
+    delete history;
+}
+
+//the title, the labels and the chart stay inside the area of the Plot and are removed with it
+static void testPlot(){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    constexpr uint16_t plotHeight = 120;
+    SceneManager::Plot* plot = new SceneManager::Plot("Pressure", 0, 0, Display::width, plotHeight, pressureMin, pressureMax, true);
+    for(uint32_t sample = 0; sample < plot->getNumberOfColumns(); sample++) plot->addSample(pressureOf(sample));
+    CHECK(Display::countPixels(0, plotHeight, Display::width, Display::height - plotHeight, TFT_BLACK) ==
+          (uint32_t)Display::width * (Display::height - plotHeight));
+    //a label left of the chart
+    CHECK(Display::countPixels(0, 20, 20, plotHeight - 20, TFT_BLACK) < 20u * (plotHeight - 20));
+    delete plot;
+    SceneManager::repaintDamage();
+    CHECK(Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK) == Screen::fullScreen);
+}
+
+int main(){
+    SdCard::insert(262144);
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    pressure.setMinIntervall(0);
+    SceneManager::getInstance().init(scene);
+    testPixels();
+    testScrolling();
+    testSources();
+    testPlot();
+    return Check::result();
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Minimal test helpers. Every test is an executable that returns Check::result() from main(), ctest runs them all.
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+
+namespace Check{
+    inline int& failures(){
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(bool condition, const char* expression, const char* file, int line){
+        if(condition) return true;
+        failures()++;
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+        return false;
+    }
+
+    inline bool checkNear(double value, double expected, double tolerance, const char* expression, const char* file, int line){
+        if(fabs(value - expected) <= tolerance) return true;
+        failures()++;
+        fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s = %.9g, expected %.9g +- %.9g\n", file, line, expression, value, expected, tolerance);
+        return false;
+    }
+
+    inline int result(){
+        if(failures() > 0) fprintf(stderr, "%d check(s) failed\n", failures());
+        return failures() > 0 ? 1 : 0;
+    }
+
+    //Host time for the benchmarks of pure computations, everything that touches hardware is measured in simulated time
+    inline uint64_t hostTime_ns(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+#define CHECK(condition) Check::check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance) Check::checkNear((value), (expected), (tolerance), #value, __FILE__, __LINE__)
+
+#endif
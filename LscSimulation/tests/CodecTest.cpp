@@ -0,0 +1,135 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Writes series of every value coding through the FRAME records of the log, reads them back bit exact and measures the
+//bytes per value against one VALUE record per value
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+#include <math.h>
+#include <limits>
+
+using namespace Simulation;
+
+constexpr uint32_t numberOfValues = 5000;
+
+enum class Mode : uint16_t { IDLE = 0, RUN = 1, SERVICE = 0x8000 };
+struct Pair{
+    int16_t a;
+    int16_t b;
+};
+struct Wide{
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+static uint32_t seed = 1;
+static uint32_t random32(){
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+//the interval between two values, the timestamps are the millis() of the writes
+static uint32_t regular(uint32_t){
+    return 1000;
+}
+static uint32_t jitter(uint32_t){
+    return 900 + random32() % 200;
+}
+static uint32_t bursts(uint32_t i){
+    return i % 50 == 0 ? 60000 : 1 + random32() % 3;
+}
+
+template<typename T>
+static void roundTrip(const char* name, T (*valueAt)(uint32_t), uint32_t (*intervalAt)(uint32_t), double maxBytesPerValue){
+    seed = 1;
+    T* values = new T[numberOfValues];
+    for(uint32_t i = 0; i < numberOfValues; i++) values[i] = valueAt(i);
+    Persistent<T>* persistent = new Persistent<T>(name, values[0]);
+    persistent->setMinIntervall(0);
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    tracker.commit();
+    unsigned long bytes = tracker.getIoStatistics().bytes;
+    for(uint32_t i = 1; i < numberOfValues; i++){
+        advance_ms(intervalAt(i));
+        *persistent = values[i];
+    }
+    tracker.commit();
+    bytes = tracker.getIoStatistics().bytes - bytes;
+
+    bool exact = persistent->getNumbersOfEntries() == numberOfValues;
+    T read[100];
+    for(uint32_t from = 0; from < numberOfValues && exact; from += 100){
+        exact &= persistent->getRange(from, 100, read) == 100;
+        for(uint32_t i = 0; i < 100 && exact; i++) exact &= memcmp(&read[i], &values[from + i], sizeof(T)) == 0;
+    }
+    double bytesPerValue = (double)bytes / (numberOfValues - 1);
+    printf("%-9s %u bytes: %6.2f bytes per value, %5.1f%% of a VALUE record\n", name, (unsigned)sizeof(T), bytesPerValue,
+           bytesPerValue * 100 / (sizeof(LogRecordHeader) + sizeof(T)));
+    if(!exact) fprintf(stderr, "%s is not read back bit exact\n", name);
+    CHECK(exact);
+    CHECK(bytesPerValue <= maxBytesPerValue);
+    delete[] values;
+}
+
+int main(){
+    SdCard::insert(262144);
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    //nothing but the test runs, without the timers and the ADC time passes quickly
+    TC_Stop(TC0, 2);
+    TC_Stop(TC1, 0);
+    TC_Stop(TC1, 2);
+    pmc_disable_periph_clk(ID_ADC);
+    constexpr double valueRecord = sizeof(LogRecordHeader);
+
+    //INTEGER
+    roundTrip<int32_t>("CONSTANT", [](uint32_t){ return (int32_t)42; }, regular, 0.5);
+    roundTrip<uint32_t>("COUNTER", [](uint32_t i){ return i; }, regular, 2);
+    roundTrip<int32_t>("EXTREMES", [](uint32_t i){
+        //the differences wrap around
+        static const int32_t extremes[] = {std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(), 0, -1, 1};
+        return i % 3 == 0 ? extremes[i % 5] : (int32_t)random32();
+    }, jitter, valueRecord + 4);
+    roundTrip<int64_t>("INT64", [](uint32_t i){
+        return i % 7 == 0 ? std::numeric_limits<int64_t>::min() + i : ((int64_t)random32() << 32 | random32());
+    }, jitter, valueRecord + 8);
+    roundTrip<uint8_t>("UINT8", [](uint32_t i){ return (uint8_t)(i * 37); }, bursts, 3);
+    roundTrip<bool>("BOOL", [](uint32_t i){ return (i / 10) % 2 == 0; }, regular, 1);
+    roundTrip<Mode>("ENUM", [](uint32_t i){
+        static const Mode modes[] = {Mode::IDLE, Mode::RUN, Mode::SERVICE};
+        return modes[(i / 20) % 3];
+    }, jitter, 3);
+
+    //BITS
+    roundTrip<float>("PRESSURE", [](uint32_t i){ return 1e-6f * (1.0f + 0.1f * sinf(i * 0.01f)); }, regular, 4);
+    roundTrip<double>("TEMP", [](uint32_t i){ return 21.5 + floor(sin(i * 0.001) * 100) / 10; }, regular, 4);
+    roundTrip<float>("SPECIAL", [](uint32_t i){
+        static const float specials[] = {NAN, INFINITY, -INFINITY, -0.0f, 0.0f, std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max()};
+        return specials[(i * 3) % 7];
+    }, bursts, valueRecord + 4);
+    roundTrip<Pair>("PAIR", [](uint32_t i){ return Pair{(int16_t)(i % 100), (int16_t)-(int32_t)(i % 7)}; }, jitter, valueRecord + 4);
+
+    //RAW
+    roundTrip<Wide>("WIDE", [](uint32_t i){ return Wide{i, ~i, 0}; }, regular, valueRecord + sizeof(Wide) + 1);
+    return Check::result();
+}
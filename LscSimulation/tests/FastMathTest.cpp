@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the accuracy of the FastMath lookup tables against the formulas they replace
+
+#include "LscSimulation.h"
+#include "LscComponents.h"
+#include "Check.h"
+
+//The Pt100 conversion before the table, see AnalogInPt100::update()
+static double pt100Temperature(double adc){
+    double rPt = adc * 3300 / (78720.8 - adc) - 0.5;
+    return 273.15 - 2.429E+02 + 2.279E+00 * rPt + 1.674E-03 * rPt * rPt - 1.815E-06 * rPt * rPt * rPt;
+}
+
+static void testTables(){
+    //the tables hold what the generator formulas in LscHardwareAbstraction.h say
+    for(int i = 0; i <= 256; i++){
+        CHECK_NEAR(FastMath::pow10FractionTable[i], pow(10., i / 256.), 5e-7 * pow(10., i / 256.));
+        CHECK_NEAR(FastMath::pt100TemperatureTable[i], pt100Temperature(i * 16) * 65536, 1);
+    }
+    for(int exponent = FastMath::minPowerOfTen; exponent <= FastMath::maxPowerOfTen; exponent++){
+        CHECK_NEAR(FastMath::powerOfTen(exponent), pow(10., exponent), 1e-15 * pow(10., exponent));
+    }
+}
+
+static void testPow10(){
+    double maxError = 0;
+    for(double x = -12; x <= 6; x += 0.0001){
+        double error = fabs(FastMath::pow10(x) / pow(10., x) - 1);
+        if(error > maxError) maxError = error;
+    }
+    printf("pow10: max relative error %.2e\n", maxError);
+    CHECK(maxError < 5e-5);
+    CHECK(FastMath::pow10(FastMath::minPowerOfTen - 1) == 0);
+    CHECK(FastMath::pow10(-3) == 1e-3);
+
+    //the pressures of all gauges over their whole output range
+    GaugeType types[] = {GaugeType::PKR, GaugeType::TPR, GaugeType::VPM5, GaugeType::BGP400, GaugeType::IKR270, GaugeType::VPMF};
+    double slopes[] = {1.667, 1, 1, 1 / 0.75, 1.25, 1.667};
+    double offsets[] = {-9.33, -3.5, -4.5, -7.75 / 0.75 + 2, -10.75, -9.333};
+    for(int i = 0; i < 6; i++){
+        Gauge gauge(types[i]);
+        for(double voltage = 0; voltage <= 10; voltage += 0.001){
+            double expected = pow(10., slopes[i] * voltage + offsets[i]);
+            CHECK_NEAR(gauge.getPressureFromVoltage(voltage), expected, 5e-5 * expected);
+        }
+    }
+}
+
+static void testPt100(){
+    //every value the AdcSampler can deliver, in 1/16 ADC counts
+    double maxError = 0;
+    for(uint32_t scaled = 0; scaled <= 4095 * 16; scaled++){
+        double temperature = FastMath::interpolateTable(FastMath::pt100TemperatureTable, scaled) / 65536.;
+        double error = fabs(temperature - pt100Temperature(scaled / 16.));
+        if(error > maxError) maxError = error;
+    }
+    printf("pt100: max error %.5f K\n", maxError);
+    CHECK(maxError < 0.001);
+}
+
+static void testExponentOfTen(){
+    for(int exponent = -20; exponent <= 20; exponent++){
+        double power = pow(10., exponent);
+        CHECK(FastMath::exponentOfTen(power) == exponent);
+        CHECK(FastMath::exponentOfTen(power * 0.9999999) == exponent - 1);
+        CHECK(FastMath::exponentOfTen(power * 9.99) == exponent);
+    }
+    CHECK(FastMath::exponentOfTen(0) == 0);
+    CHECK(FastMath::exponentOfTen(-5) == 0);
+}
+
+//Host time per call, it shows the cost of the table relative to pow()
+static void benchmark(){
+    constexpr uint32_t calls = 2000000;
+    volatile double sink = 0;
+    uint64_t start = Check::hostTime_ns();
+    for(uint32_t i = 0; i < calls; i++) sink = sink + FastMath::pow10(-9 + (double)i / calls * 10);
+    uint64_t table = Check::hostTime_ns() - start;
+    start = Check::hostTime_ns();
+    for(uint32_t i = 0; i < calls; i++) sink = sink + pow(10., -9 + (double)i / calls * 10);
+    uint64_t library = Check::hostTime_ns() - start;
+    printf("pow10: %.2f ns/call, pow(): %.2f ns/call\n", (double)table / calls, (double)library / calls);
+}
+
+int main(){
+    testTables();
+    testPow10();
+    testPt100();
+    testExponentOfTen();
+    benchmark();
+    return Check::result();
+}
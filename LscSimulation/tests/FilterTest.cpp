@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the responses of the filter stages and measures their cost per sample
+
+#include "LscSimulation.h"
+#include "LscHardwareAbstraction.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr int32_t lsb = AdcSampler::valueScale;
+
+static void testMovingAverage(){
+    Filters::MovingAverage<8> filter;
+    int32_t out = 0;
+    CHECK(filter.push(100 * lsb, out) && out == 100 * lsb);
+    for(int i = 0; i < 7; i++) filter.push(100 * lsb, out);
+    //a step needs exactly the window to pass through
+    for(int i = 1; i <= 8; i++){
+        filter.push(200 * lsb, out);
+        CHECK(out == 100 * lsb + i * 100 * lsb / 8);
+    }
+    filter.reset();
+    filter.push(50 * lsb, out);
+    CHECK(out == 50 * lsb);
+}
+
+static void testExponentialMovingAverage(){
+    Filters::ExponentialMovingAverage<4> filter;
+    int32_t out = 0;
+    filter.push(1000 * lsb, out);
+    CHECK(out == 1000 * lsb);
+    //the first sample after a step moves the output by 1/16 of the step
+    filter.push(2000 * lsb, out);
+    CHECK(out == 1000 * lsb + 1000 * lsb / 16);
+    //after 16 samples 1 - (15/16)^16 = 64% of the step is reached
+    for(int i = 1; i < 16; i++) filter.push(2000 * lsb, out);
+    CHECK_NEAR(out, 1000 * lsb + 0.644 * 1000 * lsb, 0.01 * 1000 * lsb);
+    //it settles on the input without a rounding offset
+    for(int i = 0; i < 1000; i++) filter.push(2000 * lsb, out);
+    CHECK_NEAR(out, 2000 * lsb, 16);
+}
+
+static void testMedian(){
+    Filters::Median<5> filter;
+    int32_t out = 0;
+    int32_t input[] = {10, 11, 4000, 12, 13, 0, 14, 15};
+    int32_t expected[] = {10, 11, 11, 12, 12, 12, 13, 13};
+    for(int i = 0; i < 8; i++){
+        filter.push(input[i], out);
+        CHECK(out == expected[i]);
+    }
+}
+
+static void testCic(){
+    Filters::CIC<3, 16> filter;
+    int32_t out = 0;
+    uint32_t outputs = 0;
+    for(int i = 0; i < 16 * 10; i++){
+        if(filter.push(3000 * lsb, out)) outputs++;
+    }
+    //one output per 16 inputs, unity gain once the three stages are filled
+    CHECK(outputs == 10);
+    CHECK(out == 3000 * lsb);
+    //the largest input must not overflow the integrators
+    filter.reset();
+    for(int i = 0; i < 16 * 10; i++) filter.push(4095 * lsb, out);
+    CHECK(out == 4095 * lsb);
+    //a tone at the decimation rate is cancelled completely
+    filter.reset();
+    for(int i = 0; i < 16 * 10; i++) filter.push((i % 2 ? 2100 : 1900) * lsb, out);
+    CHECK(out == 2000 * lsb);
+}
+
+static void testPipeline(){
+    FilterPipeline<Filters::Median<3>, Filters::CIC<2, 4>, Filters::MovingAverage<2>> pipeline;
+    int32_t out = 0;
+    uint32_t outputs = 0;
+    for(int i = 0; i < 40; i++){
+        //a spike every 10 samples, the median removes it before it reaches the decimator
+        if(pipeline.push(i % 10 == 5 ? 4000 * lsb : 500 * lsb, out)) outputs++;
+    }
+    CHECK(outputs == 10);
+    CHECK(out == 500 * lsb);
+}
+
+//Counts the samples the AdcSampler feeds into it
+struct CountingFilter : BaseFilter{
+    uint32_t samples = 0;
+    bool push(int32_t in, int32_t& out) override{
+        samples++;
+        out = in;
+        return true;
+    }
+    void reset() override{
+        samples = 0;
+    }
+};
+
+static void testAttached(){
+    AnalogIn input(A2);
+    setAnalogInput(A2, 1000);
+    ADC_SAMPLER.begin();
+    advance_ms(500);
+    CountingFilter counter;
+    input.setFilter(counter);
+    advance_ms(1000);
+    //every single sample of the channel passes the filter
+    CHECK_NEAR(counter.samples, AdcSampler::sampleRate_Hz, AdcSampler::samplesPerBlock);
+    CHECK_NEAR(input.getVoltage(), 10.0 * 1000 / 4096, 0.001);
+
+    FilterPipeline<Filters::Median<5>, Filters::ExponentialMovingAverage<4>> filter;
+    input.setFilter(filter);
+    setAnalogInput(A2, 2000);
+    advance_ms(100);
+    CHECK_NEAR(input.getVoltage(), 10.0 * 2000 / 4096, 0.001);
+    input.removeFilter();
+    CHECK(!ADC_SAMPLER.hasFilter(AdcSampler::getChannel(A2)));
+}
+
+//Host time per sample. It only ranks the stages against each other, the Due at 84MHz takes much longer per sample.
+template<typename Filter>
+static void benchmark(const char* name){
+    constexpr uint32_t samples = 4000000;
+    Filter filter;
+    int32_t out = 0;
+    int64_t sum = 0;
+    uint64_t start = Check::hostTime_ns();
+    for(uint32_t i = 0; i < samples; i++){
+        if(filter.push((2000 + (int32_t)(i * 2654435761u >> 24)) * lsb, out)) sum += out;
+    }
+    uint64_t duration = Check::hostTime_ns() - start;
+    printf("%-28s %6.2f ns/sample (%lld)\n", name, (double)duration / samples, (long long)(sum & 1));
+}
+
+int main(){
+    testMovingAverage();
+    testExponentialMovingAverage();
+    testMedian();
+    testCic();
+    testPipeline();
+    testAttached();
+
+    benchmark<Filters::MovingAverage<32>>("MovingAverage<32>");
+    benchmark<Filters::ExponentialMovingAverage<4>>("ExponentialMovingAverage<4>");
+    benchmark<Filters::Median<5>>("Median<5>");
+    benchmark<Filters::Median<15>>("Median<15>");
+    benchmark<Filters::CIC<3, 16>>("CIC<3, 16>");
+    benchmark<FilterPipeline<Filters::Median<5>, Filters::CIC<3, 16>>>("Median<5> + CIC<3, 16>");
+    return Check::result();
+}
@@ -0,0 +1,154 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the rounding and saturation of Fixed and the fixed point conversions of the analog inputs and outputs
+
+#include "LscSimulation.h"
+#include "LscHardwareAbstraction.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+static void testArithmetic(){
+    CHECK(Q16(1.5).raw == 3 << 15);
+    CHECK(Q16(-2).raw == -2 * 65536);
+    //doubles are rounded to the nearest step, not truncated
+    CHECK(Q16(0.4 / 65536).raw == 0 && Q16(0.6 / 65536).raw == 1 && Q16(-0.6 / 65536).raw == -1);
+    CHECK((Q16(2.5) + Q16(1.25)).toDouble() == 3.75);
+    CHECK((Q16(2.5) - Q16(3)).toDouble() == -0.5);
+    CHECK((Q16(2.5) * Q16(-4)).toDouble() == -10);
+    CHECK((Q16(10) / Q16(4)).toDouble() == 2.5);
+    CHECK(Q16(-1.5).toInt() == -2);
+    CHECK(Q16(1.5).toInt() == 1);
+    CHECK(-Q16(3) == Q16(-3));
+    Q16 value = 1;
+    value += Q16(0.5);
+    value *= 2;
+    value -= 1;
+    value /= 4;
+    CHECK(value == Q16(0.5));
+    CHECK(Q16(1) < Q16(1.0001) && Q16(-1) <= Q16(-1) && Q16(2) > Q16(-2) && Q16(2) != Q16(2.5));
+}
+
+static void testSaturation(){
+    Q16 max = Q16::fromRaw(INT32_MAX);
+    Q16 min = Q16::fromRaw(INT32_MIN);
+    CHECK(Q16(40000).raw == INT32_MAX);
+    CHECK(Q16(-40000.).raw == INT32_MIN);
+    CHECK(max + Q16(1) == max);
+    CHECK(min - Q16(1) == min);
+    CHECK(Q16(20000) * Q16(2) == max);
+    CHECK(Q16(20000) * Q16(-2) == min);
+    CHECK(Q16(1) / Q16(0) == max);
+    CHECK(Q16(-1) / Q16(0) == min);
+    CHECK(Q16(30000) / Q16(0.5) == max);
+    CHECK(-min == max);
+}
+
+static void testToString(){
+    CHECK(Q16(3.14159).toString(2) == "3.14");
+    CHECK(Q16(2.996).toString(2) == "3.00");
+    CHECK(Q16(-0.25).toString(1) == "-0.3");
+    CHECK(Q16(-12).toString(0) == "-12");
+    CHECK(Q16(0).toString(3) == "0.000");
+    CHECK(Q16::fromRaw(INT32_MAX).toString(4) == "32768.0000");
+}
+
+static void testAnalogPath(){
+    ADC_SAMPLER.begin();
+    //full scale of AnalogIn is 10V for 4096 counts
+    AnalogIn input(A0);
+    AnalogInGauge gauge(A1);
+    for(uint16_t adc = 0; adc < 4096; adc += 273){
+        setAnalogInput(A0, adc);
+        setAnalogInput(A1, adc);
+        advance_ms(250);
+        CHECK_NEAR(input.getVoltage(), 10.0 * adc / 4096, 16.0 / 65536);
+        CHECK_NEAR(gauge.getVoltage(), 8.5 * adc / 4096, 16.0 / 65536);
+        CHECK(input.getFixed().raw == (int32_t)(adc * 16 * 10));
+    }
+
+    //without a filter the inputs report the average over all blocks, not the newest block
+    setAnalogInput(A0, 1000);
+    advance_ms(50);
+    CHECK(input.getFixed().raw == (int32_t)(ADC_SAMPLER.getAverage(AdcSampler::getChannel(A0)) * 16 * 10));
+    CHECK(input.getVoltage() > 10.0 * ADC_SAMPLER.getLatest(AdcSampler::getChannel(A0)) / 4096);
+
+    //the isolated output maps 0-10V onto the 12 bit DAC
+    analogWriteResolution(12);
+    AnalogOutIsolated output(DAC0);
+    output = 5.0;
+    CHECK(getAnalogOutput(DAC0) == 2047);
+    output.setVoltage(Q16(10));
+    CHECK(getAnalogOutput(DAC0) == 4095);
+    output -= 2.5;
+    CHECK(getAnalogOutput(DAC0) == 3071);
+    CHECK((double)output == 7.5);
+}
+
+//An output written against the double interface, its override is still called
+struct LegacyOut : AnalogOutIsolated{
+    double lastValue = -1;
+    LegacyOut(uint8_t pin) : AnalogOutIsolated(pin) {}
+    using AnalogOutIsolated::operator=;
+    void setVoltage(double value) override{
+        lastValue = value;
+        AnalogOutIsolated::setVoltage(value);
+    }
+};
+
+static void testDoubleOverride(){
+    LegacyOut output(DAC1);
+    AnalogOutBase& base = output;
+    base.setVoltage(2.5);
+    CHECK(output.lastValue == 2.5);
+    output = 5.0;
+    CHECK(output.lastValue == 5.0);
+    CHECK(getAnalogOutput(DAC1) == 2047);
+}
+
+//Host time per operation. Both are cheap on the host, on the Due the double operations are soft-float library calls.
+static void benchmark(){
+    constexpr uint32_t operations = 4000000;
+    volatile int32_t rawSink = 0;
+    volatile double doubleSink = 0;
+    uint64_t start = Check::hostTime_ns();
+    for(uint32_t i = 1; i <= operations; i++){
+        Q16 value = Q16::fromRaw(i) * Q16(2.44140625e-3) / Q16::fromRaw(rawSink | 0x10000) + Q16(0.5);
+        rawSink = value.raw;
+    }
+    uint64_t fixed = Check::hostTime_ns() - start;
+    start = Check::hostTime_ns();
+    for(uint32_t i = 1; i <= operations; i++){
+        doubleSink = (double)i * 2.44140625e-3 / (doubleSink + 1) + 0.5;
+    }
+    uint64_t floating = Check::hostTime_ns() - start;
+    printf("Q16 multiply, divide, add: %.2f ns, double: %.2f ns\n", (double)fixed / operations, (double)floating / operations);
+}
+
+int main(){
+    testArithmetic();
+    testSaturation();
+    testToString();
+    testAnalogPath();
+    testDoubleOverride();
+    benchmark();
+    return Check::result();
+}
@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the history access of Persistent<T> and measures its SD reads and time per entry
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr uint32_t numberOfValues = 60000;
+Persistent<uint32_t> counter("COUNTER", 0);
+//written in between, such that the records of counter are spread over the blocks
+Persistent<uint32_t> other("OTHER", 0);
+
+struct Measurement{
+    uint64_t start_ns;
+    uint64_t blockReads;
+    unsigned long cacheHits;
+    void start(){
+        start_ns = getTime_ns();
+        blockReads = SdCard::getStatistics().blockReads;
+        cacheHits = PersistentTracker::getInstance().getIoStatistics().cacheHits;
+    }
+    void print(const char* name, uint32_t entries){
+        double reads = SdCard::getStatistics().blockReads - blockReads;
+        double hits = PersistentTracker::getInstance().getIoStatistics().cacheHits - cacheHits;
+        printf("%s: %.2f us, %.4f block reads, %.2f cache hits per entry\n", name, (getTime_ns() - start_ns) / 1e3 / entries, reads / entries, hits / entries);
+    }
+    double getReadsPerEntry(uint32_t entries){
+        return (double)(SdCard::getStatistics().blockReads - blockReads) / entries;
+    }
+};
+
+int main(){
+    SdCard::insert(262144);
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    counter.setMinIntervall(0);
+    other.setMinIntervall(0);
+    for(uint32_t value = 1; value < numberOfValues; value++){
+        counter = value * 7;
+        if(value % 4 == 0) other = value;
+    }
+    PersistentTracker::getInstance().commit();
+    CHECK(counter.getNumbersOfEntries() == numberOfValues);
+
+    //a loop over the history continues the cursor of the last getElement()
+    Measurement measurement;
+    measurement.start();
+    bool correct = true;
+    for(uint32_t i = 0; i < numberOfValues; i++) correct &= counter.getElement(i) == i * 7;
+    CHECK(correct);
+    measurement.print("getElement() in order", numberOfValues);
+    CHECK(measurement.getReadsPerEntry(numberOfValues) < 0.05);
+
+    measurement.start();
+    uint32_t values[500];
+    correct = true;
+    for(uint32_t from = 0; from < numberOfValues; from += 500){
+        CHECK(counter.getRange(from, 500, values) == 500);
+        for(uint32_t i = 0; i < 500; i++) correct &= values[i] == (from + i) * 7;
+    }
+    CHECK(correct);
+    measurement.print("getRange()", numberOfValues);
+
+    //a random entry costs the binary search over the checkpoints and the scan of its window up to the entry
+    constexpr uint32_t randomReads = 2000;
+    uint32_t seed = 1;
+    measurement.start();
+    correct = true;
+    for(uint32_t i = 0; i < randomReads; i++){
+        seed = seed * 1103515245 + 12345;
+        uint32_t index = (seed >> 8) % numberOfValues;
+        correct &= counter.getElement(index) == index * 7;
+    }
+    CHECK(correct);
+    measurement.print("getElement() at random", randomReads);
+    CHECK(measurement.getReadsPerEntry(randomReads) < PersistentTracker::checkpointInterval_blocks + 8);
+
+    //the newest entries are staged and committed before they are read
+    counter = 1;
+    CHECK(counter.getElement(numberOfValues) == 1);
+    CHECK(counter.getElement(numberOfValues + 1) == 1); //out of range returns the value
+    return Check::result();
+}
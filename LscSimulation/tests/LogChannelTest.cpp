@@ -0,0 +1,242 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks that the log channels follow the names of the Persistent<T> across firmware versions and the import of the former files
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+class TestPersistent : public Persistent<uint32_t>{
+    public:
+        TestPersistent(const char* name, uint32_t value) : Persistent<uint32_t>(name, value) {}
+        void set(uint32_t value){
+            Persistent<uint32_t>::operator=(value);
+        }
+        uint16_t getLogChannel(){
+            return channel;
+        }
+};
+
+//Every firmware reports to the test through shared memory, the checks run in the test process
+struct Report{
+    uint32_t values[4];
+    uint32_t entries[4];
+    uint32_t history[4];
+    uint16_t channels[4];
+    bool initComplete;
+    bool fatalError;
+    bool filesLeft;
+    uint64_t programmedBytes;
+    uint64_t blockReads;
+    uint64_t restore_ns;
+};
+static Report* report;
+
+static void boot(){
+    SdCard::resetStatistics();
+    uint64_t start = getTime_ns();
+    noInterrupts(); //no OS tick while the test looks at the persistence
+    OS::init("test");
+    report->restore_ns = getTime_ns() - start;
+    report->initComplete = BasePersistent::initComplete;
+    report->fatalError = false;
+    for(const Error& error : ERROR_HANDLER.getErrors()){
+        if(error.severityLevel == SeverityLevel::FATAL) report->fatalError = true;
+    }
+    report->programmedBytes = SdCard::getStatistics().programmedBytes;
+    report->blockReads = SdCard::getStatistics().blockReads;
+}
+
+static void capture(uint8_t index, TestPersistent& persistent, size_t historyIndex){
+    report->values[index] = persistent;
+    report->entries[index] = persistent.getNumbersOfEntries();
+    report->history[index] = persistent.getElement(historyIndex);
+    report->channels[index] = persistent.getLogChannel();
+}
+
+static void write(TestPersistent& persistent, uint32_t first, uint32_t last){
+    persistent.setMinIntervall(0);
+    for(uint32_t value = first; value <= last; value++) persistent.set(value);
+}
+
+static void testRenumbering(){
+    //the first firmware creates ALPHA and BETA
+    CHECK(runFirmware([](){
+        static TestPersistent alpha("ALPHA", 0);
+        static TestPersistent beta("BETA", 0);
+        boot();
+        write(alpha, 1, 100);
+        write(beta, 1001, 1050);
+        PersistentTracker::getInstance().commit();
+        capture(0, alpha, 0);
+        capture(1, beta, 0);
+        cutPower();
+    }) == Shutdown::PowerCut);
+    uint16_t alphaChannel = report->channels[0];
+    uint16_t betaChannel = report->channels[1];
+    CHECK(alphaChannel == PersistentLog::firstChannel && betaChannel == PersistentLog::firstChannel + 1);
+
+    //the next one registers a new GAMMA first and the others in reverse order, every history stays with its name
+    CHECK(runFirmware([](){
+        static TestPersistent gamma("GAMMA", 7);
+        static TestPersistent beta("BETA", 0);
+        static TestPersistent alpha("ALPHA", 0);
+        boot();
+        capture(0, alpha, 50);
+        capture(1, beta, 25);
+        write(gamma, 8, 20);
+        PersistentTracker::getInstance().commit();
+        capture(2, gamma, 0);
+        cutPower();
+    }) == Shutdown::PowerCut);
+    CHECK(report->initComplete);
+    CHECK(report->values[0] == 100 && report->entries[0] == 101 && report->history[0] == 50);
+    CHECK(report->values[1] == 1050 && report->entries[1] == 51 && report->history[1] == 1025);
+    CHECK(report->channels[0] == alphaChannel && report->channels[1] == betaChannel);
+    CHECK(report->channels[2] == betaChannel + 1);
+    CHECK(report->values[2] == 20 && report->entries[2] == 14 && report->history[2] == 7);
+    uint16_t gammaChannel = report->channels[2];
+
+    //without BETA its channel stays reserved, DELTA gets a new one
+    CHECK(runFirmware([](){
+        static TestPersistent delta("DELTA", 3);
+        static TestPersistent alpha("ALPHA", 0);
+        static TestPersistent gamma("GAMMA", 0);
+        boot();
+        capture(0, alpha, 100);
+        capture(2, gamma, 13);
+        capture(3, delta, 0);
+    }) == Shutdown::Returned);
+    CHECK(report->values[0] == 100 && report->history[0] == 100 && report->channels[0] == alphaChannel);
+    CHECK(report->values[2] == 20 && report->history[2] == 20 && report->channels[2] == gammaChannel);
+    CHECK(report->values[3] == 3 && report->entries[3] == 1 && report->channels[3] == gammaChannel + 1);
+}
+
+static void testConflict(){
+    //two Persistent with the same name: a FATAL error and the log is not written
+    CHECK(runFirmware([](){
+        static TestPersistent alpha("ALPHA", 0);
+        static TestPersistent copy("ALPHA", 0);
+        boot();
+        alpha.set(5);
+        PersistentTracker::getInstance().commit();
+        report->programmedBytes = SdCard::getStatistics().programmedBytes;
+        capture(0, alpha, 0);
+    }) == Shutdown::Returned);
+    CHECK(!report->initComplete);
+    CHECK(report->fatalError);
+    CHECK(report->programmedBytes == 0);
+    CHECK(report->channels[0] == PersistentLog::checkpointChannel);
+
+    //the next boot without the copy still finds the history of ALPHA
+    CHECK(runFirmware([](){
+        static TestPersistent alpha("ALPHA", 0);
+        boot();
+        capture(0, alpha, 0);
+    }) == Shutdown::Returned);
+    CHECK(report->initComplete && !report->fatalError);
+    CHECK(report->values[0] == 100 && report->entries[0] == 101);
+}
+
+static void testFormerFiles(){
+    //the files of the one file per Persistent format: a full first bank and the second bank that was written last
+    CHECK(runFirmware([](){
+        SD.begin(sdCardChipSelectPin);
+        File first = SD.open("OLDVAL", FILE_WRITE);
+        File second = SD.open("OLDVAL_2", FILE_WRITE);
+        for(uint32_t value = 0; value < 130; value++){
+            File& file = value < 100 ? first : second;
+            file.write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+        }
+        first.close();
+        second.close();
+    }) == Shutdown::Returned);
+    CHECK(runFirmware([](){
+        static TestPersistent old("OLDVAL", 0);
+        boot();
+        capture(0, old, 99);
+        capture(1, old, 100);
+        report->filesLeft = SD.exists("OLDVAL") || SD.exists("OLDVAL_2");
+    }) == Shutdown::Returned);
+    CHECK(report->values[0] == 129 && report->entries[0] == 130);
+    CHECK(report->history[0] == 99 && report->history[1] == 100);
+    CHECK(!report->filesLeft);
+
+    //an existing channel does not import them again
+    CHECK(runFirmware([](){
+        SD.begin(sdCardChipSelectPin);
+        File file = SD.open("OLDVAL", FILE_WRITE);
+        uint32_t value = 1000;
+        file.write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+        file.close();
+    }) == Shutdown::Returned);
+    CHECK(runFirmware([](){
+        static TestPersistent old("OLDVAL", 0);
+        boot();
+        capture(0, old, 0);
+        report->filesLeft = SD.exists("OLDVAL");
+    }) == Shutdown::Returned);
+    CHECK(report->values[0] == 129 && report->entries[0] == 130);
+    CHECK(report->filesLeft);
+}
+
+//Boot time of a log with 16 channels of 2000 records each
+static void benchmark(){
+    CHECK(runFirmware([](){
+        static TestPersistent* channels[16];
+        static char names[16][8];
+        for(uint8_t i = 0; i < 16; i++){
+            snprintf(names[i], sizeof(names[i]), "CH%u", (unsigned)i);
+            channels[i] = new TestPersistent(names[i], 0);
+        }
+        boot();
+        for(uint32_t value = 1; value <= 2000; value++){
+            for(TestPersistent* channel : channels) write(*channel, value, value);
+        }
+        PersistentTracker::getInstance().commit();
+        cutPower();
+    }) == Shutdown::PowerCut);
+    CHECK(runFirmware([](){
+        static TestPersistent* channels[16];
+        static char names[16][8];
+        for(uint8_t i = 0; i < 16; i++){
+            snprintf(names[i], sizeof(names[i]), "CH%u", (unsigned)(15 - i));
+            channels[i] = new TestPersistent(names[i], 0);
+        }
+        boot();
+        capture(0, *channels[0], 1999);
+    }) == Shutdown::Returned);
+    CHECK(report->values[0] == 2000 && report->entries[0] == 2001 && report->history[0] == 1999);
+    printf("boot with 16 channels of 2001 records: %.2f ms, %llu block reads\n", report->restore_ns / 1e6, (unsigned long long)report->blockReads);
+}
+
+int main(){
+    report = allocateShared<Report>();
+    SdCard::insert(262144);
+    testRenumbering();
+    testConflict();
+    testFormerFiles();
+    SdCard::insert(262144);
+    benchmark();
+    return Check::result();
+}
@@ -0,0 +1,135 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks that the write behind of Persistent<T> never touches the SPI bus from an interrupt and counts its SD operations
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include <TFT_eSPI.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+//Writes a counter to a Persistent every OS tick, i.e. stages its records from TC5_Handler
+class Logger : BaseComponent{
+    public:
+        Persistent<uint32_t> counter;
+        uint32_t next;
+        Logger() : BaseComponent("logger", OS::schedulerTick_ms), counter("COUNTER", 0), next(1) {
+            counter.setMinIntervall(0);
+        }
+        void update() override {
+            counter = next++;
+        }
+};
+
+//Lets the scene loop draw and call service() for the given time
+struct SceneLoop{
+    uint32_t draws;
+    void run(uint32_t duration_ms, bool callService){
+        static TFT_eSPI tft;
+        static bool tftReady = false;
+        if(!tftReady){
+            tft.init();
+            tftReady = true;
+        }
+        uint64_t end = getTime_ns() + (uint64_t)duration_ms * 1000000;
+        while(getTime_ns() < end){
+            //every fillRect is one display transaction, the OS tick fires in the middle of most of them
+            tft.fillRect(0, 0, 320, 40, draws & 1 ? TFT_BLACK : TFT_WHITE);
+            draws++;
+            if(callService) PersistentTracker::getInstance().service();
+        }
+    }
+};
+
+Logger logger;
+
+static void testStaging(){
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    SceneLoop scene = {0};
+    resetBusStatistics();
+    SdCard::resetStatistics();
+
+    //without service() nothing is written, the records wait in the staging buffer or are dropped when it is full
+    scene.run(2000, false);
+    CHECK(SdCard::getStatistics().blockWrites == 0);
+    CHECK(getBusStatistics().interruptBytes == 0);
+    CHECK(tracker.getIoStatistics().droppedRecords > 0);
+
+    //the scene loop commits, the tick keeps staging in between
+    scene.run(30000, true);
+    const IoStatistics& statistics = tracker.getIoStatistics();
+    BusStatistics bus = getBusStatistics();
+    printf("%lu records, %lu dropped, %lu commits: %lu opens, %lu closes, %lu writes, %lu flushes, %.3f operations per record\n",
+           statistics.records, statistics.droppedRecords, statistics.commits, statistics.opens, statistics.closes, statistics.writes,
+           statistics.flushes, statistics.getOperationsPerRecord());
+    printf("SD: %llu block writes (%llu multi block), bus: %llu bytes, %llu in interrupts, %llu conflicts, %u display transactions\n",
+           (unsigned long long)SdCard::getStatistics().blockWrites, (unsigned long long)SdCard::getStatistics().multiBlockWrites,
+           (unsigned long long)bus.bytes, (unsigned long long)bus.interruptBytes, (unsigned long long)bus.conflicts, (unsigned)scene.draws);
+    CHECK(bus.interruptBytes == 0);
+    CHECK(bus.conflicts == 0);
+    //commits are requested once the buffer is half full, the tick stages 100 records per second and nothing is dropped anymore
+    uint64_t dropped = statistics.droppedRecords;
+    scene.run(5000, true);
+    CHECK(statistics.droppedRecords == dropped);
+    CHECK(statistics.commits > 30000 / PersistentTracker::commitIntervall_ms);
+    CHECK(statistics.getOperationsPerRecord() < 0.1);
+
+    //the history holds the committed values in order
+    uint32_t last = logger.counter;
+    unsigned long entries = logger.counter.getNumbersOfEntries();
+    CHECK(entries > 3000);
+    CHECK(logger.counter.getElement(entries - 1) == last);
+    CHECK(logger.counter.getElement(entries - 2) == last - 1);
+    CHECK(getBusStatistics().interruptBytes == 0);
+}
+
+//The values committed before a power cut are restored at the next boot
+static void testRestore(){
+    static uint32_t* committed = allocateShared<uint32_t>();
+    static uint32_t* restored = allocateShared<uint32_t>();
+    CHECK(runFirmware([](){
+        OS::init("test");
+        SceneLoop scene = {0};
+        scene.run(3000, true);
+        //commit() enables the interrupts again, the tick must not stage anything behind it
+        NVIC_DisableIRQ(TC5_IRQn);
+        PersistentTracker::getInstance().commit();
+        *committed = logger.counter;
+        cutPower();
+    }) == Shutdown::PowerCut);
+    CHECK(runFirmware([](){
+        noInterrupts(); //no tick may write before we read
+        OS::init("test");
+        *restored = logger.counter;
+    }) == Shutdown::Returned);
+    CHECK(*committed > 250);
+    CHECK(*restored == *committed);
+}
+
+int main(){
+    SdCard::insert(262144);
+    testRestore();
+    SdCard::insert(262144);
+    OS::init("test");
+    testStaging();
+    return Check::result();
+}
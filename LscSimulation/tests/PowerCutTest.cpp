@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Cuts the power at every point of a series of commits and checks that the log restores to a consistent state with all
+//completed commits, and checks that the record CRC finds corrupted records
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr uint32_t numberOfValues = 400;
+constexpr uint32_t valuesPerCommit = 25;
+//the value of entry i is i, the first entry is the initial value 0
+Persistent<uint32_t> counter("COUNTER", 0);
+
+struct Report{
+    uint32_t committed; //the last value of the last commit that returned
+    uint32_t restored;
+    uint32_t entries;
+    bool historyConsistent;
+    uint32_t continued;
+    uint32_t continuedEntries;
+    uint64_t programmedBytes;
+};
+static Report* report;
+static uint64_t cutAfter;
+
+static void boot(){
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    counter.setMinIntervall(0);
+}
+
+static void writeValues(){
+    boot();
+    SdCard::resetStatistics();
+    if(cutAfter > 0) SdCard::cutPowerAfterProgrammedBytes(cutAfter);
+    for(uint32_t value = 1; value <= numberOfValues; value++){
+        counter = value;
+        if(value % valuesPerCommit == 0){
+            PersistentTracker::getInstance().commit();
+            report->committed = value;
+        }
+    }
+    report->programmedBytes = SdCard::getStatistics().programmedBytes;
+    SdCard::cancelPowerCut();
+}
+
+static void restoreAndContinue(){
+    boot();
+    report->restored = counter;
+    report->entries = counter.getNumbersOfEntries();
+    bool consistent = true;
+    for(uint32_t i = 0; i < report->entries; i++) consistent &= counter.getElement(i) == i;
+    report->historyConsistent = consistent;
+    for(uint32_t value = report->restored + 1; value <= report->restored + 10; value++) counter = value;
+    PersistentTracker::getInstance().commit();
+}
+
+static void restoreAgain(){
+    boot();
+    report->continued = counter;
+    report->continuedEntries = counter.getNumbersOfEntries();
+}
+
+static void testPowerCuts(){
+    //one run without a cut tells how many bytes the commits program
+    cutAfter = 0;
+    SdCard::insert(65536);
+    CHECK(runFirmware(writeValues) == Shutdown::Returned);
+    uint64_t totalBytes = report->programmedBytes;
+    CHECK(totalBytes > 0);
+    uint32_t cuts = 0;
+    uint32_t failures = 0;
+    //an odd step, such that the cuts fall on all offsets of a block
+    for(cutAfter = 1; cutAfter <= totalBytes; cutAfter += 173){
+        SdCard::insert(65536);
+        *report = Report();
+        Shutdown shutdown = runFirmware(writeValues);
+        CHECK(shutdown == Shutdown::PowerCut);
+        CHECK(runFirmware(restoreAndContinue) == Shutdown::Returned);
+        CHECK(runFirmware(restoreAgain) == Shutdown::Returned);
+        //nothing that has been committed is lost, nothing is invented and the log keeps working behind the torn commit
+        bool ok = report->restored >= report->committed && report->restored <= numberOfValues
+                  && report->entries == report->restored + 1 && report->historyConsistent
+                  && report->continued == report->restored + 10 && report->continuedEntries == report->entries + 10;
+        if(!ok){
+            failures++;
+            fprintf(stderr, "cut after %llu of %llu bytes: committed %u, restored %u with %u entries (%s), continued %u with %u entries\n",
+                    (unsigned long long)cutAfter, (unsigned long long)totalBytes, (unsigned)report->committed, (unsigned)report->restored,
+                    (unsigned)report->entries, report->historyConsistent ? "consistent" : "inconsistent", (unsigned)report->continued,
+                    (unsigned)report->continuedEntries);
+        }
+        cuts++;
+    }
+    printf("%u power cuts during %llu programmed bytes of %u commits\n", (unsigned)cuts, (unsigned long long)totalBytes, (unsigned)(numberOfValues / valuesPerCommit));
+    CHECK(failures == 0);
+}
+
+//CRC-16/CCITT-FALSE computed bit by bit
+static uint16_t referenceCrc(const uint8_t* data, size_t length){
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static void testCrc(){
+    uint8_t record[sizeof(LogRecordHeader) + 16];
+    uint32_t seed = 7;
+    bool matches = true;
+    bool detectsFlips = true;
+    for(uint32_t round = 0; round < 200; round++){
+        for(uint8_t& byte : record){
+            seed = seed * 1103515245 + 12345;
+            byte = seed >> 16;
+        }
+        LogRecordHeader header;
+        memcpy(&header, record, sizeof(header));
+        header.size = 16;
+        header.crc = 0;
+        memcpy(record, &header, sizeof(header));
+        uint16_t crc = PersistentLog::getCrc(record);
+        matches &= crc == referenceCrc(record, sizeof(record));
+        //the crc field itself is not covered
+        header.crc = 0x1234;
+        memcpy(record, &header, sizeof(header));
+        matches &= PersistentLog::getCrc(record) == crc;
+        //a single flipped bit in the payload is always detected
+        record[sizeof(LogRecordHeader) + round % 16] ^= 1 << (round % 8);
+        detectsFlips &= PersistentLog::getCrc(record) != crc;
+    }
+    CHECK(matches);
+    CHECK(detectsFlips);
+}
+
+//A bit flip in the newest record of the card: the record and everything behind it in its block is ignored
+static void testCorruptedRecord(){
+    cutAfter = 0;
+    SdCard::insert(65536);
+    CHECK(runFirmware(writeValues) == Shutdown::Returned);
+    uint8_t* newest = nullptr;
+    uint16_t newestSequence = 0;
+    for(uint32_t block = 0; block < SdCard::getNumberOfBlocks(); block++){
+        uint8_t* data = SdCard::getBlock(block);
+        uint32_t offset = 0;
+        while(offset + sizeof(LogRecordHeader) <= PersistentLog::blockSize){
+            LogRecordHeader header;
+            memcpy(&header, data + offset, sizeof(header));
+            if(header.channel == PersistentLog::noChannel || offset + sizeof(header) + header.size > PersistentLog::blockSize) break;
+            if(header.crc != PersistentLog::getCrc(data + offset)) break;
+            if(header.type == LogRecordType::FRAME && (newest == nullptr || header.sequence > newestSequence)){
+                newest = data + offset;
+                newestSequence = header.sequence;
+            }
+            offset += sizeof(header) + header.size;
+        }
+    }
+    CHECK(newest != nullptr);
+    if(newest == nullptr) return;
+    //the lowest byte of the first value of the frame
+    newest[sizeof(LogRecordHeader) + 1] ^= 0x01;
+    CHECK(runFirmware(restoreAndContinue) == Shutdown::Returned);
+    CHECK(runFirmware(restoreAgain) == Shutdown::Returned);
+    CHECK(report->restored < numberOfValues && report->entries == report->restored + 1 && report->historyConsistent);
+    CHECK(report->continued == report->restored + 10 && report->continuedEntries == report->entries + 10);
+}
+
+int main(){
+    report = allocateShared<Report>();
+    testCrc();
+    testCorruptedRecord();
+    testPowerCuts();
+    return Check::result();
+}
@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Lets the supply fail while the scene loop draws, writes a file or commits and checks that the power failure dump restores
+//every staged record without a bus conflict and within the hold-up time
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include <TFT_eSPI.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+//assumed time between the supply monitor interrupt and the brown-out of the board
+constexpr uint32_t holdUp_us = 5000;
+
+struct Report{
+    uint32_t triggered;     //the last value staged before the power failure
+    uint32_t staged;
+    bool dumpedAtOnce;      //SUPC_Handler found the bus idle
+    uint32_t dumpsBefore;
+    uint32_t triggerTime_us;
+    uint32_t latency_us;    //from the power failure to the end of the first dump
+    uint32_t maxDumpTime_us;
+    uint32_t restored;
+    uint32_t entries;
+    bool consistent;
+    uint32_t minuteSamples;
+    uint32_t restoredAgain;
+    uint32_t entriesAgain;
+};
+static Report* report;
+static unsigned long triggerTime_ms;
+//what the scene loop does besides drawing
+enum class Scene : uint8_t { DRAW, WRITE_FILE, COMMIT };
+static Scene scene;
+
+static void failPower(uint32_t lastStaged){
+    report->triggered = lastStaged;
+    report->dumpsBefore = PersistentTracker::getInstance().getIoStatistics().dumps;
+    report->triggerTime_us = micros();
+    triggerPowerFailure(holdUp_us);
+    report->dumpedAtOnce = PersistentTracker::getInstance().getIoStatistics().dumps > report->dumpsBefore;
+}
+
+static void noteDump(){
+    const IoStatistics& statistics = PersistentTracker::getInstance().getIoStatistics();
+    report->maxDumpTime_us = statistics.maxDumpTime_us;
+    if(report->triggered > 0 && report->latency_us == 0 && statistics.dumps > report->dumpsBefore){
+        report->latency_us = micros() - report->triggerTime_us;
+    }
+}
+
+//Writes a counter to a Persistent every OS tick from TC5_Handler and lets the supply fail at triggerTime_ms in the middle of
+//the scene loop
+class Logger : BaseComponent{
+    public:
+        Persistent<uint32_t> counter;
+        uint32_t next;
+        Logger() : BaseComponent("logger", OS::schedulerTick_ms), counter("COUNTER", 0), next(1) {
+            counter.setMinIntervall(0);
+            counter.enableRollups();
+        }
+        void update() override {
+            //the power may fail in the middle of the dump of the value
+            report->staged = next;
+            counter = next;
+            if(scene != Scene::COMMIT && report->triggered == 0 && millis() >= triggerTime_ms) failPower(next);
+            noteDump();
+            next++;
+        }
+};
+
+Logger logger;
+
+static void sceneLoop(){
+    OS::init("test");
+    TFT_eSPI tft;
+    tft.init();
+    File file;
+    if(scene == Scene::WRITE_FILE) file = SD.open("TRACE", FILE_WRITE);
+    uint8_t block[512];
+    memset(block, 'x', sizeof(block));
+    uint32_t draws = 0;
+    //the power fails long before the end of the loop
+    while(millis() < triggerTime_ms + 10000){
+        //the OS tick fires in the middle of most fillRect, file.write() leaves a multiple block write open
+        tft.fillRect(0, 0, 320, 20, draws++ & 1 ? TFT_BLACK : TFT_WHITE);
+        if(scene == Scene::WRITE_FILE) file.write(block, sizeof(block));
+        if(scene == Scene::COMMIT && report->triggered == 0 && millis() >= triggerTime_ms){
+            //the supply fails while the persistence uses the SD card, the end of the access dumps
+            PersistentTracker::SdAccess access;
+            failPower(logger.next - 1);
+        }
+        PersistentTracker::getInstance().service();
+        noteDump();
+        //the rest of the scene loop does not use the bus
+        delayMicroseconds(3000);
+    }
+}
+
+static void restore(){
+    noInterrupts(); //no tick may write before we read
+    OS::init("test");
+    report->restored = logger.counter;
+    report->entries = logger.counter.getNumbersOfEntries();
+    //the newest entries are the values staged before the power failure without a gap
+    bool consistent = report->entries > 1000;
+    for(uint32_t i = 1; i <= 1000 && consistent; i++) consistent &= logger.counter.getElement(report->entries - i) == report->restored + 1 - i;
+    report->consistent = consistent;
+    RollupSample<uint32_t> samples[4];
+    report->minuteSamples = logger.counter.getRollupRange(RollupTier::MINUTE, 0, 4, samples);
+}
+
+static void restoreAgain(){
+    noInterrupts();
+    OS::init("test");
+    report->restoredAgain = logger.counter;
+    report->entriesAgain = logger.counter.getNumbersOfEntries();
+}
+
+int main(){
+    report = allocateShared<Report>();
+    uint32_t runs = 0;
+    uint32_t dumpedAtOnce = 0;
+    uint32_t maxDumpTime_us = 0;
+    uint32_t maxLatency_us = 0;
+    for(Scene variant : {Scene::DRAW, Scene::WRITE_FILE, Scene::COMMIT}){
+        scene = variant;
+        //the failures fall on different phases of the scene loop, shortly after the first minute sample closed
+        for(uint32_t offset_ms = 1; offset_ms <= 60; offset_ms += 11){
+            triggerTime_ms = 60000 + offset_ms;
+            SdCard::insert(262144);
+            *report = Report();
+            resetBusStatistics();
+            CHECK(runFirmware(sceneLoop) == Shutdown::PowerCut);
+            BusStatistics bus = getBusStatistics();
+            CHECK(runFirmware(restore) == Shutdown::Returned);
+            CHECK(runFirmware(restoreAgain) == Shutdown::Returned);
+            //the dump holds everything staged before the failure and is applied only once
+            bool ok = report->triggered > 0 && report->restored >= report->triggered && report->restored <= report->staged
+                      && report->consistent && report->minuteSamples == 1
+                      && report->restoredAgain == report->restored && report->entriesAgain == report->entries && bus.conflicts == 0;
+            if(!ok){
+                fprintf(stderr, "failure at %lu ms in scene %u: triggered %u, staged %u, restored %u (%s), %u minute samples, again %u with %u entries, %llu conflicts\n",
+                        triggerTime_ms, (unsigned)scene, (unsigned)report->triggered, (unsigned)report->staged,
+                        (unsigned)report->restored, report->consistent ? "consistent" : "inconsistent",
+                        (unsigned)report->minuteSamples, (unsigned)report->restoredAgain, (unsigned)report->entriesAgain,
+                        (unsigned long long)bus.conflicts);
+            }
+            CHECK(ok);
+            runs++;
+            if(report->dumpedAtOnce) dumpedAtOnce++;
+            if(report->maxDumpTime_us > maxDumpTime_us) maxDumpTime_us = report->maxDumpTime_us;
+            if(report->latency_us > maxLatency_us) maxLatency_us = report->latency_us;
+        }
+    }
+    printf("%u power failures, %u dumped by SUPC_Handler, the others deferred: worst case dump %u us, %u us from the failure to the dump of %u us hold-up\n",
+           (unsigned)runs, (unsigned)dumpedAtOnce, (unsigned)maxDumpTime_us, (unsigned)maxLatency_us, (unsigned)holdUp_us);
+    //both paths have been taken
+    CHECK(dumpedAtOnce > 0 && dumpedAtOnce < runs);
+    CHECK(maxDumpTime_us > 0 && maxLatency_us < holdUp_us);
+    return Check::result();
+}
@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks LSC::printf() against the C library, the throughput of the async UART and compares printf() with String messages
+
+#include "LscSimulation.h"
+#include "LscHardwareAbstraction.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+LSC& lsc = LSC::getInstance();
+
+//Waits until the async UART sent everything and returns what it sent
+static std::string drain(){
+    advance_ms(400); //a full uartBuffer takes 300ms
+    std::string output = getSerialOutput();
+    clearSerialOutput();
+    return output;
+}
+
+static void check(const char* expected, const std::string& output, int line){
+    Check::check(output == expected, ("line " + std::to_string(line) + ": \"" + output + "\" == \"" + expected + "\"").c_str(), __FILE__, line);
+}
+
+#define EXPECT_PRINTF(format, ...) do{ \
+        char expected[128]; \
+        snprintf(expected, sizeof(expected), format, __VA_ARGS__); \
+        lsc.printf(format, __VA_ARGS__); \
+        check(expected, drain(), __LINE__); \
+    }while(0)
+
+static void testFormat(){
+    EXPECT_PRINTF("%d %i %u", -42, 17, 4000000000u);
+    EXPECT_PRINTF("%5d|%-5d|%05d|%x|%08X", 42, 42, -42, 0xbeefu, 0xbeefu);
+    EXPECT_PRINTF("%ld %lu %lx", -123456789L, 4000000000UL, 0xdeadbeefUL);
+    EXPECT_PRINTF("%lld %llu", -1234567890123LL, 18446744073709551615ULL);
+    EXPECT_PRINTF("%s|%.3s|%-6s|%6s", "text", "truncated", "left", "right");
+    EXPECT_PRINTF("%c%c %d%%", 'o', 'k', 100);
+    EXPECT_PRINTF("%.2f %f %.0f %8.3f", 3.14159, -2.5, 2.5001, 1.0005);
+    //unlike the C library %E defaults to two decimals, the format of the pressure display
+    EXPECT_PRINTF("%.2E %.3E %.2E", 1.2345e-4, 987654.0, 0.0);
+    //arguments after a long are read from the right place
+    EXPECT_PRINTF("%lu %s %llu %d", 1ul, "after", 2ull, 3);
+}
+
+static void testThroughput(){
+    //3000 bytes are queued at once and sent in the background at the rate of the TC2 handler
+    std::string message(99, 'x');
+    uint64_t start = getTime_ns();
+    for(int i = 0; i < 30; i++) lsc.println(message.c_str());
+    CHECK(getTime_ns() == start); //queuing does not wait
+    uint64_t bytes = getSerialBytesWritten();
+    advanceUntil([](){ return getSerialBytesWritten() >= 3000; }, 1000000000ULL, 100000);
+    double rate = (getSerialBytesWritten() - bytes) * 1e9 / (getTime_ns() - start);
+    printf("async UART: %.0f B/s\n", rate);
+    CHECK_NEAR(rate, 40 * 1e9 / getTimerPeriod_ns(TC0, 2), 200);
+    drain();
+}
+
+//Host time and heap allocations per kB of log messages, LSC::printf() against the String messages it replaces
+static void benchmark(){
+    constexpr int lines = 2000;
+    double pressure = 1.2345e-6;
+    uint32_t cycle = 123456;
+    const char* name = "gateValve";
+
+    //batches of 20 lines fit into the uartBuffer, only the time to queue them is measured
+    uint64_t printfTime = 0;
+    uint64_t printfAllocations = 0;
+    uint64_t printfBytes = 0;
+    for(int batch = 0; batch < lines / 20; batch++){
+        uint64_t allocations = getHeapAllocations();
+        uint64_t start = Check::hostTime_ns();
+        for(int i = 0; i < 20; i++){
+            lsc.printf("%s: cycle %lu, pressure %.2E mbar, temperature %.1f K\n", name, (unsigned long)(cycle + i), pressure, 293.15);
+        }
+        printfTime += Check::hostTime_ns() - start;
+        printfAllocations += getHeapAllocations() - allocations;
+        printfBytes += drain().size();
+    }
+
+    uint64_t stringTime = 0;
+    uint64_t stringAllocations = 0;
+    uint64_t stringBytes = 0;
+    for(int batch = 0; batch < lines / 20; batch++){
+        uint64_t allocations = getHeapAllocations();
+        uint64_t start = Check::hostTime_ns();
+        for(int i = 0; i < 20; i++){
+            lsc.println(String(name) + ": cycle " + String(cycle + i) + ", pressure " + String(pressure, 8) + " mbar, temperature " + String(293.15, 1) + " K");
+        }
+        stringTime += Check::hostTime_ns() - start;
+        stringAllocations += getHeapAllocations() - allocations;
+        stringBytes += drain().size();
+    }
+
+    printf("printf(): %.2f us/kB (%.0f kB/s), %.2f heap allocations per line\n", printfTime / 1000. / (printfBytes / 1024.),
+           printfBytes / 1.024 / printfTime * 1e6, (double)printfAllocations / lines);
+    printf("String:   %.2f us/kB (%.0f kB/s), %.2f heap allocations per line\n", stringTime / 1000. / (stringBytes / 1024.),
+           stringBytes / 1.024 / stringTime * 1e6, (double)stringAllocations / lines);
+    CHECK(printfAllocations == 0);
+    CHECK(stringAllocations > 0);
+}
+
+int main(){
+    drain();
+    testFormat();
+    testThroughput();
+    benchmark();
+    return Check::result();
+}
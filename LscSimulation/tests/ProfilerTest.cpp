@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the update() profiles of the OS tick against components with a known execution time
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+//A component whose update() takes duration_us of simulated time
+class TimedComponent : BaseComponent{
+    public:
+        volatile uint32_t duration_us;
+        TimedComponent(const char* name, uint32_t period_ms, uint32_t deadline_ms, uint32_t duration_us)
+            : BaseComponent(name, period_ms, deadline_ms), duration_us(duration_us) {}
+        void update() override{
+            advance_us(duration_us);
+        }
+};
+
+TimedComponent fast("fast", 10, 0, 300);
+TimedComponent slow("slow", 100, 3, 1500);
+
+int main(){
+    SdCard::insert(65536);
+    LSC::getInstance();
+    OS::init("test");
+    advance_ms(100);
+    OS::resetProfiles();
+    advance_ms(1000);
+
+    CHECK(OS::getNumberOfProfiles() == 2);
+    const OS::Profile* fastProfile = OS::getComponentProfile(0);
+    const OS::Profile* slowProfile = OS::getComponentProfile(1);
+    CHECK(OS::getComponentProfile(2) == nullptr);
+    CHECK(strcmp(fastProfile->name, "fast") == 0);
+    CHECK_NEAR(fastProfile->numberOfCalls, 100, 1);
+    CHECK_NEAR(slowProfile->numberOfCalls, 10, 1);
+    CHECK(fastProfile->minTime_us == 300 && fastProfile->maxTime_us == 300);
+    CHECK(fastProfile->getMean_us() == 300);
+    CHECK(fastProfile->getP99_us() >= 300 && fastProfile->getP99_us() < 512);
+    CHECK(slowProfile->getMean_us() == 1500);
+    CHECK(fastProfile->deadlineMisses == 0);
+
+    //the slow component runs after the fast one in the same tick, it misses its deadline when fast takes too long
+    fast.duration_us = 1400;
+    advance_ms(1000);
+    CHECK(slowProfile->deadlineMisses == 0);
+    fast.duration_us = 2000;
+    advance_ms(1000);
+    CHECK_NEAR(slowProfile->deadlineMisses, 10, 1);
+    CHECK(fastProfile->maxTime_us == 2000);
+
+    //the tick profile covers all updates of a tick
+    const OS::Profile* tick = OS::getTickProfile();
+    CHECK(tick->maxTime_us >= 3500);
+    CHECK(tick->minTime_us >= 300);
+    OS::resetProfiles();
+    CHECK(fastProfile->numberOfCalls == 0 && tick->numberOfCalls == 0);
+
+    clearSerialOutput();
+    advance_ms(100);
+    OS::printProfiles();
+    advance_ms(100);
+    CHECK(getSerialOutput().find("fast: 2000/2000/2000/") != std::string::npos);
+    printf("%s", getSerialOutput().c_str());
+    return Check::result();
+}
@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the sealed component registry and counts the heap allocations of the OS tick
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+LSC& lsc = LSC::getInstance();
+Components::TemperatureSensor temperatureSensor(lsc.analogInPt100_0, "temperature");
+Components::PressureGauge pressureGauge(lsc.analogInGauge_0, "pressure");
+Components::Valve valve(lsc.powerSwitch_0, "valve");
+Components::LN2LevelMeter ln2LevelMeter(lsc.analogIn_0, "ln2");
+Components::RoughingPump roughingPump(lsc.mosContact_0, "pump");
+Components::GateValve gateValve(lsc.powerSwitch_1, lsc.powerSwitch_2, lsc.digitalInIsolated_0, "gateValve");
+Components::FIB fib(lsc.mosContact_1, lsc.analogOutIsolated_0, lsc.digitalInIsolated_1, pressureGauge, "fib");
+constexpr size_t numberOfRealComponents = 7;
+
+//A component with one state, fills the registry up to its capacity
+class Filler : BaseComponent{
+    public:
+        ExposedState<ExposedStateType::Action, Filler> action;
+        Filler() : BaseComponent("filler", 10), action("action", this, &Filler::run) {}
+        void update() override {}
+        void run() {}
+};
+Filler fillers[ComponentTracker::maxComponents - numberOfRealComponents];
+Filler overflow; //one more than the registry holds
+
+static size_t countStatesOf(BaseComponent* component){
+    size_t count = 0;
+    for(auto& pair : ComponentTracker::getInstance().states){
+        if(pair.first == component) count++;
+    }
+    return count;
+}
+
+int main(){
+    SdCard::insert(65536);
+    OS::init("test");
+
+    //the component beyond the capacity is dropped together with its state, the state is not given to the previous component
+    ComponentTracker& tracker = ComponentTracker::getInstance();
+    CHECK(tracker.components.size() == ComponentTracker::maxComponents);
+    CHECK(ERROR_HANDLER.getErrors().size() == 1);
+    BaseComponent* lastFiller = tracker.components.back();
+    CHECK(countStatesOf(lastFiller) == 1);
+    for(auto& pair : tracker.states){
+        CHECK(pair.second != &overflow.action);
+    }
+
+    //the OS tick updates all of them without touching the heap
+    advance_ms(1000);
+    uint64_t allocations = getHeapAllocations();
+    uint64_t bytes = getHeapAllocatedBytes();
+    uint32_t ticks = getInterruptCount(TC5_IRQn);
+    advance_ms(10000);
+    ticks = getInterruptCount(TC5_IRQn) - ticks;
+    printf("%u ticks: %llu heap allocations (%llu bytes), %.3f per tick\n", (unsigned)ticks, (unsigned long long)(getHeapAllocations() - allocations),
+           (unsigned long long)(getHeapAllocatedBytes() - bytes), (double)(getHeapAllocations() - allocations) / ticks);
+    CHECK(ticks >= 999);
+    CHECK(getHeapAllocations() == allocations);
+
+    //components and states created after OS::init() are reported and ignored
+    ERROR_HANDLER.clearAll();
+    Filler* late = new Filler();
+    CHECK(ERROR_HANDLER.getErrors().size() == 2);
+    CHECK(tracker.components.size() == ComponentTracker::maxComponents);
+    CHECK(countStatesOf(lastFiller) == 1);
+    delete late;
+    return Check::result();
+}
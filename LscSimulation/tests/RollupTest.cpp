@@ -0,0 +1,171 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the minute and hour rollups of Persistent<T> against the raw values and measures a 30 day query from the raw
+//history and from the rollup tiers
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+#include <map>
+#include <vector>
+
+using namespace Simulation;
+
+constexpr uint32_t sampleInterval_ms = 10000;
+constexpr uint32_t numberOfValues = 30ul * 24 * 3600 * 1000 / sampleInterval_ms;
+Persistent<int32_t> pressure("PRESSURE", 0);
+
+struct Expected{
+    int32_t minimum;
+    int32_t maximum;
+    int64_t sum;
+    uint32_t count;
+};
+
+static int32_t valueAt(uint32_t i){
+    return (int32_t)((i * 7919u) % 2000) - 1000;
+}
+
+struct Measurement{
+    uint64_t start_ns;
+    uint64_t blockReads;
+    void start(){
+        start_ns = getTime_ns();
+        blockReads = SdCard::getStatistics().blockReads;
+    }
+    double getTime_ms(){
+        return (getTime_ns() - start_ns) / 1e6;
+    }
+    uint64_t getBlockReads(){
+        return SdCard::getStatistics().blockReads - blockReads;
+    }
+};
+
+//compares the samples of a tier with the buckets of the values written, the open bucket has not been staged
+static bool matches(const RollupSample<int32_t>* samples, size_t count, const std::map<uint32_t, Expected>& buckets){
+    if(count + 1 != buckets.size()) return false;
+    size_t i = 0;
+    for(const auto& bucket : buckets){
+        if(i == count) break;
+        const Expected& expected = bucket.second;
+        const RollupSample<int32_t>& sample = samples[i++];
+        if(sample.minimum != expected.minimum || sample.maximum != expected.maximum || sample.count != expected.count) return false;
+        if(fabs(sample.mean - (double)expected.sum / expected.count) > 1e-9) return false;
+    }
+    return true;
+}
+
+int main(){
+    SdCard::insert(262144);
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    //nothing but the test runs during the 30 days, without the timers and the ADC they pass quickly
+    TC_Stop(TC0, 2);
+    TC_Stop(TC1, 0);
+    TC_Stop(TC1, 2);
+    pmc_disable_periph_clk(ID_ADC);
+    pressure.setMinIntervall(0);
+    pressure.enableRollups();
+    std::map<uint32_t, Expected> buckets[numberOfRollupTiers];
+    for(uint32_t i = 0; i < numberOfValues; i++){
+        advance_ms(sampleInterval_ms);
+        int32_t value = valueAt(i);
+        pressure = value;
+        for(uint8_t tier = 0; tier < numberOfRollupTiers; tier++){
+            uint32_t bucket = millis() / getRollupInterval_ms((RollupTier)tier);
+            auto inserted = buckets[tier].insert({bucket, {value, value, 0, 0}});
+            Expected& expected = inserted.first->second;
+            if(value < expected.minimum) expected.minimum = value;
+            if(value > expected.maximum) expected.maximum = value;
+            expected.sum += value;
+            expected.count++;
+        }
+    }
+    PersistentTracker::getInstance().commit();
+    //the initial value is the first entry
+    CHECK(pressure.getNumbersOfEntries() == numberOfValues + 1);
+
+    //before: the hourly trend of 30 days from the raw history
+    Measurement measurement;
+    measurement.start();
+    std::map<uint32_t, Expected> hours;
+    int32_t values[500];
+    uint32_t index = 1;
+    while(index <= numberOfValues){
+        size_t read = pressure.getRange(index, 500, values);
+        if(read == 0) break;
+        for(size_t i = 0; i < read; i++){
+            uint32_t hour = (index - 1 + i) * (sampleInterval_ms / 1000) / 3600;
+            auto inserted = hours.insert({hour, {values[i], values[i], 0, 0}});
+            Expected& expected = inserted.first->second;
+            if(values[i] < expected.minimum) expected.minimum = values[i];
+            if(values[i] > expected.maximum) expected.maximum = values[i];
+            expected.sum += values[i];
+            expected.count++;
+        }
+        index += read;
+    }
+    CHECK(index == numberOfValues + 1);
+    CHECK(hours.size() == 30 * 24);
+    double rawTime_ms = measurement.getTime_ms();
+    uint64_t rawReads = measurement.getBlockReads();
+    printf("30 days from the raw history: %u values, %.1f ms, %llu block reads\n", (unsigned)numberOfValues, rawTime_ms,
+           (unsigned long long)rawReads);
+
+    //after: the same range from the tiers
+    for(uint8_t tier = 0; tier < numberOfRollupTiers; tier++){
+        RollupTier rollupTier = (RollupTier)tier;
+        size_t count = pressure.getNumberOfRollups(rollupTier);
+        CHECK(count + 1 == buckets[tier].size());
+        //the SD accesses take time as well, there may be a few more minutes than 30 days
+        std::vector<RollupSample<int32_t>> samples(count);
+        measurement.start();
+        size_t read = pressure.getRollupRange(rollupTier, 0, count, samples.data());
+        double time_ms = measurement.getTime_ms();
+        uint64_t reads = measurement.getBlockReads();
+        CHECK(read == count);
+        CHECK(matches(samples.data(), read, buckets[tier]));
+        printf("30 days from the %s tier: %u samples, %.1f ms, %llu block reads\n", rollupTier == RollupTier::MINUTE ? "minute" : "hour",
+               (unsigned)read, time_ms, (unsigned long long)reads);
+        if(rollupTier == RollupTier::HOUR){
+            CHECK(time_ms * 100 < rawTime_ms);
+            CHECK(reads * 100 < rawReads);
+        }
+    }
+
+    //the pool hands out its slots once, the Persistent<T> beyond it have no rollups
+    static Persistent<int32_t>* others[RollupPool::maxChannels / 2];
+    static char names[RollupPool::maxChannels / 2][8];
+    size_t withRollups = 0;
+    for(size_t i = 0; i < RollupPool::maxChannels / 2; i++){
+        snprintf(names[i], sizeof(names[i]), "P%u", (unsigned)i);
+        others[i] = new Persistent<int32_t>(names[i], 0);
+        others[i]->enableRollups();
+        *others[i] = 1;
+        advance_ms(60000);
+        *others[i] = 2;
+        PersistentTracker::getInstance().commit();
+        if(others[i]->getNumberOfRollups(RollupTier::MINUTE) > 0) withRollups++;
+    }
+    CHECK(withRollups == RollupPool::maxChannels / 2 - 1);
+    CHECK(RollupPool::getFreeSlots() == 0);
+    return Check::result();
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Removes overlapping elements, changes the colors and opens a popup on a P&ID scene and checks that the screen ends up
+//like a full redraw, counting the pixels sent to the display for each against a full redraw. Checks the bounds of the
+//scroll bar of the menus
+
+#include "LscSimulation.h"
+#include "LscSceneManager.h"
+#include "Check.h"
+#include "Screen.h"
+
+using namespace Simulation;
+using UI = SceneManager::UI_elements;
+
+SceneManager& sceneManager = SceneManager::getInstance();
+static Screen::Snapshot screen;
+
+//A pump line: the label of the valve overlaps the pipe and the valve, the gauge reading overlaps the chamber
+struct PumpLine{
+    UI::Rectangle frame{2, 2, 316, 236};
+    UI::VacuumChamber chamber{70, 110, 100, 80};
+    UI::Line pipe{120, 110, 290, 110};
+    UI::Valve valve{200, 110, true};
+    UI::TextBox valveLabel{180, 118, "V1 open", FM9};
+    UI::TextBox reading{30, 160, "1.23E-05 mbar", FM9};
+    UI::ProgressBar progress{30, 210, 12, 260, 40};
+};
+
+static void scene(){}
+
+static uint32_t backGroundColor(){
+    return sceneManager.getBackGroundColor();
+}
+
+//the screen a full redraw of the current elements produces, the screen is left like this. Nothing is left to repair
+static void fullRedraw(){
+    ElementTracker::getInstance().damagedRects.clear();
+    SceneManager::tft.fillScreen(backGroundColor());
+    SceneManager::reDrawAllElements();
+}
+
+//checks that the screen looks like a full redraw and returns the pixels a full redraw sends
+static uint64_t checkLikeFullRedraw(const char* what){
+    screen.take();
+    Screen::Traffic traffic;
+    traffic.start();
+    fullRedraw();
+    uint64_t pixels = traffic.getPixels();
+    uint32_t differences = screen.differences();
+    if(differences > 0){
+        fprintf(stderr, "%s: %u pixels differ from a full redraw\n", what, (unsigned)differences);
+        Display::writePpm("SceneDamageTest.ppm");
+    }
+    CHECK(differences == 0);
+    return pixels;
+}
+
+static void setColor(const char* stateName, uint32_t color){
+    for(auto& pair : ComponentTracker::getInstance().states){
+        if(strcmp(pair.second->stateName, stateName) != 0) continue;
+        //like ExposedStateInterface::setStateValue() but with the type of the state, the selection of void* it casts to has
+        //another layout on the host
+        auto state = static_cast<ExposedState<ExposedStateType::ReadWriteSelection, uint32_t>*>(pair.second);
+        state->index = state->_selection.getIndexByValue(color);
+        state->writeSelectionItemToState();
+    }
+}
+
+static void testRemoval(){
+    PumpLine* line = new PumpLine();
+    UI::TextBox* note = new UI::TextBox(150, 100, "service", FM9);
+    fullRedraw();
+    Screen::Traffic traffic;
+    traffic.start();
+    //the note overlaps the chamber, the pipe, the valve and its label
+    delete note;
+    SceneManager::repaintDamage();
+    uint64_t repaired = traffic.getPixels();
+    uint64_t full = checkLikeFullRedraw("removal of an overlapping label");
+    printf("%-38s %6llu pixels, full redraw %6llu\n", "removal of an overlapping label", (unsigned long long)repaired,
+           (unsigned long long)full);
+    CHECK(repaired * 4 < full);
+    delete line;
+}
+
+//switchScene() returns true, the scene ends and is built again like SceneManager::begin() does
+static uint64_t changeColor(const char* stateName, uint32_t color, PumpLine*& line){
+    Screen::Traffic traffic;
+    traffic.start();
+    setColor(stateName, color);
+    CHECK(sceneManager.switchScene());
+    delete line;
+    line = new PumpLine();
+    CHECK(!sceneManager.switchScene());
+    return traffic.getPixels();
+}
+
+static void testColors(){
+    PumpLine* line = new PumpLine();
+    fullRedraw();
+    uint64_t background = changeColor("Background Color", TFT_BLUE, line);
+    CHECK(backGroundColor() == TFT_BLUE);
+    uint64_t full = checkLikeFullRedraw("background color");
+    printf("%-38s %6llu pixels, full redraw %6llu\n", "background color change", (unsigned long long)background,
+           (unsigned long long)full);
+    //the scene is removed and built again and the screen is repainted once, before it was filled and redrawn twice
+    CHECK(background < full * 5 / 4);
+
+    uint64_t foreground = changeColor("Foreground Color", TFT_CYAN, line);
+    full = checkLikeFullRedraw("foreground color");
+    printf("%-38s %6llu pixels, full redraw %6llu\n", "foreground color change", (unsigned long long)foreground,
+           (unsigned long long)full);
+    //the background is not filled again, the areas of the elements, merged to a few rectangles, are repainted
+    CHECK(foreground < full * 3 / 5);
+    CHECK(Display::getPixel(100, 30) == TFT_BLUE);
+    delete line;
+    setColor("Background Color", TFT_BLACK);
+    setColor("Foreground Color", TFT_WHITE);
+    //one change per frame
+    CHECK(sceneManager.switchScene());
+    CHECK(sceneManager.switchScene());
+    CHECK(!sceneManager.switchScene());
+}
+
+//a popup like showMessageBox() without waiting for the buttons
+static void testPopup(){
+    PumpLine* line = new PumpLine();
+    fullRedraw();
+    screen.take();
+    Screen::Traffic traffic;
+    traffic.start();
+    SceneManager::clearAllElementsLayer();
+    SceneManager::StandardMenu* menu = new SceneManager::StandardMenu("Vent", "NO", "YES");
+    UI::TextBox* message = new UI::TextBox(5, 60, "Vent the chamber?", FM9);
+    delete menu;
+    delete message;
+    SceneManager::reDrawLastLayer();
+    uint64_t popup = traffic.getPixels();
+    uint32_t differences = screen.differences();
+    CHECK(differences == 0);
+    uint64_t full = checkLikeFullRedraw("popup");
+    printf("%-38s %6llu pixels, full redraw %6llu\n", "popup opened and closed", (unsigned long long)popup,
+           (unsigned long long)full);
+    //clearing and redrawing the elements of the layer is cheaper than repainting the screen below the popup
+    CHECK(popup < full + Screen::fullScreen);
+    delete line;
+}
+
+//the bounds of the scroll bar cover every pixel of its arrows, removing it leaves nothing behind
+static void testScrollBar(){
+    fullRedraw();
+    uint16_t background = backGroundColor();
+    UI::ScrollBar* scrollBar = new UI::ScrollBar();
+    ScreenRect bounds = scrollBar->getBounds();
+    uint32_t drawn = Screen::fullScreen - Display::countPixels(0, 0, Display::width, Display::height, background);
+    uint32_t inside = bounds.area() - Display::countPixels(bounds.x, bounds.y, bounds.w, bounds.h, background);
+    if(drawn == 0 || drawn != inside) fprintf(stderr, "scroll bar: %u pixels, %u inside the bounds\n", (unsigned)drawn, (unsigned)inside);
+    CHECK(drawn > 0 && drawn == inside);
+    delete scrollBar;
+    SceneManager::repaintDamage();
+    CHECK(Display::countPixels(0, 0, Display::width, Display::height, background) == Screen::fullScreen);
+}
+
+int main(){
+    sceneManager.init(scene);
+    testRemoval();
+    testColors();
+    testPopup();
+    testScrollBar();
+    return Check::result();
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the periods and the release jitter of the timer wheel scheduler
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+//Records the time of every update() and the deviation of the interval from the period
+class PeriodicComponent : BaseComponent{
+    public:
+        const char* name;
+        uint32_t period_ms;
+        uint32_t calls = 0;
+        uint64_t last_ns = 0;
+        uint64_t maxJitter_ns = 0;
+        uint32_t duration_us = 0;
+        bool saveToReadInTick = true;
+        PeriodicComponent(const char* name, uint32_t period_ms, uint32_t expectedPeriod_ms)
+            : BaseComponent(name, period_ms), name(name), period_ms(expectedPeriod_ms) {}
+        void update() override{
+            uint64_t now = getTime_ns();
+            if(calls > 0){
+                int64_t deviation = (int64_t)(now - last_ns) - (int64_t)period_ms * 1000000;
+                uint64_t jitter = deviation < 0 ? -deviation : deviation;
+                if(jitter > maxJitter_ns) maxJitter_ns = jitter;
+            }
+            last_ns = now;
+            calls++;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+            saveToReadInTick = OS::saveToRead();
+#pragma GCC diagnostic pop
+            advance_us(duration_us);
+        }
+        void reset(){
+            calls = 0;
+            maxJitter_ns = 0;
+        }
+};
+
+PeriodicComponent loadComponent("load", 10, 10);
+PeriodicComponent valve("valve", 10, 10);
+PeriodicComponent pump("pump", 20, 20);
+PeriodicComponent odd("odd", 25, 30); //rounded up to the next tick
+PeriodicComponent sensor("sensor", 1000, 1000); //longer than one turn of the wheel
+PeriodicComponent* periodic[] = {&loadComponent, &valve, &pump, &odd, &sensor};
+
+//a tick is 6563 counts of MCK/128, slightly longer than schedulerTick_ms
+static const uint64_t tick_ns = 6563ULL * 128 * 1000000000 / VARIANT_MCK;
+
+static void run(uint32_t duration_ms){
+    for(PeriodicComponent* component : periodic) component->reset();
+    advance_ms(duration_ms);
+}
+
+int main(){
+    SdCard::insert(65536);
+    LSC::getInstance();
+    OS::init("test");
+    advance_ms(2000);
+
+    //every component is released once per period, the only jitter comes from the tick being slightly longer than 10ms
+    run(10000);
+    for(PeriodicComponent* component : periodic){
+        uint32_t ticks = (component->period_ms + OS::schedulerTick_ms - 1) / OS::schedulerTick_ms;
+        uint32_t expected = 10000000000ULL / (ticks * tick_ns);
+        CHECK_NEAR(component->calls, expected, 1);
+        CHECK(component->maxJitter_ns <= ticks * (tick_ns + 1 - OS::schedulerTick_ms * 1000000));
+        printf("%-6s %4u ms: %5u calls, max jitter %6.3f us\n", component->name, (unsigned)component->period_ms,
+               (unsigned)component->calls, component->maxJitter_ns / 1000.);
+    }
+
+    //a slow update delays the components after it in the same tick, but the delay does not accumulate
+    loadComponent.duration_us = 3000;
+    run(10000);
+    CHECK(valve.maxJitter_ns <= 3000000 + tick_ns + 1 - OS::schedulerTick_ms * 1000000);
+    CHECK_NEAR(valve.calls, 10000000000ULL / tick_ns, 1);
+    CHECK_NEAR(sensor.calls, 10, 1);
+    CHECK(getLostInterruptCount(TC5_IRQn) == 0);
+    printf("with a 3ms update before it: valve max jitter %.3f us\n", valve.maxJitter_ns / 1000.);
+
+    //the deprecated polling API still answers, from the tick sequence and the time of the last tick
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    CHECK(!valve.saveToReadInTick);
+    CHECK(OS::saveToRead());
+    CHECK(OS::getNextOsCall_ms() <= OS::schedulerTick_ms);
+    //loadComponent runs first in every tick, 2ms before the next one
+    advance_us((loadComponent.last_ns + tick_ns - getTime_ns()) / 1000 - 2000);
+    CHECK_NEAR(OS::getNextOsCall_ms(), 2, 1);
+#pragma GCC diagnostic pop
+
+    return Check::result();
+}
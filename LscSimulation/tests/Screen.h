@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Helpers for the tests of the UI elements on the simulated display: a copy of the screen to compare with, and the pixels
+//and bus bytes sent to the display in between
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "LscSimulation.h"
+#include <string.h>
+
+namespace Screen{
+    using namespace Simulation;
+
+    struct Snapshot{
+        uint16_t pixels[Display::height][Display::width];
+
+        void take(){
+            for(uint16_t y = 0; y < Display::height; y++){
+                for(uint16_t x = 0; x < Display::width; x++) pixels[y][x] = Display::getPixel(x, y);
+            }
+        }
+        //the number of pixels that differ from the screen now
+        uint32_t differences() const {
+            uint32_t count = 0;
+            for(uint16_t y = 0; y < Display::height; y++){
+                for(uint16_t x = 0; x < Display::width; x++) count += pixels[y][x] != Display::getPixel(x, y);
+            }
+            return count;
+        }
+    };
+
+    //What the display received between start() and the call of a getter
+    struct Traffic{
+        Display::Statistics display;
+        uint64_t busBytes;
+
+        void start(){
+            display = Display::getStatistics();
+            busBytes = getBusStatistics().bytes;
+        }
+        uint64_t getPixels() const {
+            return Display::getStatistics().pixels - display.pixels;
+        }
+        uint64_t getWindows() const {
+            return Display::getStatistics().windows - display.windows;
+        }
+        uint64_t getBusBytes() const {
+            return getBusStatistics().bytes - busBytes;
+        }
+    };
+
+    constexpr uint32_t fullScreen = (uint32_t)Display::width * Display::height;
+}
+
+#endif
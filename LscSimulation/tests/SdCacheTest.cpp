@@ -0,0 +1,129 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Measures the hit rates of the FAT, directory and data blocks of the SdVolume cache and the block reads of the card for
+//a day of Persistent logging and for files that are looked up, appended and read again and again
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include <SD.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr uint32_t numberOfChannels = 20;
+constexpr uint32_t commitInterval_ms = 10000;
+constexpr uint32_t numberOfFiles = 20;
+
+static const char* const typeNames[] = {"FAT", "directory", "data"};
+
+static double hitRate(const SdVolume::cacheStatistics_t& statistics, uint8_t type){
+    if(statistics.lookups[type] == 0) return 1;
+    return 1 - (double)statistics.reads[type] / statistics.lookups[type];
+}
+
+static void print(const char* workload, const SdVolume::cacheStatistics_t& statistics){
+    printf("%s: %llu block reads\n", workload, (unsigned long long)SdCard::getStatistics().blockReads);
+    for(uint8_t type = 0; type < 3; type++){
+        printf("    %-9s %7u lookups, %5u reads, %6.2f%% hits\n", typeNames[type], (unsigned)statistics.lookups[type],
+               (unsigned)statistics.reads[type], hitRate(statistics, type) * 100);
+    }
+}
+
+//20 channels that change every 10 s, committed every 10 s for a simulated day
+static void testPersistence(){
+    SdCard::insert(262144);
+    noInterrupts(); //only the test writes
+    OS::init("test");
+    //nothing but the test runs during the day, without the timers and the ADC it passes quickly
+    TC_Stop(TC0, 2);
+    TC_Stop(TC1, 0);
+    TC_Stop(TC1, 2);
+    pmc_disable_periph_clk(ID_ADC);
+    static char names[numberOfChannels][8];
+    static Persistent<int32_t>* channels[numberOfChannels];
+    for(uint32_t i = 0; i < numberOfChannels; i++){
+        snprintf(names[i], sizeof(names[i]), "CH%u", (unsigned)i);
+        channels[i] = new Persistent<int32_t>(names[i], 0);
+        channels[i]->setMinIntervall(0);
+    }
+    PersistentTracker& tracker = PersistentTracker::getInstance();
+    tracker.commit();
+    SdCard::resetStatistics();
+    SdVolume::cacheResetStatistics();
+    constexpr uint32_t numberOfCommits = 24ul * 3600 * 1000 / commitInterval_ms;
+    for(uint32_t commit = 1; commit <= numberOfCommits; commit++){
+        advance_ms(commitInterval_ms);
+        for(uint32_t i = 0; i < numberOfChannels; i++) *channels[i] = (int32_t)(commit * (i + 1) % 1000);
+        tracker.commit();
+    }
+    SdVolume::cacheStatistics_t statistics = SdVolume::cacheStatistics();
+    print("a day of Persistent logging", statistics);
+    //the segments grow without a look at the FAT, the directory blocks of the segments stay cached
+    CHECK(SdCard::getStatistics().blockReads < numberOfCommits / 50);
+    CHECK(hitRate(statistics, 0) > 0.95 && hitRate(statistics, 1) > 0.99);
+    bool intact = true;
+    for(uint32_t i = 0; i < numberOfChannels; i++){
+        intact &= channels[i]->getNumbersOfEntries() == numberOfCommits + 1;
+        intact &= channels[i]->getElement(numberOfCommits) == (int32_t)(numberOfCommits * (i + 1) % 1000);
+    }
+    CHECK(intact);
+}
+
+//SD.exists(), open, append, seek to the start and read of one file after the other
+static void testFiles(){
+    SdCard::insert(262144);
+    CHECK(SD.begin(sdCardChipSelectPin));
+    char names[numberOfFiles][8];
+    for(uint32_t i = 0; i < numberOfFiles; i++) snprintf(names[i], sizeof(names[i]), "FILE%u", (unsigned)i);
+    SdCard::resetStatistics();
+    SdVolume::cacheResetStatistics();
+    constexpr uint32_t numberOfRounds = 100;
+    bool intact = true;
+    for(uint32_t round = 0; round < numberOfRounds; round++){
+        for(uint32_t i = 0; i < numberOfFiles; i++){
+            bool existed = SD.exists(names[i]);
+            intact &= existed == (round > 0);
+            File file = SD.open(names[i], FILE_WRITE);
+            uint32_t value = round * numberOfFiles + i;
+            file.write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+            file.seek(0);
+            uint32_t first = 0xFFFFFFFF;
+            intact &= file.read(reinterpret_cast<uint8_t*>(&first), sizeof(first)) == sizeof(first) && first == i;
+            file.close();
+        }
+    }
+    SdVolume::cacheStatistics_t statistics = SdVolume::cacheStatistics();
+    print("exists, open, append, seek and read of 20 files", statistics);
+    CHECK(intact);
+    //the FAT block of the clusters stays cached beside the directory and data blocks
+    CHECK(statistics.reads[0] <= 2);
+    //the 20 entries fill two directory blocks that share the directory block of the cache, i.e. the cache switches
+    //between them a few times per round
+    CHECK(statistics.reads[1] <= 10 * numberOfRounds && hitRate(statistics, 1) > 0.95);
+    //every file has a block of its own, every access of a file reads it once
+    CHECK(statistics.reads[2] <= numberOfRounds * numberOfFiles);
+}
+
+int main(){
+    testPersistence();
+    testFiles();
+    return Check::result();
+}
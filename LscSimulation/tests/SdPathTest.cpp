@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Measures the latency of SD.exists() and SD.open() in a directory with hundreds of files for paths walked through the
+//directory and for remembered paths, in simulated time of the card transfers and in host time of the computation, and
+//checks that remove, recreate and stale entries never open the wrong file
+
+#include "LscSimulation.h"
+#include <SD.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr uint32_t numberOfFiles = 300;
+//the last files of the directory, the walk scans all entries before them
+constexpr uint32_t firstUsed = numberOfFiles - SD_PATH_CACHE_ENTRIES;
+constexpr uint32_t numberOfRounds = 50;
+
+struct Measurement{
+    uint64_t start_ns;
+    uint64_t hostStart_ns;
+    uint64_t blockReads;
+    void start(){
+        start_ns = getTime_ns();
+        hostStart_ns = Check::hostTime_ns();
+        blockReads = SdCard::getStatistics().blockReads;
+    }
+    double getHostTime_us(){
+        return (Check::hostTime_ns() - hostStart_ns) / 1e3;
+    }
+    double getTime_us(){
+        return (getTime_ns() - start_ns) / 1e3;
+    }
+    uint64_t getBlockReads(){
+        return SdCard::getStatistics().blockReads - blockReads;
+    }
+    void print(const char* what, uint32_t lookups){
+        printf("%-26s %8.1f us, %5.2f block reads, %6.2f us host time per lookup\n", what, getTime_us() / lookups,
+               (double)getBlockReads() / lookups, getHostTime_us() / lookups);
+    }
+};
+
+static void pathOf(uint32_t index, char* path){
+    sprintf(path, "LOGS/F%03u", (unsigned)index);
+}
+
+//the file with the given index holds its index
+static bool holds(const char* path, uint32_t index){
+    File file = SD.open(path);
+    if(!file) return false;
+    uint32_t value = 0xFFFFFFFF;
+    bool ok = file.read(reinterpret_cast<uint8_t*>(&value), sizeof(value)) == sizeof(value) && value == index;
+    file.close();
+    return ok;
+}
+
+static void create(const char* path, uint32_t index){
+    File file = SD.open(path, FILE_WRITE);
+    file.write(reinterpret_cast<const uint8_t*>(&index), sizeof(index));
+    file.close();
+}
+
+//exists() and open() of the paths used by the scene loop, numberOfRounds times
+static void lookUp(uint32_t first, uint32_t count, const char* what){
+    char path[16];
+    Measurement measurement;
+    measurement.start();
+    bool found = true;
+    for(uint32_t round = 0; round < numberOfRounds; round++){
+        for(uint32_t index = first; index < first + count; index++){
+            pathOf(index, path);
+            found &= SD.exists(path);
+            File file = SD.open(path);
+            found &= (bool)file;
+            file.close();
+        }
+    }
+    measurement.print(what, 2 * numberOfRounds * count);
+    CHECK(found);
+}
+
+static void testLatency(){
+    char path[16];
+    //the first lookups walk through the directory
+    Measurement measurement;
+    measurement.start();
+    for(uint32_t index = firstUsed; index < numberOfFiles; index++){
+        pathOf(index, path);
+        CHECK(SD.exists(path));
+    }
+    double walk_us = measurement.getTime_us() / SD_PATH_CACHE_ENTRIES;
+    double walkReads = (double)measurement.getBlockReads() / SD_PATH_CACHE_ENTRIES;
+    measurement.print("walk of the directory", SD_PATH_CACHE_ENTRIES);
+
+    //the same paths again are remembered
+    measurement.start();
+    for(uint32_t index = firstUsed; index < numberOfFiles; index++){
+        pathOf(index, path);
+        CHECK(SD.exists(path));
+    }
+    double remembered_us = measurement.getTime_us() / SD_PATH_CACHE_ENTRIES;
+    double rememberedReads = (double)measurement.getBlockReads() / SD_PATH_CACHE_ENTRIES;
+    measurement.print("remembered path", SD_PATH_CACHE_ENTRIES);
+    CHECK(walkReads >= numberOfFiles * 32 / 512 - 1);
+    CHECK(rememberedReads <= 1);
+    CHECK(remembered_us * 10 < walk_us);
+
+    lookUp(firstUsed, SD_PATH_CACHE_ENTRIES, "exists+open, remembered");
+    //one path more than the cache holds, the least recently used is always the next one
+    lookUp(firstUsed - 1, SD_PATH_CACHE_ENTRIES + 1, "exists+open, cycling out");
+
+    //a path that does not exist is not remembered, it is walked every time
+    measurement.start();
+    for(uint32_t round = 0; round < numberOfRounds; round++) CHECK(!SD.exists("LOGS/NONE"));
+    measurement.print("missing file", numberOfRounds);
+}
+
+static void testInvalidation(){
+    char path[16];
+    pathOf(5, path);
+    CHECK(holds(path, 5));
+    //remove() forgets the path
+    CHECK(SD.remove(path));
+    CHECK(!SD.exists(path));
+    CHECK(!SD.open(path));
+    //the recreated file is found with its new content
+    create(path, 1005);
+    CHECK(holds(path, 1005));
+
+    //removed behind the back of the remembered spelling: the entry is deleted and then reused by an other file
+    pathOf(6, path);
+    CHECK(holds(path, 6));
+    CHECK(SD.remove("/LOGS/F006"));
+    CHECK(!SD.exists(path));
+    create("LOGS/G006", 2006);
+    CHECK(!SD.exists(path));
+    CHECK(!SD.open(path));
+    CHECK(holds("LOGS/G006", 2006));
+
+    //O_EXCL fails for a remembered path
+    pathOf(7, path);
+    CHECK(SD.exists(path));
+    CHECK(!SD.open(path, O_WRITE | O_CREAT | O_EXCL));
+    CHECK(holds(path, 7));
+
+    //begin() forgets all paths, the files are still found
+    CHECK(SD.begin(sdCardChipSelectPin));
+    pathOf(8, path);
+    CHECK(holds(path, 8));
+}
+
+int main(){
+    SdCard::insert(262144);
+    CHECK(SD.begin(sdCardChipSelectPin));
+    CHECK(SD.mkdir("LOGS"));
+    char path[16];
+    for(uint32_t index = 0; index < numberOfFiles; index++){
+        pathOf(index, path);
+        create(path, index);
+    }
+    //nothing is remembered from creating the files
+    CHECK(SD.begin(sdCardChipSelectPin));
+    testLatency();
+    testInvalidation();
+    return Check::result();
+}
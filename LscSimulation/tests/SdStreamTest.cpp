@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Appends log records to a file block by block through the cache and as a sequential append with multiple block writes,
+//checks that both files read back intact and compares the card commands and the time they take
+
+#include "LscSimulation.h"
+#include <SD.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+constexpr uint32_t recordSize = 64;
+constexpr uint32_t numberOfRecords = 8192; //512 KiB
+
+struct Result{
+    SdCard::Statistics card;
+    double time_ms;
+    bool intact;
+};
+
+static void fillRecord(uint32_t index, uint8_t* record){
+    for(uint32_t i = 0; i < recordSize; i++) record[i] = (uint8_t)(index * 31 + i);
+}
+
+//Appends the records and flushes after recordsPerCommit of them. Every readEvery records an other file is read in between,
+//which ends an open multiple block write
+static Result append(const char* name, bool sequential, uint32_t recordsPerCommit, uint32_t readEvery){
+    Result result;
+    File file = SD.open(name, FILE_WRITE);
+    CHECK(file);
+    if(sequential){
+        CHECK(file.preAllocate(numberOfRecords * recordSize));
+        CHECK(file.setSequentialAppend());
+    }
+    SdCard::resetStatistics();
+    uint64_t start_ns = getTime_ns();
+    uint8_t record[recordSize];
+    for(uint32_t index = 0; index < numberOfRecords; index++){
+        fillRecord(index, record);
+        file.write(record, sizeof(record));
+        if((index + 1) % recordsPerCommit == 0) file.flush();
+        if(readEvery > 0 && (index + 1) % readEvery == 0){
+            //a different block than the last time, such that it is not in the cache
+            File other = SD.open("OTHER");
+            other.seek((index / readEvery) % 4 * 512);
+            uint8_t buffer[recordSize];
+            CHECK(other.read(buffer, sizeof(buffer)) == sizeof(buffer));
+            other.close();
+        }
+    }
+    file.close();
+    result.time_ms = (getTime_ns() - start_ns) / 1e6;
+    result.card = SdCard::getStatistics();
+
+    file = SD.open(name);
+    result.intact = file.size() == numberOfRecords * recordSize;
+    uint8_t expected[recordSize];
+    for(uint32_t index = 0; index < numberOfRecords && result.intact; index++){
+        fillRecord(index, expected);
+        result.intact &= file.read(record, sizeof(record)) == sizeof(record) && memcmp(record, expected, sizeof(record)) == 0;
+    }
+    file.close();
+    CHECK(result.intact);
+    return result;
+}
+
+//The append buffers are a static pool: one file more than the pool has falls back to the cache, a closed file returns its
+//buffer and a File handed on by value keeps it
+static void testAppendBufferPool(){
+    File files[SD_APPEND_BUFFERS + 1];
+    for(uint8_t i = 0; i <= SD_APPEND_BUFFERS; i++){
+        char name[] = "POOL0";
+        name[4] += i;
+        files[i] = SD.open(name, FILE_WRITE);
+        CHECK(files[i]);
+        CHECK(files[i].setSequentialAppend() == (i < SD_APPEND_BUFFERS));
+    }
+    files[0].close();
+    File handedOn = files[SD_APPEND_BUFFERS];
+    CHECK(handedOn.setSequentialAppend());
+    uint8_t record[recordSize];
+    fillRecord(1, record);
+    CHECK(handedOn.write(record, sizeof(record)) == sizeof(record));
+    handedOn.close();
+    for(uint8_t i = 1; i < SD_APPEND_BUFFERS; i++) files[i].close();
+    File file = SD.open("POOL3");
+    uint8_t readBack[recordSize];
+    CHECK(file.read(readBack, sizeof(readBack)) == sizeof(readBack) && memcmp(readBack, record, sizeof(record)) == 0);
+    file.close();
+    //all buffers are back
+    for(uint8_t i = 0; i < SD_APPEND_BUFFERS; i++){
+        char name[] = "POOL0";
+        name[4] += i;
+        files[i] = SD.open(name, FILE_WRITE);
+        CHECK(files[i].setSequentialAppend());
+    }
+    for(uint8_t i = 0; i < SD_APPEND_BUFFERS; i++) files[i].close();
+}
+
+static void print(const char* workload, const char* mode, const Result& result){
+    printf("%-18s %-10s %8.1f ms (%6.0f KiB/s), %6llu commands, %5llu reads, %5llu single block writes, %5llu CMD25\n", workload, mode,
+           result.time_ms, numberOfRecords * recordSize / 1.024 / result.time_ms, (unsigned long long)result.card.commands,
+           (unsigned long long)result.card.blockReads, (unsigned long long)result.card.singleBlockWrites,
+           (unsigned long long)result.card.multiBlockWrites);
+}
+
+int main(){
+    SdCard::insert(262144);
+    CHECK(SD.begin(sdCardChipSelectPin));
+    File other = SD.open("OTHER", FILE_WRITE);
+    uint8_t block[512] = {1};
+    for(uint8_t i = 0; i < 4; i++) other.write(block, sizeof(block));
+    other.close();
+
+    //one flush at the end: the sequential append streams the whole file in one CMD25
+    Result plain = append("BULK", false, numberOfRecords, 0);
+    Result streamed = append("BULKSEQ", true, numberOfRecords, 0);
+    print("bulk", "cached", plain);
+    print("bulk", "sequential", streamed);
+    CHECK(streamed.card.multiBlockWrites == 1);
+    CHECK(streamed.card.blockReads < 4);
+    CHECK(streamed.card.commands * 20 < plain.card.commands);
+    CHECK(streamed.time_ms * 3 < plain.time_ms * 2);
+
+    //a commit every 16 records like the persistence: the clusters are allocated in advance, a commit writes the data with
+    //a CMD25 and the directory entry but not the FAT
+    plain = append("COMMIT", false, 16, 0);
+    streamed = append("COMMITSQ", true, 16, 0);
+    print("commit per 1 KiB", "cached", plain);
+    print("commit per 1 KiB", "sequential", streamed);
+    CHECK(streamed.card.blockReads == 0);
+    CHECK(streamed.card.singleBlockWrites == numberOfRecords / 16);
+    CHECK(streamed.card.commands * 3 < plain.card.commands * 2);
+    CHECK(streamed.time_ms * 3 < plain.time_ms * 2);
+
+    //an other file is read in between, the stream is ended for it and opened again
+    plain = append("READ", false, numberOfRecords, 256);
+    streamed = append("READSEQ", true, numberOfRecords, 256);
+    print("read per 16 KiB", "cached", plain);
+    print("read per 16 KiB", "sequential", streamed);
+    CHECK(streamed.card.multiBlockWrites >= numberOfRecords / 256);
+    CHECK(streamed.card.commands * 10 < plain.card.commands);
+    CHECK(streamed.time_ms * 3 < plain.time_ms * 2);
+
+    testAppendBufferPool();
+    return Check::result();
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Stress test of saveRead/saveReadBlock and OsTickLock: the OS tick interrupts the scene loop at random instructions
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "Check.h"
+
+using namespace Simulation;
+
+//Writes four values that always belong together in update(), checks that the pair written by the scene loop is never torn
+class StressComponent : BaseComponent{
+    public:
+        volatile double values[4];
+        volatile double first;
+        volatile double second;
+        volatile uint32_t tornPairs = 0;
+        volatile uint32_t updates = 0;
+        volatile uint32_t ticksDuringAction = 0;
+        ExposedState<ExposedStateType::Action, StressComponent> slowAction;
+
+        StressComponent() : BaseComponent("stress", 10), first(0), second(0), slowAction("slow", this, &StressComponent::runSlowAction) {
+            for(int i = 0; i < 4; i++) values[i] = i;
+        }
+        void update() override{
+            double base = values[0] + 1;
+            for(int i = 0; i < 4; i++) values[i] = base + i;
+            if(first != second) tornPairs++;
+            updates++;
+        }
+        void setPair(double value){
+            OsTickLock lock;
+            first = value;
+            second = value;
+        }
+        //an action that takes 50ms must not hold back the tick
+        void runSlowAction(){
+            uint32_t start = getInterruptCount(TC5_IRQn);
+            advance_ms(50);
+            ticksDuringAction = getInterruptCount(TC5_IRQn) - start;
+        }
+};
+
+StressComponent stress;
+
+static bool consistent(const double* copy){
+    return copy[1] == copy[0] + 1 && copy[2] == copy[0] + 2 && copy[3] == copy[0] + 3;
+}
+
+int main(){
+    SdCard::insert(65536);
+    LSC::getInstance();
+    OS::init("test");
+    advance_ms(100);
+
+    //actions run with the tick enabled
+    ExposedStateInterface(&stress.slowAction).executeAction();
+    CHECK(stress.ticksDuringAction >= 4);
+
+    //the tick fires every 5 to 50us of real time, i.e. at random instructions of the loop below
+    startAsynchronousInterrupt(TC5_IRQn, 5, 50, 12345);
+    uint64_t reads = 0;
+    uint64_t tornReads = 0;
+    uint64_t tornPlainReads = 0;
+    uint64_t end = Check::hostTime_ns() + 2000000000ULL;
+    double pair = 0;
+    while(Check::hostTime_ns() < end){
+        for(int i = 0; i < 1000; i++){
+            double copy[4];
+            saveReadBlock([&](){
+                for(int k = 0; k < 4; k++) copy[k] = stress.values[k];
+            });
+            if(!consistent(copy)) tornReads++;
+            //the same copy without the sequence lock, to see that the tick really hits the copies
+            for(int k = 0; k < 4; k++) copy[k] = stress.values[k];
+            if(!consistent(copy)) tornPlainReads++;
+            stress.setPair(++pair);
+            reads++;
+        }
+    }
+    stopAsynchronousInterrupt();
+
+    printf("%llu reads, %u ticks, %llu torn reads without the sequence lock, %llu with it, %u torn writes\n",
+           (unsigned long long)reads, (unsigned)stress.updates, (unsigned long long)tornPlainReads, (unsigned long long)tornReads,
+           (unsigned)stress.tornPairs);
+    CHECK(stress.updates > 1000);
+    CHECK(tornPlainReads > 0);
+    CHECK(tornReads == 0);
+    CHECK(stress.tornPairs == 0);
+    return Check::result();
+}
@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks the simulation itself: clock, timer rates of TC5/TC2/TC3, scripted inputs, SD card and reboots
+
+#include "LscSimulation.h"
+#include "LscOS.h"
+#include "LscHardwareAbstraction.h"
+#include <SD.h>
+#include "Check.h"
+
+using namespace Simulation;
+
+static uint64_t expectedPeriod_ns(uint32_t rc){
+    return (uint64_t)(rc + 1) * 128 * 1000000000ULL / VARIANT_MCK;
+}
+
+static void testClock(){
+    uint64_t start = getTime_ns();
+    uint32_t startMillis = millis();
+    delay(250);
+    CHECK(getTime_ns() - start == 250000000);
+    CHECK(millis() - startMillis == 250);
+    //a busy wait terminates because polling the clock lets time pass
+    uint32_t startMicros = micros();
+    while(micros() - startMicros < 500){}
+    uint32_t waited = micros() - startMicros;
+    CHECK(waited >= 500 && waited < 510);
+}
+
+struct SharedValue{
+    uint32_t value;
+};
+
+static void testReboot(){
+    SharedValue* result = allocateShared<SharedValue>();
+    static SharedValue* staticResult;
+    staticResult = result;
+    CHECK(runFirmware([](){ staticResult->value = 42; }) == Shutdown::Returned);
+    CHECK(result->value == 42);
+    CHECK(runFirmware([](){ NVIC_SystemReset(); }) == Shutdown::Reset);
+    CHECK(runFirmware([](){ delay(10); cutPower(); }) == Shutdown::PowerCut);
+    CHECK(runFirmware([](){ __BKPT(0); }) == Shutdown::Halted);
+    //the power fails 2ms after the supply monitor fired, the firmware keeps running until then
+    CHECK(runFirmware([](){
+        SUPC->SUPC_SMMR |= SUPC_SMMR_SMIEN;
+        NVIC_EnableIRQ(SUPC_IRQn);
+        triggerPowerFailure(2000);
+        uint64_t start = getTime_ns();
+        delay(1);
+        staticResult->value = (uint32_t)(getTime_ns() - start);
+        delay(1000);
+    }) == Shutdown::PowerCut);
+    CHECK(result->value == 1000000);
+}
+
+static volatile uint32_t pinChanges = 0;
+static void onPinChange(){
+    pinChanges++;
+}
+
+static void testPins(){
+    pinMode(22, INPUT_PULLUP);
+    CHECK(digitalRead(22) == HIGH);
+    attachInterrupt(digitalPinToInterrupt(22), onPinChange, FALLING);
+    setDigitalInput(22, false);
+    CHECK(digitalRead(22) == LOW);
+    CHECK(pinChanges == 1);
+    setDigitalInput(22, true);
+    CHECK(pinChanges == 1);
+    detachInterrupt(digitalPinToInterrupt(22));
+
+    pinMode(23, OUTPUT);
+    digitalWrite(23, HIGH);
+    CHECK(getDigitalOutput(23));
+    CHECK(digitalRead(23) == HIGH);
+
+    setAnalogInput(A3, 1234);
+    analogReadResolution(12);
+    CHECK(analogRead(A3) == 1234);
+    CHECK(analogRead(3) == 1234);
+    analogReadResolution(10);
+    CHECK(analogRead(A3) == 1234 >> 2);
+    analogReadResolution(12);
+}
+
+//RC value of the OS tick timer TC5
+static const uint32_t osTickRc = 6562;
+
+static void testFirmware(){
+    SdCard::insert(65536);
+    LSC::getInstance();
+    OS::init("test");
+    CHECK(getSerialOutput().find("SD Card OK") != std::string::npos);
+
+    //TC5 drives the OS tick, TC2 the async UART
+    CHECK(getTimerPeriod_ns(TC1, 2) == expectedPeriod_ns(osTickRc));
+    CHECK(getTimerPeriod_ns(TC0, 2) == expectedPeriod_ns(2281));
+    advance_ns(expectedPeriod_ns(osTickRc));
+    uint32_t ticks = getInterruptCount(TC5_IRQn);
+    uint32_t uartTicks = getInterruptCount(TC2_IRQn);
+    uint64_t tickTime = getLastInterruptTime_ns(TC5_IRQn);
+    advance_ns(100 * expectedPeriod_ns(osTickRc));
+    CHECK(getInterruptCount(TC5_IRQn) - ticks == 100);
+    CHECK_NEAR(getLastInterruptTime_ns(TC5_IRQn) - tickTime, 100 * expectedPeriod_ns(osTickRc), 100);
+    uint32_t expectedUartTicks = 100 * expectedPeriod_ns(osTickRc) / expectedPeriod_ns(2281);
+    CHECK(getInterruptCount(TC2_IRQn) - uartTicks >= expectedUartTicks && getInterruptCount(TC2_IRQn) - uartTicks <= expectedUartTicks + 1);
+    CHECK(getLostInterruptCount(TC5_IRQn) == 0);
+
+    //TC3 only runs while the beeper beeps, one interrupt per beep unit plus the one that stops it
+    uint32_t beeps = getInterruptCount(TC3_IRQn);
+    BEEPER.beep(3);
+    CHECK(getTimerPeriod_ns(TC1, 0) == expectedPeriod_ns(21000));
+    CHECK(getDigitalOutput(52));
+    advance_ns(4 * expectedPeriod_ns(21000) + 1000);
+    CHECK(!getDigitalOutput(52));
+    CHECK(getInterruptCount(TC3_IRQn) - beeps == 4);
+    advance_ms(500);
+    CHECK(getInterruptCount(TC3_IRQn) - beeps == 4);
+
+    //the AdcSampler sees the scripted inputs
+    setAnalogInput(A0, 3000);
+    advance_ms(200);
+    CHECK(getAdcConversionCount() > 0);
+    CHECK_NEAR(ADC_SAMPLER.getLatest(AdcSampler::getChannel(A0)), 3000, 0.1);
+
+    //files written through the SD library end up on the card
+    SdCard::resetStatistics();
+    File file = SD.open("SIM.TXT", FILE_WRITE);
+    CHECK(file);
+    file.print("simulated");
+    file.close();
+    CHECK(SdCard::getStatistics().blockWrites > 0);
+    file = SD.open("SIM.TXT");
+    char text[16] = {0};
+    CHECK(file.read(text, sizeof(text) - 1) == 9);
+    file.close();
+    CHECK(strcmp(text, "simulated") == 0);
+    BusStatistics bus = getBusStatistics();
+    printf("bus: %llu bytes, %llu conflicts, %llu conflict bytes, %llu unselected, %llu in interrupts\n", (unsigned long long)bus.bytes,
+           (unsigned long long)bus.conflicts, (unsigned long long)bus.conflictBytes, (unsigned long long)bus.unselectedBytes, (unsigned long long)bus.interruptBytes);
+    CHECK(bus.conflicts == 0);
+}
+
+int main(){
+    testReboot();
+    testClock();
+    testPins();
+    testFirmware();
+    return Check::result();
+}
@@ -0,0 +1,144 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Updates a buffered TextBox, which pushes its text as one sprite, and a TextBox drawn glyph by glyph with the same
+//readings and checks that they look the same after every update. Compares the windows, SPI bytes and the simulated time
+//per update, and checks that more buffered fields than the SpritePool holds are still drawn correctly
+
+#include "LscSimulation.h"
+#include "LscSceneManager.h"
+#include "Check.h"
+#include "Screen.h"
+
+using namespace Simulation;
+using UI = SceneManager::UI_elements;
+
+constexpr uint32_t numberOfTicks = 1000;
+//the glyph by glyph TextBox is drawn this far below the buffered one
+constexpr int16_t referenceOffset = 110;
+
+static void scene(){}
+
+//a temperature that changes by a tenth every tick and crosses the 10 and 100 degree boundaries, i.e. the text gets
+//longer and shorter. The channel shifts the text to the right such that the fields of the TextBoxes differ
+static String reading(uint32_t tick, uint32_t channel = 0){
+    int32_t tenths = (int32_t)((tick * 7 + channel * 131) % 1200) - 100;
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%*sT%u %d.%u C", (int)channel, "", (unsigned)channel, (int)(tenths / 10),
+             (unsigned)(tenths < 0 ? -tenths : tenths) % 10);
+    return String(buffer);
+}
+
+struct Cost{
+    uint64_t windows = 0;
+    uint64_t busBytes = 0;
+    uint64_t time_ns = 0;
+};
+
+template<typename F>
+static void measure(Cost& cost, F update){
+    Screen::Traffic traffic;
+    traffic.start();
+    uint64_t start_ns = getTime_ns();
+    update();
+    cost.time_ns += getTime_ns() - start_ns;
+    cost.windows += traffic.getWindows();
+    cost.busBytes += traffic.getBusBytes();
+}
+
+//the pixels in the rows top to bottom that differ from the rows referenceOffset below
+static uint32_t differences(int16_t top, int16_t bottom){
+    uint32_t count = 0;
+    for(int16_t y = top; y < bottom; y++){
+        for(uint16_t x = 0; x < Display::width; x++) count += Display::getPixel(x, y) != Display::getPixel(x, y + referenceOffset);
+    }
+    return count;
+}
+
+static void print(const char* font, const char* mode, const Cost& cost){
+    printf("%-18s %-15s %5.2f windows, %7.1f SPI bytes, %7.1f us per update\n", font, mode,
+           (double)cost.windows / numberOfTicks, (double)cost.busBytes / numberOfTicks, cost.time_ns / 1e3 / numberOfTicks);
+}
+
+//returns true if the sprite sends fewer bytes than the glyph diff
+static bool testFont(const char* name, const GFXfont* font){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    int16_t baseline = 20 + font->yAdvance;
+    UI::TextBox buffered(10, baseline, reading(0), font, TFT_WHITE, TFT_BLACK, true);
+    UI::TextBox glyphs(10, baseline + referenceOffset, reading(0), font);
+    Cost sprite;
+    Cost diff;
+    uint32_t mismatches = 0;
+    for(uint32_t tick = 1; tick <= numberOfTicks; tick++){
+        String text = reading(tick);
+        measure(sprite, [&](){ buffered.setText(text); });
+        measure(diff, [&](){ glyphs.setText(text); });
+        mismatches += differences(baseline - font->yAdvance, baseline + font->yAdvance);
+    }
+    print(name, "sprite", sprite);
+    print(name, "glyph by glyph", diff);
+    CHECK(mismatches == 0);
+    //at most one window per update, the field never shows a half updated text
+    CHECK(sprite.windows <= numberOfTicks);
+    CHECK(sprite.windows * 10 < diff.windows);
+    CHECK(SpritePool::usedBytes <= SpritePool::maxBytes);
+    return sprite.busBytes < diff.busBytes;
+}
+
+//more buffered fields of different sizes than the pool holds sprites, updated in turns
+static void testPoolExhaustion(){
+    constexpr uint32_t numberOfFields = 2 * SpritePool::maxSlots;
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    UI::TextBox* buffered[numberOfFields];
+    UI::TextBox* glyphs[numberOfFields];
+    for(uint32_t i = 0; i < numberOfFields; i++){
+        int16_t baseline = 15 + 12 * i;
+        buffered[i] = new UI::TextBox(0, baseline, reading(0, i), FM9, TFT_WHITE, TFT_BLACK, true);
+        glyphs[i] = new UI::TextBox(0, baseline + referenceOffset, reading(0, i), FM9);
+    }
+    uint32_t mismatches = 0;
+    for(uint32_t tick = 1; tick <= numberOfTicks / 10; tick++){
+        for(uint32_t i = 0; i < numberOfFields; i++){
+            buffered[i]->setText(reading(tick, i));
+            glyphs[i]->setText(reading(tick, i));
+        }
+        mismatches += differences(0, referenceOffset);
+        CHECK(SpritePool::usedBytes <= SpritePool::maxBytes);
+    }
+    CHECK(mismatches == 0);
+    //clear() removes the whole field of a buffered TextBox
+    for(uint32_t i = 0; i < numberOfFields; i++){
+        delete buffered[i];
+        delete glyphs[i];
+    }
+    SceneManager::repaintDamage();
+    CHECK(Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK) == Screen::fullScreen);
+}
+
+int main(){
+    SceneManager::getInstance().init(scene);
+    //small fonts send fewer bytes as a 1 bit sprite, big ones more but still in one window
+    CHECK(testFont("FreeMono9", FM9));
+    CHECK(testFont("FreeSans9", FSS9));
+    testFont("FreeMonoBold12", FMB12);
+    testFont("FreeSans12", FSS12);
+    testPoolExhaustion();
+    return Check::result();
+}
@@ -0,0 +1,232 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Checks that a Valve drawn from its baked SymbolGeometry looks like the same valve drawn line by line from its construction
+//points, and that the symbols of a vacuum schematic stay inside their bounds and are removed completely after rotate() and
+//scale(). Measures the pixels, windows, SPI bytes and time of building, redrawing and rotating the schematic
+
+#include "LscSimulation.h"
+#include "LscSceneManager.h"
+#include "Check.h"
+#include "Screen.h"
+
+using namespace Simulation;
+using UI = SceneManager::UI_elements;
+
+//the reference valve is drawn this far below the valve under test
+constexpr int16_t referenceOffset = 120;
+
+static void scene(){}
+
+struct Cost{
+    uint64_t pixels;
+    uint64_t windows;
+    uint64_t busBytes;
+    uint64_t time_ns;
+    uint64_t hostTime_ns;
+};
+
+template<typename F>
+static Cost measure(F draw){
+    Screen::Traffic traffic;
+    traffic.start();
+    uint64_t start_ns = getTime_ns();
+    uint64_t hostStart_ns = Check::hostTime_ns();
+    draw();
+    Cost cost;
+    cost.hostTime_ns = Check::hostTime_ns() - hostStart_ns;
+    cost.time_ns = getTime_ns() - start_ns;
+    cost.pixels = traffic.getPixels();
+    cost.windows = traffic.getWindows();
+    cost.busBytes = traffic.getBusBytes();
+    return cost;
+}
+
+//prints the cost of one of count repetitions
+static void print(const char* what, const Cost& cost, uint32_t count = 1){
+    printf("%-34s %6llu pixels, %4llu windows, %6llu SPI bytes, %7.1f us transfer, %6.1f us host time\n", what,
+           (unsigned long long)(cost.pixels / count), (unsigned long long)(cost.windows / count),
+           (unsigned long long)(cost.busBytes / count), cost.time_ns / 1e3 / count, cost.hostTime_ns / 1e3 / count);
+}
+
+static bool allBlack(){
+    return Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK) == Screen::fullScreen;
+}
+
+//the pixels in the rows top to bottom that differ from the rows referenceOffset below
+static uint32_t differences(int16_t top, int16_t bottom){
+    uint32_t count = 0;
+    for(int16_t y = top; y < bottom; y++){
+        for(uint16_t x = 0; x < Display::width; x++) count += Display::getPixel(x, y) != Display::getPixel(x, y + referenceOffset);
+    }
+    return count;
+}
+
+//A Valve drawn like before the geometry was baked: the construction points are transformed and every construction line is
+//sent with drawLine(), then the indicator is drawn
+struct ReferenceValve{
+    LinAlg::Vector_2D zeroPoint;
+    LinAlg::Vector_2D upperLeft{-10, 10};
+    LinAlg::Vector_2D upperRight{10, 10};
+    LinAlg::Vector_2D lowerLeft{-10, -10};
+    LinAlg::Vector_2D lowerRight{10, -10};
+    LinAlg::Vector_2D leftConnection{-15, 0};
+    LinAlg::Vector_2D leftMidPoint{-10, 0};
+    LinAlg::Vector_2D rightConnection{15, 0};
+    LinAlg::Vector_2D rightMidPoint{10, 0};
+    LinAlg::Vector_2D valveActuator{0, 10};
+    LinAlg::Vector_2D center{0, 0};
+    SceneManager::ConstructionPointCollection points;
+    SceneManager::ConstructionLineCollection lines{&zeroPoint};
+
+    ReferenceValve(uint16_t xPos, uint16_t yPos, double Rotation, double Scale): zeroPoint(xPos, yPos){
+        for(LinAlg::Vector_2D* point : {&upperLeft, &upperRight, &lowerLeft, &lowerRight, &leftConnection, &leftMidPoint,
+                                        &rightConnection, &rightMidPoint, &valveActuator, &center}){
+            points.addPoint(point);
+        }
+        lines.addLine(SceneManager::ConstructionLine(&upperLeft, &lowerRight));
+        lines.addLine(SceneManager::ConstructionLine(&lowerLeft, &upperRight));
+        lines.addLine(SceneManager::ConstructionLine(&upperLeft, &lowerLeft));
+        lines.addLine(SceneManager::ConstructionLine(&upperRight, &lowerRight));
+        lines.addLine(SceneManager::ConstructionLine(&leftConnection, &leftMidPoint));
+        lines.addLine(SceneManager::ConstructionLine(&rightConnection, &rightMidPoint));
+        lines.addLine(SceneManager::ConstructionLine(&center, &valveActuator));
+        if(Rotation != 0) points.rotate(Rotation);
+        if(Scale != 1) points.scale(Scale);
+    }
+    void draw(uint32_t color){
+        lines.draw(color);
+        LinAlg::Vector_2D indicator = zeroPoint + valveActuator;
+        SceneManager::tft.fillCircle(indicator.vec[0], indicator.vec[1], 5, TFT_RED);
+        SceneManager::tft.fillCircle(indicator.vec[0], indicator.vec[1], 2, TFT_BLACK);
+    }
+};
+
+static void testValve(double rotation, const char* name){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    UI::Valve* valve = new UI::Valve(160, 60, false, rotation, 1.3, TFT_WHITE);
+    ReferenceValve reference(160, 60 + referenceOffset, rotation, 1.3);
+    reference.draw(TFT_WHITE);
+    CHECK(differences(0, referenceOffset) == 0);
+    //the baked valve is drawn again, not constructed, the constructor also clears the unscaled valve
+    constexpr uint32_t numberOfDraws = 200;
+    Cost lines = measure([&](){ for(uint32_t i = 0; i < numberOfDraws; i++) reference.draw(TFT_WHITE); });
+    Cost redraw = measure([&](){ for(uint32_t i = 0; i < numberOfDraws; i++) valve->reDraw(); });
+    CHECK(differences(0, referenceOffset) == 0);
+    char what[48];
+    snprintf(what, sizeof(what), "%s, construction lines", name);
+    print(what, lines, numberOfDraws);
+    snprintf(what, sizeof(what), "%s, baked reDraw()", name);
+    print(what, redraw, numberOfDraws);
+    //the same pixels are sent, the baked lines save the arithmetic on the host
+    CHECK(redraw.windows == lines.windows);
+    CHECK(redraw.busBytes == lines.busBytes);
+    delete valve;
+}
+
+//A vacuum schematic: a chamber behind a gate valve and a turbo molecular pump, backed by a valve and a fore pump
+struct Schematic{
+    UI::VacuumChamber chamber{70, 90, 90, 70};
+    UI::Line chamberToGate{120, 90, 150, 90};
+    UI::GateValve gateValve{165, 90, true};
+    UI::Line gateToTurbo{180, 90, 205, 90};
+    UI::TurboMolecularPump turbo{235, 90, true};
+    UI::Line turboToValve{265, 90, 290, 90};
+    UI::Line backingLine{290, 90, 290, 180};
+    UI::Valve valve{240, 180};
+    UI::Line valveToPump{200, 180, 220, 180};
+    UI::Pump pump{170, 180, true};
+
+    std::vector<BaseUI_element*> symbols(){
+        return {&chamber, &gateValve, &turbo, &valve, &pump};
+    }
+};
+
+//every symbol draws inside its bounds and nothing is left after it was rotated, scaled and deleted
+template<typename Symbol, typename... Arguments>
+static void testBoundsAndRemoval(const char* name, Arguments... arguments){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    Symbol* symbol = new Symbol(arguments...);
+    ScreenRect bounds = symbol->getBounds().clipToScreen();
+    uint32_t inside = bounds.area() - Display::countPixels(bounds.x, bounds.y, bounds.w, bounds.h, TFT_BLACK);
+    uint32_t drawn = Screen::fullScreen - Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK);
+    if(drawn == 0 || drawn != inside) fprintf(stderr, "%s: %u pixels, %u inside the bounds\n", name, (unsigned)drawn, (unsigned)inside);
+    CHECK(drawn > 0 && drawn == inside);
+    symbol->rotate(0.7);
+    symbol->scale(1.5);
+    symbol->rotate(-2.1);
+    bounds = symbol->getBounds().clipToScreen();
+    inside = bounds.area() - Display::countPixels(bounds.x, bounds.y, bounds.w, bounds.h, TFT_BLACK);
+    drawn = Screen::fullScreen - Display::countPixels(0, 0, Display::width, Display::height, TFT_BLACK);
+    CHECK(drawn > 0 && drawn == inside);
+    delete symbol;
+    if(!allBlack()) fprintf(stderr, "%s: pixels left after delete\n", name);
+    CHECK(allBlack());
+}
+
+static void testSchematic(){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    Schematic* schematic = nullptr;
+    print("schematic, constructors", measure([&](){ schematic = new Schematic(); }));
+    Screen::Snapshot* screen = new Screen::Snapshot();
+    screen->take();
+    Cost redraw = measure([](){ SceneManager::reDrawAllElements(); });
+    print("schematic, reDrawAllElements()", redraw);
+    CHECK(screen->differences() == 0);
+
+    //every symbol cleared and drawn again, like a blinking state
+    std::vector<BaseUI_element*> symbols = schematic->symbols();
+    constexpr uint32_t numberOfCycles = 20;
+    Cost cycle = measure([&](){
+        for(uint32_t i = 0; i < numberOfCycles; i++){
+            for(BaseUI_element* symbol : symbols) symbol->clear();
+            for(BaseUI_element* symbol : symbols) symbol->reDraw();
+        }
+    });
+    print("symbols, clear and reDraw()", cycle, numberOfCycles);
+    CHECK(screen->differences() == 0);
+
+    //a transformation bakes the geometry again
+    print("valve and pump, rotate() and back", measure([&](){
+        schematic->valve.rotate(LinAlg::pi / 2);
+        schematic->valve.rotate(-LinAlg::pi / 2);
+        schematic->pump.rotate(LinAlg::pi / 2);
+        schematic->pump.rotate(-LinAlg::pi / 2);
+    }));
+    SceneManager::repaintDamage();
+    CHECK(screen->differences() == 0);
+    delete screen;
+    delete schematic;
+    SceneManager::repaintDamage();
+    CHECK(allBlack());
+}
+
+int main(){
+    SceneManager::getInstance().init(scene);
+    testValve(0, "valve");
+    testValve(0.5, "valve rotated");
+    testBoundsAndRemoval<UI::Valve>("Valve", 160, 120, true);
+    testBoundsAndRemoval<UI::GateValve>("GateValve", 160, 120, false);
+    testBoundsAndRemoval<UI::TurboMolecularPump>("TurboMolecularPump", 160, 120, true);
+    testBoundsAndRemoval<UI::Pump>("Pump", 160, 120, false);
+    testBoundsAndRemoval<UI::VacuumChamber>("VacuumChamber", 160, 120, 80, 60);
+    testSchematic();
+    return Check::result();
+}
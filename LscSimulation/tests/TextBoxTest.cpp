@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2024 Ferrovac AG
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: This specific version of the license has been chosen to ensure compatibility
+          with the SD library, which is an integral part of this application and is
+          licensed under the same version of the GNU General Public License.
+*/
+
+//Updates a pressure reading like "1.23E-05mbar" every tick with the glyph diff of TextBox::setText() and compares it with
+//a TextBox that is cleared and drawn again: the screens must match, the diff must send fewer pixels and windows. Prints the
+//pixels, windows, simulated time of the transfers and host time per update
+
+#include "LscSimulation.h"
+#include "LscSceneManager.h"
+#include "Check.h"
+#include "Screen.h"
+
+using namespace Simulation;
+using UI = SceneManager::UI_elements;
+
+constexpr uint32_t numberOfTicks = 2000;
+//the reference is drawn this far below the TextBox under test
+constexpr int16_t referenceOffset = 110;
+
+static void scene(){}
+
+//the reading of a pump down: the mantissa changes every tick, the exponent every few hundred ticks. Now and then the
+//gauge is under range and the reading is shifted by a "<", or it is off
+static String reading(uint32_t tick){
+    if(tick % 97 == 50) return "Off";
+    double pressure = 1.23e-5 * (1 + 0.013 * (tick % 71)) / pow(10, (tick / 400) % 3);
+    char buffer[20];
+    snprintf(buffer, sizeof(buffer), tick % 37 < 3 ? "<%.2Embar" : "%.2Embar", pressure);
+    return String(buffer);
+}
+
+struct Cost{
+    uint64_t pixels = 0;
+    uint64_t windows = 0;
+    uint64_t time_ns = 0;
+    uint64_t hostTime_ns = 0;
+};
+
+//Calls update() and adds what it cost to cost
+template<typename F>
+static void measure(Cost& cost, F update){
+    Screen::Traffic traffic;
+    traffic.start();
+    uint64_t start_ns = getTime_ns();
+    uint64_t hostStart_ns = Check::hostTime_ns();
+    update();
+    cost.hostTime_ns += Check::hostTime_ns() - hostStart_ns;
+    cost.time_ns += getTime_ns() - start_ns;
+    cost.pixels += traffic.getPixels();
+    cost.windows += traffic.getWindows();
+}
+
+//the pixels in the rows of the TextBox under test that differ from the rows of the reference
+static uint32_t differences(int16_t top, int16_t bottom){
+    uint32_t count = 0;
+    for(int16_t y = top; y < bottom; y++){
+        for(uint16_t x = 0; x < Display::width; x++) count += Display::getPixel(x, y) != Display::getPixel(x, y + referenceOffset);
+    }
+    return count;
+}
+
+static void print(const char* font, const char* mode, const Cost& cost){
+    printf("%-18s %-16s %7.1f pixels, %5.1f windows, %7.1f us transfer, %5.2f us host time per update\n", font, mode,
+           (double)cost.pixels / numberOfTicks, (double)cost.windows / numberOfTicks, cost.time_ns / 1e3 / numberOfTicks,
+           cost.hostTime_ns / 1e3 / numberOfTicks);
+}
+
+static void testFont(const char* name, const GFXfont* font){
+    SceneManager::tft.fillScreen(TFT_BLACK);
+    int16_t baseline = 20 + font->yAdvance;
+    UI::TextBox diffed(10, baseline, reading(0), font);
+    UI::TextBox reference(10, baseline + referenceOffset, reading(0), font);
+    Cost diff;
+    Cost redraw;
+    uint32_t mismatches = 0;
+    for(uint32_t tick = 1; tick <= numberOfTicks; tick++){
+        String text = reading(tick);
+        measure(diff, [&](){ diffed.setText(text); });
+        measure(redraw, [&](){
+            reference.setText("");
+            reference.setText(text);
+        });
+        mismatches += differences(baseline - font->yAdvance, baseline + font->yAdvance);
+    }
+    print(name, "glyph diff", diff);
+    print(name, "clear and draw", redraw);
+    CHECK(mismatches == 0);
+    CHECK(diff.pixels * 3 < redraw.pixels * 2);
+    CHECK(diff.windows < redraw.windows);
+    CHECK(diff.time_ns < redraw.time_ns);
+}
+
+int main(){
+    SceneManager::getInstance().init(scene);
+    testFont("FreeMono9", FM9);
+    testFont("FreeMonoBold12", FMB12);
+    testFont("FreeMonoOblique24", FMO24);
+    //the glyphs have different advances, a kept glyph must be at the same x in both strings
+    testFont("FreeSans12", FSS12);
+    return Check::result();
+}
@@ -139,6 +139,13 @@ public:
   bool peek(ET &outElement, const size_t distance = 0)
       __attribute__((noinline));
   bool lockedPeek(ET &outElement, const size_t distance = 0);
+  /* Return the number of elements stored contiguously from the beginning of
+   * the buffer and set outElements to the first of them. Together with drop()
+   * this allows to consume the buffer in blocks without copying */
+  IT peekSpan(const ET *&outElements);
+  /* Remove up to inCount elements from the beginning of the buffer, return
+   * the number of elements removed */
+  IT drop(IT inCount) __attribute__((noinline));
 };
 
 template <typename ET, size_t S, typename IT, typename BT>
@@ -273,6 +280,27 @@ bool RingBuf<ET, S, IT, BT>::lockedPeek(ET &outElement, const size_t distance) {
   return result;
 }
 
+template <typename ET, size_t S, typename IT, typename BT>
+IT RingBuf<ET, S, IT, BT>::peekSpan(const ET *&outElements) {
+  outElements = &mBuffer[mReadIndex];
+  BT untilEnd = (BT)S - (BT)mReadIndex;
+  if ((BT)mSize < untilEnd)
+    return mSize;
+  return (IT)untilEnd;
+}
+
+template <typename ET, size_t S, typename IT, typename BT>
+IT RingBuf<ET, S, IT, BT>::drop(IT inCount) {
+  if (inCount > mSize)
+    inCount = mSize;
+  BT readIndex = (BT)mReadIndex + (BT)inCount;
+  if (readIndex >= (BT)S)
+    readIndex -= (BT)S;
+  mReadIndex = (IT)readIndex;
+  mSize -= inCount;
+  return inCount;
+}
+
 template <typename ET, size_t S, typename IT, typename BT>
 ET &RingBuf<ET, S, IT, BT>::operator[](IT inIndex) {
   if (inIndex >= mSize)
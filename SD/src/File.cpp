@@ -18,7 +18,7 @@
    uint8_t nfilecount=0;
 */
 
-File::File(SdFile f, const char *n) {
+File::File(SdFile &f, const char *n) {
   // oh man you are kidding me, new() doesn't exist? Ok we do it by hand!
   _file = (SdFile *)malloc(sizeof(SdFile));
   if (_file) {
@@ -145,6 +145,22 @@ uint32_t File::size() {
   return _file->fileSize();
 }
 
+// allocates contiguous clusters for a file that grows to size bytes
+boolean File::preAllocate(uint32_t size) {
+  if (! _file) {
+    return false;
+  }
+  return _file->preAllocate(size);
+}
+
+// appends bypass the cache and use multiple block writes until flush()
+boolean File::setSequentialAppend() {
+  if (! _file) {
+    return false;
+  }
+  return _file->setSequentialAppend();
+}
+
 void File::close() {
   if (_file) {
     _file->close();
@@ -48,6 +48,11 @@
   or make directory) which others will only take an action at the bottom
   level (e.g. open).
 
+  `exists` and `open` remember the directory entry of the last
+  SD_PATH_CACHE_ENTRIES paths they found, a repeated lookup reads that entry
+  (usually from the SdVolume cache) instead of walking the path. `remove`
+  forgets the path, `rmdir`, `begin` and `end` forget all paths.
+
 */
 
 #include "SD.h"
@@ -233,12 +238,16 @@ namespace SDLib {
   */
 
   boolean callback_pathExists(SdFile& parentDir, const char *filePathComponent,
-                              boolean /* isLastComponent */, void * /* object */) {
+                              boolean isLastComponent, void *object) {
     /*
 
       Callback used to determine if a file/directory exists in parent
       directory.
 
+      If `object` is supplied it is an `SdFile` that is set to the
+      file/directory of the last component, its directory entry location
+      is used for the path cache.
+
       Returns true if file path exists.
 
     */
@@ -247,6 +256,9 @@ namespace SDLib {
     boolean exists = child.open(parentDir, filePathComponent, O_RDONLY);
 
     if (exists) {
+      if (isLastComponent && object) {
+        *static_cast<SdFile*>(object) = static_cast<SdFile&&>(child);
+      }
       child.close();
     }
 
@@ -268,7 +280,7 @@ namespace SDLib {
     boolean result = false;
     SdFile child;
 
-    result = callback_pathExists(parentDir, filePathComponent, isLastComponent, object);
+    result = callback_pathExists(parentDir, filePathComponent, isLastComponent, NULL);
     if (!result) {
       result = child.makeDir(parentDir, filePathComponent);
     }
@@ -340,6 +352,7 @@ namespace SDLib {
     if (root.isOpen()) {
       root.close();
     }
+    pathCacheClear();
 
     /*
 
@@ -357,6 +370,7 @@ namespace SDLib {
     if (root.isOpen()) {
       root.close();
     }
+    pathCacheClear();
 
     return card.init(SPI_HALF_SPEED, csPin) &&
            card.setSpiClock(clock) &&
@@ -367,6 +381,74 @@ namespace SDLib {
   //call this when a card is removed. It will allow you to insert and initialise a new card.
   void SDClass::end() {
     root.close();
+    pathCacheClear();
+  }
+
+  // the remembered entry of the path, NULL if the path is not remembered
+  SDClass::PathCacheEntry *SDClass::pathCacheFind(const char *filepath) {
+    for (uint8_t i = 0; i < SD_PATH_CACHE_ENTRIES; i++) {
+      if (pathCache[i].path[0] && !strcmp(pathCache[i].path, filepath)) {
+        pathCache[i].lastUse = ++pathCacheUseCount;
+        return &pathCache[i];
+      }
+    }
+    return NULL;
+  }
+
+  // remember the directory entry of an open file, replaces the least
+  // recently used path
+  void SDClass::pathCacheAdd(const char *filepath, SdFile& file) {
+    size_t len = strlen(filepath);
+    // paths ending in '/' open the parent directory, nothing to remember
+    if (len == 0 || len >= SD_PATH_CACHE_LEN || filepath[len - 1] == '/' || file.isRoot()) {
+      return;
+    }
+    PathCacheEntry *entry = pathCacheFind(filepath);
+    if (!entry) {
+      entry = &pathCache[0];
+      for (uint8_t i = 1; i < SD_PATH_CACHE_ENTRIES; i++) {
+        if (pathCache[i].lastUse < entry->lastUse) {
+          entry = &pathCache[i];
+        }
+      }
+      memcpy(entry->path, filepath, len + 1);
+    }
+    entry->dirBlock = file.dirBlock();
+    entry->dirIndex = file.dirIndex();
+    entry->lastUse = ++pathCacheUseCount;
+  }
+
+  void SDClass::pathCacheRemove(const char *filepath) {
+    for (uint8_t i = 0; i < SD_PATH_CACHE_ENTRIES; i++) {
+      if (!strcmp(pathCache[i].path, filepath)) {
+        pathCache[i].path[0] = 0;
+        pathCache[i].lastUse = 0;
+      }
+    }
+  }
+
+  void SDClass::pathCacheClear() {
+    for (uint8_t i = 0; i < SD_PATH_CACHE_ENTRIES; i++) {
+      pathCache[i].path[0] = 0;
+      pathCache[i].lastUse = 0;
+    }
+  }
+
+  // open a remembered path without walking it, a stale entry is forgotten
+  // and false is returned so the caller walks the path
+  boolean SDClass::pathCacheOpen(const char *filepath, SdFile& file, uint8_t mode) {
+    PathCacheEntry *entry = pathCacheFind(filepath);
+    if (!entry) {
+      return false;
+    }
+    const char *name = strrchr(filepath, '/');
+    name = name ? name + 1 : filepath;
+    if (!file.open(&volume, entry->dirBlock, entry->dirIndex, name, mode)) {
+      pathCacheRemove(filepath);
+      file = SdFile();
+      return false;
+    }
+    return true;
   }
 
   // this little helper is used to traverse paths
@@ -425,7 +507,7 @@ namespace SDLib {
 
     *index = (int)(filepath - origpath);
     // parent is now the parent directory of the file!
-    return *parent;
+    return static_cast<SdFile&&>(*parent);
   }
 
 
@@ -453,6 +535,17 @@ namespace SDLib {
 
     */
 
+    // a remembered path doesn't need the search
+    SdFile file;
+    if (pathCacheOpen(filepath, file, mode)) {
+      if ((mode & (O_APPEND | O_WRITE)) == (O_APPEND | O_WRITE)) {
+        file.seekSet(file.fileSize());
+      }
+      const char *name = strrchr(filepath, '/');
+      return File(file, name ? name + 1 : filepath);
+    }
+
+    const char *origpath = filepath;
     int pathidx;
 
     // do the interactive search
@@ -466,9 +559,6 @@ namespace SDLib {
       return File(parentdir, "/");
     }
 
-    // Open the file itself
-    SdFile file;
-
     // failed to open a subdir!
     if (!parentdir.isOpen()) {
       return File();
@@ -479,6 +569,7 @@ namespace SDLib {
     }
     // close the parent
     parentdir.close();
+    pathCacheAdd(origpath, file);
 
     if ((mode & (O_APPEND | O_WRITE)) == (O_APPEND | O_WRITE)) {
       file.seekSet(file.fileSize());
@@ -539,7 +630,18 @@ namespace SDLib {
        Returns true if the supplied file path exists.
 
     */
-    return walkPath(filepath, root, callback_pathExists);
+    SdFile file;
+    if (pathCacheOpen(filepath, file, O_RDONLY)) {
+      file.close();
+      return true;
+    }
+    if (!walkPath(filepath, root, callback_pathExists, &file)) {
+      return false;
+    }
+    if (file.isOpen()) {
+      pathCacheAdd(filepath, file);
+    }
+    return true;
   }
 
 
@@ -573,10 +675,13 @@ namespace SDLib {
       A rough equivalent to `rm -rf`.
 
     */
+    // the paths below the directory go stale too
+    pathCacheClear();
     return walkPath(filepath, root, callback_rmdir);
   }
 
   boolean SDClass::remove(const char *filepath) {
+    pathCacheRemove(filepath);
     return walkPath(filepath, root, callback_remove);
   }
 
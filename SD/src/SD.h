@@ -23,6 +23,14 @@
 #define FILE_READ O_READ
 #define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
 
+// Number of paths SDClass remembers the directory entry of, so that exists()
+// and open() of a recently used path don't walk the directories again.
+#ifndef SD_PATH_CACHE_ENTRIES
+  #define SD_PATH_CACHE_ENTRIES 8
+#endif
+// Longer paths are not remembered.
+#define SD_PATH_CACHE_LEN 32
+
 namespace SDLib {
 
   class File : public Stream {
@@ -31,7 +39,7 @@ namespace SDLib {
       SdFile *_file;  // underlying file pointer
 
     public:
-      File(SdFile f, const char *name);     // wraps an underlying SdFile
+      File(SdFile &f, const char *name);    // wraps an underlying SdFile
       File(void);      // 'empty' constructor
       virtual size_t write(uint8_t);
       virtual size_t write(const uint8_t *buf, size_t size);
@@ -44,6 +52,8 @@ namespace SDLib {
       boolean seek(uint32_t pos);
       uint32_t position();
       uint32_t size();
+      boolean preAllocate(uint32_t size);
+      boolean setSequentialAppend();
       void close();
       operator bool();
       char * name();
@@ -116,6 +126,24 @@ namespace SDLib {
       // It shouldn't be set directly--it is set via the parameters to `open`.
       int fileOpenMode;
 
+      // A remembered path and the location of its directory entry. A hit is
+      // checked against the name in the entry, so an entry that went stale
+      // behind SDClass' back is a miss and not a wrong file.
+      struct PathCacheEntry {
+        char path[SD_PATH_CACHE_LEN];
+        uint32_t dirBlock;
+        uint8_t dirIndex;
+        uint32_t lastUse;
+      };
+      PathCacheEntry pathCache[SD_PATH_CACHE_ENTRIES];
+      uint32_t pathCacheUseCount;
+
+      PathCacheEntry *pathCacheFind(const char *filepath);
+      void pathCacheAdd(const char *filepath, SdFile& file);
+      void pathCacheRemove(const char *filepath);
+      void pathCacheClear();
+      boolean pathCacheOpen(const char *filepath, SdFile& file, uint8_t mode);
+
       friend class File;
       friend boolean callback_openPath(SdFile&, const char *, boolean, void *);
   };
@@ -35,6 +35,32 @@
 */
 #define ALLOW_DEPRECATED_FUNCTIONS 1
 //------------------------------------------------------------------------------
+/**
+   Number of 512 byte blocks the SdVolume cache holds for FAT blocks,
+   directory blocks and file data blocks.  Each type is replaced least
+   recently used first within its own blocks, so a FAT chain walk does not
+   evict the directory block and reading a file evicts neither.
+*/
+#ifndef SD_CACHE_FAT_BLOCKS
+  #define SD_CACHE_FAT_BLOCKS 2
+#endif
+#ifndef SD_CACHE_DIR_BLOCKS
+  #define SD_CACHE_DIR_BLOCKS 1
+#endif
+#ifndef SD_CACHE_DATA_BLOCKS
+  #define SD_CACHE_DATA_BLOCKS 1
+#endif
+#define SD_CACHE_BLOCKS (SD_CACHE_FAT_BLOCKS + SD_CACHE_DIR_BLOCKS + SD_CACHE_DATA_BLOCKS)
+//------------------------------------------------------------------------------
+/**
+   Number of 512 byte block buffers for files in sequential append mode,
+   see SdFile::setSequentialAppend().  The buffers are a static pool, one
+   for the active segment of each PersistentLog.
+*/
+#ifndef SD_APPEND_BUFFERS
+  #define SD_APPEND_BUFFERS 3
+#endif
+//------------------------------------------------------------------------------
 // forward declaration since SdVolume is used in SdFile
 class SdVolume;
 //==============================================================================
@@ -151,7 +177,18 @@ uint16_t const FAT_DEFAULT_TIME = (1 << 11);
 class SdFile : public Print {
   public:
     /** Create an instance of SdFile. */
-    SdFile(void) : type_(FAT_FILE_TYPE_CLOSED) {}
+    SdFile(void) : type_(FAT_FILE_TYPE_CLOSED), appendBuffer_(0) {}
+    /**
+       An SdFile in sequential append mode owns a block buffer of the
+       pool, see setSequentialAppend().  It can not be copied, a move hands
+       the buffer over.
+    */
+    SdFile(const SdFile&) = delete;
+    SdFile& operator=(const SdFile&) = delete;
+    SdFile(SdFile&& other) : type_(FAT_FILE_TYPE_CLOSED), appendBuffer_(0) {
+      *this = static_cast<SdFile&&>(other);
+    }
+    SdFile& operator=(SdFile&& other);
     /**
        writeError is set to true if an error occurs during a write().
        Set writeError to false before calling print() and/or write() and check
@@ -256,8 +293,11 @@ class SdFile : public Print {
     }
     void ls(uint8_t flags = 0, uint8_t indent = 0);
     uint8_t makeDir(SdFile* dir, const char* dirName);
+    uint8_t preAllocate(uint32_t length);
     uint8_t open(SdFile* dirFile, uint16_t index, uint8_t oflag);
     uint8_t open(SdFile* dirFile, const char* fileName, uint8_t oflag);
+    uint8_t open(SdVolume* vol, uint32_t dirBlock, uint8_t dirIndex,
+                 const char* fileName, uint8_t oflag);
 
     uint8_t openRoot(SdVolume* vol);
     static void printDirName(const dir_t& dir, uint8_t width);
@@ -296,6 +336,11 @@ class SdFile : public Print {
       return seekSet(fileSize_);
     }
     uint8_t seekSet(uint32_t pos);
+    uint8_t setSequentialAppend(void);
+    /** \return True if appends use multiple block writes, see setSequentialAppend(). */
+    uint8_t sequentialAppend(void) const {
+      return appendBuffer_ != 0;
+    }
     /**
        Use unbuffered reads to access this file.  Used with Wave
        Shield ISR.  Used with Sd2Card::partialBlockRead() in WaveRP.
@@ -445,12 +490,19 @@ class SdFile : public Print {
     uint32_t  fileSize_;      // file size in bytes
     uint32_t  firstCluster_;  // first cluster of file
     SdVolume* vol_;           // volume where file is located
+    uint8_t*  appendBuffer_;  // last block of a sequential append, 0 if none
+    uint32_t  appendBlock_;   // SD block in appendBuffer_
+    uint8_t   appendDirty_;   // appendBuffer_ has not been written
 
     // private functions
     uint8_t addCluster(void);
     uint8_t addDirCluster(void);
+    uint8_t appendFlush(void);
     dir_t* cacheDirEntry(uint8_t action);
     static void (*dateTime_)(uint16_t* date, uint16_t* time);
+    static uint8_t appendBuffers_[SD_APPEND_BUFFERS][512];
+    static uint8_t appendBufferUsed_[SD_APPEND_BUFFERS];
+    void releaseAppendBuffer(void);
     static uint8_t make83Name(const char* str, uint8_t* name);
     uint8_t openCachedEntry(uint8_t cacheIndex, uint8_t oflags);
     dir_t* readDirCache(void);
@@ -488,8 +540,9 @@ class SdVolume {
     */
     static uint8_t* cacheClear(void) {
       cacheFlush();
-      cacheBlockNumber_ = 0XFFFFFFFF;
-      return cacheBuffer_.data;
+      streamStop();
+      cacheInvalidate(cacheBlockNumber_, 0);
+      return cacheBuffer_->data;
     }
     /**
        Initialize a FAT volume.  Try partition one first then try super
@@ -553,6 +606,23 @@ class SdVolume {
     static Sd2Card* sdCard(void) {
       return sdCard_;
     }
+    /** End the multiple block write of a file, required before any other
+        access to the card */
+    static uint8_t streamStop(void);
+    /** Lookups of the cache and the blocks read for them, indexed by
+        block type: FAT, directory, file data */
+    struct cacheStatistics_t {
+      uint32_t lookups[3];
+      uint32_t reads[3];
+    };
+    /** \return The lookups since the last cacheResetStatistics(). */
+    static const cacheStatistics_t& cacheStatistics(void) {
+      return cacheStatistics_;
+    }
+    /** Start counting the lookups of the cache from zero. */
+    static void cacheResetStatistics(void) {
+      cacheStatistics_ = cacheStatistics_t();
+    }
     //------------------------------------------------------------------------------
     #if ALLOW_DEPRECATED_FUNCTIONS
     // Deprecated functions  - suppress cpplint warnings with NOLINT comment
@@ -575,12 +645,27 @@ class SdVolume {
     static uint8_t const CACHE_FOR_READ = 0;
     // value for action argument in cacheRawBlock to indicate cache dirty
     static uint8_t const CACHE_FOR_WRITE = 1;
+    // values for type argument in cacheRawBlock, see SD_CACHE_FAT_BLOCKS
+    static uint8_t const CACHE_TYPE_FAT = 0;
+    static uint8_t const CACHE_TYPE_DIR = 1;
+    static uint8_t const CACHE_TYPE_DATA = 2;
 
-    static cache_t cacheBuffer_;        // 512 byte cache for device blocks
-    static uint32_t cacheBlockNumber_;  // Logical number of block in the cache
+    // a 512 byte cache for a device block
+    struct cacheEntry_t {
+      cache_t buffer;
+      uint32_t blockNumber;  // Logical number of the block, 0XFFFFFFFF if none
+      uint32_t mirrorBlock;  // block number for mirror FAT, 0 if none
+      uint32_t lastUse;      // for least recently used replacement
+      uint8_t dirty;         // cacheFlush() will write block if true
+    };
+    static cacheEntry_t cache_[SD_CACHE_BLOCKS];  // FAT, dir, data blocks
+    static uint8_t cacheIndex_;         // entry of the last cacheRawBlock()
+    static cache_t* cacheBuffer_;       // buffer of the last cacheRawBlock()
+    static uint32_t cacheBlockNumber_;  // Logical number of block in cacheBuffer_
+    static uint32_t cacheUseCount_;     // time of use for lastUse
+    static cacheStatistics_t cacheStatistics_;  // see cacheStatistics()
     static Sd2Card* sdCard_;            // Sd2Card object for cache
-    static uint8_t cacheDirty_;         // cacheFlush() will write block if true
-    static uint32_t cacheMirrorBlock_;  // block number for mirror FAT
+    static uint32_t streamBlockNumber_; // next block of the open multiple block write
     //
     uint32_t allocSearchStart_;   // start cluster for alloc search
     uint8_t blocksPerCluster_;    // cluster size in blocks
@@ -604,13 +689,27 @@ class SdVolume {
     uint32_t blockNumber(uint32_t cluster, uint32_t position) const {
       return clusterStartBlock(cluster) + blockOfCluster(position);
     }
+    static uint8_t cacheContains(uint32_t blockNumber);
+    // first cache block of a type, the blocks of a type end at the first of
+    // the next type
+    static uint8_t cacheFirst(uint8_t type) {
+      return type == CACHE_TYPE_FAT ? 0 :
+             type == CACHE_TYPE_DIR ? SD_CACHE_FAT_BLOCKS :
+             type == CACHE_TYPE_DATA ? SD_CACHE_FAT_BLOCKS + SD_CACHE_DIR_BLOCKS :
+             SD_CACHE_BLOCKS;
+    }
     static uint8_t cacheFlush(uint8_t blocking = 1);
+    static uint8_t cacheInvalidate(uint32_t blockNumber, uint8_t writeBack);
     static uint8_t cacheMirrorBlockFlush(uint8_t blocking);
-    static uint8_t cacheRawBlock(uint32_t blockNumber, uint8_t action);
+    static uint8_t cacheRawBlock(uint32_t blockNumber, uint8_t action,
+                                 uint8_t type);
+    static uint8_t cacheSelect(uint32_t blockNumber, uint8_t type);
     static void cacheSetDirty(void) {
-      cacheDirty_ |= CACHE_FOR_WRITE;
+      cache_[cacheIndex_].dirty |= CACHE_FOR_WRITE;
     }
-    static uint8_t cacheZeroBlock(uint32_t blockNumber);
+    static uint8_t cacheWriteBack(uint8_t index, uint8_t blocking);
+    static uint8_t cacheZeroBlock(uint32_t blockNumber, uint8_t type);
+    static uint8_t streamWrite(uint32_t blockNumber, const uint8_t* src);
     uint8_t chainSize(uint32_t beginCluster, uint32_t* size) const;
     uint8_t fatGet(uint32_t cluster, uint32_t* value) const;
     uint8_t fatPut(uint32_t cluster, uint32_t value);
@@ -622,20 +721,25 @@ class SdVolume {
       return  cluster >= (fatType_ == 16 ? FAT16EOC_MIN : FAT32EOC_MIN);
     }
     uint8_t readBlock(uint32_t block, uint8_t* dst) {
-      return sdCard_->readBlock(block, dst);
+      return streamStop() && sdCard_->readBlock(block, dst);
     }
     uint8_t readData(uint32_t block, uint16_t offset,
                      uint16_t count, uint8_t* dst) {
-      return sdCard_->readData(block, offset, count, dst);
+      return streamStop() && sdCard_->readData(block, offset, count, dst);
     }
     uint8_t writeBlock(uint32_t block, const uint8_t* dst, uint8_t blocking = 1) {
-      return sdCard_->writeBlock(block, dst, blocking);
+      return streamStop() && sdCard_->writeBlock(block, dst, blocking);
     }
     uint8_t isBusy(void) {
       return sdCard_->isBusy();
     }
     uint8_t isCacheMirrorBlockDirty(void) {
-      return (cacheMirrorBlock_ != 0);
+      for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+        if (cache_[i].mirrorBlock != 0) {
+          return true;
+        }
+      }
+      return false;
     }
 };
 #endif  // SdFat_h
@@ -25,6 +25,9 @@
 //------------------------------------------------------------------------------
 // callback function for date/time
 void (*SdFile::dateTime_)(uint16_t* date, uint16_t* time) = NULL;
+// block buffers of the files in sequential append mode, see setSequentialAppend()
+uint8_t SdFile::appendBuffers_[SD_APPEND_BUFFERS][512];
+uint8_t SdFile::appendBufferUsed_[SD_APPEND_BUFFERS];
 
 #if ALLOW_DEPRECATED_FUNCTIONS
   // suppress cpplint warnings with NOLINT comment
@@ -56,7 +59,7 @@ uint8_t SdFile::addDirCluster(void) {
   // zero data in cluster insure first cluster is in cache
   uint32_t block = vol_->clusterStartBlock(curCluster_);
   for (uint8_t i = vol_->blocksPerCluster_; i != 0; i--) {
-    if (!SdVolume::cacheZeroBlock(block + i - 1)) {
+    if (!SdVolume::cacheZeroBlock(block + i - 1, SdVolume::CACHE_TYPE_DIR)) {
       return false;
     }
   }
@@ -65,13 +68,25 @@ uint8_t SdFile::addDirCluster(void) {
   return true;
 }
 //------------------------------------------------------------------------------
+// write the block buffer of a sequential append, see setSequentialAppend()
+uint8_t SdFile::appendFlush(void) {
+  if (!appendDirty_) {
+    return true;
+  }
+  if (!SdVolume::streamWrite(appendBlock_, appendBuffer_)) {
+    return false;
+  }
+  appendDirty_ = false;
+  return true;
+}
+//------------------------------------------------------------------------------
 // cache a file's directory entry
 // return pointer to cached entry or null for failure
 dir_t* SdFile::cacheDirEntry(uint8_t action) {
-  if (!SdVolume::cacheRawBlock(dirBlock_, action)) {
+  if (!SdVolume::cacheRawBlock(dirBlock_, action, SdVolume::CACHE_TYPE_DIR)) {
     return NULL;
   }
-  return SdVolume::cacheBuffer_.dir + dirIndex_;
+  return SdVolume::cacheBuffer_->dir + dirIndex_;
 }
 //------------------------------------------------------------------------------
 /**
@@ -83,7 +98,11 @@ dir_t* SdFile::cacheDirEntry(uint8_t action) {
    Reasons for failure include no file is open or an I/O error.
 */
 uint8_t SdFile::close(void) {
-  if (!sync()) {
+  uint8_t synced = sync();
+
+  // release the block buffer of a sequential append
+  releaseAppendBuffer();
+  if (!synced) {
     return false;
   }
   type_ = FAT_FILE_TYPE_CLOSED;
@@ -378,12 +397,13 @@ uint8_t SdFile::makeDir(SdFile* dir, const char* dirName) {
 
   // cache block for '.'  and '..'
   uint32_t block = vol_->clusterStartBlock(firstCluster_);
-  if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE)) {
+  if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE,
+                               SdVolume::CACHE_TYPE_DIR)) {
     return false;
   }
 
   // copy '.' to block
-  memcpy(&SdVolume::cacheBuffer_.dir[0], &d, sizeof(d));
+  memcpy(&SdVolume::cacheBuffer_->dir[0], &d, sizeof(d));
 
   // make entry for '..'
   d.name[1] = '.';
@@ -395,7 +415,7 @@ uint8_t SdFile::makeDir(SdFile* dir, const char* dirName) {
     d.firstClusterHigh = dir->firstCluster_ >> 16;
   }
   // copy '..' to block
-  memcpy(&SdVolume::cacheBuffer_.dir[1], &d, sizeof(d));
+  memcpy(&SdVolume::cacheBuffer_->dir[1], &d, sizeof(d));
 
   // set position after '..'
   curPosition_ = 2 * sizeof(d);
@@ -520,7 +540,7 @@ uint8_t SdFile::open(SdFile* dirFile, const char* fileName, uint8_t oflag) {
 
     // use first entry in cluster
     dirIndex_ = 0;
-    p = SdVolume::cacheBuffer_.dir;
+    p = SdVolume::cacheBuffer_->dir;
   }
   // initialize as empty file
   memset(p, 0, sizeof(dir_t));
@@ -595,10 +615,66 @@ uint8_t SdFile::open(SdFile* dirFile, uint16_t index, uint8_t oflag) {
   return openCachedEntry(index & 0XF, oflag);
 }
 //------------------------------------------------------------------------------
+/**
+   Open a file by the location of its directory entry.
+
+   \param[in] vol The FAT volume containing the file.
+
+   \param[in] dirBlock The SD block that contains the directory entry, see
+   dirBlock().
+
+   \param[in] dirIndex The index of the entry in \a dirBlock, see dirIndex().
+
+   \param[in] fileName The name the entry must still have.
+
+   \param[in] oflag See open() by fileName, O_CREAT only allows an existing
+   file to be opened.
+
+   \return The value one, true, is returned for success and
+   the value zero, false, is returned for failure.
+   Reasons for failure include the entry is free, deleted or has a different
+   name or the file can't be opened with \a oflag.  The directory is not
+   searched, the caller falls back to open() by fileName.
+*/
+uint8_t SdFile::open(SdVolume* vol, uint32_t dirBlock, uint8_t dirIndex,
+                     const char* fileName, uint8_t oflag) {
+  uint8_t dname[11];
+
+  // error if already open
+  if (isOpen()) {
+    return false;
+  }
+
+  // don't open existing file if O_CREAT and O_EXCL
+  if ((oflag & (O_CREAT | O_EXCL)) == (O_CREAT | O_EXCL)) {
+    return false;
+  }
+
+  if (dirIndex > 0XF || !make83Name(fileName, dname)) {
+    return false;
+  }
+  vol_ = vol;
+
+  // read entry into cache
+  if (!SdVolume::cacheRawBlock(dirBlock, SdVolume::CACHE_FOR_READ,
+                               SdVolume::CACHE_TYPE_DIR)) {
+    return false;
+  }
+  dir_t* p = SdVolume::cacheBuffer_->dir + dirIndex;
+
+  // error if the entry was removed or reused
+  if (p->name[0] == DIR_NAME_FREE || p->name[0] == DIR_NAME_DELETED ||
+      memcmp(dname, p->name, 11)) {
+    return false;
+  }
+  // open cached entry
+  return openCachedEntry(dirIndex, oflag);
+}
+//------------------------------------------------------------------------------
 // open a cached directory entry. Assumes vol_ is initializes
 uint8_t SdFile::openCachedEntry(uint8_t dirIndex, uint8_t oflag) {
   // location of entry in cache
-  dir_t* p = SdVolume::cacheBuffer_.dir + dirIndex;
+  dir_t* p = SdVolume::cacheBuffer_->dir + dirIndex;
 
   // write or truncate is an error for a directory or read-only file
   if (p->attributes & (DIR_ATT_READ_ONLY | DIR_ATT_DIRECTORY)) {
@@ -684,6 +760,55 @@ uint8_t SdFile::openRoot(SdVolume* vol) {
   return true;
 }
 //------------------------------------------------------------------------------
+/**
+   Allocate contiguous clusters for a file that grows to \a length bytes.
+
+   The clusters are linked to the end of the cluster chain of the file, the
+   size of the file is not changed.  Appending to the file up to \a length
+   bytes does not update the FAT and the blocks written follow each other on
+   the card, see setSequentialAppend().  truncate() frees the clusters that
+   are not used.
+
+   \param[in] length The size the file is expected to grow to.
+
+   \return The value one, true, is returned for success and
+   the value zero, false, is returned for failure.
+   Reasons for failure include the file is not open for writing, there is
+   no contiguous free space of the required size or an I/O error occurred.
+*/
+uint8_t SdFile::preAllocate(uint32_t length) {
+  if (!isFile() || !(flags_ & O_WRITE)) {
+    return false;
+  }
+  uint8_t shift = vol_->clusterSizeShift_ + 9;
+  uint32_t needed = (length >> shift) + ((length & ((1UL << shift) - 1)) != 0);
+
+  // find the last cluster of the file
+  uint32_t count = 0;
+  uint32_t cluster = 0;
+  if (firstCluster_) {
+    uint32_t next = firstCluster_;
+    do {
+      cluster = next;
+      count++;
+      if (!vol_->fatGet(cluster, &next)) {
+        return false;
+      }
+    } while (!vol_->isEOC(next));
+  }
+  if (count >= needed) {
+    return true;
+  }
+  if (!vol_->allocContiguous(needed - count, &cluster)) {
+    return false;
+  }
+  if (firstCluster_ == 0) {
+    firstCluster_ = cluster;
+    flags_ |= F_FILE_DIR_DIRTY;
+  }
+  return sync();
+}
+//------------------------------------------------------------------------------
 /** %Print the name field of a directory entry in 8.3 format to Serial.
 
    \param[in] dir The directory structure containing the name.
@@ -809,19 +934,23 @@ int16_t SdFile::read(void* buf, uint16_t nbyte) {
       n = 512 - offset;
     }
 
-    // no buffering needed if n == 512 or user requests no buffering
-    if ((unbufferedRead() || n == 512) &&
-        block != SdVolume::cacheBlockNumber_) {
+    if (appendBuffer_ && block == appendBlock_) {
+      // last block of a sequential append, it may not be written yet
+      memcpy(dst, appendBuffer_ + offset, n);
+      dst += n;
+    } else if ((unbufferedRead() || n == 512) &&
+               !SdVolume::cacheContains(block)) {
       if (!vol_->readData(block, offset, n, dst)) {
         return -1;
       }
       dst += n;
     } else {
       // read block to cache and copy data to caller
-      if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_READ)) {
+      if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_READ,
+                                   isDir() ? SdVolume::CACHE_TYPE_DIR : SdVolume::CACHE_TYPE_DATA)) {
         return -1;
       }
-      uint8_t* src = SdVolume::cacheBuffer_.data + offset;
+      uint8_t* src = SdVolume::cacheBuffer_->data + offset;
       uint8_t* end = src + n;
       while (src != end) {
         *dst++ = *src++;
@@ -889,7 +1018,7 @@ dir_t* SdFile::readDirCache(void) {
   curPosition_ += 31;
 
   // return pointer to entry
-  return (SdVolume::cacheBuffer_.dir + i);
+  return (SdVolume::cacheBuffer_->dir + i);
 }
 //------------------------------------------------------------------------------
 /**
@@ -923,6 +1052,7 @@ uint8_t SdFile::remove(void) {
 
   // set this SdFile closed
   type_ = FAT_FILE_TYPE_CLOSED;
+  releaseAppendBuffer();
 
   // write entry to SD
   return SdVolume::cacheFlush();
@@ -1118,6 +1248,70 @@ uint8_t SdFile::seekSet(uint32_t pos) {
   return true;
 }
 //------------------------------------------------------------------------------
+/**
+   Use multiple block writes for appends to this file.
+
+   Appended data bypasses the volume cache.  The last block of the file is
+   kept in a block buffer of this file and full blocks are written with one
+   multiple block write (CMD25) as long as they follow each other on the
+   card, see preAllocate().  sync() writes the last block and ends the
+   multiple block write, any other access to the card ends it as well.
+
+   \return The value one, true, is returned for success and
+   the value zero, false, is returned for failure.
+   Reasons for failure include the file is not open for writing or all
+   SD_APPEND_BUFFERS block buffers are in use.
+*/
+uint8_t SdFile::setSequentialAppend(void) {
+  if (!isFile() || !(flags_ & O_WRITE)) {
+    return false;
+  }
+  if (!appendBuffer_) {
+    for (uint8_t i = 0; i < SD_APPEND_BUFFERS; i++) {
+      if (!appendBufferUsed_[i]) {
+        appendBufferUsed_[i] = true;
+        appendBuffer_ = appendBuffers_[i];
+        appendBlock_ = 0XFFFFFFFF;
+        appendDirty_ = false;
+        return true;
+      }
+    }
+    return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// take over the state of other, its append buffer included
+SdFile& SdFile::operator=(SdFile&& other) {
+  if (this == &other) {
+    return *this;
+  }
+  releaseAppendBuffer();
+  flags_ = other.flags_;
+  type_ = other.type_;
+  curCluster_ = other.curCluster_;
+  curPosition_ = other.curPosition_;
+  dirBlock_ = other.dirBlock_;
+  dirIndex_ = other.dirIndex_;
+  fileSize_ = other.fileSize_;
+  firstCluster_ = other.firstCluster_;
+  vol_ = other.vol_;
+  appendBuffer_ = other.appendBuffer_;
+  appendBlock_ = other.appendBlock_;
+  appendDirty_ = other.appendDirty_;
+  other.appendBuffer_ = 0;
+  return *this;
+}
+//------------------------------------------------------------------------------
+// return the block buffer of a sequential append to the pool
+void SdFile::releaseAppendBuffer(void) {
+  // the buffer moves with the SdFile (File wraps a copy of its bytes), so its slot is found by address
+  if (appendBuffer_) {
+    appendBufferUsed_[(appendBuffer_ - appendBuffers_[0]) / 512] = false;
+  }
+  appendBuffer_ = 0;
+}
+//------------------------------------------------------------------------------
 /**
    The sync() call causes all modified data and directory fields
    to be written to the storage device.
@@ -1135,6 +1329,13 @@ uint8_t SdFile::sync(uint8_t blocking) {
     return false;
   }
 
+  if (appendBuffer_) {
+    // write the last block of a sequential append before the directory entry
+    if (!appendFlush() || !SdVolume::streamStop()) {
+      return false;
+    }
+  }
+
   if (flags_ & F_FILE_DIR_DIRTY) {
     dir_t* d = cacheDirEntry(SdVolume::CACHE_FOR_WRITE);
     if (!d) {
@@ -1261,8 +1462,16 @@ uint8_t SdFile::truncate(uint32_t length) {
     return false;
   }
 
-  // fileSize and length are zero - nothing to do
-  if (fileSize_ == 0) {
+  // the last block changes, drop the block buffer of a sequential append
+  if (appendBuffer_) {
+    if (!appendFlush()) {
+      return false;
+    }
+    appendBlock_ = 0XFFFFFFFF;
+  }
+
+  // fileSize and length are zero and no cluster is allocated - nothing to do
+  if (fileSize_ == 0 && firstCluster_ == 0) {
     return true;
   }
 
@@ -1348,6 +1557,15 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
     }
   }
 
+  // a write inside the file goes through the cache, drop the block buffer
+  // of a sequential append
+  if (appendBuffer_ && curPosition_ < fileSize_) {
+    if (!appendFlush()) {
+      goto writeErrorReturn;
+    }
+    appendBlock_ = 0XFFFFFFFF;
+  }
+
   while (nToWrite > 0) {
     uint8_t blockOfCluster = vol_->blockOfCluster(curPosition_);
     uint16_t blockOffset = curPosition_ & 0X1FF;
@@ -1387,11 +1605,45 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
 
     // block for data write
     uint32_t block = vol_->clusterStartBlock(curCluster_) + blockOfCluster;
-    if (n == 512) {
+    if (appendBuffer_ && curPosition_ >= fileSize_) {
+      // sequential append - bypass the cache
+      if (!SdVolume::cacheInvalidate(block, 1)) {
+        goto writeErrorReturn;
+      }
+      if (n == 512) {
+        // full block - don't need the block buffer
+        if (appendBlock_ == block) {
+          appendBlock_ = 0XFFFFFFFF;
+          appendDirty_ = false;
+        }
+        if (!SdVolume::streamWrite(block, src)) {
+          goto writeErrorReturn;
+        }
+      } else {
+        if (appendBlock_ != block) {
+          if (!appendFlush()) {
+            goto writeErrorReturn;
+          }
+          // continue the last block of the file
+          if (blockOffset != 0 && !vol_->readBlock(block, appendBuffer_)) {
+            goto writeErrorReturn;
+          }
+          appendBlock_ = block;
+        }
+        memcpy(appendBuffer_ + blockOffset, src, n);
+        appendDirty_ = true;
+
+        // write the block as soon as it is full
+        if (blockOffset + n == 512 && !appendFlush()) {
+          goto writeErrorReturn;
+        }
+      }
+      src += n;
+    } else if (n == 512) {
       // full block - don't need to use cache
       // invalidate cache if block is in cache
-      if (SdVolume::cacheBlockNumber_ == block) {
-        SdVolume::cacheBlockNumber_ = 0XFFFFFFFF;
+      if (!SdVolume::cacheInvalidate(block, 0)) {
+        goto writeErrorReturn;
       }
       if (!vol_->writeBlock(block, src, blocking)) {
         goto writeErrorReturn;
@@ -1400,18 +1652,17 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
     } else {
       if (blockOffset == 0 && curPosition_ >= fileSize_) {
         // start of new block don't need to read into cache
-        if (!SdVolume::cacheFlush()) {
+        if (!SdVolume::cacheZeroBlock(block, SdVolume::CACHE_TYPE_DATA)) {
           goto writeErrorReturn;
         }
-        SdVolume::cacheBlockNumber_ = block;
-        SdVolume::cacheSetDirty();
       } else {
         // rewrite part of block
-        if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE)) {
+        if (!SdVolume::cacheRawBlock(block, SdVolume::CACHE_FOR_WRITE,
+                                     SdVolume::CACHE_TYPE_DATA)) {
           goto writeErrorReturn;
         }
       }
-      uint8_t* dst = SdVolume::cacheBuffer_.data + blockOffset;
+      uint8_t* dst = SdVolume::cacheBuffer_->data + blockOffset;
       uint8_t* end = dst + n;
       while (dst != end) {
         *dst++ = *src++;
@@ -19,13 +19,17 @@
 */
 #include "SdFat.h"
 //------------------------------------------------------------------------------
-// raw block cache
+// raw block cache, init() marks the blocks invalid
+SdVolume::cacheEntry_t SdVolume::cache_[SD_CACHE_BLOCKS];
+uint8_t  SdVolume::cacheIndex_ = 0;  // entry of cacheBuffer_
+cache_t* SdVolume::cacheBuffer_ = &SdVolume::cache_[0].buffer;
 // init cacheBlockNumber_to invalid SD block number
 uint32_t SdVolume::cacheBlockNumber_ = 0XFFFFFFFF;
-cache_t  SdVolume::cacheBuffer_;     // 512 byte cache for Sd2Card
+uint32_t SdVolume::cacheUseCount_ = 0;
+SdVolume::cacheStatistics_t SdVolume::cacheStatistics_;
 Sd2Card* SdVolume::sdCard_;          // pointer to SD card object
-uint8_t  SdVolume::cacheDirty_ = 0;  // cacheFlush() will write block if true
-uint32_t SdVolume::cacheMirrorBlock_ = 0;  // mirror  block for second FAT
+// no multiple block write is open
+uint32_t SdVolume::streamBlockNumber_ = 0XFFFFFFFF;
 //------------------------------------------------------------------------------
 // find a contiguous group of clusters
 uint8_t SdVolume::allocContiguous(uint32_t count, uint32_t* curCluster) {
@@ -108,64 +112,185 @@ uint8_t SdVolume::allocContiguous(uint32_t count, uint32_t* curCluster) {
   return true;
 }
 //------------------------------------------------------------------------------
+// write all dirty blocks, the data blocks before the FAT blocks before the
+// directory blocks, i.e. a directory entry never points to unwritten clusters
 uint8_t SdVolume::cacheFlush(uint8_t blocking) {
-  if (cacheDirty_) {
-    if (!sdCard_->writeBlock(cacheBlockNumber_, cacheBuffer_.data, blocking)) {
-      return false;
+  static uint8_t const order[] = {CACHE_TYPE_DATA, CACHE_TYPE_FAT, CACHE_TYPE_DIR};
+  for (uint8_t t = 0; t < sizeof(order); t++) {
+    for (uint8_t i = cacheFirst(order[t]); i < cacheFirst(order[t] + 1); i++) {
+      if (!cacheWriteBack(i, blocking)) {
+        return false;
+      }
     }
-
-    if (!blocking) {
-      return true;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// cache the block in the blocks of its type, the least recently used block of
+// the type is written back and replaced if the block is not cached yet
+uint8_t SdVolume::cacheRawBlock(uint32_t blockNumber, uint8_t action,
+                                uint8_t type) {
+  if (!cacheSelect(blockNumber, type)) {
+    return false;
+  }
+  cacheStatistics_.lookups[type]++;
+  if (cacheBlockNumber_ != blockNumber) {
+    if (!streamStop()) {
+      return false;
     }
-
-    // mirror FAT tables
-    if (!cacheMirrorBlockFlush(blocking)) {
+    if (!sdCard_->readBlock(blockNumber, cacheBuffer_->data)) {
       return false;
     }
-    cacheDirty_ = 0;
+    cacheStatistics_.reads[type]++;
+    cache_[cacheIndex_].blockNumber = cacheBlockNumber_ = blockNumber;
   }
+  cache_[cacheIndex_].dirty |= action;
   return true;
 }
 //------------------------------------------------------------------------------
+// drop a cached block, a dirty block is written first if writeBack is true
+uint8_t SdVolume::cacheInvalidate(uint32_t blockNumber, uint8_t writeBack) {
+  for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+    if (cache_[i].blockNumber == blockNumber) {
+      if (writeBack && !cacheWriteBack(i, 1)) {
+        return false;
+      }
+      cache_[i].blockNumber = 0XFFFFFFFF;
+      cache_[i].dirty = 0;
+      cache_[i].mirrorBlock = 0;
+      if (i == cacheIndex_) {
+        cacheBlockNumber_ = 0XFFFFFFFF;
+      }
+    }
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// return true if the block is in the cache
+uint8_t SdVolume::cacheContains(uint32_t blockNumber) {
+  for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+    if (cache_[i].blockNumber == blockNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
 uint8_t SdVolume::cacheMirrorBlockFlush(uint8_t blocking) {
-  if (cacheMirrorBlock_) {
-    if (!sdCard_->writeBlock(cacheMirrorBlock_, cacheBuffer_.data, blocking)) {
+  for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+    if (cache_[i].mirrorBlock) {
+      if (!streamStop()) {
+        return false;
+      }
+      if (!sdCard_->writeBlock(cache_[i].mirrorBlock, cache_[i].buffer.data, blocking)) {
+        return false;
+      }
+      cache_[i].mirrorBlock = 0;
+    }
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// make the cached block or the least recently used block of the type the
+// block of cacheBuffer_, a replaced block is written back if dirty
+uint8_t SdVolume::cacheSelect(uint32_t blockNumber, uint8_t type) {
+  uint8_t index = cacheFirst(type);
+  for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+    if (cache_[i].blockNumber == blockNumber) {
+      // a block stays with the type it was cached for
+      index = i;
+      break;
+    }
+    if (i >= cacheFirst(type) && i < cacheFirst(type + 1) &&
+        cache_[i].lastUse < cache_[index].lastUse) {
+      index = i;
+    }
+  }
+  if (cache_[index].blockNumber != blockNumber) {
+    if (!cacheWriteBack(index, 1)) {
       return false;
     }
-    cacheMirrorBlock_ = 0;
+    cache_[index].blockNumber = 0XFFFFFFFF;
   }
+  cache_[index].lastUse = ++cacheUseCount_;
+  cacheIndex_ = index;
+  cacheBuffer_ = &cache_[index].buffer;
+  cacheBlockNumber_ = cache_[index].blockNumber;
   return true;
 }
 //------------------------------------------------------------------------------
-uint8_t SdVolume::cacheRawBlock(uint32_t blockNumber, uint8_t action) {
-  if (cacheBlockNumber_ != blockNumber) {
-    if (!cacheFlush()) {
+// write a cached block if it is dirty
+uint8_t SdVolume::cacheWriteBack(uint8_t index, uint8_t blocking) {
+  cacheEntry_t* entry = &cache_[index];
+  if (entry->dirty) {
+    if (!streamStop()) {
       return false;
     }
-    if (!sdCard_->readBlock(blockNumber, cacheBuffer_.data)) {
+    if (!sdCard_->writeBlock(entry->blockNumber, entry->buffer.data, blocking)) {
       return false;
     }
-    cacheBlockNumber_ = blockNumber;
+
+    if (!blocking) {
+      return true;
+    }
+
+    // mirror FAT tables
+    if (entry->mirrorBlock) {
+      if (!sdCard_->writeBlock(entry->mirrorBlock, entry->buffer.data, blocking)) {
+        return false;
+      }
+      entry->mirrorBlock = 0;
+    }
+    entry->dirty = 0;
   }
-  cacheDirty_ |= action;
   return true;
 }
 //------------------------------------------------------------------------------
 // cache a zero block for blockNumber
-uint8_t SdVolume::cacheZeroBlock(uint32_t blockNumber) {
-  if (!cacheFlush()) {
+uint8_t SdVolume::cacheZeroBlock(uint32_t blockNumber, uint8_t type) {
+  if (!cacheSelect(blockNumber, type)) {
     return false;
   }
 
-  // loop take less flash than memset(cacheBuffer_.data, 0, 512);
+  // loop take less flash than memset(cacheBuffer_->data, 0, 512);
   for (uint16_t i = 0; i < 512; i++) {
-    cacheBuffer_.data[i] = 0;
+    cacheBuffer_->data[i] = 0;
   }
-  cacheBlockNumber_ = blockNumber;
+  cache_[cacheIndex_].blockNumber = cacheBlockNumber_ = blockNumber;
   cacheSetDirty();
   return true;
 }
 //------------------------------------------------------------------------------
+// write a block with a multiple block write, a new one is started if the
+// block does not follow the block written last
+uint8_t SdVolume::streamWrite(uint32_t blockNumber, const uint8_t* src) {
+  if (streamBlockNumber_ != blockNumber) {
+    if (!streamStop()) {
+      return false;
+    }
+    if (!sdCard_->writeStart(blockNumber, 1)) {
+      return false;
+    }
+  }
+  // the card ends the sequence on an error
+  streamBlockNumber_ = 0XFFFFFFFF;
+  if (!sdCard_->writeData(src)) {
+    return false;
+  }
+  streamBlockNumber_ = blockNumber + 1;
+  return true;
+}
+//------------------------------------------------------------------------------
+// end the multiple block write of streamWrite(), required before any other
+// access to the card
+uint8_t SdVolume::streamStop(void) {
+  if (streamBlockNumber_ == 0XFFFFFFFF) {
+    return true;
+  }
+  streamBlockNumber_ = 0XFFFFFFFF;
+  return sdCard_->writeStop();
+}
+//------------------------------------------------------------------------------
 // return the size in bytes of a cluster chain
 uint8_t SdVolume::chainSize(uint32_t cluster, uint32_t* size) const {
   uint32_t s = 0;
@@ -187,14 +312,14 @@ uint8_t SdVolume::fatGet(uint32_t cluster, uint32_t* value) const {
   uint32_t lba = fatStartBlock_;
   lba += fatType_ == 16 ? cluster >> 8 : cluster >> 7;
   if (lba != cacheBlockNumber_) {
-    if (!cacheRawBlock(lba, CACHE_FOR_READ)) {
+    if (!cacheRawBlock(lba, CACHE_FOR_READ, CACHE_TYPE_FAT)) {
       return false;
     }
   }
   if (fatType_ == 16) {
-    *value = cacheBuffer_.fat16[cluster & 0XFF];
+    *value = cacheBuffer_->fat16[cluster & 0XFF];
   } else {
-    *value = cacheBuffer_.fat32[cluster & 0X7F] & FAT32MASK;
+    *value = cacheBuffer_->fat32[cluster & 0X7F] & FAT32MASK;
   }
   return true;
 }
@@ -216,21 +341,21 @@ uint8_t SdVolume::fatPut(uint32_t cluster, uint32_t value) {
   lba += fatType_ == 16 ? cluster >> 8 : cluster >> 7;
 
   if (lba != cacheBlockNumber_) {
-    if (!cacheRawBlock(lba, CACHE_FOR_READ)) {
+    if (!cacheRawBlock(lba, CACHE_FOR_READ, CACHE_TYPE_FAT)) {
       return false;
     }
   }
   // store entry
   if (fatType_ == 16) {
-    cacheBuffer_.fat16[cluster & 0XFF] = value;
+    cacheBuffer_->fat16[cluster & 0XFF] = value;
   } else {
-    cacheBuffer_.fat32[cluster & 0X7F] = value;
+    cacheBuffer_->fat32[cluster & 0X7F] = value;
   }
   cacheSetDirty();
 
   // mirror second FAT
   if (fatCount_ > 1) {
-    cacheMirrorBlock_ = lba + blocksPerFat_;
+    cache_[cacheIndex_].mirrorBlock = lba + blocksPerFat_;
   }
   return true;
 }
@@ -275,16 +400,25 @@ uint8_t SdVolume::freeChain(uint32_t cluster) {
 uint8_t SdVolume::init(Sd2Card* dev, uint8_t part) {
   uint32_t volumeStartBlock = 0;
   sdCard_ = dev;
+  // blocks of a previous card are not valid
+  for (uint8_t i = 0; i < SD_CACHE_BLOCKS; i++) {
+    cache_[i].blockNumber = 0XFFFFFFFF;
+    cache_[i].mirrorBlock = 0;
+    cache_[i].lastUse = 0;
+    cache_[i].dirty = 0;
+  }
+  cacheBlockNumber_ = 0XFFFFFFFF;
+  streamBlockNumber_ = 0XFFFFFFFF;
   // if part == 0 assume super floppy with FAT boot sector in block zero
   // if part > 0 assume mbr volume with partition table
   if (part) {
     if (part > 4) {
       return false;
     }
-    if (!cacheRawBlock(volumeStartBlock, CACHE_FOR_READ)) {
+    if (!cacheRawBlock(volumeStartBlock, CACHE_FOR_READ, CACHE_TYPE_DATA)) {
       return false;
     }
-    part_t* p = &cacheBuffer_.mbr.part[part - 1];
+    part_t* p = &cacheBuffer_->mbr.part[part - 1];
     if ((p->boot & 0X7F) != 0  ||
         p->totalSectors < 100 ||
         p->firstSector == 0) {
@@ -293,10 +427,10 @@ uint8_t SdVolume::init(Sd2Card* dev, uint8_t part) {
     }
     volumeStartBlock = p->firstSector;
   }
-  if (!cacheRawBlock(volumeStartBlock, CACHE_FOR_READ)) {
+  if (!cacheRawBlock(volumeStartBlock, CACHE_FOR_READ, CACHE_TYPE_DATA)) {
     return false;
   }
-  bpb_t* bpb = &cacheBuffer_.fbs.bpb;
+  bpb_t* bpb = &cacheBuffer_->fbs.bpb;
   if (bpb->bytesPerSector != 512 ||
       bpb->fatCount == 0 ||
       bpb->reservedSectorCount == 0 ||